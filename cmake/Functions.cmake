@@ -754,4 +754,28 @@ macro(dune_probe_functions)
     "stdio.h"
     DUNE_SYS_HAS_POPEN)
 
+  dune_test_function(fdatasync
+    "int"
+    "int"
+    "unistd.h"
+    DUNE_SYS_HAS_FDATASYNC)
+
+  dune_test_function(madvise
+    "int"
+    "void*;size_t;int"
+    "sys/mman.h"
+    DUNE_SYS_HAS_MADVISE)
+
+  dune_test_function(sendmmsg
+    "int"
+    "int;mmsghdr*;unsigned;int"
+    "sys/socket.h"
+    DUNE_SYS_HAS_SENDMMSG)
+
+  dune_test_function(recvmmsg
+    "int"
+    "int;mmsghdr*;unsigned;int;timespec*"
+    "sys/socket.h;time.h"
+    DUNE_SYS_HAS_RECVMMSG)
+
 endmacro(dune_probe_functions)
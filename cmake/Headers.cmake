@@ -111,10 +111,12 @@ macro(dune_probe_headers)
   dune_test_header(linux/rtc.h)
   dune_test_header(linux/input.h)
   dune_test_header(linux/spi/spidev.h)
+  dune_test_header(linux/futex.h)
   dune_test_header(netdb.h)
   dune_test_header(pthread.h)
   dune_test_header(signal.h)
   dune_test_header(stdint.h)
+  dune_test_header(sys/epoll.h)
   dune_test_header(sys/io.h)
   dune_test_header(sys/ioctl.h)
   dune_test_header(sys/procfs.h)
@@ -133,6 +135,8 @@ macro(dune_probe_headers)
   dune_test_header(sys/reboot.h)
   dune_test_header(termios.h)
   dune_test_header(unistd.h)
+  dune_test_header(cpuid.h)
+  dune_test_header(wmmintrin.h)
   dune_test_header(windows.h)
   dune_test_header(direct.h)
   dune_test_header(winsock2.h)
@@ -0,0 +1,231 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+// Microbenchmark of IMC::Bus message dispatching.                          *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+using DUNE_NAMESPACES;
+
+//! Recipient that only counts delivered messages.
+class CountingTask: public Tasks::AbstractTask
+{
+public:
+  CountingTask(void):
+    m_count(0)
+  { }
+
+  void
+  receive(const IMC::Message* msg)
+  {
+    (void)msg;
+    ++m_count;
+  }
+
+  void
+  receive(const IMC::SharedMessage& msg)
+  {
+    (void)msg;
+    ++m_count;
+  }
+
+  const char*
+  getName(void) const
+  {
+    return "Counting Task";
+  }
+
+  void inf(const char*, ...) { }
+  void war(const char*, ...) { }
+  void err(const char*, ...) { }
+  void cri(const char*, ...) { }
+  void debug(const char*, ...) { }
+  void trace(const char*, ...) { }
+  void spew(const char*, ...) { }
+
+  unsigned long
+  getCount(void) const
+  {
+    return m_count;
+  }
+
+protected:
+  void
+  run(void)
+  { }
+
+private:
+  unsigned long m_count;
+};
+
+static void
+benchmark(unsigned subscribers, unsigned iterations)
+{
+  IMC::Bus bus;
+  std::vector<CountingTask*> tasks;
+
+  for (unsigned i = 0; i < subscribers; ++i)
+  {
+    tasks.push_back(new CountingTask);
+    bus.registerRecipient(tasks.back(), IMC::EstimatedState::getIdStatic());
+  }
+
+  // Unrelated subscriptions.
+  for (unsigned i = 0; i < subscribers; ++i)
+    bus.registerRecipient(tasks[i], IMC::Heartbeat::getIdStatic());
+
+  IMC::EstimatedState msg;
+
+  double start = Time::Clock::get();
+  for (unsigned i = 0; i < iterations; ++i)
+    bus.dispatch(&msg);
+  double elapsed = Time::Clock::get() - start;
+
+  unsigned long delivered = 0;
+  for (unsigned i = 0; i < subscribers; ++i)
+  {
+    delivered += tasks[i]->getCount();
+    delete tasks[i];
+  }
+
+  std::printf("%3u subscribers: %8.1f ns/dispatch %8.1f ns/delivery (%lu deliveries)\n",
+              subscribers,
+              elapsed * 1e9 / iterations,
+              elapsed * 1e9 / delivered,
+              delivered);
+}
+
+//! Dispatcher thread of the contended benchmark.
+class Dispatcher: public Concurrency::Thread
+{
+public:
+  Dispatcher(IMC::Bus& bus, const IMC::Message* msg, unsigned iterations):
+    m_bus(bus),
+    m_msg(msg),
+    m_iterations(iterations)
+  { }
+
+private:
+  IMC::Bus& m_bus;
+  const IMC::Message* m_msg;
+  unsigned m_iterations;
+
+  void
+  run(void)
+  {
+    for (unsigned i = 0; i < m_iterations; ++i)
+      m_bus.dispatch(m_msg);
+  }
+};
+
+//! Dispatch concurrently from several threads. Each thread sends its
+//! own message type to its own subscriber, so the only shared state
+//! is the bus itself.
+static void
+benchmarkContended(unsigned threads, unsigned iterations)
+{
+  IMC::Bus bus;
+  std::vector<IMC::Message*> msgs;
+  std::vector<CountingTask*> tasks;
+  std::vector<Dispatcher*> dispatchers;
+
+  msgs.push_back(new IMC::EstimatedState);
+  msgs.push_back(new IMC::Temperature);
+  msgs.push_back(new IMC::Pressure);
+  msgs.push_back(new IMC::Depth);
+  msgs.push_back(new IMC::Voltage);
+  msgs.push_back(new IMC::Current);
+  msgs.push_back(new IMC::Rpm);
+  msgs.push_back(new IMC::Salinity);
+
+  for (unsigned i = 0; i < threads; ++i)
+  {
+    tasks.push_back(new CountingTask);
+    bus.registerRecipient(tasks.back(), msgs[i % msgs.size()]->getId());
+    dispatchers.push_back(new Dispatcher(bus, msgs[i % msgs.size()], iterations));
+  }
+
+  double start = Time::Clock::get();
+  for (unsigned i = 0; i < threads; ++i)
+    dispatchers[i]->start();
+
+  for (unsigned i = 0; i < threads; ++i)
+    dispatchers[i]->join();
+  double elapsed = Time::Clock::get() - start;
+
+  unsigned long delivered = 0;
+  for (unsigned i = 0; i < threads; ++i)
+  {
+    delivered += tasks[i]->getCount();
+    delete dispatchers[i];
+  }
+
+  for (unsigned i = 0; i < threads; ++i)
+    delete tasks[i];
+
+  for (unsigned i = 0; i < msgs.size(); ++i)
+    delete msgs[i];
+
+  // Aggregate figures: without contention throughput grows with the
+  // number of cores.
+  std::printf("%3u threads:     %8.1f ns/dispatch %8.1f Mdispatch/s (%lu deliveries)\n",
+              threads,
+              elapsed * 1e9 / delivered,
+              delivered / elapsed / 1e6,
+              delivered);
+}
+
+int
+main(int argc, char** argv)
+{
+  unsigned iterations = 1000000;
+  if (argc > 1)
+    iterations = std::atoi(argv[1]);
+
+  std::printf("IMC::Bus::dispatch, %u iterations\n", iterations);
+
+  benchmark(1, iterations);
+  benchmark(10, iterations);
+  benchmark(50, iterations);
+
+  std::printf("IMC::Bus::dispatch, contended, %u iterations per thread\n", iterations);
+
+  benchmarkContended(1, iterations);
+  benchmarkContended(2, iterations);
+  benchmarkContended(4, iterations);
+  benchmarkContended(8, iterations);
+
+  return 0;
+}
@@ -0,0 +1,103 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+// Microbenchmark of CRC16 and CRC32 implementations.                       *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+using DUNE_NAMESPACES;
+
+//! Buffer sizes, from an empty IMC packet to the largest one.
+static const unsigned c_sizes[] = {20, 64, 256, 1024, 4096, 16384, 65535};
+//! Number of bytes processed per measurement.
+static const double c_volume = 256.0 * 1024 * 1024;
+
+//! Prevents the compiler from discarding results.
+static volatile uint32_t s_sink;
+
+template <typename T, typename L>
+static double
+measure(T (*fn)(const uint8_t*, L, T), const std::vector<uint8_t>& data, unsigned size)
+{
+  unsigned iterations = (unsigned)(c_volume / size) + 1;
+  T crc = 0;
+
+  double start = Time::Clock::get();
+  for (unsigned i = 0; i < iterations; ++i)
+    crc = fn(&data[0], size, crc);
+  double elapsed = Time::Clock::get() - start;
+
+  s_sink = crc;
+  return elapsed * 1e9 / iterations;
+}
+
+static void
+report(const char* name, double ns, unsigned size)
+{
+  std::printf("  %-10s %10.1f ns %8.2f GB/s\n", name, ns, size / ns);
+}
+
+int
+main(int argc, char** argv)
+{
+  (void)argc;
+  (void)argv;
+
+  std::vector<uint8_t> data(65536);
+  for (unsigned i = 0; i < data.size(); ++i)
+    data[i] = (uint8_t)std::rand();
+
+  std::printf("CRC32 carry-less multiplication: %s\n", CRC32::hasCLMUL() ? "yes" : "no");
+
+  for (unsigned i = 0; i < sizeof(c_sizes) / sizeof(c_sizes[0]); ++i)
+  {
+    unsigned size = c_sizes[i];
+
+    std::printf("CRC16, %u bytes\n", size);
+    report("bytewise", measure(&CRC16::computeBytewise, data, size), size);
+    report("slicing-4", measure(&CRC16::computeSlicing4, data, size), size);
+    report("slicing-8", measure(&CRC16::computeSlicing8, data, size), size);
+    report("compute", measure(&CRC16::compute, data, size), size);
+
+    std::printf("CRC32, %u bytes\n", size);
+    report("bytewise", measure(&CRC32::computeBytewise, data, size), size);
+    report("slicing-4", measure(&CRC32::computeSlicing4, data, size), size);
+    report("slicing-8", measure(&CRC32::computeSlicing8, data, size), size);
+    report("clmul", measure(&CRC32::computeCLMUL, data, size), size);
+    report("fast", measure(&CRC32::computeFast, data, size), size);
+  }
+
+  return 0;
+}
@@ -0,0 +1,294 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: José Braga                                                       *
+//***************************************************************************
+// Benchmark of Kalman filter update methods with an AUV-like model: nine  *
+// states, four motion outputs and sparse GPS/LBL outputs. The trajectory  *
+// comes from the EstimatedState messages of a log (if given) or from a    *
+// synthetic survey pattern.                                                *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+using DUNE_NAMESPACES;
+
+//! Number of states.
+static const unsigned c_states = 9;
+//! Number of outputs, including LBL beacons.
+static const unsigned c_outputs = 10;
+//! Number of LBL beacons.
+static const unsigned c_beacons = 4;
+//! LBL beacon positions.
+static const double c_beacon_pos[c_beacons][2] =
+{
+  {-200.0, -200.0},
+  {-200.0, 600.0},
+  {600.0, -200.0},
+  {600.0, 600.0}
+};
+
+enum States { ST_X, ST_Y, ST_PSI, ST_R, ST_U, ST_V, ST_R_BIAS, ST_PSI_BIAS, ST_K };
+enum Outputs { OT_U, OT_V, OT_PSI, OT_R, OT_GPS_X, OT_GPS_Y, OT_LBL };
+
+typedef Navigation::FixedKalmanFilter<c_states, c_outputs> Filter;
+typedef Filter::StateMatrix StateMatrix;
+
+//! Trajectory sample.
+struct TrajectorySample
+{
+  double dt;
+  double x, y, psi, r, u, v;
+};
+
+//! Load trajectory from EstimatedState messages.
+static bool
+loadTrajectory(const char* file, std::vector<TrajectorySample>& traj)
+{
+  IMC::LsfReader reader(file);
+  double last = -1;
+  IMC::Message* msg = NULL;
+
+  while ((msg = reader.read()) != NULL)
+  {
+    if (msg->getId() == IMC::EstimatedState::getIdStatic())
+    {
+      IMC::EstimatedState* es = static_cast<IMC::EstimatedState*>(msg);
+      double now = es->getTimeStamp();
+      if (last > 0 && now > last && now - last < 1.0)
+      {
+        TrajectorySample s = {now - last, es->x, es->y, es->psi, es->r, es->u, es->v};
+        traj.push_back(s);
+      }
+      last = now;
+    }
+
+    delete msg;
+  }
+
+  return !traj.empty();
+}
+
+//! Generate a survey pattern at 10 Hz.
+static void
+makeTrajectory(unsigned samples, std::vector<TrajectorySample>& traj)
+{
+  TrajectorySample s = {0.1, 0.0, 0.0, 0.0, 0.0, 1.5, 0.0};
+
+  for (unsigned i = 0; i < samples; ++i)
+  {
+    // Alternate straight legs and 180 degree turns.
+    s.r = ((i / 600) % 2) ? (((i / 1200) % 2) ? -0.1 : 0.1) : 0.0;
+    s.psi = Angles::normalizeRadian(s.psi + s.r * s.dt);
+    s.x += (s.u * std::cos(s.psi) - s.v * std::sin(s.psi)) * s.dt;
+    s.y += (s.u * std::sin(s.psi) + s.v * std::cos(s.psi)) * s.dt;
+    traj.push_back(s);
+  }
+}
+
+//! Hand transitions over to the filter.
+static void
+setTransitions(Navigation::KalmanFilter& kal, const StateMatrix& a, const StateMatrix& ap)
+{
+  kal.setStateTransition(a.toMatrix());
+  kal.setCovarianceTransition(ap.toMatrix());
+}
+
+static void
+setTransitions(Filter& kal, const StateMatrix& a, const StateMatrix& ap)
+{
+  kal.setStateTransition(a);
+  kal.setCovarianceTransition(ap);
+}
+
+//! Run a filter over the trajectory.
+template <typename F>
+static void
+run(const char* name, F& kal, const std::vector<TrajectorySample>& traj, std::vector<double>& est)
+{
+  kal.reset(c_states, c_outputs);
+  kal.setProcessNoise(1e-3);
+  kal.setProcessNoise(ST_R_BIAS, 1e-6);
+  kal.setProcessNoise(ST_PSI_BIAS, 1e-7);
+  kal.setProcessNoise(ST_K, 0.0);
+  kal.setMeasurementNoise(1e-2);
+  kal.setMeasurementNoise(OT_GPS_X, 4.0);
+  kal.setMeasurementNoise(OT_GPS_Y, 4.0);
+  for (unsigned i = 0; i < c_beacons; ++i)
+    kal.setMeasurementNoise(OT_LBL + i, 1.0);
+  kal.setCovariance(1.0);
+  kal.setState(ST_U, traj[0].u);
+
+  Random::Generator* rnd = Random::Factory::create(Random::Factory::c_default, 1);
+  est.resize(traj.size() * 2);
+
+  StateMatrix a;
+  StateMatrix ap;
+  double pos_error = 0.0;
+  double start = Time::Clock::get();
+
+  for (unsigned k = 0; k < traj.size(); ++k)
+  {
+    const TrajectorySample& s = traj[k];
+    double psi = kal.getState(ST_PSI);
+    double u = kal.getState(ST_U);
+    double v = kal.getState(ST_V);
+
+    // Discretized kinematic model.
+    a.identity();
+    a(ST_X, ST_U) = std::cos(psi) * s.dt;
+    a(ST_X, ST_V) = -std::sin(psi) * s.dt;
+    a(ST_Y, ST_U) = std::sin(psi) * s.dt;
+    a(ST_Y, ST_V) = std::cos(psi) * s.dt;
+    a(ST_PSI, ST_R) = s.dt;
+    ap = a;
+    ap(ST_X, ST_PSI) = (-u * std::sin(psi) - v * std::cos(psi)) * s.dt;
+    ap(ST_Y, ST_PSI) = (u * std::cos(psi) - v * std::sin(psi)) * s.dt;
+    setTransitions(kal, a, ap);
+    kal.predict();
+
+    for (unsigned i = 0; i < c_outputs; ++i)
+    {
+      for (unsigned j = 0; j < c_states; ++j)
+        kal.setObservation(i, j, 0.0);
+    }
+
+    // Motion sensors at every step.
+    kal.setObservation(OT_U, ST_U, 1.0);
+    kal.setObservation(OT_V, ST_V, 1.0);
+    kal.setObservation(OT_PSI, ST_PSI, 1.0);
+    kal.setObservation(OT_PSI, ST_PSI_BIAS, 1.0);
+    kal.setObservation(OT_R, ST_R, 1.0);
+    kal.setObservation(OT_R, ST_R_BIAS, 1.0);
+    kal.setInnovation(OT_U, s.u + rnd->gaussian() * 0.05 - kal.getState(ST_U));
+    kal.setInnovation(OT_V, s.v + rnd->gaussian() * 0.05 - kal.getState(ST_V));
+    kal.setInnovation(OT_PSI, Angles::normalizeRadian(s.psi + rnd->gaussian() * 0.02
+                                                      - kal.getState(ST_PSI)
+                                                      - kal.getState(ST_PSI_BIAS)));
+    kal.setInnovation(OT_R, s.r + rnd->gaussian() * 0.01 - kal.getState(ST_R)
+                      - kal.getState(ST_R_BIAS));
+
+    // GPS at the surface during the first tenth of the trajectory.
+    if (k < traj.size() / 10 && (k % 10) == 0)
+    {
+      kal.setObservation(OT_GPS_X, ST_X, 1.0);
+      kal.setObservation(OT_GPS_Y, ST_Y, 1.0);
+      kal.setInnovation(OT_GPS_X, s.x + rnd->gaussian() * 2.0 - kal.getState(ST_X));
+      kal.setInnovation(OT_GPS_Y, s.y + rnd->gaussian() * 2.0 - kal.getState(ST_Y));
+    }
+
+    // One LBL range every second step, round robin.
+    if ((k % 2) == 0)
+    {
+      unsigned b = (k / 2) % c_beacons;
+      double dx = kal.getState(ST_X) - c_beacon_pos[b][0];
+      double dy = kal.getState(ST_Y) - c_beacon_pos[b][1];
+      double range = std::sqrt(dx * dx + dy * dy);
+      double tx = s.x - c_beacon_pos[b][0];
+      double ty = s.y - c_beacon_pos[b][1];
+      double meas = std::sqrt(tx * tx + ty * ty) + rnd->gaussian() * 0.5;
+
+      kal.setObservation(OT_LBL + b, ST_X, dx / range);
+      kal.setObservation(OT_LBL + b, ST_Y, dy / range);
+      kal.setInnovation(OT_LBL + b, meas - range);
+    }
+
+    kal.update(0.0);
+
+    est[2 * k] = kal.getState(ST_X);
+    est[2 * k + 1] = kal.getState(ST_Y);
+    double ex = est[2 * k] - s.x;
+    double ey = est[2 * k + 1] - s.y;
+    pos_error += ex * ex + ey * ey;
+  }
+
+  double elapsed = Time::Clock::get() - start;
+  delete rnd;
+
+  std::printf("%-24s %8.1f ns/cycle, position RMS error %.3f m\n", name,
+              elapsed * 1e9 / traj.size(), std::sqrt(pos_error / traj.size()));
+}
+
+//! Largest position difference between two runs.
+static double
+maxDifference(const std::vector<double>& a, const std::vector<double>& b)
+{
+  double d = 0.0;
+  for (unsigned i = 0; i < a.size(); ++i)
+    d = std::max(d, std::fabs(a[i] - b[i]));
+
+  return d;
+}
+
+int
+main(int argc, char** argv)
+{
+  std::vector<TrajectorySample> traj;
+
+  if (argc > 1)
+  {
+    if (!loadTrajectory(argv[1], traj))
+    {
+      std::fprintf(stderr, "no EstimatedState samples in %s\n", argv[1]);
+      return 1;
+    }
+  }
+  else
+  {
+    makeTrajectory(100000, traj);
+  }
+
+  std::printf("Kalman filter update methods, %u cycles\n", (unsigned)traj.size());
+
+  std::vector<double> reference;
+  std::vector<double> est;
+
+  Navigation::KalmanFilter dynamic;
+  run("KalmanFilter", dynamic, traj, reference);
+
+  Filter dense;
+  run("Fixed, dense", dense, traj, est);
+  std::printf("%-24s %.3g m\n", "  difference", maxDifference(reference, est));
+
+  Filter sequential;
+  sequential.setUpdateMethod(Filter::UM_SEQUENTIAL);
+  run("Fixed, sequential", sequential, traj, est);
+  std::printf("%-24s %.3g m\n", "  difference", maxDifference(reference, est));
+
+  Filter square_root;
+  square_root.setUpdateMethod(Filter::UM_SQUARE_ROOT);
+  run("Fixed, square root", square_root, traj, est);
+  std::printf("%-24s %.3g m\n", "  difference", maxDifference(reference, est));
+
+  return 0;
+}
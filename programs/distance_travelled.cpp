@@ -87,12 +87,7 @@ main(int32_t argc, char** argv)
 
   for (int32_t i = 1; i < argc; ++i)
   {
-    std::istream* is = 0;
-    Compression::Methods method = Compression::Factory::detect(argv[i]);
-    if (method == METHOD_UNKNOWN)
-      is = new std::ifstream(argv[i], std::ios::binary);
-    else
-      is = new Compression::FileInput(argv[i], method);
+    IMC::LsfReader* reader = new IMC::LsfReader(argv[i]);
 
     IMC::Message* msg = NULL;
 
@@ -117,7 +112,7 @@ main(int32_t argc, char** argv)
 
     try
     {
-      while ((msg = IMC::Packet::deserialize(*is)) != 0)
+      while ((msg = reader->read()) != 0)
       {
         if (msg->getId() == DUNE_IMC_ANNOUNCE)
         {
@@ -207,7 +202,7 @@ main(int32_t argc, char** argv)
       std::cerr << "ERROR: " << e.what() << std::endl;
     }
 
-    delete is;
+    delete reader;
 
     if (ignore)
     {
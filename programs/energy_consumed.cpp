@@ -99,12 +99,7 @@ main(int32_t argc, char** argv)
 
   for (int32_t i = start_index; i < argc; ++i)
   {
-    std::istream* is = 0;
-    DUNE::Compression::Methods method = DUNE::Compression::Factory::detect(argv[i]);
-    if (method == DUNE::Compression::METHOD_UNKNOWN)
-      is = new std::ifstream(argv[i], std::ios::binary);
-    else
-      is = new DUNE::Compression::FileInput(argv[i], method);
+    DUNE::IMC::LsfReader* reader = new DUNE::IMC::LsfReader(argv[i]);
 
     DUNE::IMC::Message* msg = NULL;
 
@@ -129,7 +124,7 @@ main(int32_t argc, char** argv)
 
     try
     {
-      while ((msg = DUNE::IMC::Packet::deserialize(*is)) != 0)
+      while ((msg = reader->read()) != 0)
       {
 
         if (msg->getId() == DUNE_IMC_LOGGINGCONTROL)
@@ -217,7 +212,7 @@ main(int32_t argc, char** argv)
       std::cerr << "ERROR: " << e.what() << std::endl;
     }
 
-    delete is;
+    delete reader;
 
     if (ignore)
     {
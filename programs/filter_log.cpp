@@ -58,8 +58,6 @@ main(int32_t argc, char** argv)
   ByteBuffer buffer;
   std::ofstream lsf("FilteredData.lsf", std::ios::binary);
 
-  IMC::Message* msg;
-
   uint32_t accum = 0;
 
   bool done_first = false;
@@ -76,41 +74,33 @@ main(int32_t argc, char** argv)
 
   for (uint32_t j = 2; j < (uint32_t)argc; ++j)
   {
-    std::istream* is = 0;
-    Compression::Methods method = Compression::Factory::detect(argv[j]);
-    if (method == METHOD_UNKNOWN)
-      is = new std::ifstream(argv[j], std::ios::binary);
-    else
-      is = new Compression::FileInput(argv[j], method);
-
     uint32_t i = 0;
 
     try
     {
-      while ((msg = IMC::Packet::deserialize(*is)) != 0)
+      // Only headers are parsed, selected packets are validated and
+      // copied as is.
+      IMC::LsfReader reader(argv[j]);
+      while (reader.next())
       {
         if (!done_first)
         {
           // place an empty estimatedstate message in the log
           IMC::EstimatedState state;
-          state.setTimeStamp(msg->getTimeStamp());
+          state.setTimeStamp(reader.getHeader().timestamp);
           IMC::Packet::serialize(&state, buffer);
           lsf.write(buffer.getBufferSigned(), buffer.getSize());
           done_first = true;
         }
 
-        std::set<uint32_t>::const_iterator it;
-        it = ids.find(msg->getId());
-
-        if (it != ids.end())
+        if (ids.find(reader.getHeader().mgid) != ids.end())
         {
-          IMC::Packet::serialize(msg, buffer);
-          lsf.write(buffer.getBufferSigned(), buffer.getSize());
+          if (!reader.isValid())
+            throw IMC::InvalidCrc();
 
+          lsf.write((const char*)reader.getPacket(), reader.getPacketSize());
           ++i;
         }
-
-        delete msg;
       }
     }
     catch (std::runtime_error& e)
@@ -121,8 +111,6 @@ main(int32_t argc, char** argv)
 
     std::cerr << i << " messages in " << argv[j] << std::endl;
     accum += i;
-
-    delete is;
   }
 
   lsf.close();
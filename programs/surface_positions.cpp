@@ -54,12 +54,7 @@ main(int32_t argc, char** argv)
     return 1;
   }
 
-  std::istream* is = 0;
-  Compression::Methods method = Compression::Factory::detect(argv[1]);
-  if (method == METHOD_UNKNOWN)
-    is = new std::ifstream(argv[1], std::ios::binary);
-  else
-    is = new Compression::FileInput(argv[1], method);
+  IMC::LsfReader* reader = new IMC::LsfReader(argv[1]);
 
   ByteBuffer buffer;
   std::ofstream lsf("SurfaceData.lsf", std::ios::binary);
@@ -75,7 +70,7 @@ main(int32_t argc, char** argv)
 
   try
   {
-    while ((msg = IMC::Packet::deserialize(*is)) != 0)
+    while ((msg = reader->read()) != 0)
     {
       if (msg->getId() == DUNE_IMC_GPSFIX)
       {
@@ -105,7 +100,7 @@ main(int32_t argc, char** argv)
 
   lsf.close();
 
-  delete is;
+  delete reader;
 
   std::cerr << "Got " << i << " GpsFix messages." << std::endl;
 
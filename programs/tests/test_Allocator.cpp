@@ -0,0 +1,147 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cstring>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using namespace DUNE::System;
+using namespace DUNE::Concurrency;
+
+class Worker: public Thread
+{
+public:
+  Worker(void):
+    created(false),
+    owned(false),
+    fallback(false),
+    leftover(NULL),
+    used(0)
+  { }
+
+  bool created;
+  bool owned;
+  bool fallback;
+  void* leftover;
+  size_t used;
+
+  void
+  run(void)
+  {
+    created = Allocator::createThreadArena(64 * 1024);
+
+    Allocator::Statistics initial;
+    Allocator::getThreadStatistics(initial);
+    used = initial.used;
+
+    for (unsigned i = 0; i < 100; ++i)
+      Allocator::deallocate(Allocator::allocate(i * 8));
+
+    // Larger than the arena, served by the C library.
+    char* big = static_cast<char*>(Allocator::allocate(256 * 1024));
+    std::memset(big, 0xaa, 256 * 1024);
+    Allocator::deallocate(big);
+
+    leftover = Allocator::allocate(128);
+
+    Allocator::Statistics stats;
+    owned = Allocator::getThreadStatistics(stats);
+    fallback = stats.fallbacks == 1 && stats.allocations == 102;
+  }
+};
+
+int
+main(void)
+{
+  Test test("System::Allocator");
+
+  {
+    void* ptr = Allocator::allocate(100);
+    std::memset(ptr, 0x55, 100);
+    test.boolean("allocate()", ptr != NULL);
+    Allocator::deallocate(ptr);
+    Allocator::deallocate(NULL);
+  }
+
+  {
+    Allocator::Statistics stats;
+    test.boolean("getThreadStatistics() without arena", !Allocator::getThreadStatistics(stats));
+  }
+
+  {
+    Worker worker;
+    worker.start();
+    worker.stopAndJoin();
+
+    if (Allocator::isAvailable())
+    {
+      test.boolean("createThreadArena()", worker.created);
+      test.boolean("getThreadStatistics()", worker.owned);
+      test.boolean("fallback", worker.fallback);
+    }
+    else
+    {
+      test.boolean("createThreadArena() unavailable", !worker.created);
+    }
+
+    // An arena with blocks still in use outlives its thread and is
+    // adopted by the next thread asking for an arena of its size.
+    Worker next;
+    next.start();
+    next.stopAndJoin();
+
+    if (Allocator::isAvailable())
+      test.boolean("arena of exited thread reused", next.created && next.used > 0);
+
+    // Blocks may be released by threads other than their owner.
+    Allocator::deallocate(worker.leftover);
+    Allocator::deallocate(next.leftover);
+  }
+
+  if (Allocator::isAvailable())
+  {
+    // Threads without an arena reuse cached blocks.
+    Allocator::Statistics before;
+    Allocator::getThreadStatistics(before);
+
+    for (unsigned i = 0; i < 1000; ++i)
+      Allocator::deallocate(Allocator::allocate(64));
+
+    Allocator::Statistics after;
+    Allocator::getThreadStatistics(after);
+    test.boolean("process-wide arena cached", after.allocations - before.allocations <= 1);
+  }
+
+  return test.getReturnValue();
+}
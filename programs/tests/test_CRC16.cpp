@@ -0,0 +1,77 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cstdlib>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+using DUNE_NAMESPACES;
+
+// Local headers.
+#include "Test.hpp"
+
+int
+main(void)
+{
+  Test test("Algorithms::CRC16");
+
+  const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+  test.boolean("compute(123456789) == 0xBB3D", CRC16::compute(check, sizeof(check)) == 0xBB3D);
+
+  std::vector<uint8_t> data(4096);
+  for (unsigned i = 0; i < data.size(); ++i)
+    data[i] = (uint8_t)std::rand();
+
+  // Slicing variants must match the bytewise implementation for
+  // every length and alignment.
+  bool slicing4 = true;
+  bool slicing8 = true;
+  for (unsigned len = 0; len < 1024; ++len)
+  {
+    for (unsigned off = 0; off < 8; ++off)
+    {
+      uint16_t crc = CRC16::computeBytewise(&data[off], len, 0xFFFF);
+      slicing4 = slicing4 && CRC16::computeSlicing4(&data[off], len, 0xFFFF) == crc;
+      slicing8 = slicing8 && CRC16::computeSlicing8(&data[off], len, 0xFFFF) == crc;
+    }
+  }
+
+  test.boolean("computeSlicing4() == computeBytewise()", slicing4);
+  test.boolean("computeSlicing8() == computeBytewise()", slicing8);
+
+  // Incremental computation.
+  uint16_t crc = CRC16::compute(&data[0], 1000);
+  crc = CRC16::compute(&data[1000], 3000, crc);
+  test.boolean("incremental compute()", crc == CRC16::computeBytewise(&data[0], 4000));
+
+  return test.getReturnValue();
+}
@@ -29,8 +29,10 @@
 // Test program for DUNE::Algorithms::CRC32 class.                          *
 //***************************************************************************
 // ISO C++ headers
+#include <cstdlib>
 #include <cstring>
 #include <string>
+#include <vector>
 
 // DUNE headers
 #include <DUNE/Algorithms/CRC32.hpp>
@@ -106,5 +108,32 @@ main(int argc, char** argv)
     testname = "No data reflection, " + std::string(input_strings[i]);
     test.boolean(testname.c_str(), crc == results_no_reflect_data[i]);
   }
-  return 0;
+
+  // All implementations must match the bytewise one, including
+  // lengths that leave a tail after the carry-less folding.
+  std::vector<uint8_t> data(4096);
+  for (unsigned i = 0; i < data.size(); ++i)
+    data[i] = (uint8_t)std::rand();
+
+  bool slicing4 = true;
+  bool slicing8 = true;
+  bool clmul = true;
+  for (unsigned len = 0; len < 1024; ++len)
+  {
+    for (unsigned off = 0; off < 8; ++off)
+    {
+      uint32_t crc = CRC32::computeBytewise(&data[off], len, 0x12345678);
+      slicing4 = slicing4 && CRC32::computeSlicing4(&data[off], len, 0x12345678) == crc;
+      slicing8 = slicing8 && CRC32::computeSlicing8(&data[off], len, 0x12345678) == crc;
+      clmul = clmul && CRC32::computeCLMUL(&data[off], len, 0x12345678) == crc;
+    }
+  }
+
+  test.boolean("computeSlicing4() == computeBytewise()", slicing4);
+  test.boolean("computeSlicing8() == computeBytewise()", slicing8);
+  test.boolean(CRC32::hasCLMUL() ? "computeCLMUL() == computeBytewise()"
+               : "computeCLMUL() == computeBytewise() (fallback)", clmul);
+  test.boolean("computeFast(4096 bytes)",
+               CRC32::computeFast(&data[0], data.size()) == CRC32::computeBytewise(&data[0], data.size()));
+  return test.getReturnValue();
 }
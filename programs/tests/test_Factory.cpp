@@ -0,0 +1,188 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+
+//! Message subclass that the factory does not create.
+class CustomHeartbeat: public IMC::Heartbeat
+{ };
+
+//! Releases messages produced by another thread.
+class Releaser: public Concurrency::Thread
+{
+public:
+  Releaser(std::vector<IMC::Message*>& msgs):
+    m_msgs(msgs)
+  { }
+
+private:
+  std::vector<IMC::Message*>& m_msgs;
+
+  void
+  run(void)
+  {
+    for (unsigned i = 0; i < m_msgs.size(); ++i)
+      IMC::Factory::recycle(m_msgs[i]);
+  }
+};
+
+int
+main(void)
+{
+  Test test("IMC::Factory");
+
+  {
+    IMC::Message* msg = IMC::Factory::produce(DUNE_IMC_ESTIMATEDSTATE);
+    test.boolean("produce(id)", msg != NULL && msg->getId() == DUNE_IMC_ESTIMATEDSTATE);
+    delete msg;
+
+    test.boolean("produce(unknown id)", IMC::Factory::produce(60000) == NULL);
+  }
+
+  {
+    IMC::LogBookEntry* msg = static_cast<IMC::LogBookEntry*>(IMC::Factory::produce(DUNE_IMC_LOGBOOKENTRY));
+    msg->text.assign(1000, 'x');
+    msg->setSource(0x1234);
+    msg->setTimeStamp(10.0);
+    const char* data = msg->text.data();
+    IMC::Factory::recycle(msg);
+
+    IMC::LogBookEntry* other = static_cast<IMC::LogBookEntry*>(IMC::Factory::produce(DUNE_IMC_LOGBOOKENTRY));
+    test.boolean("recycled object is reused", other == msg);
+    test.boolean("recycled object is cleared", other->text.empty() && other->getTimeStamp() < 0
+                 && other->getSource() == IMC::AddressResolver::invalid());
+    test.boolean("recycled object keeps capacity", other->text.capacity() >= 1000 && other->text.data() == data);
+    delete other;
+  }
+
+  {
+    IMC::LogBookEntry* msg = static_cast<IMC::LogBookEntry*>(IMC::Factory::produce(DUNE_IMC_LOGBOOKENTRY));
+    msg->text.assign(IMC::Pool::c_max_payload + 1, 'x');
+    IMC::Factory::recycle(msg);
+
+    IMC::LogBookEntry* other = static_cast<IMC::LogBookEntry*>(IMC::Factory::produce(DUNE_IMC_LOGBOOKENTRY));
+    test.boolean("large objects are not recycled", other->text.capacity() <= IMC::Pool::c_max_payload);
+    delete other;
+  }
+
+  {
+    IMC::LogBookEntry src;
+    src.text = "clone of a message with a long text field";
+    src.setSource(0x4321);
+
+    IMC::Message* msg = IMC::Factory::produce(DUNE_IMC_LOGBOOKENTRY);
+    IMC::Factory::recycle(msg);
+    IMC::Message* copy = IMC::Factory::clone(src);
+    test.boolean("clone() reuses recycled object", copy == msg);
+    test.boolean("clone() copies fields and header", *copy == src && copy->getSource() == 0x4321);
+    delete copy;
+  }
+
+  {
+    IMC::Message* custom = new CustomHeartbeat;
+    IMC::Factory::recycle(custom);
+    IMC::Message* msg = IMC::Factory::produce(DUNE_IMC_HEARTBEAT);
+    test.boolean("subclasses are not recycled", dynamic_cast<CustomHeartbeat*>(msg) == NULL);
+    delete msg;
+  }
+
+  {
+    IMC::Factory::setPooling(false);
+    IMC::Message* msg = IMC::Factory::produce(DUNE_IMC_HEARTBEAT);
+    IMC::Factory::recycle(msg);
+    IMC::Message* other = IMC::Factory::produce(DUNE_IMC_HEARTBEAT);
+    test.boolean("pooling disabled", other != NULL && other->getId() == DUNE_IMC_HEARTBEAT);
+    delete other;
+    IMC::Factory::setPooling(true);
+  }
+
+  {
+    // Objects released in another thread return to this one through
+    // the shared depot.
+    std::vector<IMC::Message*> msgs;
+    for (unsigned i = 0; i < 256; ++i)
+      msgs.push_back(IMC::Factory::produce(DUNE_IMC_ENTITYSTATE));
+
+    Releaser releaser(msgs);
+    releaser.start();
+    releaser.stopAndJoin();
+
+    unsigned reused = 0;
+    for (unsigned i = 0; i < msgs.size(); ++i)
+    {
+      IMC::Message* msg = IMC::Factory::produce(DUNE_IMC_ENTITYSTATE);
+      if (std::find(msgs.begin(), msgs.end(), msg) != msgs.end())
+        ++reused;
+      delete msg;
+    }
+
+    test.boolean("objects are recycled across threads", reused == msgs.size());
+  }
+
+  {
+    // Caches of exiting threads do not grow the depot beyond its
+    // limit.
+    std::vector<std::vector<IMC::Message*> > batches(64);
+    for (unsigned i = 0; i < batches.size(); ++i)
+    {
+      for (unsigned j = 0; j < 16; ++j)
+        batches[i].push_back(IMC::Factory::produce(DUNE_IMC_TEMPERATURE));
+    }
+
+    for (unsigned i = 0; i < batches.size(); ++i)
+    {
+      Releaser releaser(batches[i]);
+      releaser.start();
+      releaser.stopAndJoin();
+    }
+
+    std::vector<IMC::Message*> cached;
+    IMC::Message* msg = NULL;
+    while ((msg = IMC::Pool::take(DUNE_IMC_TEMPERATURE)) != NULL)
+      cached.push_back(msg);
+
+    test.boolean("exiting threads respect depot limit",
+                 !cached.empty() && cached.size() < batches.size() * 16 / 2);
+
+    for (unsigned i = 0; i < cached.size(); ++i)
+      delete cached[i];
+  }
+
+  return test.getReturnValue();
+}
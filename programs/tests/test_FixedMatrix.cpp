@@ -0,0 +1,276 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cmath>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE::Math::Matrix;
+using DUNE::Math::FixedMatrix;
+using DUNE::Navigation::KalmanFilter;
+using DUNE::Navigation::FixedKalmanFilter;
+
+//! Compare a fixed size matrix with a dynamic one.
+template <unsigned R, unsigned C>
+static bool
+equal(const FixedMatrix<R, C>& a, const Matrix& b, double tol = 1e-9)
+{
+  if ((size_t)b.rows() != R || (size_t)b.columns() != C)
+    return false;
+
+  for (unsigned i = 0; i < R; ++i)
+  {
+    for (unsigned j = 0; j < C; ++j)
+    {
+      if (std::fabs(a(i, j) - b(i, j)) > tol)
+        return false;
+    }
+  }
+
+  return true;
+}
+
+int
+main(void)
+{
+  Test test("Math::FixedMatrix");
+
+  DUNE::Math::Random::Generator* rnd =
+    DUNE::Math::Random::Factory::create(DUNE::Math::Random::Factory::c_default, 1);
+
+  FixedMatrix<4, 3> a;
+  FixedMatrix<3, 5> b;
+  FixedMatrix<4, 4> p;
+  FixedMatrix<4, 4> q;
+
+  for (unsigned i = 0; i < a.size(); ++i)
+    a(i) = rnd->uniform(-1, 1);
+
+  for (unsigned i = 0; i < b.size(); ++i)
+    b(i) = rnd->uniform(-1, 1);
+
+  for (unsigned i = 0; i < p.size(); ++i)
+    p(i) = rnd->uniform(-1, 1);
+
+  // Symmetric positive definite matrix.
+  p = p * DUNE::Math::transpose(p);
+  for (unsigned i = 0; i < 4; ++i)
+    p(i, i) += 1.0;
+
+  q.identity();
+  q *= 0.1;
+
+  Matrix ma = a.toMatrix();
+  Matrix mb = b.toMatrix();
+  Matrix mp = p.toMatrix();
+  Matrix mq = q.toMatrix();
+
+  test.boolean("toMatrix()", equal(a, ma, 0));
+  test.boolean("from Matrix", FixedMatrix<4, 3>(ma) == a);
+
+  bool thrown = false;
+  try
+  {
+    FixedMatrix<3, 4> wrong(ma);
+  }
+  catch (Matrix::Error&)
+  {
+    thrown = true;
+  }
+  test.boolean("from Matrix with invalid dimensions", thrown);
+
+  test.boolean("operator*", equal(a * b, ma * mb));
+  test.boolean("operator+", equal(p + q, mp + mq));
+  test.boolean("operator-", equal(p - q, mp - mq));
+  test.boolean("scalar operator*", equal(2.5 * a, 2.5 * ma));
+  test.boolean("transpose()", equal(DUNE::Math::transpose(a), transpose(ma), 0));
+  test.boolean("inverse()", equal(DUNE::Math::inverse(p), inverse(mp)));
+  test.boolean("get()", equal(p.get<2, 3>(1, 1), mp.get(1, 2, 1, 3), 0));
+
+  FixedMatrix<3, 3> m3;
+  m3.put(0, 0, a.get<3, 3>(0, 0));
+  test.boolean("put()", equal(m3, ma.get(0, 2, 0, 2), 0));
+
+  FixedMatrix<4, 4> singular(1.0);
+  FixedMatrix<4, 4> out;
+  test.boolean("inverse() of singular matrix", !DUNE::Math::inverse(singular, out));
+
+  FixedMatrix<4, 5> apb;
+  DUNE::Math::multiplyTransposed(a, DUNE::Math::transpose(b), apb);
+  test.boolean("multiplyTransposed()", equal(apb, ma * mb));
+
+  DUNE::Math::congruence(p, p, q, out);
+  test.boolean("congruence()", equal(out, mp * mp * transpose(mp) + mq, 1e-8));
+
+  test.boolean("expmts()", equal((p * 0.3).expmts(), (mp * 0.3).expmts(), 1e-6));
+  test.boolean("expmts() with scaling", equal((p * 3.0).expmts(), (mp * 3.0).expmts(), 1e-4));
+
+  // Both filters must produce the same estimates, including when the
+  // fixed filter has inactive outputs.
+  KalmanFilter kf;
+  FixedKalmanFilter<4, 4> fkf;
+  kf.reset(4, 2);
+  fkf.reset(4, 2);
+
+  FixedMatrix<4, 4> t;
+  t.identity();
+  t(0, 2) = 0.1;
+  t(1, 3) = 0.1;
+  kf.setTransitions(t.toMatrix());
+  fkf.setTransitions(t);
+
+  kf.setProcessNoise(0.01);
+  fkf.setProcessNoise(0.01);
+  kf.setMeasurementNoise(0.5);
+  fkf.setMeasurementNoise(0.5);
+  kf.setCovariance(1.0);
+  fkf.setCovariance(1.0);
+
+  kf.setObservation(0, 0, 1.0);
+  fkf.setObservation(0, 0, 1.0);
+  kf.setObservation(1, 1, 1.0);
+  fkf.setObservation(1, 1, 1.0);
+
+  for (unsigned k = 0; k < 50; ++k)
+  {
+    kf.predict();
+    fkf.predict();
+
+    double zx = 0.2 * k + rnd->uniform(-0.3, 0.3);
+    double zy = -0.1 * k + rnd->uniform(-0.3, 0.3);
+    kf.setInnovation(0, zx - kf.getState(0));
+    fkf.setInnovation(0, zx - fkf.getState(0));
+    kf.setInnovation(1, zy - kf.getState(1));
+    fkf.setInnovation(1, zy - fkf.getState(1));
+
+    kf.update(0.0);
+    fkf.update(0.0);
+  }
+
+  test.boolean("FixedKalmanFilter state", equal(fkf.getState(), kf.getState(), 1e-9));
+  test.boolean("FixedKalmanFilter covariance", equal(fkf.getCovariance(), kf.getCovariance(), 1e-9));
+
+  thrown = false;
+  try
+  {
+    fkf.setInnovation(3, 1.0);
+  }
+  catch (std::runtime_error&)
+  {
+    thrown = true;
+  }
+  test.boolean("FixedKalmanFilter inactive output", thrown);
+
+  // Sequential and factorized updates must match the dense update when
+  // measurement noise is uncorrelated, including absent measurements.
+  typedef FixedKalmanFilter<6, 4> Filter6;
+  Filter6 filters[3];
+  filters[1].setUpdateMethod(Filter6::UM_SEQUENTIAL);
+  filters[2].setUpdateMethod(Filter6::UM_SQUARE_ROOT);
+
+  FixedMatrix<6, 6> t6;
+  t6.identity();
+  for (unsigned i = 0; i < 3; ++i)
+    t6(i, i + 3) = 0.1;
+
+  for (unsigned f = 0; f < 3; ++f)
+  {
+    filters[f].setTransitions(t6);
+    filters[f].setProcessNoise(0.01);
+    filters[f].setProcessNoise(0, 1, 0.002);
+    filters[f].setProcessNoise(1, 0, 0.002);
+    filters[f].setCovariance(1.0);
+    filters[f].setMeasurementNoise(0.3);
+    filters[f].setMeasurementNoise(3, 3, 0.05);
+  }
+
+  for (unsigned k = 0; k < 100; ++k)
+  {
+    for (unsigned f = 0; f < 3; ++f)
+      filters[f].predict();
+
+    double z[4] = {0.2 * k, -0.1 * k, 0.05 * k, 0.1 * k};
+    bool present[4] = {true, (k % 3) != 0, (k % 5) == 0, (k % 2) == 0};
+    double noise[4];
+    for (unsigned i = 0; i < 4; ++i)
+      noise[i] = rnd->uniform(-0.3, 0.3);
+
+    for (unsigned f = 0; f < 3; ++f)
+    {
+      Filter6& kal = filters[f];
+      for (unsigned i = 0; i < 4; ++i)
+      {
+        for (unsigned j = 0; j < 6; ++j)
+          kal.setObservation(i, j, 0.0);
+      }
+
+      if (present[0])
+        kal.setObservation(0, 0, 1.0);
+      if (present[1])
+        kal.setObservation(1, 1, 1.0);
+      if (present[2])
+        kal.setObservation(2, 2, 1.0);
+      if (present[3])
+      {
+        kal.setObservation(3, 0, 0.6);
+        kal.setObservation(3, 1, 0.8);
+      }
+
+      const FixedMatrix<6, 1>& x = kal.getState();
+      kal.setInnovation(0, z[0] + noise[0] - x(0));
+      kal.setInnovation(1, z[1] + noise[1] - x(1));
+      kal.setInnovation(2, z[2] + noise[2] - x(2));
+      kal.setInnovation(3, z[3] + noise[3] - (0.6 * x(0) + 0.8 * x(1)));
+      kal.update(0.0);
+    }
+  }
+
+  test.boolean("sequential update state",
+               (filters[1].getState() - filters[0].getState()).norm_2() < 1e-8);
+  test.boolean("sequential update covariance",
+               (filters[1].getCovariance() - filters[0].getCovariance()).norm_2() < 1e-8);
+  test.boolean("square root update state",
+               (filters[2].getState() - filters[0].getState()).norm_2() < 1e-8);
+  test.boolean("square root update covariance",
+               (filters[2].getCovariance() - filters[0].getCovariance()).norm_2() < 1e-8);
+
+  // Switching methods keeps the estimate.
+  filters[2].setUpdateMethod(Filter6::UM_DENSE);
+  test.boolean("update method switch",
+               (filters[2].getCovariance() - filters[0].getCovariance()).norm_2() < 1e-8);
+
+  delete rnd;
+
+  return test.getReturnValue();
+}
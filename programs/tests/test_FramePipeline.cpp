@@ -0,0 +1,196 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cstring>
+#include <set>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+
+//! Number of frames per run.
+static const unsigned c_count = 200;
+
+//! Processor that stores the complement of the input.
+class Inverter: public FramePipeline::Processor
+{
+public:
+  Inverter(double delay):
+    m_delay(delay)
+  { }
+
+  void
+  process(FramePipeline::Frame& frame)
+  {
+    ByteBuffer* input = frame.getInput();
+    ByteBuffer* output = frame.getOutput();
+    output->setSize(input->getSize());
+
+    for (unsigned i = 0; i < input->getSize(); ++i)
+      output->getBuffer()[i] = ~input->getBuffer()[i];
+
+    frame.setValue(frame.getTimeStamp());
+
+    if (m_delay > 0)
+      Delay::wait(m_delay);
+  }
+
+private:
+  double m_delay;
+};
+
+//! Writer that records the stored frames.
+class Recorder: public FramePipeline::Writer
+{
+public:
+  Recorder(std::vector<unsigned>& ids, bool& valid):
+    m_ids(ids),
+    m_valid(valid)
+  { }
+
+  void
+  write(FramePipeline::Frame& frame)
+  {
+    ByteBuffer* input = frame.getInput();
+    ByteBuffer* output = frame.getOutput();
+    m_ids.push_back((unsigned)frame.getTimeStamp());
+
+    // Unprocessed frame.
+    if (output->getSize() == 0)
+      return;
+
+    if (input->getSize() != output->getSize())
+      m_valid = false;
+
+    for (unsigned i = 0; m_valid && i < input->getSize(); ++i)
+      m_valid = (uint8_t)~input->getBuffer()[i] == output->getBuffer()[i];
+  }
+
+private:
+  std::vector<unsigned>& m_ids;
+  bool& m_valid;
+};
+
+static void
+fill(FramePipeline::Frame* frame, unsigned id)
+{
+  ByteBuffer* input = frame->getInput();
+  input->setSize(1024 + id);
+  std::memset(input->getBuffer(), id & 0xff, input->getSize());
+  frame->setTimeStamp(id);
+}
+
+int
+main(void)
+{
+  Test test("Media::FramePipeline");
+
+  {
+    std::vector<unsigned> ids;
+    bool valid = true;
+    FramePipeline pipeline(8, 1024, 1024, new Recorder(ids, valid));
+    for (unsigned i = 0; i < 4; ++i)
+      pipeline.addProcessor(new Inverter(0));
+    pipeline.start();
+
+    unsigned queued = 0;
+    for (unsigned i = 0; i < c_count; ++i)
+    {
+      FramePipeline::Frame* frame = NULL;
+      while ((frame = pipeline.getFreeFrame()) == NULL)
+        Delay::wait(0.001);
+
+      fill(frame, i);
+      pipeline.put(frame);
+      ++queued;
+    }
+
+    test.boolean("flush()", pipeline.flush(5.0));
+    std::set<unsigned> unique(ids.begin(), ids.end());
+    test.boolean("all frames stored", unique.size() == queued && pipeline.getWriteCount() == queued);
+    test.boolean("processed output", valid);
+
+    double value = 0;
+    test.boolean("getValue()", pipeline.getValue(value) && value < c_count);
+    test.boolean("getValue() returns each value once", !pipeline.getValue(value));
+    test.boolean("getPendingCount()", pipeline.getPendingCount() == 0);
+  }
+
+  {
+    std::vector<unsigned> ids;
+    bool valid = true;
+    FramePipeline pipeline(4, 1024, 1024, new Recorder(ids, valid));
+    pipeline.addProcessor(new Inverter(0.05));
+    pipeline.start();
+
+    unsigned queued = 0;
+    for (unsigned i = 0; i < 10; ++i)
+    {
+      FramePipeline::Frame* frame = pipeline.getFreeFrame();
+      if (frame == NULL)
+        continue;
+
+      fill(frame, i);
+      pipeline.put(frame);
+      ++queued;
+    }
+
+    test.boolean("getFreeFrame() never blocks", queued == 4);
+    test.boolean("getDropCount()", pipeline.getDropCount() == 6);
+    test.boolean("flush() with slow processor", pipeline.flush(5.0) && ids.size() == 4);
+  }
+
+  {
+    std::vector<unsigned> ids;
+    bool valid = true;
+    FramePipeline pipeline(4, 1024, 0, new Recorder(ids, valid));
+    pipeline.start();
+
+    for (unsigned i = 0; i < 4; ++i)
+    {
+      FramePipeline::Frame* frame = pipeline.getFreeFrame();
+      fill(frame, i);
+      pipeline.put(frame);
+    }
+
+    bool ordered = pipeline.flush(5.0) && ids.size() == 4;
+    for (unsigned i = 0; ordered && i < ids.size(); ++i)
+      ordered = ids[i] == i;
+
+    test.boolean("without processors: frames stored in order", ordered);
+  }
+
+  return test.getReturnValue();
+}
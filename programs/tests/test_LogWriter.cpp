@@ -0,0 +1,129 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE::Tasks::LogWriter;
+
+//! Capture and render a format, returning true if the result matches
+//! vsnprintf().
+static bool
+check(const char* format, ...)
+{
+  char expected[1024];
+  char args[2048];
+  char result[1024];
+
+  std::va_list ap;
+  va_start(ap, format);
+  std::vsnprintf(expected, sizeof(expected), format, ap);
+  va_end(ap);
+
+  va_start(ap, format);
+  int rv = LogWriter::capture(args, sizeof(args), format, ap);
+  va_end(ap);
+
+  if (rv < 0)
+    return false;
+
+  LogWriter::render(result, sizeof(result), format, args);
+  if (std::strcmp(expected, result) != 0)
+  {
+    std::fprintf(stderr, "'%s' != '%s'\n", expected, result);
+    return false;
+  }
+
+  return true;
+}
+
+//! Test if a format is rejected by capture().
+static bool
+rejected(const char* format, ...)
+{
+  char args[2048];
+
+  std::va_list ap;
+  va_start(ap, format);
+  int rv = LogWriter::capture(args, sizeof(args), format, ap);
+  va_end(ap);
+
+  return rv < 0;
+}
+
+int
+main(void)
+{
+  Test test("Tasks::LogWriter");
+
+  test.boolean("no arguments", check("plain text 100%% done"));
+  test.boolean("integers", check("%d %i %5d %-5d| %+d %05d", -1, 2, 3, 4, 5, -6));
+  test.boolean("unsigned", check("%u %x %X %#o %08x", 1u, 255u, 255u, 8u, 0xabcu));
+  test.boolean("length modifiers", check("%hhd %hd %ld %lld %lu %llu %zu %jd",
+                                         (signed char)-3, (short)-300, -70000L,
+                                         -5000000000LL, 70000UL, 5000000000ULL,
+                                         (size_t)42, (intmax_t)-7));
+  test.boolean("characters", check("%c%c %3c", 'o', 'k', 'x'));
+  test.boolean("floating point", check("%f %.2f %10.3e %g %G %a", 1.5, 3.14159,
+                                       12345.678, 0.0001, 1e20, 0.5));
+  test.boolean("long double", check("%Lf %.3Lg", 2.5L, 1.0L / 3));
+  test.boolean("strings", check("[%s] [%10s] [%-10s] [%.3s] [%s]", "abc", "right",
+                                "left", "truncated", ""));
+  test.boolean("null string", check("%s", (const char*)NULL));
+  test.boolean("pointer", check("%p", (void*)&test));
+  test.boolean("variable width", check("[%*d] [%-*d] [%*d]", 6, 1, 6, 2, -6, 3));
+  test.boolean("variable precision", check("[%.*f] [%.*s] [%.*f]", 3, 1.0, 2, "abcd", -1, 2.0));
+
+  // Like mavlink text fields: fixed size and not terminated.
+  char* unterminated = new char[50];
+  std::memset(unterminated, 'u', 50);
+  test.boolean("variable precision, unterminated string", check("[%.*s]", 50, unterminated));
+  test.boolean("literal precision, unterminated string", check("[%.50s] [%.5s]", unterminated, unterminated));
+  delete [] unterminated;
+
+  test.boolean("mixed", check("task %s: %u of %d (%.1f%%)", "Monitor", 3u, 10, 30.0));
+
+  std::string longstr(1500, 'x');
+  test.boolean("long string", check("%s", longstr.c_str()));
+
+  test.boolean("positional arguments rejected", rejected("%1$d", 1));
+  test.boolean("wide strings rejected", rejected("%ls", L"abc"));
+  test.boolean("unknown conversion rejected", rejected("%m"));
+
+  return test.getReturnValue();
+}
@@ -0,0 +1,228 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+
+static const unsigned c_messages = 20000;
+static const size_t c_block_size = 16 * 1024;
+
+//! Write an indexed LSF file the same way Transports::Logging does.
+static void
+writeLog(const std::string& file, Compression::Methods method)
+{
+  std::ofstream lsf(file.c_str(), std::ios::binary);
+  std::ofstream idx(IMC::LsfIndex::getPath(file).c_str(), std::ios::binary);
+  std::ofstream blk;
+  Compression::Compressor* com = Compression::Factory::compressor(method);
+
+  uint8_t rec[IMC::LsfIndex::c_record_size];
+  IMC::LsfIndex::encodeHeader(rec);
+  idx.write((char*)rec, IMC::LsfIndex::c_header_size);
+
+  if (com)
+  {
+    blk.open(IMC::LsfIndex::getBlockPath(file).c_str(), std::ios::binary);
+    IMC::LsfIndex::encodeBlockHeader(rec);
+    blk.write((char*)rec, IMC::LsfIndex::c_header_size);
+  }
+
+  Utils::ByteBuffer bfr;
+  Utils::ByteBuffer cbfr;
+  std::vector<char> block;
+  uint64_t offset = 0;
+  uint64_t file_offset = 0;
+  double max_time = 0;
+
+  for (unsigned i = 0; i <= c_messages; ++i)
+  {
+    if (block.size() >= c_block_size || (i == c_messages && !block.empty()))
+    {
+      if (com)
+      {
+        IMC::LsfIndex::Block block_rec;
+        block_rec.offset = offset - block.size();
+        block_rec.file_offset = file_offset;
+        IMC::LsfIndex::encode(block_rec, rec);
+        blk.write((char*)rec, IMC::LsfIndex::c_block_record_size);
+
+        com->compress(cbfr, &block[0], block.size());
+        lsf.write(cbfr.getBufferSigned(), cbfr.getSize());
+        file_offset += cbfr.getSize();
+      }
+      else
+      {
+        lsf.write(&block[0], block.size());
+      }
+
+      block.clear();
+    }
+
+    if (i == c_messages)
+      break;
+
+    IMC::Message* msg = NULL;
+    if (i % 100 == 0)
+    {
+      IMC::EntityInfo* info = new IMC::EntityInfo;
+      info->id = i / 100;
+      msg = info;
+    }
+    else
+    {
+      IMC::Depth* depth = new IMC::Depth;
+      depth->value = i;
+      msg = depth;
+    }
+
+    // Slightly out of order timestamps.
+    msg->setTimeStamp(1000.0 + i * 0.01 + ((i % 7 == 0) ? -0.05 : 0.0));
+    msg->setSourceEntity(i % 256);
+
+    IMC::LsfIndex::Entry entry;
+    entry.timestamp = msg->getTimeStamp();
+    max_time = (i == 0) ? entry.timestamp : std::max(max_time, entry.timestamp);
+    entry.max_time = max_time;
+    entry.offset = offset;
+    entry.id = msg->getId();
+    entry.src = msg->getSource();
+    entry.src_ent = msg->getSourceEntity();
+    IMC::LsfIndex::encode(entry, rec);
+    idx.write((char*)rec, sizeof(rec));
+
+    IMC::Packet::serialize(msg, bfr);
+    block.insert(block.end(), bfr.getBufferSigned(), bfr.getBufferSigned() + bfr.getSize());
+    offset += bfr.getSize();
+    delete msg;
+  }
+
+  delete com;
+}
+
+static void
+testMethod(Test& test, Compression::Methods method)
+{
+  std::string name = Compression::Factory::method(method);
+  std::string file = "test_LsfIndex.lsf" + Compression::Factory::extension(method);
+  writeLog(file, method);
+
+  IMC::LsfIndex index(file);
+  test.boolean((name + ": getEntryCount()").c_str(), index.getEntryCount() == c_messages);
+
+  // First message at or after t = 1150 is message 15000.
+  size_t entry = index.findTime(1150.0);
+  bool ok = entry < index.getEntryCount();
+  for (size_t i = 0; ok && i < entry; ++i)
+    ok = index.getEntry(i).timestamp < 1150.0;
+  test.boolean((name + ": findTime()").c_str(), ok);
+
+  std::istream* is = index.open(entry);
+  IMC::Message* msg = IMC::Packet::deserialize(*is);
+  test.boolean((name + ": open()").c_str(), msg != NULL && msg->getTimeStamp() == index.getEntry(entry).timestamp);
+  delete msg;
+  delete is;
+
+  size_t info = index.findMessage(DUNE_IMC_ENTITYINFO, 12345);
+  test.boolean((name + ": findMessage()").c_str(), info == 12400);
+  test.boolean((name + ": findMessage() range").c_str(),
+               index.findMessage(DUNE_IMC_ENTITYINFO, 12345, 12400) == index.getEntryCount());
+
+  is = index.open(info);
+  msg = IMC::Packet::deserialize(*is);
+  test.boolean((name + ": open() EntityInfo").c_str(),
+               msg != NULL && msg->getId() == DUNE_IMC_ENTITYINFO
+               && static_cast<IMC::EntityInfo*>(msg)->id == 124);
+  delete msg;
+
+  // Reading continues across compressed blocks.
+  unsigned count = 0;
+  while ((msg = IMC::Packet::deserialize(*is)) != NULL)
+  {
+    ++count;
+    delete msg;
+  }
+  test.boolean((name + ": read to end").c_str(), count == c_messages - 12401);
+  delete is;
+
+  test.boolean((name + ": findMessage() not found").c_str(),
+               index.findMessage(DUNE_IMC_TEMPERATURE) == index.getEntryCount());
+
+  std::remove(file.c_str());
+  std::remove(IMC::LsfIndex::getPath(file).c_str());
+  std::remove(IMC::LsfIndex::getBlockPath(file).c_str());
+}
+
+int
+main(void)
+{
+  Test test("IMC::LsfIndex");
+
+  test.boolean("getPath()", IMC::LsfIndex::getPath("log/Data.lsf.gz") == "log/Data.lsf.idx");
+  test.boolean("getBlockPath()", IMC::LsfIndex::getBlockPath("log/Data.lsf.lz4") == "log/Data.lsf.blk");
+
+  // Records are little-endian on every host.
+  IMC::LsfIndex::Entry entry;
+  entry.timestamp = 1.0;
+  entry.max_time = 2.0;
+  entry.offset = 0x0102030405060708ULL;
+  entry.id = 0x1234;
+  entry.src = 0x5678;
+  entry.src_ent = 0x9a;
+  uint8_t rec[IMC::LsfIndex::c_record_size];
+  IMC::LsfIndex::encode(entry, rec);
+  test.boolean("encode() little-endian",
+               rec[7] == 0x3f && rec[6] == 0xf0 && rec[15] == 0x40
+               && rec[16] == 0x08 && rec[23] == 0x01
+               && rec[24] == 0x34 && rec[26] == 0x78 && rec[28] == 0x9a);
+
+  IMC::LsfIndex::Entry copy;
+  IMC::LsfIndex::decode(rec, copy);
+  test.boolean("decode()",
+               copy.timestamp == entry.timestamp && copy.max_time == entry.max_time
+               && copy.offset == entry.offset && copy.id == entry.id
+               && copy.src == entry.src && copy.src_ent == entry.src_ent);
+
+  testMethod(test, Compression::METHOD_UNKNOWN);
+  testMethod(test, Compression::METHOD_GZIP);
+  testMethod(test, Compression::METHOD_LZ4);
+
+  return test.getReturnValue();
+}
@@ -0,0 +1,202 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+
+static const unsigned c_messages = 50000;
+
+int
+main(void)
+{
+  Test test("IMC::LsfReader");
+
+  std::string data;
+  {
+    std::ostringstream os;
+    for (unsigned i = 0; i < c_messages; ++i)
+    {
+      if (i % 3 == 0)
+      {
+        IMC::LogBookEntry entry;
+        entry.text = std::string(i % 1000, 'x');
+        entry.setTimeStamp(i);
+        IMC::Packet::serialize(&entry, os);
+      }
+      else
+      {
+        IMC::Depth depth;
+        depth.value = i;
+        depth.setTimeStamp(i);
+        depth.setSourceEntity(i % 200);
+        IMC::Packet::serialize(&depth, os);
+      }
+    }
+
+    data = os.str();
+  }
+
+  {
+    std::istringstream is(data);
+    IMC::LsfReader reader(is, true);
+
+    unsigned count = 0;
+    bool headers = true;
+    bool decoded = true;
+    std::string copy;
+
+    while (reader.next())
+    {
+      const IMC::Header& hdr = reader.getHeader();
+      headers = headers && hdr.timestamp == count
+        && hdr.mgid == ((count % 3 == 0) ? DUNE_IMC_LOGBOOKENTRY : DUNE_IMC_DEPTH);
+
+      if (hdr.mgid == DUNE_IMC_DEPTH)
+      {
+        IMC::Message* msg = reader.decode();
+        decoded = decoded && static_cast<IMC::Depth*>(msg)->value == count
+          && msg->getSourceEntity() == count % 200;
+        delete msg;
+      }
+
+      copy.append((const char*)reader.getPacket(), reader.getPacketSize());
+      ++count;
+    }
+
+    test.boolean("message count", count == c_messages);
+    test.boolean("headers", headers);
+    test.boolean("decode()", decoded);
+    test.boolean("byte copy", copy == data);
+  }
+
+  {
+    std::string corrupted = data;
+    corrupted[DUNE_IMC_CONST_HEADER_SIZE + 3] ^= 0x55;
+
+    std::istringstream is(corrupted);
+    IMC::LsfReader reader(is);
+    reader.next();
+    test.boolean("isValid() detects corruption", !reader.isValid());
+
+    std::istringstream is_crc(corrupted);
+    IMC::LsfReader reader_crc(is_crc, true);
+    bool thrown = false;
+    try
+    {
+      reader_crc.next();
+    }
+    catch (IMC::InvalidCrc& e)
+    {
+      (void)e;
+      thrown = true;
+    }
+
+    test.boolean("next() validates CRC", thrown);
+  }
+
+  {
+    std::istringstream is(data.substr(0, data.size() - 5));
+    IMC::LsfReader reader(is);
+    bool thrown = false;
+    try
+    {
+      while (reader.next())
+        ;
+    }
+    catch (IMC::BufferTooShort& e)
+    {
+      (void)e;
+      thrown = true;
+    }
+
+    test.boolean("truncated packet", thrown);
+  }
+
+  // File backed readers: mapped (plain, LZ4) and streamed (gzip).
+  const Compression::Methods methods[] = {Compression::METHOD_UNKNOWN,
+                                          Compression::METHOD_LZ4,
+                                          Compression::METHOD_GZIP};
+
+  for (unsigned k = 0; k < sizeof(methods) / sizeof(methods[0]); ++k)
+  {
+    std::string name = Compression::Factory::method(methods[k]);
+    std::string file = "test_LsfReader.lsf" + Compression::Factory::extension(methods[k]);
+
+    if (methods[k] == Compression::METHOD_UNKNOWN)
+    {
+      std::ofstream ofs(file.c_str(), std::ios::binary);
+      ofs.write(data.data(), data.size());
+    }
+    else
+    {
+      Compression::FileOutput ofs(file.c_str(), methods[k]);
+      ofs.write(data.data(), data.size());
+    }
+
+    {
+      IMC::LsfReader reader(file, true);
+      std::string copy;
+      while (reader.next())
+        copy.append((const char*)reader.getPacket(), reader.getPacketSize());
+
+      test.boolean((name + ": file byte copy").c_str(), copy == data);
+    }
+
+    {
+      // Packet 3 starts after two Depth messages and one LogBookEntry.
+      IMC::LsfReader reader(file);
+      reader.next();
+      uint64_t offset = reader.getPacketSize();
+      reader.next();
+      offset += reader.getPacketSize();
+      reader.next();
+      offset += reader.getPacketSize();
+
+      reader.seek(0, offset);
+      IMC::Message* msg = reader.read();
+      test.boolean((name + ": seek()").c_str(), msg != NULL && msg->getTimeStamp() == 3);
+      delete msg;
+    }
+
+    std::remove(file.c_str());
+  }
+
+  return test.getReturnValue();
+}
@@ -0,0 +1,160 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using namespace DUNE::Compression;
+
+static std::vector<char>
+createData(unsigned size)
+{
+  std::vector<char> data(size);
+  uint32_t seed = 1;
+
+  // Mix compressible text with pseudo-random bytes.
+  for (unsigned i = 0; i < size; ++i)
+  {
+    seed = seed * 1103515245 + 12345;
+    if ((i / 1000) % 2)
+      data[i] = (char)(seed >> 16);
+    else
+      data[i] = "lsts dune lz4 "[i % 14];
+  }
+
+  return data;
+}
+
+static std::vector<char>
+roundTrip(const std::vector<char>& data, unsigned chunk, unsigned out_size)
+{
+  Compressor* com = Factory::compressor(METHOD_LZ4);
+  Decompressor* dec = Factory::decompressor(METHOD_LZ4);
+
+  // Concatenate one frame per chunk.
+  DUNE::Utils::ByteBuffer stream;
+  for (unsigned i = 0; i < data.size(); i += chunk)
+  {
+    unsigned len = std::min(chunk, (unsigned)data.size() - i);
+    DUNE::Utils::ByteBuffer frame = com->compress((char*)&data[i], len);
+    stream.append(frame.getBuffer(), frame.getSize());
+  }
+
+  // Decompress with a small output buffer.
+  std::vector<char> out;
+  std::vector<char> bfr(out_size);
+  unsigned long idx = 0;
+  unsigned long rem = stream.getSize();
+  while (true)
+  {
+    dec->decompress(&bfr[0], bfr.size(), stream.getBufferSigned() + idx, rem);
+    idx += dec->processed();
+    rem -= dec->processed();
+    out.insert(out.end(), bfr.begin(), bfr.begin() + dec->decompressed());
+
+    if (dec->decompressed() == 0 && rem == 0)
+      break;
+  }
+
+  delete com;
+  delete dec;
+  return out;
+}
+
+int
+main(void)
+{
+  Test test("Compression::LZ4");
+
+  test.boolean("method(lz4)", Factory::method("lz4") == METHOD_LZ4);
+  test.boolean("extension(lz4)", Factory::extension(METHOD_LZ4) == ".lz4");
+
+  std::vector<char> data = createData(300 * 1024);
+  test.boolean("single frame", roundTrip(data, data.size(), 128 * 1024) == data);
+  test.boolean("concatenated frames", roundTrip(data, 10000, 7) == data);
+
+  {
+    Compressor* com = Factory::compressor(METHOD_LZ4);
+    Decompressor* dec = Factory::decompressor(METHOD_LZ4);
+    DUNE::Utils::ByteBuffer frame = com->compress(&data[0], 0);
+    DUNE::Utils::ByteBuffer out = dec->decompress(frame.getBufferSigned(), frame.getSize());
+    test.boolean("empty frame", out.getSize() == 0 && dec->processed() == frame.getSize());
+    delete com;
+    delete dec;
+  }
+
+  {
+    Compressor* com = Factory::compressor(METHOD_LZ4);
+    Decompressor* dec = Factory::decompressor(METHOD_LZ4);
+    DUNE::Utils::ByteBuffer frame = com->compress(&data[0], 4096);
+    frame.getBuffer()[frame.getSize() - 1] ^= 0xff;
+
+    bool corrupted = false;
+    try
+    {
+      dec->decompress(frame.getBufferSigned(), frame.getSize());
+    }
+    catch (CorruptedData& e)
+    {
+      (void)e;
+      corrupted = true;
+    }
+
+    test.boolean("content checksum", corrupted);
+    delete com;
+    delete dec;
+  }
+
+  {
+    std::string fname = "test_Lz4.lsf.lz4";
+
+    {
+      FileOutput ofs(fname.c_str(), METHOD_LZ4);
+      ofs.write(&data[0], data.size());
+    }
+
+    test.boolean("detect()", Factory::detect(fname.c_str()) == METHOD_LZ4);
+
+    std::vector<char> out(data.size());
+    FileInput ifs(fname.c_str(), METHOD_LZ4);
+    ifs.read(&out[0], out.size());
+    test.boolean("FileInput", ifs.gcount() == (std::streamsize)data.size() && out == data);
+    std::remove(fname.c_str());
+  }
+
+  return test.getReturnValue();
+}
@@ -0,0 +1,138 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using namespace DUNE::Concurrency;
+
+static const unsigned c_producers = 4;
+static const unsigned c_items = 20000;
+
+class Producer: public Thread
+{
+public:
+  Producer(Mailbox<unsigned>& mbox, unsigned id):
+    m_mbox(mbox),
+    m_id(id)
+  { }
+
+  void
+  run(void)
+  {
+    for (unsigned i = 0; i < c_items; ++i)
+      m_mbox.push(m_id * c_items + i);
+  }
+
+private:
+  Mailbox<unsigned>& m_mbox;
+  unsigned m_id;
+};
+
+int
+main(void)
+{
+  Test test("Concurrency::Mailbox");
+
+  {
+    Mailbox<unsigned> mbox(5);
+    test.boolean("getCapacity()", mbox.getCapacity() == 8);
+    test.boolean("empty()", mbox.empty());
+
+    for (unsigned i = 0; i < 20; ++i)
+      mbox.push(i);
+
+    test.boolean("size()", mbox.size() == 20);
+    test.boolean("getOverflowCount()", mbox.getOverflowCount() == 12);
+
+    std::vector<unsigned> out;
+    test.boolean("drain()", mbox.drain(out, 5) == 5 && mbox.size() == 15);
+
+    unsigned v = 0;
+    while (mbox.pop(v))
+      out.push_back(v);
+
+    bool ordered = out.size() == 20;
+    for (unsigned i = 0; ordered && i < out.size(); ++i)
+      ordered = out[i] == i;
+
+    test.boolean("FIFO order with overflow", ordered);
+    test.boolean("waitForItems() timeout", !mbox.waitForItems(0.1));
+  }
+
+  {
+    Mailbox<unsigned> mbox(64);
+    std::vector<Producer*> producers;
+    for (unsigned i = 0; i < c_producers; ++i)
+    {
+      producers.push_back(new Producer(mbox, i));
+      producers[i]->start();
+    }
+
+    std::vector<unsigned> next(c_producers, 0);
+    std::vector<unsigned> batch;
+    unsigned total = 0;
+    bool ordered = true;
+
+    while (total < c_producers * c_items)
+    {
+      if (!mbox.waitForItems(5.0))
+        break;
+
+      batch.clear();
+      mbox.drain(batch, mbox.size());
+      for (unsigned i = 0; i < batch.size(); ++i)
+      {
+        unsigned id = batch[i] / c_items;
+        if (batch[i] % c_items != next[id])
+          ordered = false;
+        next[id] = batch[i] % c_items + 1;
+      }
+
+      total += batch.size();
+    }
+
+    for (unsigned i = 0; i < c_producers; ++i)
+    {
+      producers[i]->join();
+      delete producers[i];
+    }
+
+    test.boolean("multiple producers: all items received", total == c_producers * c_items);
+    test.boolean("multiple producers: per producer order", ordered);
+  }
+
+  return test.getReturnValue();
+}
@@ -0,0 +1,333 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using DUNE_NAMESPACES;
+
+//! Minimal task that records the values of consumed messages.
+class Sink: public AbstractTask
+{
+public:
+  Sink(Context& ctx):
+    m_recipient(this, ctx)
+  {
+    m_recipient.bind(IMC::Temperature::getIdStatic(),
+                     new Consumer<Sink, IMC::Temperature>(*this, &Sink::consume));
+    m_recipient.bind(IMC::Depth::getIdStatic(),
+                     new Consumer<Sink, IMC::Depth>(*this, &Sink::consume));
+  }
+
+  void
+  receive(const IMC::Message* msg)
+  {
+    m_recipient.put(msg);
+  }
+
+  void
+  receive(const IMC::SharedMessage& msg)
+  {
+    m_recipient.put(msg);
+  }
+
+  const char*
+  getName(void) const
+  {
+    return "Sink";
+  }
+
+  void inf(const char*, ...) { }
+  void war(const char*, ...) { }
+  void err(const char*, ...) { }
+  void cri(const char*, ...) { }
+  void debug(const char*, ...) { }
+  void trace(const char*, ...) { }
+  void spew(const char*, ...) { }
+
+  //! Consume all queued messages, including those made available by
+  //! token exchanges.
+  void
+  drain(void)
+  {
+    for (unsigned i = 0; i < 20; ++i)
+      m_recipient.runCallBacks();
+  }
+
+  //! Retrieve the statistics of temperature messages.
+  bool
+  getStatistics(QueueStatistics& qs)
+  {
+    std::vector<QueueStatistics> stats;
+    if (!m_recipient.getQueueStatistics(stats))
+      return false;
+
+    qs = stats[0];
+    return true;
+  }
+
+  Recipient m_recipient;
+  std::vector<int> m_temps;
+  std::vector<int> m_depths;
+
+private:
+  void
+  run(void)
+  { }
+
+  void
+  consume(const IMC::Temperature* msg)
+  {
+    m_temps.push_back((int)msg->value);
+  }
+
+  void
+  consume(const IMC::Depth* msg)
+  {
+    m_depths.push_back((int)msg->value);
+  }
+};
+
+//! Dispatch temperatures with values in [first, last[.
+static void
+dispatch(Context& ctx, int first, int last)
+{
+  IMC::Temperature msg;
+  for (int i = first; i < last; ++i)
+  {
+    msg.value = i;
+    ctx.mbus.dispatch(&msg);
+  }
+}
+
+//! Thread dispatching temperatures.
+class Producer: public Thread
+{
+public:
+  Producer(Context& ctx, int count):
+    m_ctx(ctx),
+    m_count(count)
+  { }
+
+private:
+  Context& m_ctx;
+  int m_count;
+
+  void
+  run(void)
+  {
+    dispatch(m_ctx, 0, m_count);
+  }
+};
+
+static bool
+equals(const std::vector<int>& values, int first, int last)
+{
+  if (values.size() != (size_t)(last - first))
+    return false;
+
+  for (size_t i = 0; i < values.size(); ++i)
+  {
+    if (values[i] != first + (int)i)
+      return false;
+  }
+
+  return true;
+}
+
+int
+main(void)
+{
+  Test test("Tasks::Recipient");
+
+  {
+    Context ctx;
+    Sink sink(ctx);
+    sink.m_recipient.setQueuePolicy(IMC::Temperature::getIdStatic(), 3, QP_DROP_OLDEST);
+    dispatch(ctx, 0, 6);
+    sink.drain();
+
+    QueueStatistics qs;
+    test.boolean("drop oldest: newest messages delivered", equals(sink.m_temps, 3, 6));
+    test.boolean("drop oldest: statistics", sink.getStatistics(qs) && qs.dropped == 3
+                 && qs.coalesced == 0 && qs.size == 0 && qs.limit == 3);
+    test.boolean("statistics only reported when changed", !sink.getStatistics(qs));
+  }
+
+  {
+    Context ctx;
+    Sink sink(ctx);
+    sink.m_recipient.setQueuePolicy(IMC::Temperature::getIdStatic(), 3, QP_DROP_NEWEST);
+    dispatch(ctx, 0, 6);
+    sink.drain();
+
+    QueueStatistics qs;
+    test.boolean("drop newest: oldest messages delivered", equals(sink.m_temps, 0, 3));
+    test.boolean("drop newest: statistics", sink.getStatistics(qs) && qs.dropped == 3);
+  }
+
+  {
+    Context ctx;
+    Sink sink(ctx);
+    sink.m_recipient.setQueuePolicy(IMC::Temperature::getIdStatic(), 2, QP_COALESCE);
+    dispatch(ctx, 0, 6);
+    sink.drain();
+
+    QueueStatistics qs;
+    test.boolean("coalesce: first and latest messages delivered",
+                 sink.m_temps.size() == 2 && sink.m_temps[0] == 0 && sink.m_temps[1] == 5);
+    test.boolean("coalesce: statistics", sink.getStatistics(qs) && qs.coalesced == 4
+                 && qs.dropped == 0);
+  }
+
+  {
+    // Limited and unlimited types interleaved: the main queue holds
+    // one token for temperatures, exchanged on consumption.
+    Context ctx;
+    Sink sink(ctx);
+    sink.m_recipient.setQueuePolicy(IMC::Temperature::getIdStatic(), 10, QP_DROP_OLDEST);
+
+    IMC::Depth depth;
+    for (int i = 0; i < 5; ++i)
+    {
+      dispatch(ctx, i * 2, i * 2 + 2);
+      depth.value = i;
+      ctx.mbus.dispatch(&depth);
+    }
+
+    sink.m_recipient.runCallBacks();
+    test.boolean("token: one limited message per pass", sink.m_temps.size() == 1
+                 && equals(sink.m_depths, 0, 5));
+
+    sink.drain();
+    test.boolean("token: all messages delivered in order", equals(sink.m_temps, 0, 10));
+
+    QueueStatistics qs;
+    test.boolean("token: no statistics without overflow", !sink.getStatistics(qs));
+
+    dispatch(ctx, 10, 12);
+    sink.drain();
+    test.boolean("token: new token after queue emptied", equals(sink.m_temps, 0, 12));
+  }
+
+  {
+    Context ctx;
+    Sink sink(ctx);
+    sink.m_recipient.setQueuePolicy(IMC::Temperature::getIdStatic(), 1, QP_BLOCK);
+
+    Producer producer(ctx, 4);
+    producer.start();
+
+    double deadline = Clock::get() + 5.0;
+    while (sink.m_temps.size() < 4 && Clock::get() < deadline)
+    {
+      Delay::wait(0.05);
+      sink.m_recipient.runCallBacks();
+    }
+
+    producer.join();
+
+    QueueStatistics qs;
+    test.boolean("block: all messages delivered in order", equals(sink.m_temps, 0, 4));
+    test.boolean("block: statistics", sink.getStatistics(qs) && qs.blocked > 0
+                 && qs.dropped == 0);
+  }
+
+  {
+    Context ctx;
+    Sink sink(ctx);
+    sink.m_recipient.setQueuePolicy(IMC::Temperature::getIdStatic(), 1, QP_BLOCK);
+    sink.m_recipient.setConsumerThread();
+
+    // Consumer is busy elsewhere: the producer gives up.
+    Producer producer(ctx, 2);
+    double start = Clock::get();
+    producer.start();
+    producer.join();
+    double elapsed = Clock::get() - start;
+    sink.drain();
+
+    QueueStatistics qs;
+    test.boolean("block: timeout", elapsed > 0.9 && equals(sink.m_temps, 0, 1));
+    test.boolean("block: timeout statistics", sink.getStatistics(qs) && qs.blocked == 1
+                 && qs.dropped == 1);
+  }
+
+  {
+    Context ctx;
+    Sink sink(ctx);
+    Sink other(ctx);
+    sink.m_recipient.setQueuePolicy(IMC::Temperature::getIdStatic(), 1, QP_BLOCK);
+    sink.m_recipient.setConsumerThread();
+
+    // A blocked producer neither delays other recipients nor holds
+    // the bus.
+    Producer producer(ctx, 2);
+    producer.start();
+    Delay::wait(0.2);
+
+    double start = Clock::get();
+    Sink late(ctx);
+    double elapsed = Clock::get() - start;
+    other.drain();
+
+    test.boolean("block: other recipients not delayed", equals(other.m_temps, 0, 2));
+    test.boolean("block: bus not held", elapsed < 0.5);
+
+    producer.join();
+    sink.drain();
+  }
+
+  {
+    Context ctx;
+    Sink sink(ctx);
+    sink.m_recipient.setQueuePolicy(IMC::Temperature::getIdStatic(), 1, QP_BLOCK);
+    sink.m_recipient.setConsumerThread();
+
+    // Loop back: the consumer thread is the producer.
+    double start = Clock::get();
+    dispatch(ctx, 0, 3);
+    double elapsed = Clock::get() - start;
+    sink.drain();
+
+    QueueStatistics qs;
+    test.boolean("block: consumer thread is never blocked", elapsed < 0.5
+                 && equals(sink.m_temps, 0, 1));
+    test.boolean("block: loop back statistics", sink.getStatistics(qs) && qs.blocked == 0
+                 && qs.dropped == 2);
+  }
+
+  return test.getReturnValue();
+}
@@ -0,0 +1,78 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// DUNE headers.
+#include <DUNE/IMC.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using namespace DUNE::IMC;
+
+int
+main(void)
+{
+  Test test("IMC::SharedMessage");
+
+  {
+    SharedMessage empty;
+    test.boolean("null handle", empty.isNull() && empty.getReferenceCount() == 0);
+  }
+
+  {
+    Heartbeat hb;
+    hb.setSource(0x1234);
+
+    SharedMessage a = SharedMessage::copy(hb);
+    test.boolean("copy()", !a.isNull() && a.get() != &hb && a->getSource() == 0x1234);
+    test.boolean("initial reference count", a.getReferenceCount() == 1);
+
+    SharedMessage b(a);
+    SharedMessage c;
+    c = b;
+    test.boolean("instance is shared", a.get() == b.get() && b.get() == c.get());
+    test.boolean("reference count after copies", a.getReferenceCount() == 3);
+
+    b.reset();
+    test.boolean("reset()", b.isNull() && a.getReferenceCount() == 2);
+
+    c = c;
+    test.boolean("self assignment", c.getReferenceCount() == 2);
+  }
+
+  {
+    Heartbeat hb;
+    SharedMessage a = SharedMessage::copy(hb);
+    Heartbeat copy(*static_cast<const Heartbeat*>(a.get()));
+    SharedMessage b = SharedMessage::copy(copy);
+    test.boolean("reference count is not copied", b.getReferenceCount() == 1);
+  }
+
+  return test.getReturnValue();
+}
@@ -0,0 +1,141 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cstring>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using namespace DUNE::Network;
+
+//! Number of datagrams per batch.
+static const unsigned c_count = 100;
+//! Size of the receive buffers.
+static const unsigned c_bfr_size = 2048;
+
+int
+main(void)
+{
+  Test test("Network::UDPSocket");
+
+  UDPSocket rx;
+  UDPSocket tx;
+  uint16_t port = 0;
+
+  for (uint16_t p = 42100; p < 42200; ++p)
+  {
+    try
+    {
+      rx.bind(p, Address::Loopback, false);
+      port = p;
+      break;
+    }
+    catch (std::runtime_error&)
+    { }
+  }
+
+  test.boolean("bind", port != 0);
+
+  std::vector<uint8_t> data(c_count * c_bfr_size);
+  std::vector<UDPSocket::Datagram> out(c_count);
+  for (unsigned i = 0; i < c_count; ++i)
+  {
+    out[i].data = &data[i * c_bfr_size];
+    out[i].size = 1 + i * 7;
+    out[i].address = Address(Address::Loopback);
+    out[i].port = port;
+    std::memset(out[i].data, i, out[i].size);
+  }
+
+  test.boolean("batched write", tx.write(&out[0], c_count) == c_count);
+
+  std::vector<uint8_t> bfr(c_count * c_bfr_size);
+  std::vector<UDPSocket::Datagram> in(c_count);
+  unsigned received = 0;
+  bool valid = true;
+
+  while (received < c_count && DUNE::IO::Poll::poll(rx, 1.0))
+  {
+    for (unsigned i = received; i < c_count; ++i)
+    {
+      in[i].data = &bfr[i * c_bfr_size];
+      in[i].size = c_bfr_size;
+    }
+
+    size_t n = rx.read(&in[received], c_count - received);
+    for (size_t i = received; i < received + n; ++i)
+    {
+      if (in[i].size != out[i].size || std::memcmp(in[i].data, out[i].data, in[i].size) != 0)
+        valid = false;
+
+      if (in[i].address != Address::Loopback)
+        valid = false;
+    }
+
+    received += n;
+  }
+
+  test.boolean("batched read", received == c_count);
+  test.boolean("batched read contents", valid);
+
+  uint8_t single[c_bfr_size];
+  tx.write(out[3].data, out[3].size, Address::Loopback, port);
+  DUNE::IO::Poll::poll(rx, 1.0);
+  in[0].size = c_bfr_size;
+  test.boolean("single write, batched read",
+               rx.read(&in[0], 1) == 1 && in[0].size == out[3].size);
+
+  tx.write(&out[5], 1);
+  DUNE::IO::Poll::poll(rx, 1.0);
+  test.boolean("batched write, single read", rx.read(single, sizeof(single)) == out[5].size);
+
+  // A datagram larger than the UDP limit fails; the others are sent.
+  std::vector<uint8_t> huge(70000);
+  UDPSocket::Datagram batch[3] = {out[1], out[2], out[4]};
+  batch[1].data = &huge[0];
+  batch[1].size = huge.size();
+  test.boolean("failed datagram skipped", tx.write(batch, 3) == 2);
+
+  unsigned after = 0;
+  while (after < 2 && DUNE::IO::Poll::poll(rx, 1.0))
+  {
+    in[after].size = c_bfr_size;
+    after += rx.read(&in[after], 1);
+  }
+
+  test.boolean("datagrams after failure sent",
+               after == 2 && in[0].size == out[1].size && in[1].size == out[4].size);
+
+  return test.getReturnValue();
+}
@@ -0,0 +1,258 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 11 headers.
+#include <atomic>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Test.hpp"
+
+using namespace DUNE::Time;
+using namespace DUNE::Concurrency;
+
+//! Thread that ticks once per virtual second.
+class Ticker: public Thread
+{
+public:
+  Ticker(void):
+    m_ticks(0)
+  { }
+
+  unsigned
+  getTicks(void) const
+  {
+    return m_ticks.load();
+  }
+
+  void
+  run(void)
+  {
+    while (!isStopping() && Clock::isVirtual())
+    {
+      Delay::wait(1.0);
+      ++m_ticks;
+    }
+  }
+
+private:
+  std::atomic<unsigned> m_ticks;
+};
+
+//! Periodic task, ticking once per virtual second, that subscribes
+//! to temperature messages.
+class Subscriber: public DUNE::Tasks::Periodic
+{
+public:
+  Subscriber(DUNE::Tasks::Context& ctx):
+    DUNE::Tasks::Periodic("Subscriber", ctx),
+    m_ticks(0),
+    m_consumed(0)
+  {
+    bind<DUNE::IMC::Temperature>(this);
+  }
+
+  unsigned
+  getTicks(void) const
+  {
+    return m_ticks.load();
+  }
+
+  unsigned
+  getConsumed(void) const
+  {
+    return m_consumed.load();
+  }
+
+  void
+  consume(const DUNE::IMC::Temperature* msg)
+  {
+    (void)msg;
+    ++m_consumed;
+  }
+
+private:
+  std::atomic<unsigned> m_ticks;
+  std::atomic<unsigned> m_consumed;
+
+  void
+  task(void)
+  {
+    ++m_ticks;
+  }
+};
+
+//! Wait, as lockstep clock drivers do, until all messages were
+//! consumed and no thread is busy or a real time timeout expires.
+static bool
+waitDrained(DUNE::IMC::Bus& bus)
+{
+  for (unsigned i = 0; i < 1000; ++i)
+  {
+    if (bus.isDrained() && Clock::getBusyCount() == 0)
+      return true;
+
+    Delay::waitNsec(1000000);
+  }
+
+  return false;
+}
+
+//! Wait until no thread is busy or a real time timeout expires.
+static bool
+waitIdle(void)
+{
+  for (unsigned i = 0; i < 1000; ++i)
+  {
+    if (Clock::getBusyCount() == 0)
+      return true;
+
+    Delay::waitNsec(1000000);
+  }
+
+  return false;
+}
+
+int
+main(void)
+{
+  Test test("Time::Clock (virtual)");
+
+  double start = 1.0e9;
+  Clock::setVirtual(start);
+  test.boolean("isVirtual()", Clock::isVirtual());
+  test.boolean("getSinceEpoch()", Clock::getSinceEpoch() == start);
+
+  double mono = Clock::get();
+  Delay::waitNsec(10000000);
+  test.boolean("frozen", Clock::get() == mono && Clock::getSinceEpoch() == start);
+
+  Clock::advance(start - 10.0);
+  test.boolean("advance() backwards", Clock::getSinceEpoch() == start);
+
+  Ticker ticker;
+  ticker.start();
+
+  // Let the ticker suspend on its first deadline.
+  Delay::waitNsec(50000000);
+  test.boolean("suspended", ticker.getTicks() == 0);
+
+  Clock::advance(start + 0.5);
+  Delay::waitNsec(50000000);
+  test.boolean("deadline not reached", ticker.getTicks() == 0);
+  test.boolean("get() follows virtual time", std::fabs(Clock::get() - mono - 0.5) < 1e-6);
+
+  for (unsigned i = 1; i <= 5; ++i)
+  {
+    Clock::advance(start + i);
+    test.boolean("idle after advance()", waitIdle());
+    test.boolean("one tick per second", ticker.getTicks() == i);
+  }
+
+  // The ticker waits for start + 6.
+  test.boolean("advanceToNextDeadline() bounded", std::fabs(Clock::advanceToNextDeadline(0.25) - 0.25) < 1e-9);
+  test.boolean("waiting for deadline", waitIdle() && ticker.getTicks() == 5);
+  test.boolean("advanceToNextDeadline()", std::fabs(Clock::advanceToNextDeadline(10.0) - 0.75) < 1e-9);
+  test.boolean("deadline reached", waitIdle() && ticker.getTicks() == 6);
+  test.boolean("advanceToNextDeadline() time", Clock::getSinceEpoch() == start + 6);
+
+  Clock::clearVirtual();
+  test.boolean("clearVirtual()", !Clock::isVirtual());
+  ticker.stopAndJoin();
+  test.boolean("real time", std::fabs(Clock::getSinceEpoch() - Clock::getSinceEpochRT()) < 1.0);
+
+  // Periodic task driven like Simulators.Scheduler does.
+  {
+    DUNE::Tasks::Context ctx;
+    Subscriber sub(ctx);
+    sub.loadConfig();
+
+    Clock::setVirtual(start);
+    ctx.mbus.setTracking(true);
+    sub.start();
+
+    // Let the task suspend on its first deadline.
+    Delay::waitNsec(50000000);
+
+    DUNE::IMC::Temperature temp;
+    for (unsigned i = 1; i <= 3; ++i)
+    {
+      ctx.mbus.dispatch(&temp);
+      test.boolean("periodic: consumed before deadline", waitDrained(ctx.mbus) && sub.getConsumed() == i);
+      test.boolean("periodic: no tick before deadline", sub.getTicks() == i - 1);
+
+      Clock::advanceToNextDeadline(10.0);
+      test.boolean("periodic: idle after tick", waitDrained(ctx.mbus));
+      test.boolean("periodic: one tick per step", sub.getTicks() == i);
+    }
+
+    ctx.mbus.setTracking(false);
+    Clock::clearVirtual();
+    sub.stopAndJoin();
+  }
+
+  // Periodic task fed like Transports.Replay does in lockstep mode:
+  // the clock is advanced to the time stamp of each message before
+  // it is dispatched.
+  {
+    DUNE::Tasks::Context ctx;
+    Subscriber sub(ctx);
+    sub.loadConfig();
+
+    Clock::setVirtual(start);
+    ctx.mbus.setTracking(true);
+    sub.start();
+    Delay::waitNsec(50000000);
+
+    DUNE::IMC::Temperature temp;
+    bool drained = true;
+    for (unsigned i = 1; i <= 12; ++i)
+    {
+      double timestamp = start + i * 0.25;
+      Clock::advance(timestamp);
+      drained = waitDrained(ctx.mbus) && drained;
+
+      temp.setTimeStamp(timestamp);
+      ctx.mbus.dispatch(&temp);
+      drained = waitDrained(ctx.mbus) && drained;
+    }
+
+    test.boolean("replay: subscribers drained", drained);
+    test.boolean("replay: all messages consumed", sub.getConsumed() == 12);
+    test.boolean("replay: ticks follow log time", sub.getTicks() == 3);
+
+    ctx.mbus.setTracking(false);
+    Clock::clearVirtual();
+    sub.stopAndJoin();
+  }
+
+  return test.getReturnValue();
+}
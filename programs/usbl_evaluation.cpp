@@ -62,12 +62,7 @@ main(int32_t argc, char** argv)
     std::vector<float> m_bearings;
     float m_sum_ranges = 0.0;
     float m_sum_bearings = 0.0;
-    std::istream* is = 0;
-    DUNE::Compression::Methods method = DUNE::Compression::Factory::detect(argv[i]);
-    if (method == DUNE::Compression::METHOD_UNKNOWN)
-      is = new std::ifstream(argv[i], std::ios::binary);
-    else
-      is = new DUNE::Compression::FileInput(argv[i], method);
+    DUNE::IMC::LsfReader* reader = new DUNE::IMC::LsfReader(argv[i]);
 
     DUNE::IMC::Message* msg = NULL;
 
@@ -78,7 +73,7 @@ main(int32_t argc, char** argv)
 
     try
     {
-      while ((msg = DUNE::IMC::Packet::deserialize(*is)) != 0)
+      while ((msg = reader->read()) != 0)
       {
         if (msg->getId() == DUNE_IMC_LOGGINGCONTROL)
         {
@@ -138,7 +133,7 @@ main(int32_t argc, char** argv)
       std::cerr << "ERROR: " << e.what() << std::endl;
     }
 
-    delete is;
+    delete reader;
 
     if (m_ranges.size() == 0)
     {
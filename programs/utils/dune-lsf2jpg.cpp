@@ -46,12 +46,7 @@ main(int argc, char** argv)
     return 1;
   }
 
-  std::istream* is = 0;
-  Compression::Methods method = Compression::Factory::detect(argv[1]);
-  if (method == METHOD_UNKNOWN)
-    is = new std::ifstream(argv[1], std::ios::binary);
-  else
-    is = new Compression::FileInput(argv[1], method);
+  IMC::LsfReader* reader = new IMC::LsfReader(argv[1]);
 
   DUNE::IMC::Message* msg = NULL;
 
@@ -59,7 +54,7 @@ main(int argc, char** argv)
 
   try
   {
-    while ((msg = DUNE::IMC::Packet::deserialize(*is)) != 0)
+    while ((msg = reader->read()) != 0)
     {
       if (msg->getId() == DUNE_IMC_COMPRESSEDIMAGE)
       {
@@ -78,7 +73,7 @@ main(int argc, char** argv)
     std::cerr << "ERROR: " << e.what() << std::endl;
   }
 
-  delete is;
+  delete reader;
 
   return 0;
 }
@@ -50,8 +50,8 @@ usage(void)
             << "\t-D addr: filter using destination adreess\n"
             << "\t-v [0-2]: verbosity level\n\n"
             << "f1 ... fn can be:\n"
-            << "\t* Gzipped LSF files (.gz extension)\n"
-            << "\t* LLF log dir names (will look for Data.lsf.gz in it)\n"
+            << "\t* Compressed LSF files (.gz, .bz2 or .lz4 extension)\n"
+            << "\t* LLF log dir names (will look for Data.lsf[.gz|.lz4] in it)\n"
             << "\t* plain LSF files\n";
 }
 
@@ -192,13 +192,15 @@ main(int argc, char** argv)
   for (; *argv != 0; argv++)
   {
     Path file(*argv);
-    std::istream* is;
 
     if (file.isDirectory())
     {
-      file = file / "Data.lsf";
+      Path dir = file;
+      file = dir / "Data.lsf";
       if (!file.isFile())
-        file += ".gz";
+        file = dir / "Data.lsf.gz";
+      if (!file.isFile())
+        file = dir / "Data.lsf.lz4";
     }
 
     if (!file.isFile())
@@ -207,35 +209,48 @@ main(int argc, char** argv)
       return 1;
     }
 
-    Compression::Methods method = Compression::Factory::detect(file.c_str());
-    if (method == METHOD_UNKNOWN)
-      is = new std::ifstream(file.c_str(), std::ios::binary);
-    else
-      is = new Compression::FileInput(file.c_str(), method);
-
+    IMC::LsfReader* reader = new IMC::LsfReader(file.str());
     IMC::Message* m;
 
-    m = IMC::Packet::deserialize(*is);
+    m = reader->read();
     if (!m)
     {
       std::cerr << file << " contains no messages\n";
-      delete is;
+      delete reader;
       continue;
     }
 
     DUNE::Utils::ByteBuffer bb;
 
     double time_origin = m->getTimeStamp();
+
+    // Use the index, if available, to skip straight to the begin time.
+    if (begin > 0 && Path(IMC::LsfIndex::getPath(file.str())).isFile())
+    {
+      try
+      {
+        IMC::LsfIndex index(file.str());
+        size_t entry = index.findTime(time_origin + begin);
+        if (entry > 0 && entry < index.getEntryCount())
+        {
+          index.seek(*reader, entry);
+          delete m;
+          m = reader->read();
+        }
+      }
+      catch (std::exception& e)
+      {
+        std::cerr << "ignoring index: " << e.what() << '\n';
+      }
+    }
+
     if (begin >= 0)
     {
-      do
+      while (m && m->getTimeStamp() - time_origin < begin)
       {
-        if (m->getTimeStamp() - time_origin >= begin)
-          break;
         delete m;
-        m = IMC::Packet::deserialize(*is);
+        m = reader->read();
       }
-      while (m);
 
       if (!m)
       {
@@ -287,8 +302,8 @@ main(int argc, char** argv)
       if (end >= 0 && vtime >= end)
         break;
     }
-    while ((m = IMC::Packet::deserialize(*is)) != 0);
-    delete is;
+    while ((m = reader->read()) != 0);
+    delete reader;
   }
   return 0;
 }
@@ -0,0 +1,846 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+// Headless batch runner of Monte-Carlo simulations over VSIM worlds.       *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// ISO C++ 11 headers.
+#include <atomic>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Platform headers.
+#if defined(DUNE_SYS_HAS_UNISTD_H)
+#  include <unistd.h>
+#endif
+
+// VSIM headers.
+#include "Factory.hpp"
+#include <VSIM/VSIM.hpp>
+
+using DUNE_NAMESPACES;
+using Simulators::VSIM::Fin;
+using Simulators::VSIM::UUV;
+using Simulators::VSIM::Vehicle;
+using Simulators::VSIM::World;
+
+//! Configuration section of the attitude controller.
+static const char* c_attitude_section = "Control.AUV.Attitude";
+//! Configuration section of the control allocator.
+static const char* c_allocator_section = "Control.AUV.Allocator";
+//! Depth error below which the vehicle is considered settled (m).
+static const double c_depth_tolerance = 0.5;
+//! Heading error below which the vehicle is considered settled (rad).
+static const double c_heading_tolerance = Angles::radians(5.0);
+//! Fin effect below which a fin does not act on an axis (Nm/rad).
+static const double c_min_effect = 1e-6;
+
+//! Control loops, as in Control.AUV.Attitude.
+enum Loops
+{
+  //! Roll loop.
+  LP_ROLL,
+  //! Pitch loop.
+  LP_PITCH,
+  //! Depth loop.
+  LP_DEPTH,
+  //! Heading loop.
+  LP_HEADING,
+  //! Heading rate loop.
+  LP_HRATE,
+  //! Number of loops.
+  LP_MAX_LOOPS
+};
+
+//! Loop names, as used in the configuration of Control.AUV.Attitude.
+static const char* c_loop_names[LP_MAX_LOOPS] =
+{
+  "Roll", "Pitch", "Depth", "Heading", "Heading Rate"
+};
+
+//! Loop names, as used in the columns of the sets file.
+static const char* c_loop_columns[LP_MAX_LOOPS] =
+{
+  "roll", "pitch", "depth", "heading", "heading_rate"
+};
+
+//! Names of the PID gains, as used in the columns of the sets file.
+static const char* c_gain_suffixes[3] =
+{
+  "_kp", "_ki", "_kd"
+};
+
+//! Parameters of one simulation set, as named in the sets file.
+struct Parameters
+{
+  //! Thruster actuation (-1 to 1).
+  double thrust;
+  //! Desired depth (m).
+  double depth;
+  //! Desired heading (deg).
+  double heading;
+  //! PID gains of each loop: proportional, integral and derivative.
+  double gains[LP_MAX_LOOPS][3];
+  //! Maximum water current speed (m/s).
+  double current;
+  //! Standard deviation of the initial heading error (deg).
+  double heading_spread;
+};
+
+//! Settings of Control.AUV.Attitude other than the gains.
+struct AttitudeSettings
+{
+  //! Integral limits of each loop (rad).
+  float max_int[LP_MAX_LOOPS];
+  //! Maximum fin rotation (rad).
+  float max_fin_rot;
+  //! Enable roll controller.
+  bool roll_control_enabled;
+  //! Maximum pitch actuation (rad).
+  float max_pitch_act;
+  //! Maximum pitch reference (rad).
+  float max_pitch;
+  //! Maximum heading rate reference (rad/s).
+  float max_hrate;
+  //! Heading rate in open loop.
+  bool hrate_oloop;
+  //! Number of pitch steps per depth step.
+  int sampling_rate_relation;
+};
+
+//! Effect of one fin of the vehicle model.
+struct FinEffect
+{
+  //! Fin identifier.
+  unsigned id;
+  //! Torque about each axis per fin rotation at unit speed.
+  double torque[3];
+};
+
+//! Settings of Control.AUV.Allocator and fins of the vehicle model.
+struct AllocatorSettings
+{
+  //! Maximum fin rotation (rad).
+  float max_fin_rot;
+  //! Angle to torque conversion factors (Nm/rad).
+  float conv[3];
+  //! Fins of the vehicle model.
+  std::vector<FinEffect> fins;
+};
+
+//! Names of the metrics of a single run.
+static const char* c_metric_names[] =
+{
+  "depth_rmse",
+  "depth_overshoot",
+  "heading_rmse",
+  "max_roll",
+  "mean_speed",
+  "settling_time"
+};
+
+//! Number of metrics.
+static const unsigned c_metrics = sizeof(c_metric_names) / sizeof(c_metric_names[0]);
+
+//! Result of a single run.
+struct Result
+{
+  //! Index of the parameter set.
+  unsigned set;
+  //! Random seed.
+  int32_t seed;
+  //! Metrics, in the order of c_metric_names.
+  double metrics[c_metrics];
+};
+
+//! Batch description shared by all workers.
+struct Batch
+{
+  //! Vehicle model configuration.
+  Parsers::Config* config;
+  //! Serializes access to the configuration.
+  Concurrency::Mutex config_lock;
+  //! Attitude controller settings.
+  AttitudeSettings attitude;
+  //! Control allocator settings.
+  AllocatorSettings allocator;
+  //! Default parameters, taken from the configuration.
+  Parameters defaults;
+  //! Parameter sets.
+  std::vector<Parameters> sets;
+  //! Number of runs of each set.
+  unsigned runs;
+  //! Seed of the first run.
+  int32_t seed;
+  //! Simulated time of each run (s).
+  double duration;
+  //! Integration time step (s).
+  double time_step;
+  //! Results, one per run.
+  std::vector<Result> results;
+  //! Index of the next run to simulate.
+  std::atomic<unsigned> next;
+};
+
+//! Read the settings and gains of Control.AUV.Attitude and the
+//! settings of Control.AUV.Allocator, with the same names, units and
+//! defaults as those tasks.
+//! @param[in] cfg configuration.
+//! @param[out] batch batch description.
+static void
+readControlSettings(Parsers::Config& cfg, Batch& batch)
+{
+  AttitudeSettings& att = batch.attitude;
+  Parameters& p = batch.defaults;
+
+  p.thrust = 0.7;
+  p.depth = 5.0;
+  p.heading = 90.0;
+  p.current = 0.0;
+  p.heading_spread = 10.0;
+
+  for (unsigned i = 0; i < LP_MAX_LOOPS; ++i)
+  {
+    std::string name = c_loop_names[i];
+    std::vector<double> gains;
+    cfg.get(c_attitude_section, name + " PID Gains", "", gains);
+    if (gains.size() != 3)
+      throw std::runtime_error(String::str("option '%s PID Gains' of section '%s' must have 3 values",
+                                           name.c_str(), c_attitude_section));
+
+    for (unsigned j = 0; j < 3; ++j)
+      p.gains[i][j] = gains[j];
+
+    cfg.get(c_attitude_section, name + " Integral Limit", "-1.0", att.max_int[i]);
+    att.max_int[i] = Angles::radians(att.max_int[i]);
+  }
+
+  cfg.get(c_attitude_section, "Maximum Fin Rotation", "25.0", att.max_fin_rot);
+  cfg.get(c_attitude_section, "Enable roll controller", "false", att.roll_control_enabled);
+  cfg.get(c_attitude_section, "Maximum Pitch Actuation", "15.0", att.max_pitch_act);
+  cfg.get(c_attitude_section, "Maximum Pitch Reference", "10.0", att.max_pitch);
+  cfg.get(c_attitude_section, "Maximum Heading Rate", "45.0", att.max_hrate);
+  cfg.get(c_attitude_section, "Heading Rate Open Loop", "false", att.hrate_oloop);
+  cfg.get(c_attitude_section, "Depth-to-pitch PID sampling rate relation", "1",
+          att.sampling_rate_relation);
+  att.max_fin_rot = Angles::radians(att.max_fin_rot);
+  att.max_pitch_act = Angles::radians(att.max_pitch_act);
+  att.max_pitch = Angles::radians(att.max_pitch);
+  att.max_hrate = Angles::radians(att.max_hrate);
+  att.sampling_rate_relation = std::max(att.sampling_rate_relation, 1);
+
+  AllocatorSettings& alloc = batch.allocator;
+  bool velocity_dependent = false;
+  cfg.get(c_allocator_section, "Maximum Fin Rotation", "25.0", alloc.max_fin_rot);
+  cfg.get(c_allocator_section, "Fin effect K", "0.25", alloc.conv[0]);
+  cfg.get(c_allocator_section, "Fin effect M", "0.5", alloc.conv[1]);
+  cfg.get(c_allocator_section, "Fin effect N", "0.5", alloc.conv[2]);
+  cfg.get(c_allocator_section, "Fin effect Velocity dependent", "false", velocity_dependent);
+  alloc.max_fin_rot = Angles::radians(alloc.max_fin_rot);
+
+  if (velocity_dependent)
+    throw std::runtime_error("velocity dependent fin effects of the allocator are not supported");
+}
+
+//! Read the fins of the vehicle model, as the VSIM Factory does, and
+//! compute the torque each of them produces.
+//! @param[in] cfg configuration.
+//! @param[out] fins fins of the vehicle model.
+static void
+readFins(Parsers::Config& cfg, std::vector<FinEffect>& fins)
+{
+  std::string model;
+  cfg.get("General", "Vehicle Type", "lauv", model);
+  std::string section = "VSIM/Model/" + model;
+
+  unsigned count = 0;
+  cfg.get(section, "Fin Count", "0", count);
+
+  for (unsigned i = 0; i < count; ++i)
+  {
+    std::string idx = String::str(i);
+    double force[3];
+    double position[3];
+
+    if (!cfg.getList(section, "Fin Force " + idx, force, 3)
+        || !cfg.getList(section, "Fin Position " + idx, position, 3))
+      throw std::runtime_error(String::str("invalid fin %u of model '%s'", i, model.c_str()));
+
+    // Forces and torques applied by the fin at unit speed.
+    Fin fin(i, force, position);
+    double forces[6];
+    fin.updateAct(Simulators::VSIM::c_max_act);
+    fin.applyForce(1.0, forces);
+
+    FinEffect effect;
+    effect.id = i;
+    for (unsigned j = 0; j < 3; ++j)
+      effect.torque[j] = forces[3 + j] / Simulators::VSIM::c_max_act;
+    fins.push_back(effect);
+  }
+
+  if (fins.empty())
+    throw std::runtime_error(String::str("model '%s' has no fins", model.c_str()));
+}
+
+//! Read parameter sets from a CSV file. The first line names the
+//! columns; parameters without a column keep their default values.
+//! Gains are named after the loop and the gain, e.g. 'depth_kp' or
+//! 'heading_rate_kd', and map to the "PID Gains" options of
+//! Control.AUV.Attitude.
+//! @param[in] file file name.
+//! @param[in] defaults default parameters.
+//! @param[out] sets parameter sets.
+static void
+readSets(const std::string& file, const Parameters& defaults, std::vector<Parameters>& sets)
+{
+  std::ifstream ifs(file.c_str());
+  if (!ifs.is_open())
+    throw std::runtime_error(String::str("unable to open '%s'", file.c_str()));
+
+  std::map<std::string, size_t> offsets;
+  offsets["thrust"] = offsetof(Parameters, thrust);
+  offsets["depth"] = offsetof(Parameters, depth);
+  offsets["heading"] = offsetof(Parameters, heading);
+  offsets["current"] = offsetof(Parameters, current);
+  offsets["heading_spread"] = offsetof(Parameters, heading_spread);
+
+  for (unsigned i = 0; i < LP_MAX_LOOPS; ++i)
+  {
+    for (unsigned j = 0; j < 3; ++j)
+    {
+      std::string column = std::string(c_loop_columns[i]) + c_gain_suffixes[j];
+      offsets[column] = offsetof(Parameters, gains) + (i * 3 + j) * sizeof(double);
+    }
+  }
+
+  std::string line;
+  std::vector<std::string> header;
+  std::vector<std::string> fields;
+
+  while (std::getline(ifs, line))
+  {
+    line = String::trim(line);
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    fields.clear();
+    String::split(line, ",", fields);
+
+    if (header.empty())
+    {
+      for (unsigned i = 0; i < fields.size(); ++i)
+      {
+        if (offsets.find(fields[i]) == offsets.end())
+          throw std::runtime_error(String::str("unknown parameter '%s'", fields[i].c_str()));
+      }
+
+      header = fields;
+      continue;
+    }
+
+    if (fields.size() != header.size())
+      throw std::runtime_error(String::str("invalid line: %s", line.c_str()));
+
+    Parameters p = defaults;
+
+    for (unsigned i = 0; i < fields.size(); ++i)
+    {
+      double* field = (double*)((char*)&p + offsets[header[i]]);
+      if (!castLexical(fields[i], *field))
+        throw std::runtime_error(String::str("invalid value '%s'", fields[i].c_str()));
+    }
+
+    sets.push_back(p);
+  }
+}
+
+//! Allocate control torques on the fins of the vehicle model, as
+//! Control.AUV.Allocator does: yaw and pitch torques are split evenly
+//! by the fins acting on those axes and the roll torque uses the
+//! remaining fin margin.
+//! @param[in] alloc allocator settings.
+//! @param[in] torques desired torques about x, y and z.
+//! @param[out] fins fin rotations, indexed like the fins of the model.
+static void
+allocate(const AllocatorSettings& alloc, const float torques[3], std::vector<double>& fins)
+{
+  static const unsigned c_order[3] = {2, 1, 0};
+
+  fins.assign(alloc.fins.size(), 0.0);
+  double margin = alloc.max_fin_rot;
+
+  for (unsigned a = 0; a < 3; ++a)
+  {
+    unsigned axis = c_order[a];
+    unsigned count = 0;
+    for (unsigned i = 0; i < alloc.fins.size(); ++i)
+    {
+      if (std::fabs(alloc.fins[i].torque[axis]) > c_min_effect)
+        ++count;
+    }
+
+    if (count == 0)
+      continue;
+
+    double ang = (torques[axis] / alloc.conv[axis]) / count;
+
+    // Roll uses whatever margin yaw and pitch left.
+    double limit = (axis == 0) ? margin : alloc.max_fin_rot;
+    ang = trimValue(ang, -limit, limit);
+
+    for (unsigned i = 0; i < alloc.fins.size(); ++i)
+    {
+      double effect = alloc.fins[i].torque[axis];
+      if (std::fabs(effect) <= c_min_effect)
+        continue;
+
+      fins[i] += (effect > 0) ? ang : -ang;
+      margin = std::min(margin, alloc.max_fin_rot - std::fabs(fins[i]));
+    }
+  }
+}
+
+//! Simulate one run.
+//! @param[in] batch batch description.
+//! @param[in] p parameters.
+//! @param[in,out] result run result; set and seed must be filled.
+static void
+simulate(Batch& batch, const Parameters& p, Result& result)
+{
+  World* world = NULL;
+  Vehicle* vehicle = NULL;
+
+  {
+    Concurrency::ScopedMutex l(batch.config_lock);
+    world = Simulators::VSIM::Factory::produceWorld(*batch.config);
+    vehicle = Simulators::VSIM::Factory::produceVehicle(*batch.config);
+  }
+
+  UUV* uuv = dynamic_cast<UUV*>(vehicle);
+
+  if (world == NULL || uuv == NULL)
+  {
+    delete vehicle;
+    delete world;
+    throw std::runtime_error("error loading VSIM model parameters or model is not an UUV");
+  }
+
+  world->addVehicle(vehicle);
+  world->setTimeStep(batch.time_step);
+
+  Random::Generator* rng = Random::Factory::create(Random::Factory::c_default, result.seed);
+
+  // Randomize initial heading and water current.
+  double heading = Angles::radians(p.heading);
+  double dir = rng->uniform(0, Math::c_two_pi);
+  double speed = rng->uniform(0, p.current);
+  double current[2] = {speed * std::cos(dir), speed * std::sin(dir)};
+
+  vehicle->setPosition(0, 0, 0);
+  vehicle->setOrientation(0, 0, heading + Angles::radians(rng->gaussian(0, p.heading_spread)));
+  vehicle->updateEngine(0, p.thrust);
+
+  // Controllers, configured as Control.AUV.Attitude configures them.
+  const AttitudeSettings& att = batch.attitude;
+  float output_limits[LP_MAX_LOOPS];
+  output_limits[LP_ROLL] = att.max_fin_rot;
+  output_limits[LP_PITCH] = att.max_pitch_act;
+  output_limits[LP_DEPTH] = att.max_pitch;
+  output_limits[LP_HEADING] = att.max_hrate;
+  output_limits[LP_HRATE] = att.max_fin_rot;
+
+  DiscretePID pid[LP_MAX_LOOPS];
+  for (unsigned i = 0; i < LP_MAX_LOOPS; ++i)
+  {
+    std::vector<float> gains(p.gains[i], p.gains[i] + 3);
+    pid[i].setGains(gains);
+    pid[i].setOutputLimits(-output_limits[i], output_limits[i]);
+    pid[i].setIntegralLimits(att.max_int[i]);
+  }
+
+  std::vector<double> fins;
+  float pitch_ref = 0;
+  int depth_steps = att.sampling_rate_relation;
+
+  double depth_sq = 0;
+  double heading_sq = 0;
+  double overshoot = 0;
+  double max_roll = 0;
+  double speed_sum = 0;
+  double settled = 0;
+  unsigned steps = (unsigned)(batch.duration / batch.time_step);
+  double dt = batch.time_step;
+
+  for (unsigned i = 0; i < steps; ++i)
+  {
+    double* pos = vehicle->getPosition();
+    double* att_v = vehicle->getOrientation();
+    double* av = vehicle->getAngularVelocity();
+    double* lv = vehicle->getLinearVelocity();
+
+    double phi = Angles::normalizeRadian(att_v[0]);
+    double theta = Angles::normalizeRadian(att_v[1]);
+    double psi = Angles::normalizeRadian(att_v[2]);
+
+    // Errors.
+    double z = std::max(pos[2], 0.0);
+    double depth_err = p.depth - z;
+    double heading_err = Angles::normalizeRadian(heading - psi);
+
+    // Depth and pitch control.
+    if (++depth_steps >= att.sampling_rate_relation)
+    {
+      depth_steps = 0;
+      double z_rate = -std::sin(theta) * lv[0]
+                      + std::cos(theta) * (std::sin(phi) * lv[1] + std::cos(phi) * lv[2]);
+      pitch_ref = -pid[LP_DEPTH].step(dt, depth_err, -z_rate);
+    }
+
+    double pitch_rate = av[1] * std::cos(phi) - av[2] * std::sin(phi);
+    float torques[3];
+    torques[1] = pid[LP_PITCH].step(dt, pitch_ref - theta, -pitch_rate);
+
+    // Roll control.
+    torques[0] = 0;
+    if (att.roll_control_enabled)
+      torques[0] = pid[LP_ROLL].step(dt, -phi, -(av[0] + std::tan(theta)
+                                                 * (std::sin(phi) * av[1] + std::cos(phi) * av[2])));
+
+    // Heading and heading rate control.
+    double yaw_rate = (std::sin(phi) * av[1] + std::cos(phi) * av[2]) / std::cos(theta);
+    float hrate_ref = pid[LP_HEADING].step(dt, heading_err, -yaw_rate);
+    if (att.hrate_oloop)
+      torques[2] = p.gains[LP_HRATE][0] * hrate_ref;
+    else
+      torques[2] = pid[LP_HRATE].step(dt, hrate_ref - av[2]);
+
+    allocate(batch.allocator, torques, fins);
+    for (unsigned j = 0; j < fins.size(); ++j)
+      uuv->updateFin(batch.allocator.fins[j].id, fins[j]);
+
+    world->takeStep();
+
+    // Water current.
+    pos[0] += batch.time_step * current[0];
+    pos[1] += batch.time_step * current[1];
+
+    // Metrics.
+    depth_sq += depth_err * depth_err;
+    heading_sq += heading_err * heading_err;
+    overshoot = std::max(overshoot, -depth_err);
+    max_roll = std::max(max_roll, std::fabs(phi));
+    speed_sum += lv[0];
+
+    if (std::fabs(depth_err) > c_depth_tolerance || std::fabs(heading_err) > c_heading_tolerance)
+      settled = (i + 1) * batch.time_step;
+  }
+
+  delete rng;
+  delete vehicle;
+  delete world;
+
+  steps = std::max(steps, 1u);
+  result.metrics[0] = std::sqrt(depth_sq / steps);
+  result.metrics[1] = overshoot;
+  result.metrics[2] = Angles::degrees(std::sqrt(heading_sq / steps));
+  result.metrics[3] = Angles::degrees(max_roll);
+  result.metrics[4] = speed_sum / steps;
+  result.metrics[5] = settled;
+}
+
+//! Thread that simulates runs until none is left.
+class Worker: public Concurrency::Thread
+{
+public:
+  Worker(Batch& batch):
+    m_batch(batch)
+  { }
+
+  //! Error message of the first failed run, if any.
+  std::string error;
+
+private:
+  Batch& m_batch;
+
+  void
+  run(void)
+  {
+    while (!isStopping())
+    {
+      unsigned idx = m_batch.next.fetch_add(1);
+      if (idx >= m_batch.results.size())
+        break;
+
+      Result& result = m_batch.results[idx];
+      result.set = idx / m_batch.runs;
+      result.seed = m_batch.seed + idx;
+
+      try
+      {
+        simulate(m_batch, m_batch.sets[result.set], result);
+      }
+      catch (std::exception& e)
+      {
+        error = e.what();
+        break;
+      }
+    }
+  }
+};
+
+//! Write the mean and standard deviation of the metrics of each set.
+//! @param[in] batch finished batch.
+//! @param[in] os output stream.
+static void
+writeSummary(const Batch& batch, std::ostream& os)
+{
+  os << "set,runs";
+  for (unsigned i = 0; i < c_metrics; ++i)
+    os << ',' << c_metric_names[i] << "_mean," << c_metric_names[i] << "_std";
+  os << '\n';
+
+  for (unsigned s = 0; s < batch.sets.size(); ++s)
+  {
+    os << s << ',' << batch.runs;
+
+    for (unsigned i = 0; i < c_metrics; ++i)
+    {
+      double sum = 0;
+      double sum_sq = 0;
+
+      for (unsigned r = 0; r < batch.runs; ++r)
+      {
+        double v = batch.results[s * batch.runs + r].metrics[i];
+        sum += v;
+        sum_sq += v * v;
+      }
+
+      double mean = sum / batch.runs;
+      double var = std::max(0.0, sum_sq / batch.runs - mean * mean);
+      os << ',' << mean << ',' << std::sqrt(var);
+    }
+
+    os << '\n';
+  }
+}
+
+//! Write the metrics of every run.
+//! @param[in] batch finished batch.
+//! @param[in] os output stream.
+static void
+writeRuns(const Batch& batch, std::ostream& os)
+{
+  os << "set,seed";
+  for (unsigned i = 0; i < c_metrics; ++i)
+    os << ',' << c_metric_names[i];
+  os << '\n';
+
+  for (unsigned r = 0; r < batch.results.size(); ++r)
+  {
+    const Result& result = batch.results[r];
+    os << result.set << ',' << result.seed;
+    for (unsigned i = 0; i < c_metrics; ++i)
+      os << ',' << result.metrics[i];
+    os << '\n';
+  }
+}
+
+//! Retrieve the number of online processors.
+static unsigned
+getProcessorCount(void)
+{
+#if defined(DUNE_SYS_HAS_UNISTD_H) && defined(_SC_NPROCESSORS_ONLN)
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  if (count > 0)
+    return (unsigned)count;
+#endif
+  return 1;
+}
+
+int
+main(int argc, char** argv)
+{
+  OptionParser options;
+  options.executable("dune-vsim-batch")
+  .program(DUNE_SHORT_NAME)
+  .copyright(DUNE_COPYRIGHT)
+  .email(DUNE_CONTACT)
+  .version(getFullVersion())
+  .date(getCompileDate())
+  .arch(DUNE_SYSTEM_NAME)
+  .description("Run Monte-Carlo simulations of VSIM vehicles in parallel,"
+               " controlled as Control.AUV.Attitude and Control.AUV.Allocator"
+               " are configured in the configuration file.")
+  .add("-c", "--config-file",
+       "Configuration file with VSIM models", "CONFIG")
+  .add("-m", "--model",
+       "Vehicle model (default: [General] Vehicle Type)", "MODEL")
+  .add("-s", "--sets",
+       "CSV file with one parameter set per line", "FILE")
+  .add("-n", "--runs",
+       "Number of runs of each parameter set (default: 10)", "RUNS")
+  .add("-r", "--seed",
+       "Seed of the first run (default: 1)", "SEED")
+  .add("-t", "--duration",
+       "Simulated time of each run in seconds (default: 120)", "SECONDS")
+  .add("-i", "--time-step",
+       "Integration time step in seconds (default: 0.01)", "SECONDS")
+  .add("-j", "--jobs",
+       "Number of worker threads (default: number of processors)", "JOBS")
+  .add("-o", "--output",
+       "Summary CSV file (default: standard output)", "FILE")
+  .add("-p", "--per-run",
+       "CSV file with the metrics of every run", "FILE");
+
+  // Parse command line arguments.
+  if (!options.parse(argc, argv))
+  {
+    if (options.bad())
+      std::cerr << "ERROR: " << options.error() << std::endl;
+    options.usage();
+    return 1;
+  }
+
+  if (options.value("--config-file").empty())
+  {
+    std::cerr << "ERROR: you must specify one configuration file." << std::endl;
+    return 1;
+  }
+
+  Batch batch;
+  batch.runs = 10;
+  batch.seed = 1;
+  batch.duration = 120.0;
+  batch.time_step = 0.01;
+  batch.next = 0;
+
+  unsigned jobs = getProcessorCount();
+
+  castLexical(options.value("--runs"), batch.runs);
+  castLexical(options.value("--seed"), batch.seed);
+  castLexical(options.value("--duration"), batch.duration);
+  castLexical(options.value("--time-step"), batch.time_step);
+  castLexical(options.value("--jobs"), jobs);
+
+  if (batch.runs == 0 || jobs == 0 || batch.time_step <= 0)
+  {
+    std::cerr << "ERROR: invalid number of runs, jobs or time step." << std::endl;
+    return 1;
+  }
+
+  std::vector<Worker*> workers;
+
+  try
+  {
+    batch.config = new Parsers::Config(options.value("--config-file").c_str());
+    if (!options.value("--model").empty())
+      batch.config->set("General", "Vehicle Type", options.value("--model"));
+
+    // Only underwater vehicles with fins can be controlled.
+    Vehicle* vehicle = Simulators::VSIM::Factory::produceVehicle(*batch.config);
+    bool uuv = (dynamic_cast<UUV*>(vehicle) != NULL);
+    delete vehicle;
+    if (!uuv)
+      throw std::runtime_error("vehicle model is invalid or is not an UUV");
+
+    readControlSettings(*batch.config, batch);
+    readFins(*batch.config, batch.allocator.fins);
+
+    if (options.value("--sets").empty())
+      batch.sets.push_back(batch.defaults);
+    else
+      readSets(options.value("--sets"), batch.defaults, batch.sets);
+
+    batch.results.resize(batch.sets.size() * batch.runs);
+
+    double start = Clock::getRT();
+
+    for (unsigned i = 0; i < jobs; ++i)
+    {
+      workers.push_back(new Worker(batch));
+      workers.back()->start();
+    }
+
+    std::string error;
+    for (unsigned i = 0; i < workers.size(); ++i)
+    {
+      workers[i]->join();
+      if (error.empty())
+        error = workers[i]->error;
+      delete workers[i];
+    }
+    workers.clear();
+
+    if (!error.empty())
+      throw std::runtime_error(error);
+
+    std::fprintf(stderr, "%u runs in %0.2f s\n", (unsigned)batch.results.size(),
+                 Clock::getRT() - start);
+
+    if (options.value("--output").empty())
+    {
+      writeSummary(batch, std::cout);
+    }
+    else
+    {
+      std::ofstream ofs(options.value("--output").c_str());
+      writeSummary(batch, ofs);
+    }
+
+    if (!options.value("--per-run").empty())
+    {
+      std::ofstream ofs(options.value("--per-run").c_str());
+      writeRuns(batch, ofs);
+    }
+  }
+  catch (std::exception& e)
+  {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    for (unsigned i = 0; i < workers.size(); ++i)
+    {
+      workers[i]->stopAndJoin();
+      delete workers[i];
+    }
+    delete batch.config;
+    return 1;
+  }
+
+  delete batch.config;
+  return 0;
+}
@@ -0,0 +1,12 @@
+file(GLOB DUNE_VSIM_BATCH_SOURCES
+  ${PROJECT_SOURCE_DIR}/src/Simulators/VSIM/VSIM/*.cpp)
+
+add_executable(dune-vsim-batch
+  programs/vsim-batch/Main.cpp
+  src/Simulators/VSIM/Factory.cpp
+  ${DUNE_VSIM_BATCH_SOURCES})
+
+set_target_properties(dune-vsim-batch PROPERTIES COMPILE_FLAGS "${DUNE_CXX_FLAGS}")
+target_include_directories(dune-vsim-batch PRIVATE ${PROJECT_SOURCE_DIR}/src/Simulators/VSIM)
+target_link_libraries(dune-vsim-batch dune-core ${DUNE_SYS_LIBS})
+set(DUNE_EXTRA_EXE ${DUNE_EXTRA_EXE} dune-vsim-batch)
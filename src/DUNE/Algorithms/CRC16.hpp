@@ -47,13 +47,29 @@ namespace DUNE
     class CRC16
     {
     public:
-      //! Compute the CRC-16-IBM of a given data buffer.
+      //! Compute the CRC-16-IBM of a given data buffer. Buffers of
+      //! at least 16 bytes are processed eight bytes at a time.
       //! @param buffer data buffer.
       //! @param len data buffer length.
       //! @param crc CRC-16-IBM value to update.
       //! @return computed CRC-16-IBM.
       static inline uint16_t
       compute(const uint8_t* buffer, uint16_t len, uint16_t crc = 0)
+      {
+        if (len >= 16)
+          return computeSlicing8(buffer, len, crc);
+
+        return computeBytewise(buffer, len, crc);
+      }
+
+      //! Compute the CRC-16-IBM of a given data buffer, one byte at
+      //! a time.
+      //! @param buffer data buffer.
+      //! @param len data buffer length.
+      //! @param crc CRC-16-IBM value to update.
+      //! @return computed CRC-16-IBM.
+      static inline uint16_t
+      computeBytewise(const uint8_t* buffer, uint16_t len, uint16_t crc = 0)
       {
         while (len--)
           crc = (crc >> 8) ^ c_crc16_ibm_table[(crc ^ *buffer++) & 0xff];
@@ -61,6 +77,24 @@ namespace DUNE
         return crc;
       }
 
+      //! Compute the CRC-16-IBM of a given data buffer, four bytes
+      //! at a time (slicing-by-4).
+      //! @param buffer data buffer.
+      //! @param len data buffer length.
+      //! @param crc CRC-16-IBM value to update.
+      //! @return computed CRC-16-IBM.
+      static uint16_t
+      computeSlicing4(const uint8_t* buffer, uint16_t len, uint16_t crc = 0);
+
+      //! Compute the CRC-16-IBM of a given data buffer, eight bytes
+      //! at a time (slicing-by-8).
+      //! @param buffer data buffer.
+      //! @param len data buffer length.
+      //! @param crc CRC-16-IBM value to update.
+      //! @return computed CRC-16-IBM.
+      static uint16_t
+      computeSlicing8(const uint8_t* buffer, uint16_t len, uint16_t crc = 0);
+
       //! Compute the CRC-16-IBM of a given byte.
       //! @param byte byte.
       //! @param crc CRC-16-IBM value to update.
@@ -74,9 +74,11 @@ namespace DUNE
       //! @param do_reflect if true, the intermediate results are reflected
       //! @param crc CRC-32 value to update.
       //! @return computed CRC-32.
-      static inline uint32_t 
-      compute(const uint8_t *buf, const uint8_t len, bool do_reflect, uint32_t crc=0)
+      static inline uint32_t
+      compute(const uint8_t *buf, uint32_t len, bool do_reflect, uint32_t crc=0)
       {
+        if (!do_reflect)
+          return computeFast(buf, len, crc);
 
         const uint8_t *end;
         uint8_t data;
@@ -84,11 +86,61 @@ namespace DUNE
         crc = ~crc;
         for (end = buf + len; buf < end; ++buf)
         {
-          data = do_reflect? reflect(*buf,8) : *buf;
+          data = reflect(*buf,8);
           crc = c_crc32_table[(crc ^ data) & 0xff] ^ (crc >> 8);
         }
         return ~crc;
       }
+
+      //! Compute the CRC-32 of a given data buffer using the fastest
+      //! method available on this CPU.
+      //! @param buffer data buffer.
+      //! @param len data buffer length.
+      //! @param crc CRC-32 value to update.
+      //! @return computed CRC-32.
+      static uint32_t
+      computeFast(const uint8_t* buffer, uint32_t len, uint32_t crc = 0);
+
+      //! Compute the CRC-32 of a given data buffer, one byte at a time.
+      //! @param buffer data buffer.
+      //! @param len data buffer length.
+      //! @param crc CRC-32 value to update.
+      //! @return computed CRC-32.
+      static uint32_t
+      computeBytewise(const uint8_t* buffer, uint32_t len, uint32_t crc = 0);
+
+      //! Compute the CRC-32 of a given data buffer, four bytes at a
+      //! time (slicing-by-4).
+      //! @param buffer data buffer.
+      //! @param len data buffer length.
+      //! @param crc CRC-32 value to update.
+      //! @return computed CRC-32.
+      static uint32_t
+      computeSlicing4(const uint8_t* buffer, uint32_t len, uint32_t crc = 0);
+
+      //! Compute the CRC-32 of a given data buffer, eight bytes at a
+      //! time (slicing-by-8).
+      //! @param buffer data buffer.
+      //! @param len data buffer length.
+      //! @param crc CRC-32 value to update.
+      //! @return computed CRC-32.
+      static uint32_t
+      computeSlicing8(const uint8_t* buffer, uint32_t len, uint32_t crc = 0);
+
+      //! Compute the CRC-32 of a given data buffer using carry-less
+      //! multiplication (PCLMULQDQ). Falls back to slicing-by-8 if
+      //! the CPU does not support it.
+      //! @param buffer data buffer.
+      //! @param len data buffer length.
+      //! @param crc CRC-32 value to update.
+      //! @return computed CRC-32.
+      static uint32_t
+      computeCLMUL(const uint8_t* buffer, uint32_t len, uint32_t crc = 0);
+
+      //! Check if carry-less multiplication is available.
+      //! @return true if computeCLMUL() uses PCLMULQDQ, false otherwise.
+      static bool
+      hasCLMUL(void);
     };
   }
 }
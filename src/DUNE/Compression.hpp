@@ -45,8 +45,10 @@ namespace DUNE
 #include <DUNE/Compression/GzipCompressor.hpp>
 #include <DUNE/Compression/Bzip2Compressor.hpp>
 #include <DUNE/Compression/ZlibCompressor.hpp>
+#include <DUNE/Compression/Lz4Compressor.hpp>
 #include <DUNE/Compression/Bzip2Decompressor.hpp>
 #include <DUNE/Compression/ZlibDecompressor.hpp>
+#include <DUNE/Compression/Lz4Decompressor.hpp>
 #include <DUNE/Compression/StreamBuffer.hpp>
 #include <DUNE/Compression/FilterInput.hpp>
 #include <DUNE/Compression/FilterOutput.hpp>
@@ -69,6 +69,19 @@ namespace DUNE
         rdbuf(m_buffer);
       }
 
+      //! Restart decompression at a given position of the file. The
+      //! position must be the beginning of an independently
+      //! compressed unit (e.g., a gzip member or an LZ4 frame).
+      //! @param[in] offset position in the compressed file.
+      void
+      seek(std::streamoff offset)
+      {
+        m_stream.clear();
+        m_stream.seekg(offset);
+        attach(m_stream);
+        clear();
+      }
+
     protected:
       Methods m_method;
       std::ifstream m_stream;
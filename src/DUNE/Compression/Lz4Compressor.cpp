@@ -0,0 +1,129 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <cstring>
+
+// DUNE headers.
+#include <DUNE/Compression/Exceptions.hpp>
+#include <DUNE/Compression/Lz4Compressor.hpp>
+
+// LZ4 headers.
+#include <lz4/lz4.h>
+#include <lz4/lz4hc.h>
+#include <lz4/xxhash.h>
+
+namespace DUNE
+{
+  namespace Compression
+  {
+    //! Frame magic number.
+    static const uint32_t c_magic = 0x184D2204;
+    //! Frame flags: version 01, independent blocks, content checksum.
+    static const uint8_t c_flags = 0x64;
+    //! Block descriptor: 64 KiB maximum block size.
+    static const uint8_t c_block_desc = 0x40;
+    //! Maximum block size.
+    static const unsigned long c_block_size = 64 * 1024;
+    //! Flag signaling an uncompressed block.
+    static const uint32_t c_uncompressed = 0x80000000;
+    //! Size of the frame header (magic, flags, descriptor, checksum).
+    static const unsigned long c_header_size = 7;
+    //! Size of the frame footer (end mark and content checksum).
+    static const unsigned long c_footer_size = 8;
+    //! Minimum level that selects the high compression encoder.
+    static const int c_hc_level = 4;
+
+    static void
+    encodeLE(char* dst, uint32_t value)
+    {
+      dst[0] = (char)(value & 0xff);
+      dst[1] = (char)((value >> 8) & 0xff);
+      dst[2] = (char)((value >> 16) & 0xff);
+      dst[3] = (char)((value >> 24) & 0xff);
+    }
+
+    unsigned long
+    Lz4Compressor::compressBound(unsigned long length) const
+    {
+      unsigned long blocks = (length + c_block_size - 1) / c_block_size;
+      return c_header_size + c_footer_size + blocks * 4 + length;
+    }
+
+    unsigned long
+    Lz4Compressor::compressBlock(char* dst, unsigned long dst_len, char* src, unsigned long src_len)
+    {
+      if (dst_len < c_header_size + c_footer_size)
+        throw BufferTooShort(dst_len);
+
+      // Frame header.
+      encodeLE(dst, c_magic);
+      dst[4] = (char)c_flags;
+      dst[5] = (char)c_block_desc;
+      dst[6] = (char)((XXH32(dst + 4, 2, 0) >> 8) & 0xff);
+
+      unsigned long idx = c_header_size;
+      bool hc = level() >= c_hc_level;
+
+      for (unsigned long offset = 0; offset < src_len; offset += c_block_size)
+      {
+        unsigned long size = std::min(c_block_size, src_len - offset);
+
+        if (idx + 4 + size + c_footer_size > dst_len)
+          throw BufferTooShort(dst_len);
+
+        // Only keep the compressed block if it is smaller.
+        int rv = 0;
+        if (hc)
+          rv = LZ4_compressHC_limitedOutput(src + offset, dst + idx + 4, size, size - 1);
+        else
+          rv = LZ4_compress_limitedOutput(src + offset, dst + idx + 4, size, size - 1);
+
+        if (rv > 0)
+        {
+          encodeLE(dst + idx, (uint32_t)rv);
+          idx += 4 + rv;
+        }
+        else
+        {
+          encodeLE(dst + idx, (uint32_t)size | c_uncompressed);
+          std::memcpy(dst + idx + 4, src + offset, size);
+          idx += 4 + size;
+        }
+      }
+
+      // End mark and content checksum.
+      encodeLE(dst + idx, 0);
+      encodeLE(dst + idx + 4, XXH32(src, src_len, 0));
+
+      return idx + c_footer_size;
+    }
+  }
+}
@@ -0,0 +1,414 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/Compression/Exceptions.hpp>
+#include <DUNE/Compression/Lz4Decompressor.hpp>
+
+// LZ4 headers.
+#include <lz4/lz4.h>
+#include <lz4/xxhash.h>
+
+namespace DUNE
+{
+  namespace Compression
+  {
+    //! Frame magic number.
+    static const uint32_t c_magic = 0x184D2204;
+    //! Skippable frame magic number (lower nibble is user defined).
+    static const uint32_t c_magic_skippable = 0x184D2A50;
+    //! Flag signaling an uncompressed block.
+    static const uint32_t c_uncompressed = 0x80000000;
+    //! Amount of history needed to decode linked blocks.
+    static const unsigned long c_prefix_size = 64 * 1024;
+
+    //! Frame decoding states.
+    enum State
+    {
+      //! Waiting for the frame magic number.
+      ST_MAGIC,
+      //! Waiting for the frame descriptor.
+      ST_DESCRIPTOR,
+      //! Waiting for the size of a skippable frame.
+      ST_SKIP_SIZE,
+      //! Skipping the contents of a skippable frame.
+      ST_SKIP,
+      //! Waiting for a block size.
+      ST_BLOCK_SIZE,
+      //! Waiting for block data.
+      ST_BLOCK_DATA,
+      //! Waiting for a block checksum.
+      ST_BLOCK_CRC,
+      //! Waiting for the content checksum.
+      ST_CONTENT_CRC
+    };
+
+    static uint32_t
+    decodeLE(const char* src)
+    {
+      const uint8_t* ptr = (const uint8_t*)src;
+      return ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | ((uint32_t)ptr[3] << 24);
+    }
+
+    struct Lz4Decompressor::PrivateData
+    {
+      //! Current decoding state.
+      State state;
+      //! Partially received frame fields.
+      std::vector<char> input;
+      //! Number of bytes needed to complete the current field.
+      unsigned long need;
+      //! Number of bytes left in a skippable frame.
+      unsigned long skip;
+      //! Maximum block size of the current frame.
+      unsigned long block_max;
+      //! True if blocks depend on previous blocks.
+      bool linked;
+      //! True if blocks are followed by a checksum.
+      bool block_crc;
+      //! True if the frame ends with a content checksum.
+      bool content_crc;
+      //! True if the current block is stored uncompressed.
+      bool block_raw;
+      //! Checksum of the current block.
+      uint32_t block_hash;
+      //! Content checksum state.
+      XXH32_stateSpace_t content_hash;
+      //! History followed by the last decoded block.
+      std::vector<char> output;
+      //! Size of the last decoded block.
+      unsigned long output_size;
+      //! Index of the next decoded byte to deliver.
+      unsigned long output_idx;
+      //! True if history is available for linked blocks.
+      bool history;
+      //! True if one consumed byte was reported as unprocessed.
+      bool hold;
+
+      unsigned long
+      pending(void) const
+      {
+        return output_size - output_idx;
+      }
+    };
+
+    Lz4Decompressor::Lz4Decompressor(void):
+      Decompressor()
+    {
+      m_private = new PrivateData;
+      clear();
+    }
+
+    Lz4Decompressor::~Lz4Decompressor(void)
+    {
+      delete m_private;
+    }
+
+    void
+    Lz4Decompressor::clear(void)
+    {
+      PrivateData* p = m_private;
+      p->state = ST_MAGIC;
+      p->input.clear();
+      p->need = 4;
+      p->skip = 0;
+      p->block_max = 0;
+      p->linked = false;
+      p->block_crc = false;
+      p->content_crc = false;
+      p->block_raw = false;
+      p->block_hash = 0;
+      p->output_size = 0;
+      p->output_idx = 0;
+      p->history = false;
+      p->hold = false;
+    }
+
+    unsigned long
+    Lz4Decompressor::flush(char* dst, unsigned long dst_len)
+    {
+      PrivateData* p = m_private;
+      unsigned long size = std::min(p->pending(), dst_len);
+      if (size == 0)
+        return 0;
+
+      std::memcpy(dst, &p->output[c_prefix_size + p->output_idx], size);
+      p->output_idx += size;
+      return size;
+    }
+
+    void
+    Lz4Decompressor::parseHeader(void)
+    {
+      PrivateData* p = m_private;
+      uint8_t flags = (uint8_t)p->input[4];
+      uint8_t desc = (uint8_t)p->input[5];
+
+      // First pass: compute the full descriptor size.
+      if (p->need == 6)
+      {
+        if ((flags >> 6) != 1)
+          throw CorruptedData();
+
+        p->need += 1;
+        if (flags & 0x08)
+          p->need += 8;
+        if (flags & 0x01)
+          p->need += 4;
+
+        return;
+      }
+
+      uint8_t hc = (uint8_t)((XXH32(&p->input[4], p->need - 5, 0) >> 8) & 0xff);
+      if (hc != (uint8_t)p->input[p->need - 1])
+        throw CorruptedData();
+
+      unsigned bsid = (desc >> 4) & 0x07;
+      if (bsid < 4)
+        throw CorruptedData();
+
+      p->block_max = 1UL << (8 + 2 * bsid);
+      p->linked = (flags & 0x20) == 0;
+      p->block_crc = (flags & 0x10) != 0;
+      p->content_crc = (flags & 0x04) != 0;
+      p->history = false;
+      p->output_size = 0;
+      p->output_idx = 0;
+      p->output.resize(c_prefix_size + p->block_max);
+
+      if (p->content_crc)
+        XXH32_resetState(&p->content_hash, 0);
+    }
+
+    void
+    Lz4Decompressor::decodeBlock(const char* src, unsigned long src_len)
+    {
+      PrivateData* p = m_private;
+      char* prefix = &p->output[0];
+      char* block = &p->output[c_prefix_size];
+
+      // Keep the last 64 KiB of decoded data as history.
+      if (p->linked && p->output_size > 0)
+      {
+        unsigned long size = p->output_size;
+        if (size >= c_prefix_size)
+        {
+          std::memcpy(prefix, block + size - c_prefix_size, c_prefix_size);
+        }
+        else
+        {
+          std::memmove(prefix, prefix + size, c_prefix_size - size);
+          std::memcpy(prefix + c_prefix_size - size, block, size);
+        }
+
+        p->history = true;
+      }
+
+      int rv = 0;
+      if (p->block_raw)
+      {
+        std::memcpy(block, src, src_len);
+        rv = (int)src_len;
+      }
+      else if (p->history)
+      {
+        rv = LZ4_decompress_safe_withPrefix64k(src, block, src_len, p->block_max);
+      }
+      else
+      {
+        rv = LZ4_decompress_safe(src, block, src_len, p->block_max);
+      }
+
+      if (rv < 0)
+        throw CorruptedData();
+
+      if (p->block_crc)
+        p->block_hash = XXH32(src, src_len, 0);
+
+      if (p->content_crc)
+        XXH32_update(&p->content_hash, block, rv);
+
+      p->output_size = rv;
+      p->output_idx = 0;
+    }
+
+    unsigned long
+    Lz4Decompressor::decompressBlock(char* dst, unsigned long dst_len, char* src, unsigned long src_len, unsigned long& unprocessed_len)
+    {
+      PrivateData* p = m_private;
+
+      unsigned long produced = flush(dst, dst_len);
+      if (p->pending() > 0)
+      {
+        unprocessed_len = src_len;
+        return produced;
+      }
+
+      unsigned long idx = 0;
+      if (p->hold && src_len > 0)
+      {
+        p->hold = false;
+        idx = 1;
+      }
+
+      while (idx < src_len && produced < dst_len)
+      {
+        if (p->state == ST_SKIP)
+        {
+          unsigned long size = std::min(p->skip, src_len - idx);
+          idx += size;
+          p->skip -= size;
+          if (p->skip == 0)
+          {
+            p->state = ST_MAGIC;
+            p->need = 4;
+          }
+          continue;
+        }
+
+        // Decode complete blocks straight from the input buffer.
+        if (p->state == ST_BLOCK_DATA && p->input.empty() && (src_len - idx) >= p->need)
+        {
+          decodeBlock(src + idx, p->need);
+          idx += p->need;
+        }
+        else
+        {
+          unsigned long size = std::min(p->need - p->input.size(), src_len - idx);
+          p->input.insert(p->input.end(), src + idx, src + idx + size);
+          idx += size;
+          if (p->input.size() < p->need)
+            break;
+
+          if (p->state == ST_BLOCK_DATA)
+            decodeBlock(&p->input[0], p->need);
+        }
+
+        switch (p->state)
+        {
+          case ST_MAGIC:
+            {
+              uint32_t magic = decodeLE(&p->input[0]);
+              if (magic == c_magic)
+              {
+                p->state = ST_DESCRIPTOR;
+                p->need = 6;
+                continue;
+              }
+
+              if ((magic & 0xfffffff0) != c_magic_skippable)
+                throw CorruptedData();
+
+              p->state = ST_SKIP_SIZE;
+              p->need = 4;
+            }
+            break;
+
+          case ST_DESCRIPTOR:
+            parseHeader();
+            if (p->input.size() < p->need)
+              continue;
+
+            p->state = ST_BLOCK_SIZE;
+            p->need = 4;
+            break;
+
+          case ST_SKIP_SIZE:
+            p->skip = decodeLE(&p->input[0]);
+            p->state = (p->skip > 0) ? ST_SKIP : ST_MAGIC;
+            p->need = 4;
+            break;
+
+          case ST_BLOCK_SIZE:
+            {
+              uint32_t size = decodeLE(&p->input[0]);
+              if (size == 0)
+              {
+                p->state = p->content_crc ? ST_CONTENT_CRC : ST_MAGIC;
+                p->need = 4;
+                break;
+              }
+
+              p->block_raw = (size & c_uncompressed) != 0;
+              p->need = size & ~c_uncompressed;
+              if (p->need > p->block_max)
+                throw CorruptedData();
+
+              p->state = ST_BLOCK_DATA;
+            }
+            break;
+
+          case ST_BLOCK_DATA:
+            produced += flush(dst + produced, dst_len - produced);
+            p->state = p->block_crc ? ST_BLOCK_CRC : ST_BLOCK_SIZE;
+            p->need = 4;
+            break;
+
+          case ST_BLOCK_CRC:
+            if (decodeLE(&p->input[0]) != p->block_hash)
+              throw CorruptedData();
+
+            p->state = ST_BLOCK_SIZE;
+            p->need = 4;
+            break;
+
+          case ST_CONTENT_CRC:
+            if (decodeLE(&p->input[0]) != XXH32_intermediateDigest(&p->content_hash))
+              throw CorruptedData();
+
+            p->state = ST_MAGIC;
+            p->need = 4;
+            break;
+
+          case ST_SKIP:
+            break;
+        }
+
+        p->input.clear();
+      }
+
+      // Decoded data is still pending but the input was exhausted:
+      // report the last byte as unprocessed so that the caller keeps
+      // calling us before reaching end-of-file.
+      if (p->pending() > 0 && idx > 0)
+      {
+        --idx;
+        p->hold = true;
+      }
+
+      unprocessed_len = src_len - idx;
+      return produced;
+    }
+  }
+}
@@ -39,6 +39,7 @@ namespace DUNE
       METHOD_ZLIB,
       METHOD_GZIP,
       METHOD_BZIP2,
+      METHOD_LZ4,
       METHOD_UNKNOWN
     };
   }
@@ -91,18 +91,21 @@ namespace DUNE
     bool
     Condition::wait(double t)
     {
+      // A thread woken by virtual time is done with its work when it
+      // blocks.
+      Time::Clock::setIdle();
+
 #if defined(DUNE_SYS_HAS_PTHREAD_COND)
       int rv = 0;
 
       if (t > 0)
       {
+        // The deadline is always given in real time, since the clock
+        // may be accelerated or virtual.
         if (Time::Clock::getTimeMultiplier() != 1.0)
-        {
           t /= Time::Clock::getTimeMultiplier();
-          t += m_clock_monotonic ? Time::Clock::getRT() : Time::Clock::getSinceEpochRT();
-        }
-        else
-          t += m_clock_monotonic ? Time::Clock::get() : Time::Clock::getSinceEpoch();
+
+        t += m_clock_monotonic ? Time::Clock::getRT() : Time::Clock::getSinceEpochRT();
 
         timespec ts = DUNE_TIMESPEC_INIT_SEC_FP(t);
         rv = pthread_cond_timedwait(&m_cond, &m_mutex, &ts);
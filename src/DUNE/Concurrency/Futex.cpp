@@ -0,0 +1,101 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+
+// DUNE headers.
+#include <DUNE/Concurrency/Futex.hpp>
+#include <DUNE/Concurrency/ScopedCondition.hpp>
+#include <DUNE/Time/Clock.hpp>
+#include <DUNE/Time/Utils.hpp>
+
+// Linux headers.
+#if defined(DUNE_CONCURRENCY_FUTEX_LINUX)
+#  include <linux/futex.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+namespace DUNE
+{
+  namespace Concurrency
+  {
+    Futex::Futex(void):
+      m_word(0)
+    { }
+
+    bool
+    Futex::wait(int expected, double timeout)
+    {
+      // A thread woken by virtual time is done with its work when it
+      // blocks.
+      if (timeout != 0)
+        Time::Clock::setIdle();
+
+      if (Time::Clock::getTimeMultiplier() != 1.0 && timeout > 0)
+        timeout /= Time::Clock::getTimeMultiplier();
+
+#if defined(DUNE_CONCURRENCY_FUTEX_LINUX)
+      timespec ts = DUNE_TIMESPEC_INIT_SEC_FP(timeout);
+      timespec* tsp = (timeout < 0) ? NULL : &ts;
+
+      int rv = syscall(SYS_futex, reinterpret_cast<int*>(&m_word),
+                       FUTEX_WAIT_PRIVATE, expected, tsp, NULL, 0);
+
+      return !(rv == -1 && errno == ETIMEDOUT);
+#else
+      ScopedCondition l(m_cond);
+      if (m_word.load() != expected)
+        return true;
+
+      if (timeout == 0)
+        return false;
+
+      return m_cond.wait(timeout);
+#endif
+    }
+
+    void
+    Futex::wake(void)
+    {
+#if defined(DUNE_CONCURRENCY_FUTEX_LINUX)
+      ++m_word;
+      syscall(SYS_futex, reinterpret_cast<int*>(&m_word),
+              FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+      ScopedCondition l(m_cond);
+      ++m_word;
+      m_cond.broadcast();
+#endif
+    }
+  }
+}
@@ -0,0 +1,103 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+#ifndef DUNE_CONCURRENCY_FUTEX_HPP_INCLUDED_
+#define DUNE_CONCURRENCY_FUTEX_HPP_INCLUDED_
+
+// ISO C++ 11 headers.
+#include <atomic>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/Concurrency/Condition.hpp>
+
+// Use the futex system call when available.
+#if defined(DUNE_SYS_HAS_LINUX_FUTEX_H) && defined(DUNE_SYS_HAS_SYS_SYSCALL_H)
+#  ifndef DUNE_CONCURRENCY_FUTEX_LINUX
+#    define DUNE_CONCURRENCY_FUTEX_LINUX
+#  endif
+#endif
+
+namespace DUNE
+{
+  namespace Concurrency
+  {
+    // Export DLL Symbol.
+    class DUNE_DLL_SYM Futex;
+
+    //! Wait/wake primitive built around a 32-bit sequence
+    //! number. Waiters sleep while the sequence number matches an
+    //! expected value, wakers increment it. On Linux this maps
+    //! directly to the futex system call and wakers do not need to
+    //! take a lock. On other systems a condition variable is used.
+    class Futex
+    {
+    public:
+      Futex(void);
+
+      //! Retrieve the current sequence number.
+      //! @return sequence number.
+      int
+      value(void) const
+      {
+        return m_word.load();
+      }
+
+      //! Block the calling thread while the sequence number is equal
+      //! to a given value.
+      //! @param[in] expected expected sequence number.
+      //! @param[in] timeout timeout in seconds, use a negative number
+      //! to wait forever.
+      //! @return false if the timeout expired, true otherwise.
+      bool
+      wait(int expected, double timeout = -1.0);
+
+      //! Increment the sequence number and wake all waiting threads.
+      void
+      wake(void);
+
+    private:
+      //! Sequence number.
+      std::atomic<int> m_word;
+#if !defined(DUNE_CONCURRENCY_FUTEX_LINUX)
+      //! Condition for the generic implementation.
+      Condition m_cond;
+#endif
+
+      // Non - copyable.
+      Futex(const Futex&);
+
+      // Non - assignable
+      Futex&
+      operator=(const Futex&);
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,313 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+#ifndef DUNE_CONCURRENCY_MAILBOX_HPP_INCLUDED_
+#define DUNE_CONCURRENCY_MAILBOX_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+// ISO C++ 11 headers.
+#include <atomic>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/Concurrency/Futex.hpp>
+#include <DUNE/Concurrency/Mutex.hpp>
+#include <DUNE/Concurrency/ScopedMutex.hpp>
+
+namespace DUNE
+{
+  namespace Concurrency
+  {
+    //! Multiple-producer single-consumer FIFO. Items are stored in a
+    //! bounded lock-free ring buffer; producers never block and the
+    //! consumer is woken through a Futex only when it is sleeping.
+    //! When the ring is full, items are spilled to a locked overflow
+    //! list until the consumer catches up, so no item is ever lost.
+    //! Only one thread may call pop(), drain() and waitForItems().
+    template <typename T>
+    class Mailbox
+    {
+    public:
+      //! Constructor.
+      //! @param[in] capacity ring buffer capacity, rounded up to the
+      //! next power of two.
+      Mailbox(size_t capacity = 256):
+        m_mask(roundCapacity(capacity) - 1),
+        m_cells(m_mask + 1),
+        m_head(0),
+        m_tail(0),
+        m_spilled(0),
+        m_overflows(0),
+        m_sleeping(false)
+      {
+        for (size_t i = 0; i <= m_mask; ++i)
+          m_cells[i].seq.store(i, std::memory_order_relaxed);
+      }
+
+      //! Add an item to the end of the queue, waking the consumer if
+      //! needed. May be called from any thread.
+      //! @param[in] v item.
+      void
+      push(const T& v)
+      {
+        if (m_spilled.load() != 0 || !tryPush(v))
+        {
+          ScopedMutex l(m_spill_lock);
+          m_spill.push_back(v);
+          ++m_spilled;
+          ++m_overflows;
+        }
+
+        notify();
+      }
+
+      //! Remove the item at the front of the queue.
+      //! @param[out] v item.
+      //! @return true if an item was removed, false if the queue is
+      //! empty.
+      bool
+      pop(T& v)
+      {
+        if (tryPop(v))
+          return true;
+
+        if (m_spilled.load() == 0)
+          return false;
+
+        ScopedMutex l(m_spill_lock);
+        if (m_spill.empty())
+          return false;
+
+        v = m_spill.front();
+        m_spill.pop_front();
+        --m_spilled;
+        return true;
+      }
+
+      //! Remove up to a given number of items from the front of the
+      //! queue, appending them to a vector.
+      //! @param[out] out output vector.
+      //! @param[in] max maximum number of items to remove.
+      //! @return number of items removed.
+      size_t
+      drain(std::vector<T>& out, size_t max)
+      {
+        size_t count = 0;
+        T v;
+
+        while (count < max && pop(v))
+        {
+          out.push_back(v);
+          ++count;
+        }
+
+        return count;
+      }
+
+      //! Wait for items to be available.
+      //! @param[in] timeout timeout in seconds, use a negative number
+      //! to wait forever.
+      //! @return true if at least one item is available, false
+      //! otherwise.
+      bool
+      waitForItems(double timeout = -1.0)
+      {
+        if (!empty())
+          return true;
+
+        int seq = m_futex.value();
+        m_sleeping.store(true);
+
+        if (empty())
+          m_futex.wait(seq, timeout);
+
+        m_sleeping.store(false);
+        return !empty();
+      }
+
+      //! Test if the queue is empty.
+      //! @return true if the queue is empty, false otherwise.
+      bool
+      empty(void) const
+      {
+        return size() == 0;
+      }
+
+      //! Retrieve the number of items in the queue. The value is only
+      //! exact if no other thread is modifying the queue.
+      //! @return number of items.
+      size_t
+      size(void) const
+      {
+        size_t tail = m_tail.load();
+        size_t head = m_head.load();
+        return (tail - head) + m_spilled.load();
+      }
+
+      //! Retrieve the capacity of the ring buffer.
+      //! @return capacity.
+      size_t
+      getCapacity(void) const
+      {
+        return m_mask + 1;
+      }
+
+      //! Retrieve the number of items that did not fit in the ring
+      //! buffer since the queue was created.
+      //! @return number of overflowed items.
+      size_t
+      getOverflowCount(void) const
+      {
+        return m_overflows.load();
+      }
+
+    private:
+      //! Ring buffer cell.
+      struct Cell
+      {
+        Cell(void):
+          seq(0)
+        { }
+
+        Cell(const Cell& other):
+          seq(other.seq.load()),
+          data(other.data)
+        { }
+
+        //! Sequence number used to synchronize producers and consumer.
+        std::atomic<size_t> seq;
+        //! Item.
+        T data;
+      };
+
+      //! Cache line size used to keep indexes apart.
+      static const size_t c_line = 64;
+      //! Index mask.
+      const size_t m_mask;
+      //! Ring buffer.
+      std::vector<Cell> m_cells;
+      char m_pad0[c_line];
+      //! Consumer index.
+      std::atomic<size_t> m_head;
+      char m_pad1[c_line];
+      //! Producer index.
+      std::atomic<size_t> m_tail;
+      char m_pad2[c_line];
+      //! Number of spilled items.
+      std::atomic<size_t> m_spilled;
+      //! Number of items that overflowed the ring buffer.
+      std::atomic<size_t> m_overflows;
+      //! True if the consumer is (about to be) sleeping.
+      std::atomic<bool> m_sleeping;
+      //! Consumer wake-up primitive.
+      Futex m_futex;
+      //! Overflow list.
+      std::deque<T> m_spill;
+      //! Overflow list lock.
+      Mutex m_spill_lock;
+
+      static size_t
+      roundCapacity(size_t capacity)
+      {
+        size_t rv = 2;
+        while (rv < capacity)
+          rv <<= 1;
+        return rv;
+      }
+
+      bool
+      tryPush(const T& v)
+      {
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+          Cell& cell = m_cells[pos & m_mask];
+          size_t seq = cell.seq.load(std::memory_order_acquire);
+          ptrdiff_t diff = (ptrdiff_t)seq - (ptrdiff_t)pos;
+
+          if (diff == 0)
+          {
+            if (m_tail.compare_exchange_weak(pos, pos + 1))
+            {
+              cell.data = v;
+              cell.seq.store(pos + 1, std::memory_order_release);
+              return true;
+            }
+          }
+          else if (diff < 0)
+          {
+            return false;
+          }
+          else
+          {
+            pos = m_tail.load(std::memory_order_relaxed);
+          }
+        }
+      }
+
+      bool
+      tryPop(T& v)
+      {
+        size_t pos = m_head.load(std::memory_order_relaxed);
+        Cell& cell = m_cells[pos & m_mask];
+        size_t seq = cell.seq.load(std::memory_order_acquire);
+
+        if ((ptrdiff_t)seq - (ptrdiff_t)(pos + 1) < 0)
+          return false;
+
+        v = cell.data;
+        cell.data = T();
+        cell.seq.store(pos + m_mask + 1, std::memory_order_release);
+        m_head.store(pos + 1, std::memory_order_relaxed);
+        return true;
+      }
+
+      void
+      notify(void)
+      {
+        if (m_sleeping.load())
+          m_futex.wake();
+      }
+
+      // Non - copyable.
+      Mailbox(const Mailbox&);
+
+      // Non - assignable
+      Mailbox&
+      operator=(const Mailbox&);
+    };
+  }
+}
+
+#endif
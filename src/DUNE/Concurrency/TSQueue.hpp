@@ -77,7 +77,7 @@ namespace DUNE
           m_queue.pop();
           return v;
         }
-        return 0;
+        return T();
       }
 
       //! Wait for items to be available.
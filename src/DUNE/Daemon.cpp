@@ -40,6 +40,7 @@
 #include <DUNE/I18N.hpp>
 #include <DUNE/Tasks/Factory.hpp>
 #include <DUNE/Tasks/Manager.hpp>
+#include <DUNE/Tasks/LogWriter.hpp>
 #include <DUNE/FileSystem/Path.hpp>
 #include <DUNE/Time/Delay.hpp>
 #include <DUNE/Utils/String.hpp>
@@ -138,6 +139,9 @@ namespace DUNE
 
     m_tman = new DUNE::Tasks::Manager(m_ctx);
 
+    // From now on, log entries are written by a background thread.
+    Tasks::LogWriter::start();
+
     bind<IMC::RestartSystem>(this);
     bind<IMC::EntityList>(this);
     bind<IMC::SaveEntityParameters>(this);
@@ -150,6 +154,8 @@ namespace DUNE
     delete m_tman;
     delete m_cpu_avg;
     inf(DTR("clean shutdown"));
+
+    Tasks::LogWriter::stop();
   }
 
   bool
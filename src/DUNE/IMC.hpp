@@ -50,6 +50,8 @@ namespace DUNE
 #include <DUNE/IMC/Exceptions.hpp>
 #include <DUNE/IMC/Definitions.hpp>
 #include <DUNE/IMC/Blob.hpp>
+#include <DUNE/IMC/LsfIndex.hpp>
+#include <DUNE/IMC/LsfReader.hpp>
 #include <DUNE/IMC/IridiumMessageDefinitions.hpp>
 
 #endif
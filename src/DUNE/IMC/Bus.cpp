@@ -31,12 +31,14 @@
 #include <algorithm>
 
 // DUNE headers.
+#include <DUNE/Concurrency/Scheduler.hpp>
 #include <DUNE/Streams/Terminal.hpp>
 #include <DUNE/Utils/String.hpp>
 #include <DUNE/IMC/Factory.hpp>
 #include <DUNE/IMC/Bus.hpp>
 #include <DUNE/IMC/Message.hpp>
 #include <DUNE/IMC/Definitions.hpp>
+#include <DUNE/Tasks/Recipient.hpp>
 
 namespace DUNE
 {
@@ -44,25 +46,32 @@ namespace DUNE
   {
     struct BackLogEntry
     {
-      BackLogEntry(const Message* msg, Tasks::AbstractTask* exc):
-        message(msg->clone()),
+      BackLogEntry(const SharedMessage& msg, Tasks::AbstractTask* exc):
+        message(msg),
         exclude(exc)
       {  }
 
-      ~BackLogEntry(void)
-      {
-        delete message;
-      }
-
       //! Message.
-      Message* message;
+      SharedMessage message;
       //! Exclude this task.
       Tasks::AbstractTask* exclude;
     };
 
     Bus::Bus(void):
-      m_paused(false)
-    { }
+      m_epoch(0),
+      m_paused(false),
+      m_tracking(false),
+      m_pending(0)
+    {
+      for (unsigned i = 0; i < c_reader_slots; ++i)
+      {
+        m_readers[i].count[0] = 0;
+        m_readers[i].count[1] = 0;
+      }
+
+      for (unsigned i = 0; i < c_page_count; ++i)
+        m_pages[i] = NULL;
+    }
 
     Bus::~Bus(void)
     {
@@ -75,6 +84,67 @@ namespace DUNE
 
       for (unsigned i = 0; i < m_bind_msgs.size(); ++i)
         delete m_bind_msgs[i];
+
+      for (unsigned i = 0; i < c_page_count; ++i)
+      {
+        Page* page = m_pages[i].load();
+        if (page == NULL)
+          continue;
+
+        for (unsigned j = 0; j < c_page_size; ++j)
+          delete page->lists[j].load();
+
+        delete page;
+      }
+    }
+
+    unsigned
+    Bus::getReaderSlot(void)
+    {
+      // Threads are spread over the slots in creation order; threads
+      // sharing a slot are still accounted correctly.
+      static std::atomic<unsigned> s_next(0);
+      static thread_local unsigned t_slot = s_next.fetch_add(1) % c_reader_slots;
+      return t_slot;
+    }
+
+    void
+    Bus::synchronize(void)
+    {
+      // Two flips guarantee that every dispatcher that entered before
+      // the new list was published has left.
+      for (unsigned i = 0; i < 2; ++i)
+      {
+        unsigned epoch = m_epoch.load();
+        m_epoch.store(epoch ^ 1);
+
+        for (unsigned j = 0; j < c_reader_slots; ++j)
+        {
+          while (m_readers[j].count[epoch].load() != 0)
+            Concurrency::Scheduler::yield();
+        }
+      }
+    }
+
+    void
+    Bus::setRecipients(uint16_t id, const RecipientList* list)
+    {
+      Page* page = m_pages[id / c_page_size].load();
+      if (page == NULL)
+      {
+        page = new Page;
+        for (unsigned i = 0; i < c_page_size; ++i)
+          page->lists[i] = NULL;
+
+        m_pages[id / c_page_size].store(page, std::memory_order_release);
+      }
+
+      const RecipientList* old = page->lists[id % c_page_size].exchange(list, std::memory_order_acq_rel);
+      if (old != NULL)
+      {
+        synchronize();
+        delete old;
+      }
     }
 
     void
@@ -86,23 +156,75 @@ namespace DUNE
       bind->consumer = task->getName();
       bind->message_id = id;
 
-      Concurrency::ScopedRWLock l(m_lock, true);
+      Concurrency::ScopedMutex l(m_lock);
       m_bind_msgs.push_back(bind);
-      TransportList::iterator itr = std::find(m_recipients[id].begin(), m_recipients[id].end(), task);
-      if (itr == m_recipients[id].end())
-        m_recipients[id].push_back(task);
+
+      const RecipientList* list = getRecipients(id);
+      if (list != NULL && std::find(list->begin(), list->end(), task) != list->end())
+        return;
+
+      RecipientList* nlist = (list == NULL) ? new RecipientList : new RecipientList(*list);
+      nlist->push_back(task);
+      setRecipients(id, nlist);
     }
 
     void
     Bus::unregisterRecipient(Tasks::AbstractTask* task, uint16_t id)
     {
-      Concurrency::ScopedRWLock l(m_lock, true);
-      m_recipients[id].remove(task);
+      Concurrency::ScopedMutex l(m_lock);
+
+      const RecipientList* list = getRecipients(id);
+      if (list == NULL || std::find(list->begin(), list->end(), task) == list->end())
+        return;
+
+      RecipientList* nlist = new RecipientList(*list);
+      nlist->erase(std::remove(nlist->begin(), nlist->end(), task), nlist->end());
+      setRecipients(id, nlist);
     }
 
     void
     Bus::dispatch(const Message* msg, Tasks::AbstractTask* task)
     {
+      if (m_paused)
+      {
+        Concurrency::ScopedMutex lock(m_paused_lock);
+        if (m_paused)
+        {
+          m_back_log.push(new BackLogEntry(SharedMessage::copy(*msg), task));
+          return;
+        }
+      }
+
+      {
+        ReadGuard guard(*this);
+
+        const RecipientList* list = getRecipients(msg->getId());
+        if (list == NULL)
+          return;
+
+        // The copy is only made if there is at least one recipient.
+        SharedMessage shared;
+
+        for (size_t i = 0; i < list->size(); ++i)
+        {
+          Tasks::AbstractTask* recipient = (*list)[i];
+          if (recipient == task)
+            continue;
+
+          if (shared.isNull())
+            shared = SharedMessage::copy(*msg);
+
+          recipient->receive(shared);
+        }
+      }
+
+      Tasks::Recipient::deliverDeferred();
+    }
+
+    void
+    Bus::dispatch(const SharedMessage& msg, Tasks::AbstractTask* task)
+    {
+      if (m_paused)
       {
         Concurrency::ScopedMutex lock(m_paused_lock);
         if (m_paused)
@@ -112,14 +234,21 @@ namespace DUNE
         }
       }
 
-      uint16_t id = msg->getId();
-      Concurrency::ScopedRWLock l(m_lock);
-      TransportList& dlst(m_recipients[id]);
-      for (TransportList::iterator itr = dlst.begin(); itr != dlst.end(); ++itr)
       {
-        if (*itr != task)
-          (*itr)->receive(msg);
+        ReadGuard guard(*this);
+
+        const RecipientList* list = getRecipients(msg->getId());
+        if (list == NULL)
+          return;
+
+        for (size_t i = 0; i < list->size(); ++i)
+        {
+          if ((*list)[i] != task)
+            (*list)[i]->receive(msg);
+        }
       }
+
+      Tasks::Recipient::deliverDeferred();
     }
 
     void
@@ -143,7 +272,7 @@ namespace DUNE
     const std::vector<TransportBindings*>
     Bus::getBindings(void)
     {
-      Concurrency::ScopedRWLock l(m_lock);
+      Concurrency::ScopedMutex l(m_lock);
       return m_bind_msgs;
     }
   }
@@ -39,7 +39,11 @@
 #include <vector>
 #include <queue>
 
+// ISO C++ 11 headers.
+#include <atomic>
+
 // DUNE headers.
+#include <DUNE/IMC/SharedMessage.hpp>
 #include <DUNE/Tasks/AbstractTask.hpp>
 #include <DUNE/Concurrency/TSQueue.hpp>
 #include <DUNE/Concurrency/ScopedMutex.hpp>
@@ -56,6 +60,16 @@ namespace DUNE
     // Export DLL Symbol.
     class DUNE_DLL_SYM Bus;
 
+    //! The message bus keeps, for each message identification
+    //! number, an immutable list of recipients. Lists are stored in
+    //! a dense two-level table indexed by identification number and
+    //! are replaced (copy-on-write) when recipients register or
+    //! unregister, so dispatching a message never takes a lock.
+    //! Dispatchers are accounted in one of two reader epochs, using
+    //! per-thread counter slots so that concurrent dispatchers do not
+    //! contend on a shared counter, and writers wait for a grace
+    //! period (both epochs drained) before releasing a replaced list. Once unregisterRecipient() returns
+    //! no dispatcher can still deliver messages to the task.
     class Bus
     {
     public:
@@ -79,12 +93,20 @@ namespace DUNE
       void
       unregisterRecipient(Tasks::AbstractTask* task, uint16_t id);
 
-      //! Dispatches a message to registered listeners.
+      //! Dispatches a message to registered listeners. The message
+      //! is copied once and the copy is shared by all listeners.
       //! @param msg message to dispatch.
       //! @param task do not deliver message to this task.
       void
       dispatch(const Message* msg, Tasks::AbstractTask* task = NULL);
 
+      //! Dispatches a shared message to registered listeners without
+      //! copying it.
+      //! @param msg message to dispatch.
+      //! @param task do not deliver message to this task.
+      void
+      dispatch(const SharedMessage& msg, Tasks::AbstractTask* task = NULL);
+
       inline void
       pause(void)
       {
@@ -92,27 +114,176 @@ namespace DUNE
         m_paused = true;
       }
 
+      //! Retrieve the number of recipients of a given message
+      //! identification number.
+      //! @param id message identification number.
+      //! @return number of recipients.
+      size_t
+      getRecipientCount(uint16_t id) const
+      {
+        ReadGuard guard(*this);
+        const RecipientList* list = getRecipients(id);
+        return (list == NULL) ? 0 : list->size();
+      }
+
       void
       resume(void);
 
+      //! Enable or disable the accounting of messages queued by
+      //! recipients and not yet consumed, used to run tasks in
+      //! lockstep with a message source.
+      //! @param enabled true to enable accounting.
+      void
+      setTracking(bool enabled)
+      {
+        m_pending = 0;
+        m_tracking = enabled;
+      }
+
+      //! Test if queued messages are being accounted.
+      //! @return true if accounting is enabled, false otherwise.
+      bool
+      isTracking(void) const
+      {
+        return m_tracking.load(std::memory_order_relaxed);
+      }
+
+      //! Update the number of queued messages not yet consumed.
+      //! @param count number of queued (positive) or consumed
+      //! (negative) messages.
+      void
+      addPending(long count)
+      {
+        m_pending.fetch_add(count);
+      }
+
+      //! Test if all accounted messages were consumed. Messages
+      //! queued before accounting was enabled may make the count
+      //! transiently negative.
+      //! @return true if no message is waiting to be consumed.
+      bool
+      isDrained(void) const
+      {
+        return m_pending.load() <= 0;
+      }
+
       const std::vector<TransportBindings*>
       getBindings(void);
 
     private:
-      typedef std::list<Tasks::AbstractTask*> TransportList;
+      //! Immutable list of recipients.
+      typedef std::vector<Tasks::AbstractTask*> RecipientList;
+
+      //! Number of identification numbers per table page.
+      static const unsigned c_page_size = 256;
+      //! Number of table pages.
+      static const unsigned c_page_count = 65536 / c_page_size;
+      //! Number of reader slots.
+      static const unsigned c_reader_slots = 64;
+      //! Size of a reader slot, two cache lines so that counters of
+      //! different slots never share a line whatever the alignment.
+      static const unsigned c_reader_slot_size = 128;
+
+      //! Table page.
+      struct Page
+      {
+        std::atomic<const RecipientList*> lists[c_page_size];
+      };
+
+      //! Reader slot: number of dispatchers of the threads mapped to
+      //! the slot in each reader epoch.
+      struct ReaderSlot
+      {
+        std::atomic<long> count[2];
+        char padding[c_reader_slot_size - 2 * sizeof(std::atomic<long>)];
+      };
+
       //! Table of recipients.
-      std::map<uint16_t, TransportList> m_recipients;
-      //! Internal list lock.
-      Concurrency::RWLock m_lock;
+      std::atomic<Page*> m_pages[c_page_count];
+      //! Current reader epoch (0 or 1).
+      mutable std::atomic<unsigned> m_epoch;
+      //! Reader slots.
+      mutable ReaderSlot m_readers[c_reader_slots];
+      //! Table writers lock.
+      Concurrency::Mutex m_lock;
       //! Bus is paused.
-      bool m_paused;
+      std::atomic<bool> m_paused;
       //! Pause lock.
       Concurrency::Mutex m_paused_lock;
+      //! Queued messages are being accounted.
+      std::atomic<bool> m_tracking;
+      //! Number of queued messages not yet consumed.
+      std::atomic<long> m_pending;
       //! List containing all generated TransportBindings for future logging/reference.
       std::vector<TransportBindings*> m_bind_msgs;
       //! Back log queue. Saves messages when Bus is paused.
       Concurrency::TSQueue<BackLogEntry*> m_back_log;
 
+      //! Retrieve the recipients of a given message identification
+      //! number.
+      //! @param id message identification number.
+      //! @return list of recipients or NULL.
+      const RecipientList*
+      getRecipients(uint16_t id) const
+      {
+        const Page* page = m_pages[id / c_page_size].load(std::memory_order_acquire);
+        if (page == NULL)
+          return NULL;
+
+        return page->lists[id % c_page_size].load(std::memory_order_acquire);
+      }
+
+      //! Retrieve the reader slot of the calling thread.
+      //! @return reader slot index.
+      static unsigned
+      getReaderSlot(void);
+
+      //! Read-side critical section: recipient lists loaded while
+      //! an object of this class is alive are not released.
+      class ReadGuard
+      {
+      public:
+        ReadGuard(const Bus& bus):
+          m_slot(bus.m_readers[getReaderSlot()]),
+          m_epoch(0)
+        {
+          while (true)
+          {
+            m_epoch = bus.m_epoch.load();
+            m_slot.count[m_epoch].fetch_add(1);
+            if (bus.m_epoch.load() == m_epoch)
+              break;
+
+            m_slot.count[m_epoch].fetch_sub(1);
+          }
+        }
+
+        ~ReadGuard(void)
+        {
+          m_slot.count[m_epoch].fetch_sub(1);
+        }
+
+      private:
+        //! Reader slot of the calling thread.
+        ReaderSlot& m_slot;
+        //! Reader epoch.
+        unsigned m_epoch;
+      };
+
+      //! Wait until all dispatchers that may have loaded a replaced
+      //! list have finished. Must be called with the writers lock
+      //! held and never from a dispatcher.
+      void
+      synchronize(void);
+
+      //! Replace the recipients of a given message identification
+      //! number and release the old list after a grace period. Must
+      //! be called with the writers lock held.
+      //! @param id message identification number.
+      //! @param list new list of recipients.
+      void
+      setRecipients(uint16_t id, const RecipientList* list);
+
       //! Non - copyable.
       Bus(Bus const&);
 
@@ -28,11 +28,14 @@
 //***************************************************************************
 
 // ISO C++ 98 headers.
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <string>
 #include <cstdio>
 #include <map>
+#include <typeinfo>
+#include <vector>
 
 // DUNE headers.
 #include <DUNE/Streams/Terminal.hpp>
@@ -41,6 +44,7 @@
 #include <DUNE/IMC/Exceptions.hpp>
 #include <DUNE/IMC/Factory.hpp>
 #include <DUNE/IMC/Definitions.hpp>
+#include <DUNE/IMC/Pool.hpp>
 
 namespace DUNE
 {
@@ -48,6 +52,8 @@ namespace DUNE
   {
     typedef Message* (*Creator) (void);
 
+    typedef void (*Assigner) (Message*, const Message&);
+
     template <typename Type>
     static Message*
     create(void)
@@ -55,6 +61,13 @@ namespace DUNE
       return new Type();
     }
 
+    template <typename Type>
+    static void
+    assign(Message* dst, const Message& src)
+    {
+      *static_cast<Type*>(dst) = static_cast<const Type&>(src);
+    }
+
     static std::pair<uint32_t, std::string> pairs_id_abbrev[] =
     {
 #define MESSAGE(id, abbrev)                             \
@@ -69,27 +82,122 @@ namespace DUNE
 #include <DUNE/IMC/Factory.def>
     };
 
-    static std::pair<int, Creator> creator_pairs_id[] =
+    //! Creator and concrete type of a message.
+    struct CreatorEntry
+    {
+      uint32_t id;
+      Creator create;
+      Assigner assign;
+      const std::type_info* type;
+    };
+
+    static const CreatorEntry creator_entries[] =
     {
 #define MESSAGE(id, abbrev)                                     \
-      std::pair<int, Creator>(id, &create<abbrev>),
+      {id, &create<abbrev>, &assign<abbrev>, &typeid(abbrev)},
 #include <DUNE/IMC/Factory.def>
     };
 
-    DUNE_DECLARE_STATIC_MAP(creators_by_id, int, Creator, creator_pairs_id);
+    //! Build the table of creators indexed by message identification
+    //! number.
+    static std::vector<const CreatorEntry*>*
+    createCreatorTable(void)
+    {
+      size_t count = sizeof(creator_entries) / sizeof(creator_entries[0]);
+      uint32_t max = 0;
+      for (size_t i = 0; i < count; ++i)
+        max = std::max(max, creator_entries[i].id);
+
+      std::vector<const CreatorEntry*>* table = new std::vector<const CreatorEntry*>(max + 1);
+      for (size_t i = 0; i < count; ++i)
+        (*table)[creator_entries[i].id] = &creator_entries[i];
+
+      return table;
+    }
+
+    //! Creators indexed by message identification number. The table
+    //! is never destroyed, so messages can be produced during static
+    //! destruction.
+    static const std::vector<const CreatorEntry*>&
+    getCreators(void)
+    {
+      static const std::vector<const CreatorEntry*>* table = createCreatorTable();
+      return *table;
+    }
+
     DUNE_DECLARE_STATIC_MAP(map_id_abbrev, uint32_t, std::string, pairs_id_abbrev);
     DUNE_DECLARE_STATIC_MAP(map_abbrev_id, std::string, uint32_t, pairs_abbrev_id);
 
     Message*
     Factory::produce(uint32_t id)
     {
-      if (creators_by_id[id])
-        return creators_by_id[id]();
+      const std::vector<const CreatorEntry*>& creators = getCreators();
+
+      if (id < creators.size() && creators[id] != NULL)
+      {
+        Message* msg = Pool::take(id);
+        if (msg != NULL)
+          return msg;
+
+        return creators[id]->create();
+      }
 
       DUNE_DBG("IMC Message Factory", "unknown message " << id);
       return 0;
     }
 
+    Message*
+    Factory::clone(const Message& msg)
+    {
+      const std::vector<const CreatorEntry*>& creators = getCreators();
+      uint32_t id = msg.getId();
+
+      if (id < creators.size() && creators[id] != NULL
+          && *creators[id]->type == typeid(msg))
+      {
+        Message* copy = Pool::take(id);
+        if (copy != NULL)
+        {
+          creators[id]->assign(copy, msg);
+          return copy;
+        }
+      }
+
+      return msg.clone();
+    }
+
+    void
+    Factory::recycle(Message* msg)
+    {
+      if (msg == NULL)
+        return;
+
+      const std::vector<const CreatorEntry*>& creators = getCreators();
+      uint32_t id = msg->getId();
+
+      // Only objects of the exact type produce() would create are
+      // reused; anything else (e.g., user-defined subclasses) is
+      // deleted, as are objects holding large variable-length fields.
+      if (Pool::isEnabled() && id < creators.size() && creators[id] != NULL
+          && *creators[id]->type == typeid(*msg)
+          && msg->getPayloadSerializationSize() <= Pool::c_max_payload)
+      {
+        msg->clear();
+        msg->clearHeader();
+
+        if (Pool::give(msg))
+          return;
+      }
+
+      delete msg;
+    }
+
+    void
+    Factory::setPooling(bool enabled)
+    {
+      Pool::setEnabled(enabled);
+    }
+
     Message*
     Factory::produce(const std::string& name)
     {
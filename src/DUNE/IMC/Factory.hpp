@@ -48,12 +48,36 @@ namespace DUNE
     class Factory
     {
     public:
-      //! Produce a message object by identification number.
+      //! Produce a message object by identification number. If
+      //! pooling is enabled, a previously recycled object may be
+      //! returned.
       //! @param key message identification number.
       //! @return message object allocated on the heap.
       static Message*
       produce(uint32_t key);
 
+      //! Copy a message object. If pooling is enabled, a previously
+      //! recycled object may be assigned instead of allocating a new
+      //! one.
+      //! @param msg message to copy.
+      //! @return message object allocated on the heap.
+      static Message*
+      clone(const Message& msg);
+
+      //! Release a message object that is no longer referenced. If
+      //! pooling is enabled, the object is cleared and kept for
+      //! reuse by produce(), preserving the capacity of its
+      //! variable-length fields; otherwise it is deleted.
+      //! @param msg message object (may be NULL).
+      static void
+      recycle(Message* msg);
+
+      //! Enable or disable pooled allocation of message objects.
+      //! Pooling is enabled by default.
+      //! @param enabled true to enable pooling.
+      static void
+      setPooling(bool enabled);
+
       //! Produce a message object by name.
       //! @param name message name.
       //! @return message object allocated on the heap.
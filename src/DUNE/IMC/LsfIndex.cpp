@@ -0,0 +1,401 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/Utils/ByteCopy.hpp>
+#include <DUNE/Compression/Factory.hpp>
+#include <DUNE/Compression/FileInput.hpp>
+#include <DUNE/IMC/LsfIndex.hpp>
+#include <DUNE/IMC/LsfReader.hpp>
+
+#if defined(DUNE_SYS_HAS_UNISTD_H)
+#  include <unistd.h>
+#endif
+
+#if defined(DUNE_SYS_HAS_SYS_MMAN_H)
+#  include <sys/mman.h>
+#endif
+
+#if defined(DUNE_SYS_HAS_FCNTL_H)
+#  include <fcntl.h>
+#endif
+
+#if defined(DUNE_SYS_HAS_MMAP) && defined(DUNE_SYS_HAS_SYS_MMAN_H) && defined(DUNE_SYS_HAS_FCNTL_H)
+#  define DUNE_IMC_LSF_INDEX_MMAP
+#endif
+
+namespace DUNE
+{
+  namespace IMC
+  {
+    using Utils::ByteCopy;
+
+    //! Message index magic.
+    static const char c_magic[] = {'L', 'S', 'F', 'I'};
+    //! Block index magic.
+    static const char c_block_magic[] = {'L', 'S', 'F', 'B'};
+    //! Index format version.
+    static const uint8_t c_version = 2;
+    //! Number of records read at a time when the index is not mapped.
+    static const size_t c_records_per_read = 128;
+    //! Extensions of compressed LSF files.
+    static const char* c_extensions[] = {".gz", ".bz2", ".z", ".lz4"};
+
+    //! Strip the compression extension of an LSF file.
+    //! @param[in] lsf path to the LSF file.
+    //! @return path without compression extension.
+    static std::string
+    stripExtension(const std::string& lsf)
+    {
+      std::string path = lsf;
+
+      for (size_t i = 0; i < sizeof(c_extensions) / sizeof(c_extensions[0]); ++i)
+      {
+        size_t len = std::strlen(c_extensions[i]);
+        if (path.size() > len && path.compare(path.size() - len, len, c_extensions[i]) == 0)
+        {
+          path.erase(path.size() - len);
+          break;
+        }
+      }
+
+      return path;
+    }
+
+    //! Check an index header.
+    //! @param[in] ifs index stream positioned at the beginning.
+    //! @param[in] magic expected magic.
+    //! @return true if the header is valid, false otherwise.
+    static bool
+    checkHeader(std::istream& ifs, const char* magic)
+    {
+      uint8_t hdr[LsfIndex::c_header_size];
+      ifs.read((char*)hdr, sizeof(hdr));
+      return (ifs.gcount() == (std::streamsize)sizeof(hdr)
+              && std::memcmp(hdr, magic, 4) == 0
+              && hdr[4] == c_version);
+    }
+
+    std::string
+    LsfIndex::getPath(const std::string& lsf)
+    {
+      return stripExtension(lsf) + ".idx";
+    }
+
+    std::string
+    LsfIndex::getBlockPath(const std::string& lsf)
+    {
+      return stripExtension(lsf) + ".blk";
+    }
+
+    void
+    LsfIndex::encodeHeader(uint8_t* bfr)
+    {
+      std::memset(bfr, 0, c_header_size);
+      std::memcpy(bfr, c_magic, sizeof(c_magic));
+      bfr[4] = c_version;
+    }
+
+    void
+    LsfIndex::encodeBlockHeader(uint8_t* bfr)
+    {
+      std::memset(bfr, 0, c_header_size);
+      std::memcpy(bfr, c_block_magic, sizeof(c_block_magic));
+      bfr[4] = c_version;
+    }
+
+    void
+    LsfIndex::encode(const Entry& entry, uint8_t* bfr)
+    {
+      std::memset(bfr, 0, c_record_size);
+      ByteCopy::toLE(entry.timestamp, bfr);
+      ByteCopy::toLE(entry.max_time, bfr + 8);
+      ByteCopy::toLE(entry.offset, bfr + 16);
+      ByteCopy::toLE(entry.id, bfr + 24);
+      ByteCopy::toLE(entry.src, bfr + 26);
+      bfr[28] = entry.src_ent;
+    }
+
+    void
+    LsfIndex::encode(const Block& block, uint8_t* bfr)
+    {
+      ByteCopy::toLE(block.offset, bfr);
+      ByteCopy::toLE(block.file_offset, bfr + 8);
+    }
+
+    void
+    LsfIndex::decode(const uint8_t* bfr, Entry& entry)
+    {
+      ByteCopy::fromLE(entry.timestamp, bfr);
+      ByteCopy::fromLE(entry.max_time, bfr + 8);
+      ByteCopy::fromLE(entry.offset, bfr + 16);
+      ByteCopy::fromLE(entry.id, bfr + 24);
+      ByteCopy::fromLE(entry.src, bfr + 26);
+      entry.src_ent = bfr[28];
+    }
+
+    void
+    LsfIndex::decode(const uint8_t* bfr, Block& block)
+    {
+      ByteCopy::fromLE(block.offset, bfr);
+      ByteCopy::fromLE(block.file_offset, bfr + 8);
+    }
+
+    LsfIndex::LsfIndex(const std::string& lsf):
+      m_lsf(lsf),
+      m_count(0),
+      m_map(NULL),
+      m_map_size(0),
+      m_bfr_first(0)
+    {
+      m_method = Compression::Factory::detect(lsf.c_str());
+
+      std::string path = getPath(lsf);
+      m_ifs.open(path.c_str(), std::ios::binary);
+      if (!m_ifs.is_open())
+        throw std::runtime_error("unable to open index: " + path);
+
+      if (!checkHeader(m_ifs, c_magic))
+        throw std::runtime_error("invalid index: " + path);
+
+      m_ifs.seekg(0, std::ios::end);
+      uint64_t size = m_ifs.tellg();
+      m_count = (size - c_header_size) / c_record_size;
+
+      loadBlocks();
+
+#if defined(DUNE_IMC_LSF_INDEX_MMAP)
+      if (m_count == 0)
+        return;
+
+      int fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0)
+        return;
+
+      void* ptr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      ::close(fd);
+
+      if (ptr != MAP_FAILED)
+      {
+        m_map = (const uint8_t*)ptr;
+        m_map_size = size;
+        m_ifs.close();
+      }
+#endif
+    }
+
+    LsfIndex::~LsfIndex(void)
+    {
+#if defined(DUNE_IMC_LSF_INDEX_MMAP)
+      if (m_map != NULL)
+        munmap((void*)m_map, m_map_size);
+#endif
+    }
+
+    void
+    LsfIndex::loadBlocks(void)
+    {
+      if (m_method == Compression::METHOD_UNKNOWN)
+        return;
+
+      std::string path = getBlockPath(m_lsf);
+      std::ifstream ifs(path.c_str(), std::ios::binary);
+      if (!ifs.is_open())
+        throw std::runtime_error("unable to open block index: " + path);
+
+      if (!checkHeader(ifs, c_block_magic))
+        throw std::runtime_error("invalid block index: " + path);
+
+      uint8_t bfr[c_block_record_size];
+      while (ifs.read((char*)bfr, sizeof(bfr)))
+      {
+        Block block;
+        decode(bfr, block);
+        m_blocks.push_back(block);
+      }
+    }
+
+    const uint8_t*
+    LsfIndex::getRecord(size_t index) const
+    {
+      if (m_map != NULL)
+        return m_map + c_header_size + index * c_record_size;
+
+      size_t loaded = m_bfr.size() / c_record_size;
+      if (index < m_bfr_first || index >= m_bfr_first + loaded)
+      {
+        size_t count = std::min(c_records_per_read, m_count - index);
+        m_bfr.resize(count * c_record_size);
+        m_ifs.clear();
+        m_ifs.seekg(c_header_size + (uint64_t)index * c_record_size);
+        m_ifs.read((char*)&m_bfr[0], m_bfr.size());
+
+        if (m_ifs.gcount() != (std::streamsize)m_bfr.size())
+        {
+          m_bfr.clear();
+          throw std::runtime_error("unable to read index: " + getPath(m_lsf));
+        }
+
+        m_bfr_first = index;
+      }
+
+      return &m_bfr[(index - m_bfr_first) * c_record_size];
+    }
+
+    LsfIndex::Entry
+    LsfIndex::getEntry(size_t index) const
+    {
+      if (index >= m_count)
+        throw std::out_of_range("invalid index entry");
+
+      Entry entry;
+      decode(getRecord(index), entry);
+      return entry;
+    }
+
+    size_t
+    LsfIndex::findTime(double time) const
+    {
+      size_t lo = 0;
+      size_t hi = m_count;
+
+      while (lo < hi)
+      {
+        size_t mid = lo + (hi - lo) / 2;
+        double max_time = 0;
+        ByteCopy::fromLE(max_time, getRecord(mid) + 8);
+
+        if (max_time < time)
+          lo = mid + 1;
+        else
+          hi = mid;
+      }
+
+      return lo;
+    }
+
+    size_t
+    LsfIndex::findMessage(uint16_t id, size_t from, size_t to) const
+    {
+      to = std::min(to, m_count);
+
+      for (size_t i = from; i < to; ++i)
+      {
+        uint16_t rec_id = 0;
+        ByteCopy::fromLE(rec_id, getRecord(i) + 24);
+        if (rec_id == id)
+          return i;
+      }
+
+      return m_count;
+    }
+
+    std::istream*
+    LsfIndex::open(size_t index) const
+    {
+      return openAt(getEntry(index).offset);
+    }
+
+    void
+    LsfIndex::locate(uint64_t offset, uint64_t& file_offset, uint64_t& skip) const
+    {
+      if (m_method == Compression::METHOD_UNKNOWN)
+      {
+        file_offset = 0;
+        skip = offset;
+        return;
+      }
+
+      // Find the last compressed block starting at or before offset.
+      uint64_t block_offset = 0;
+      file_offset = 0;
+      for (size_t lo = 0, hi = m_blocks.size(); lo < hi; )
+      {
+        size_t mid = lo + (hi - lo) / 2;
+        if (m_blocks[mid].offset <= offset)
+        {
+          block_offset = m_blocks[mid].offset;
+          file_offset = m_blocks[mid].file_offset;
+          lo = mid + 1;
+        }
+        else
+        {
+          hi = mid;
+        }
+      }
+
+      skip = offset - block_offset;
+    }
+
+    void
+    LsfIndex::seek(LsfReader& reader, size_t index) const
+    {
+      uint64_t file_offset = 0;
+      uint64_t skip = 0;
+      locate(getEntry(index).offset, file_offset, skip);
+      reader.seek(file_offset, skip);
+    }
+
+    std::istream*
+    LsfIndex::openAt(uint64_t offset) const
+    {
+      if (m_method == Compression::METHOD_UNKNOWN)
+      {
+        std::ifstream* ifs = new std::ifstream(m_lsf.c_str(), std::ios::binary);
+        ifs->seekg(offset);
+        return ifs;
+      }
+
+      uint64_t file_offset = 0;
+      uint64_t skip = 0;
+      locate(offset, file_offset, skip);
+
+      Compression::FileInput* ifs = new Compression::FileInput(m_lsf.c_str(), m_method);
+      ifs->seek(file_offset);
+
+      // Skip data preceding offset inside the block.
+      char bfr[4096];
+      while (skip > 0 && *ifs)
+      {
+        std::streamsize size = (std::streamsize)std::min<uint64_t>(skip, sizeof(bfr));
+        ifs->read(bfr, size);
+        skip -= size;
+      }
+
+      return ifs;
+    }
+  }
+}
@@ -0,0 +1,266 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+#ifndef DUNE_IMC_LSF_INDEX_HPP_INCLUDED_
+#define DUNE_IMC_LSF_INDEX_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <cstddef>
+#include <fstream>
+#include <istream>
+#include <string>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/Compression/Methods.hpp>
+
+namespace DUNE
+{
+  namespace IMC
+  {
+    // Export DLL Symbol.
+    class DUNE_DLL_SYM LsfIndex;
+
+    // Forward declarations.
+    class LsfReader;
+
+    //! Index of an LSF file. The index is made of two sidecar files,
+    //! each with a small header followed by fixed size little-endian
+    //! records. The message index describes the position of each
+    //! logged message in the uncompressed LSF stream and the block
+    //! index, written only for compressed files, the position of each
+    //! independently compressed block. It allows readers to start
+    //! reading an LSF file at a given time or message without
+    //! decompressing and parsing what precedes it.
+    //!
+    //! Only the block index is loaded in memory, message records are
+    //! read from the file on demand.
+    class LsfIndex
+    {
+    public:
+      //! Index entry of a logged message.
+      struct Entry
+      {
+        //! Message timestamp.
+        double timestamp;
+        //! Highest timestamp of this and all previous messages.
+        double max_time;
+        //! Offset of the message in the uncompressed stream.
+        uint64_t offset;
+        //! Message identification number.
+        uint16_t id;
+        //! Source address.
+        uint16_t src;
+        //! Source entity.
+        uint8_t src_ent;
+      };
+
+      //! Independently compressed block of an LSF file.
+      struct Block
+      {
+        //! Offset of the first byte of the block in the uncompressed
+        //! stream.
+        uint64_t offset;
+        //! Offset of the block in the compressed file.
+        uint64_t file_offset;
+      };
+
+      //! Size of the index headers.
+      static const size_t c_header_size = 8;
+      //! Size of each message record.
+      static const size_t c_record_size = 32;
+      //! Size of each block record.
+      static const size_t c_block_record_size = 16;
+
+      //! Get the path of the message index of a given LSF file.
+      //! Compression extensions are stripped, i.e., both 'Data.lsf'
+      //! and 'Data.lsf.gz' are indexed by 'Data.lsf.idx'.
+      //! @param[in] lsf path to the LSF file.
+      //! @return path to the message index file.
+      static std::string
+      getPath(const std::string& lsf);
+
+      //! Get the path of the block index of a given LSF file, e.g.,
+      //! 'Data.lsf.blk' for 'Data.lsf.gz'.
+      //! @param[in] lsf path to the LSF file.
+      //! @return path to the block index file.
+      static std::string
+      getBlockPath(const std::string& lsf);
+
+      //! Encode the message index header.
+      //! @param[out] bfr destination buffer (c_header_size bytes).
+      static void
+      encodeHeader(uint8_t* bfr);
+
+      //! Encode the block index header.
+      //! @param[out] bfr destination buffer (c_header_size bytes).
+      static void
+      encodeBlockHeader(uint8_t* bfr);
+
+      //! Encode a message record.
+      //! @param[in] entry message entry.
+      //! @param[out] bfr destination buffer (c_record_size bytes).
+      static void
+      encode(const Entry& entry, uint8_t* bfr);
+
+      //! Encode a block record.
+      //! @param[in] block compressed block.
+      //! @param[out] bfr destination buffer (c_block_record_size
+      //! bytes).
+      static void
+      encode(const Block& block, uint8_t* bfr);
+
+      //! Decode a message record.
+      //! @param[in] bfr source buffer (c_record_size bytes).
+      //! @param[out] entry message entry.
+      static void
+      decode(const uint8_t* bfr, Entry& entry);
+
+      //! Decode a block record.
+      //! @param[in] bfr source buffer (c_block_record_size bytes).
+      //! @param[out] block compressed block.
+      static void
+      decode(const uint8_t* bfr, Block& block);
+
+      //! Open the index of an LSF file. Truncated trailing records,
+      //! e.g., after a power failure, are ignored.
+      //! @param[in] lsf path to the LSF file.
+      //! @throw std::runtime_error if the index does not exist or is
+      //! invalid.
+      LsfIndex(const std::string& lsf);
+
+      //! Destructor.
+      ~LsfIndex(void);
+
+      //! Get the number of indexed messages.
+      //! @return number of messages.
+      size_t
+      getEntryCount(void) const
+      {
+        return m_count;
+      }
+
+      //! Get an indexed message.
+      //! @param[in] index entry index.
+      //! @return entry.
+      Entry
+      getEntry(size_t index) const;
+
+      //! Find the first entry such that all messages with timestamp
+      //! greater or equal than a given time are at or after it.
+      //! Messages are logged in arrival order, so some of the messages
+      //! after the returned entry may still be older than time.
+      //! @param[in] time time in seconds since the Unix Epoch.
+      //! @return entry index or getEntryCount() if there is none.
+      size_t
+      findTime(double time) const;
+
+      //! Find the first message of a given type in a range of
+      //! entries. Records are scanned in order, so the cost of the
+      //! search grows with the distance to the message found.
+      //! @param[in] id message identification number.
+      //! @param[in] from entry index where the search starts.
+      //! @param[in] to entry index where the search stops (excluded),
+      //! searches up to the last entry by default.
+      //! @return entry index or getEntryCount() if there is none.
+      size_t
+      findMessage(uint16_t id, size_t from = 0, size_t to = (size_t)-1) const;
+
+      //! Find where to start decompressing to reach an offset of the
+      //! uncompressed stream.
+      //! @param[in] offset offset in the uncompressed stream.
+      //! @param[out] file_offset offset of the enclosing compressed
+      //! block in the file (0 for uncompressed files).
+      //! @param[out] skip number of uncompressed bytes between the
+      //! beginning of the block and offset.
+      void
+      locate(uint64_t offset, uint64_t& file_offset, uint64_t& skip) const;
+
+      //! Position a reader of the indexed LSF file at a given entry.
+      //! @param[in] reader reader constructed from the LSF file name.
+      //! @param[in] index entry index.
+      void
+      seek(LsfReader& reader, size_t index) const;
+
+      //! Open the LSF file positioned at a given entry.
+      //! @param[in] index entry index.
+      //! @return input stream, must be deleted by the caller.
+      std::istream*
+      open(size_t index) const;
+
+      //! Open the LSF file positioned at an offset of the uncompressed
+      //! stream.
+      //! @param[in] offset offset in the uncompressed stream.
+      //! @return input stream, must be deleted by the caller.
+      std::istream*
+      openAt(uint64_t offset) const;
+
+    private:
+      //! Path to the LSF file.
+      std::string m_lsf;
+      //! Compression method of the LSF file.
+      Compression::Methods m_method;
+      //! Number of message records.
+      size_t m_count;
+      //! Mapped message index or NULL if the file is read instead.
+      const uint8_t* m_map;
+      //! Size of the mapped message index.
+      size_t m_map_size;
+      //! Message index, used when it cannot be mapped.
+      mutable std::ifstream m_ifs;
+      //! Buffer of records read from m_ifs.
+      mutable std::vector<uint8_t> m_bfr;
+      //! Index of the first record in m_bfr.
+      mutable size_t m_bfr_first;
+      //! Compressed blocks.
+      std::vector<Block> m_blocks;
+
+      //! Get a message record.
+      //! @param[in] index record index (lower than m_count).
+      //! @return pointer to the record (c_record_size bytes), valid
+      //! until the next call.
+      const uint8_t*
+      getRecord(size_t index) const;
+
+      //! Load the block index.
+      void
+      loadBlocks(void);
+
+      //! Non-copyable.
+      LsfIndex(const LsfIndex&);
+
+      //! Non-assignable.
+      LsfIndex&
+      operator=(const LsfIndex&);
+    };
+  }
+}
+
+#endif
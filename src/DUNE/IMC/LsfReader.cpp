@@ -0,0 +1,378 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/Utils/ByteCopy.hpp>
+#include <DUNE/Algorithms/CRC16.hpp>
+#include <DUNE/Compression/Decompressor.hpp>
+#include <DUNE/Compression/Factory.hpp>
+#include <DUNE/Compression/FileInput.hpp>
+#include <DUNE/System/Error.hpp>
+#include <DUNE/IMC/Exceptions.hpp>
+#include <DUNE/IMC/Packet.hpp>
+#include <DUNE/IMC/LsfReader.hpp>
+
+#if defined(DUNE_SYS_HAS_UNISTD_H)
+#  include <unistd.h>
+#endif
+
+#if defined(DUNE_SYS_HAS_SYS_MMAN_H)
+#  include <sys/mman.h>
+#endif
+
+#if defined(DUNE_SYS_HAS_SYS_STAT_H)
+#  include <sys/stat.h>
+#endif
+
+#if defined(DUNE_SYS_HAS_FCNTL_H)
+#  include <fcntl.h>
+#endif
+
+#if defined(DUNE_SYS_HAS_MMAP) && defined(DUNE_SYS_HAS_SYS_MMAN_H) && defined(DUNE_SYS_HAS_FCNTL_H)
+#  define DUNE_IMC_LSF_READER_MMAP
+#endif
+
+namespace DUNE
+{
+  namespace IMC
+  {
+    //! Size of each read from the input stream.
+    static const size_t c_read_size = 256 * 1024;
+    //! Size of the read buffer.
+    static const size_t c_buffer_size = c_read_size + DUNE_IMC_CONST_MAX_SIZE
+      + DUNE_IMC_CONST_HEADER_SIZE + DUNE_IMC_CONST_FOOTER_SIZE;
+
+    struct LsfReader::PrivateData
+    {
+      //! Compression method.
+      Compression::Methods method;
+      //! True if the file is mapped.
+      bool mapped;
+      //! File mapping.
+      const uint8_t* map;
+      //! Size of the file mapping.
+      size_t map_size;
+      //! Decompressor of mapped data.
+      Compression::Decompressor* dec;
+      //! Index of the next mapped byte to decompress.
+      size_t map_idx;
+      //! Input stream, if the file is not mapped.
+      std::istream* input;
+
+      PrivateData(void):
+        method(Compression::METHOD_UNKNOWN),
+        mapped(false),
+        map(NULL),
+        map_size(0),
+        dec(NULL),
+        map_idx(0),
+        input(NULL)
+      { }
+
+      ~PrivateData(void)
+      {
+        delete dec;
+        delete input;
+
+#if defined(DUNE_IMC_LSF_READER_MMAP)
+        if (map != NULL)
+          munmap((void*)map, map_size);
+#endif
+      }
+
+      //! Map a file.
+      //! @param[in] file file name.
+      //! @return true if the file was mapped.
+      bool
+      mapFile(const std::string& file)
+      {
+#if defined(DUNE_IMC_LSF_READER_MMAP)
+        int fd = ::open(file.c_str(), O_RDONLY);
+        if (fd < 0)
+          throw System::Error(errno, "unable to open " + file);
+
+        struct stat st;
+        if (fstat(fd, &st) < 0)
+        {
+          ::close(fd);
+          throw System::Error(errno, "unable to stat " + file);
+        }
+
+        map_size = st.st_size;
+        if (map_size > 0)
+        {
+          void* ptr = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+          if (ptr == MAP_FAILED)
+          {
+            ::close(fd);
+            map_size = 0;
+            return false;
+          }
+
+          map = (const uint8_t*)ptr;
+
+#  if defined(DUNE_SYS_HAS_MADVISE)
+          madvise(ptr, map_size, MADV_SEQUENTIAL);
+#  endif
+        }
+
+        ::close(fd);
+        mapped = true;
+        return true;
+#else
+        (void)file;
+        return false;
+#endif
+      }
+    };
+
+    LsfReader::LsfReader(std::istream& is, bool check_crc):
+      m_private(NULL),
+      m_is(&is),
+      m_check_crc(check_crc),
+      m_bfr(c_buffer_size),
+      m_data(&m_bfr[0]),
+      m_begin(0),
+      m_end(0),
+      m_packet(NULL)
+    {
+      std::memset(&m_header, 0, sizeof(m_header));
+    }
+
+    LsfReader::LsfReader(const std::string& file, bool check_crc):
+      m_private(new PrivateData),
+      m_is(NULL),
+      m_check_crc(check_crc),
+      m_data(NULL),
+      m_begin(0),
+      m_end(0),
+      m_packet(NULL)
+    {
+      std::memset(&m_header, 0, sizeof(m_header));
+
+      PrivateData* p = m_private;
+      p->method = Compression::Factory::detect(file.c_str());
+
+      try
+      {
+        bool mappable = p->method == Compression::METHOD_UNKNOWN
+          || p->method == Compression::METHOD_LZ4;
+
+        if (mappable && p->mapFile(file))
+        {
+          if (p->method == Compression::METHOD_UNKNOWN)
+          {
+            m_data = p->map;
+            m_end = p->map_size;
+            return;
+          }
+
+          p->dec = Compression::Factory::decompressor(p->method);
+        }
+        else if (p->method == Compression::METHOD_UNKNOWN)
+        {
+          p->input = new std::ifstream(file.c_str(), std::ios::binary);
+        }
+        else
+        {
+          p->input = new Compression::FileInput(file.c_str(), p->method);
+        }
+
+        if (p->input != NULL && !*p->input)
+          throw std::runtime_error("unable to open " + file);
+      }
+      catch (...)
+      {
+        delete m_private;
+        throw;
+      }
+
+      m_is = p->input;
+      m_bfr.resize(c_buffer_size);
+      m_data = &m_bfr[0];
+    }
+
+    LsfReader::~LsfReader(void)
+    {
+      delete m_private;
+    }
+
+    void
+    LsfReader::seek(uint64_t file_offset, uint64_t skip)
+    {
+      PrivateData* p = m_private;
+      if (p == NULL)
+        throw std::runtime_error("LSF reader is not seekable");
+
+      m_packet = NULL;
+
+      if (p->mapped && p->dec == NULL)
+      {
+        m_begin = std::min<uint64_t>(file_offset + skip, p->map_size);
+        return;
+      }
+
+      if (p->dec != NULL)
+      {
+        delete p->dec;
+        p->dec = Compression::Factory::decompressor(p->method);
+        p->map_idx = std::min<uint64_t>(file_offset, p->map_size);
+      }
+      else if (p->method == Compression::METHOD_UNKNOWN)
+      {
+        p->input->clear();
+        p->input->seekg(file_offset);
+      }
+      else
+      {
+        static_cast<Compression::FileInput*>(p->input)->seek(file_offset);
+      }
+
+      m_begin = 0;
+      m_end = 0;
+      discard(skip);
+    }
+
+    size_t
+    LsfReader::fill(size_t size)
+    {
+      size_t available = m_end - m_begin;
+      if (available >= size)
+        return available;
+
+      // Mapped uncompressed files are always complete.
+      if (m_private != NULL && m_private->mapped && m_private->dec == NULL)
+        return available;
+
+      // Move unread data to the beginning of the buffer.
+      if (m_begin > 0)
+      {
+        std::memmove(&m_bfr[0], &m_bfr[m_begin], available);
+        m_begin = 0;
+        m_end = available;
+      }
+
+      if (m_private != NULL && m_private->dec != NULL)
+      {
+        PrivateData* p = m_private;
+        while (m_end < size && p->map_idx < p->map_size)
+        {
+          p->dec->decompress((char*)&m_bfr[m_end], m_bfr.size() - m_end,
+                             (char*)p->map + p->map_idx, p->map_size - p->map_idx);
+          p->map_idx += p->dec->processed();
+          m_end += p->dec->decompressed();
+
+          if (p->dec->processed() == 0 && p->dec->decompressed() == 0)
+            break;
+        }
+      }
+      else
+      {
+        while (m_end < size && *m_is)
+        {
+          size_t room = std::min(c_read_size, m_bfr.size() - m_end);
+          m_is->read((char*)&m_bfr[m_end], room);
+          m_end += m_is->gcount();
+        }
+      }
+
+      return m_end - m_begin;
+    }
+
+    void
+    LsfReader::discard(uint64_t size)
+    {
+      while (size > 0)
+      {
+        size_t available = fill((size_t)std::min<uint64_t>(size, c_read_size));
+        if (available == 0)
+          break;
+
+        size_t count = (size_t)std::min<uint64_t>(size, available);
+        m_begin += count;
+        size -= count;
+      }
+    }
+
+    bool
+    LsfReader::next(void)
+    {
+      m_packet = NULL;
+
+      size_t available = fill(DUNE_IMC_CONST_HEADER_SIZE);
+      if (available == 0)
+        return false;
+
+      if (available < DUNE_IMC_CONST_HEADER_SIZE)
+        throw BufferTooShort();
+
+      Packet::deserializeHeader(m_header, m_data + m_begin, DUNE_IMC_CONST_HEADER_SIZE);
+
+      size_t size = getPacketSize();
+      if (fill(size) < size)
+        throw BufferTooShort();
+
+      m_packet = m_data + m_begin;
+      m_begin += size;
+
+      if (m_check_crc && !isValid())
+        throw InvalidCrc();
+
+      return true;
+    }
+
+    bool
+    LsfReader::isValid(void) const
+    {
+      uint16_t rcrc = 0;
+      const uint8_t* footer = m_packet + DUNE_IMC_CONST_HEADER_SIZE + m_header.size;
+
+      if (m_header.sync == DUNE_IMC_CONST_SYNC_REV)
+        Utils::ByteCopy::rcopy(rcrc, footer);
+      else
+        Utils::ByteCopy::copy(rcrc, footer);
+
+      return Algorithms::CRC16::compute(m_packet, DUNE_IMC_CONST_HEADER_SIZE + m_header.size) == rcrc;
+    }
+
+    Message*
+    LsfReader::decode(Message* msg) const
+    {
+      return Packet::deserializePayload(m_header, m_packet, getPacketSize(), msg);
+    }
+  }
+}
@@ -0,0 +1,207 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+#ifndef DUNE_IMC_LSF_READER_HPP_INCLUDED_
+#define DUNE_IMC_LSF_READER_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/IMC/Constants.hpp>
+#include <DUNE/IMC/Header.hpp>
+
+namespace DUNE
+{
+  namespace IMC
+  {
+    // Export DLL Symbol.
+    class DUNE_DLL_SYM LsfReader;
+
+    // Forward declarations.
+    class Message;
+
+    //! Streaming LSF reader that parses only packet headers. Packets
+    //! are read in large chunks and handed out in place: callers
+    //! inspect the header, decode the payload only when needed and
+    //! copy the raw packet when filtering. CRC validation is optional.
+    //!
+    //! When constructed from a file name, uncompressed and LZ4 files
+    //! are memory mapped: uncompressed packets are handed out
+    //! directly from the mapping and LZ4 frames are decompressed
+    //! straight from it, without stream or per packet read overhead.
+    //! Other compression methods are read through
+    //! Compression::FileInput.
+    class LsfReader
+    {
+    public:
+      //! Constructor.
+      //! @param[in] is input stream.
+      //! @param[in] check_crc true to validate the CRC of every packet.
+      LsfReader(std::istream& is, bool check_crc = false);
+
+      //! Constructor.
+      //! @param[in] file LSF file, possibly compressed.
+      //! @param[in] check_crc true to validate the CRC of every packet.
+      //! @throw std::runtime_error if the file cannot be opened.
+      LsfReader(const std::string& file, bool check_crc = false);
+
+      //! Destructor.
+      ~LsfReader(void);
+
+      //! Restart reading at a given position. Only available for
+      //! readers constructed from a file name.
+      //! @param[in] file_offset offset in the file of an
+      //! independently compressed block (0 for uncompressed files).
+      //! @param[in] skip number of uncompressed bytes to skip after
+      //! file_offset.
+      //! @throw std::runtime_error if the reader is not seekable.
+      void
+      seek(uint64_t file_offset, uint64_t skip);
+
+      //! Advance to the next packet. Pointers returned by previous
+      //! calls are invalidated.
+      //! @return true if a packet is available, false at the end of
+      //! the stream.
+      //! @throw BufferTooShort if the stream ends in the middle of a
+      //! packet.
+      //! @throw InvalidSync if the synchronization number is invalid.
+      //! @throw InvalidCrc if CRC validation is enabled and fails.
+      bool
+      next(void);
+
+      //! Get the header of the current packet.
+      //! @return header.
+      const Header&
+      getHeader(void) const
+      {
+        return m_header;
+      }
+
+      //! Get the payload of the current packet, serialized in the
+      //! byte order given by the synchronization number.
+      //! @return pointer to the payload.
+      const uint8_t*
+      getPayload(void) const
+      {
+        return m_packet + DUNE_IMC_CONST_HEADER_SIZE;
+      }
+
+      //! Get the payload size of the current packet.
+      //! @return payload size in bytes.
+      uint16_t
+      getPayloadSize(void) const
+      {
+        return m_header.size;
+      }
+
+      //! Get the current packet, including header and footer.
+      //! @return pointer to the packet.
+      const uint8_t*
+      getPacket(void) const
+      {
+        return m_packet;
+      }
+
+      //! Get the size of the current packet.
+      //! @return packet size in bytes.
+      unsigned
+      getPacketSize(void) const
+      {
+        return DUNE_IMC_CONST_HEADER_SIZE + m_header.size + DUNE_IMC_CONST_FOOTER_SIZE;
+      }
+
+      //! Check the CRC of the current packet.
+      //! @return true if the CRC is valid, false otherwise.
+      bool
+      isValid(void) const;
+
+      //! Deserialize the current packet.
+      //! @param[in] msg message object to fill or NULL to create one.
+      //! @return message object.
+      Message*
+      decode(Message* msg = NULL) const;
+
+      //! Advance to the next packet and deserialize it.
+      //! @return message object, to be deleted by the caller, or NULL
+      //! at the end of the stream.
+      Message*
+      read(void)
+      {
+        return next() ? decode() : NULL;
+      }
+
+    private:
+      // Forward declaration of private data.
+      struct PrivateData;
+      //! File backed sources.
+      PrivateData* m_private;
+      //! Input stream.
+      std::istream* m_is;
+      //! True to validate CRCs.
+      bool m_check_crc;
+      //! Read buffer.
+      std::vector<uint8_t> m_bfr;
+      //! Start of data, either the read buffer or a file mapping.
+      const uint8_t* m_data;
+      //! Index of the first unread byte.
+      size_t m_begin;
+      //! Index past the last read byte.
+      size_t m_end;
+      //! Current packet.
+      const uint8_t* m_packet;
+      //! Header of the current packet.
+      Header m_header;
+
+      //! Ensure a number of bytes is available after m_begin.
+      //! @param[in] size number of bytes.
+      //! @return number of bytes available.
+      size_t
+      fill(size_t size);
+
+      //! Discard a number of bytes.
+      //! @param[in] size number of bytes.
+      void
+      discard(uint64_t size);
+
+      //! Non-copyable.
+      LsfReader(const LsfReader&);
+
+      //! Non-copyable.
+      LsfReader&
+      operator=(const LsfReader&);
+    };
+  }
+}
+
+#endif
@@ -33,16 +33,21 @@
 // DUNE headers.
 #include <DUNE/Config.hpp>
 #include <DUNE/Time/Clock.hpp>
+#include <DUNE/Concurrency/AtomicCounter.hpp>
 #include <DUNE/IMC/Constants.hpp>
 #include <DUNE/IMC/Header.hpp>
 #include <DUNE/IMC/Packet.hpp>
 #include <DUNE/IMC/AddressResolver.hpp>
+#include <DUNE/IMC/Pool.hpp>
 
 namespace DUNE
 {
   //! Implementation of the %IMC API
   namespace IMC
   {
+    // Forward declarations.
+    class SharedMessage;
+
     // Export symbol.
     class DUNE_DLL_SYM Message;
 
@@ -53,11 +58,25 @@ namespace DUNE
       //! Default constructor.
       Message(void)
       {
-        m_header.src = AddressResolver::invalid();
-        m_header.src_ent = DUNE_IMC_CONST_UNK_EID;
-        m_header.dst = AddressResolver::invalid();
-        m_header.dst_ent = DUNE_IMC_CONST_UNK_EID;
-        m_header.timestamp = -1.0;
+        clearHeader();
+      }
+
+      //! Copy constructor. The reference count of shared messages
+      //! is never copied.
+      //! @param[in] other message to copy.
+      Message(const Message& other):
+        m_header(other.m_header)
+      { }
+
+      //! Assignment operator. The reference count of shared
+      //! messages is never copied.
+      //! @param[in] other message to copy.
+      //! @return this message.
+      Message&
+      operator=(const Message& other)
+      {
+        m_header = other.m_header;
+        return *this;
       }
 
       //! Default destructor.
@@ -65,6 +84,36 @@ namespace DUNE
       ~Message(void)
       { }
 
+      //! Allocate message objects from the thread-cached pool.
+      //! @param[in] size object size.
+      //! @return memory block.
+      static void*
+      operator new(std::size_t size)
+      {
+        return Pool::allocate(size);
+      }
+
+      //! Return message objects to the thread-cached pool.
+      //! @param[in] ptr memory block.
+      //! @param[in] size object size.
+      static void
+      operator delete(void* ptr, std::size_t size)
+      {
+        Pool::deallocate(ptr, size);
+      }
+
+      //! Reset the header to its default values (no source,
+      //! destination or timestamp).
+      void
+      clearHeader(void)
+      {
+        m_header.src = AddressResolver::invalid();
+        m_header.src_ent = DUNE_IMC_CONST_UNK_EID;
+        m_header.dst = AddressResolver::invalid();
+        m_header.dst_ent = DUNE_IMC_CONST_UNK_EID;
+        m_header.timestamp = -1.0;
+      }
+
       //! Retrieve a copy of the message.
       //! @return message copy.
       virtual Message*
@@ -366,6 +415,12 @@ namespace DUNE
         (void)other;
         return true;
       }
+
+    private:
+      //! Number of SharedMessage handles referencing this message.
+      mutable Concurrency::AtomicCounter m_refs;
+
+      friend class SharedMessage;
     };
   }
 }
@@ -0,0 +1,297 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <new>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/Concurrency/Mutex.hpp>
+#include <DUNE/Concurrency/ScopedMutex.hpp>
+#include <DUNE/Concurrency/TLS.hpp>
+#include <DUNE/IMC/Message.hpp>
+#include <DUNE/IMC/Pool.hpp>
+
+namespace DUNE
+{
+  namespace IMC
+  {
+    //! Size class granularity (bytes).
+    static const std::size_t c_granularity = 16;
+    //! Number of size classes. Larger objects are not cached.
+    static const unsigned c_size_classes = 128;
+    //! Maximum number of memory blocks per size class in a thread.
+    static const unsigned c_thread_blocks = 64;
+    //! Maximum number of memory blocks per size class in the depot.
+    static const unsigned c_depot_blocks = 4096;
+    //! Maximum number of objects per message type in a thread.
+    static const unsigned c_thread_objects = 16;
+    //! Maximum number of objects per message type in the depot.
+    static const unsigned c_depot_objects = 256;
+
+    typedef std::vector<void*> BlockList;
+    typedef std::vector<Message*> ObjectList;
+
+    //! Lists shared by all threads.
+    struct Depot
+    {
+      Concurrency::Mutex lock;
+      BlockList blocks[c_size_classes];
+      std::vector<ObjectList> objects;
+    };
+
+    //! Shared depot. It is never destroyed, since messages may be
+    //! released during static destruction.
+    static Depot&
+    getDepot(void)
+    {
+      static Depot* depot = new Depot;
+      return *depot;
+    }
+
+    //! True while the cache of the calling thread is being destroyed.
+    //! Caching is bypassed from then on, so that messages deleted by
+    //! the destructor do not create a new cache.
+    static thread_local bool t_exiting = false;
+
+    //! Lists owned by one thread.
+    struct ThreadCache
+    {
+      BlockList blocks[c_size_classes];
+      std::vector<ObjectList> objects;
+
+      //! Hand everything over to the depot when the thread exits.
+      //! Whatever does not fit within the depot limits is released.
+      ~ThreadCache(void)
+      {
+        t_exiting = true;
+
+        ObjectList excess;
+
+        {
+          Depot& depot = getDepot();
+          Concurrency::ScopedMutex l(depot.lock);
+
+          for (unsigned i = 0; i < c_size_classes; ++i)
+          {
+            BlockList& shared = depot.blocks[i];
+            for (unsigned j = 0; j < blocks[i].size(); ++j)
+            {
+              if (shared.size() < c_depot_blocks)
+                shared.push_back(blocks[i][j]);
+              else
+                ::operator delete(blocks[i][j]);
+            }
+          }
+
+          if (depot.objects.size() < objects.size())
+            depot.objects.resize(objects.size());
+
+          for (unsigned i = 0; i < objects.size(); ++i)
+          {
+            ObjectList& shared = depot.objects[i];
+            for (unsigned j = 0; j < objects[i].size(); ++j)
+            {
+              if (shared.size() < c_depot_objects)
+                shared.push_back(objects[i][j]);
+              else
+                excess.push_back(objects[i][j]);
+            }
+          }
+        }
+
+        for (unsigned i = 0; i < excess.size(); ++i)
+          delete excess[i];
+      }
+    };
+
+    static ThreadCache&
+    getThreadCache(void)
+    {
+      static Concurrency::TLS<ThreadCache>* tls = new Concurrency::TLS<ThreadCache>;
+      return tls->value();
+    }
+
+    static volatile bool s_enabled = true;
+
+    void*
+    Pool::allocate(std::size_t size)
+    {
+      unsigned sc = (unsigned)((size + c_granularity - 1) / c_granularity);
+      if (sc == 0 || sc > c_size_classes)
+        return ::operator new(size);
+
+      std::size_t bsize = sc * c_granularity;
+      if (!s_enabled || t_exiting)
+        return ::operator new(bsize);
+
+      BlockList& list = getThreadCache().blocks[sc - 1];
+      if (list.empty())
+      {
+        Depot& depot = getDepot();
+        Concurrency::ScopedMutex l(depot.lock);
+        BlockList& shared = depot.blocks[sc - 1];
+        std::size_t n = std::min<std::size_t>(shared.size(), c_thread_blocks / 2);
+        list.insert(list.end(), shared.end() - n, shared.end());
+        shared.resize(shared.size() - n);
+      }
+
+      if (list.empty())
+        return ::operator new(bsize);
+
+      void* ptr = list.back();
+      list.pop_back();
+      return ptr;
+    }
+
+    void
+    Pool::deallocate(void* ptr, std::size_t size)
+    {
+      if (ptr == NULL)
+        return;
+
+      unsigned sc = (unsigned)((size + c_granularity - 1) / c_granularity);
+      if (!s_enabled || t_exiting || sc == 0 || sc > c_size_classes)
+      {
+        ::operator delete(ptr);
+        return;
+      }
+
+      BlockList& list = getThreadCache().blocks[sc - 1];
+      if (list.size() >= c_thread_blocks)
+      {
+        Depot& depot = getDepot();
+        Concurrency::ScopedMutex l(depot.lock);
+        BlockList& shared = depot.blocks[sc - 1];
+        while (list.size() > c_thread_blocks / 2)
+        {
+          if (shared.size() < c_depot_blocks)
+            shared.push_back(list.back());
+          else
+            ::operator delete(list.back());
+          list.pop_back();
+        }
+      }
+
+      list.push_back(ptr);
+    }
+
+    Message*
+    Pool::take(uint16_t id)
+    {
+      if (!s_enabled || t_exiting)
+        return NULL;
+
+      ThreadCache& cache = getThreadCache();
+      if (cache.objects.size() <= id)
+        cache.objects.resize(id + 1);
+
+      ObjectList& list = cache.objects[id];
+      if (list.empty())
+      {
+        Depot& depot = getDepot();
+        Concurrency::ScopedMutex l(depot.lock);
+        if (depot.objects.size() <= id)
+          return NULL;
+
+        ObjectList& shared = depot.objects[id];
+        std::size_t n = std::min<std::size_t>(shared.size(), c_thread_objects / 2);
+        list.insert(list.end(), shared.end() - n, shared.end());
+        shared.resize(shared.size() - n);
+      }
+
+      if (list.empty())
+        return NULL;
+
+      Message* msg = list.back();
+      list.pop_back();
+      return msg;
+    }
+
+    bool
+    Pool::give(Message* msg)
+    {
+      if (!s_enabled || t_exiting)
+        return false;
+
+      uint16_t id = msg->getId();
+      ThreadCache& cache = getThreadCache();
+      if (cache.objects.size() <= id)
+        cache.objects.resize(id + 1);
+
+      ObjectList& list = cache.objects[id];
+      if (list.size() < c_thread_objects)
+      {
+        list.push_back(msg);
+        return true;
+      }
+
+      // Objects that do not fit in the depot are deleted after the
+      // lock is released, since deletion goes through deallocate().
+      Message* excess[c_thread_objects];
+      unsigned excess_count = 0;
+
+      {
+        Depot& depot = getDepot();
+        Concurrency::ScopedMutex l(depot.lock);
+        if (depot.objects.size() <= id)
+          depot.objects.resize(id + 1);
+
+        ObjectList& shared = depot.objects[id];
+        while (list.size() > c_thread_objects / 2)
+        {
+          if (shared.size() < c_depot_objects)
+            shared.push_back(list.back());
+          else
+            excess[excess_count++] = list.back();
+          list.pop_back();
+        }
+      }
+
+      for (unsigned i = 0; i < excess_count; ++i)
+        delete excess[i];
+
+      list.push_back(msg);
+      return true;
+    }
+
+    void
+    Pool::setEnabled(bool enabled)
+    {
+      s_enabled = enabled;
+    }
+
+    bool
+    Pool::isEnabled(void)
+    {
+      return s_enabled;
+    }
+  }
+}
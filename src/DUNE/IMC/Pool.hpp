@@ -0,0 +1,105 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+#ifndef DUNE_IMC_POOL_HPP_INCLUDED_
+#define DUNE_IMC_POOL_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <cstddef>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+
+namespace DUNE
+{
+  namespace IMC
+  {
+    // Export DLL Symbol.
+    class DUNE_DLL_SYM Pool;
+
+    // Forward declarations.
+    class Message;
+
+    //! Thread-cached freelists of message objects. Raw memory blocks
+    //! are cached per size class and back every message allocation
+    //! (see Message::operator new). Cleared message objects are cached
+    //! per message identification number so that the capacity of
+    //! their variable-length fields is reused. Each thread keeps its
+    //! own lists and exchanges batches with a shared depot, so
+    //! messages produced in one thread and released in another are
+    //! recycled as well. Objects whose payload exceeds c_max_payload
+    //! are not cached, so that occasional large messages do not pin
+    //! their capacity in the pool.
+    class Pool
+    {
+    public:
+      //! Largest payload (bytes) of a message object that is cached.
+      static const unsigned c_max_payload = 4096;
+
+      //! Allocate memory for a message object.
+      //! @param[in] size object size.
+      //! @return memory block.
+      static void*
+      allocate(std::size_t size);
+
+      //! Release memory previously returned by allocate().
+      //! @param[in] ptr memory block.
+      //! @param[in] size object size.
+      static void
+      deallocate(void* ptr, std::size_t size);
+
+      //! Take a cached message object.
+      //! @param[in] id message identification number.
+      //! @return cleared message object or NULL if none is cached.
+      static Message*
+      take(uint16_t id);
+
+      //! Cache a message object. The object must be cleared and must
+      //! not be referenced elsewhere.
+      //! @param[in] msg message object.
+      //! @return true if the object was cached, false if the caller
+      //! must delete it.
+      static bool
+      give(Message* msg);
+
+      //! Enable or disable caching. Memory blocks are always compatible
+      //! with the global allocator, so this can be changed at any time.
+      //! @param[in] enabled true to enable caching.
+      static void
+      setEnabled(bool enabled);
+
+      //! Check if caching is enabled.
+      //! @return true if caching is enabled, false otherwise.
+      static bool
+      isEnabled(void);
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,179 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+#ifndef DUNE_IMC_SHARED_MESSAGE_HPP_INCLUDED_
+#define DUNE_IMC_SHARED_MESSAGE_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <cstddef>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/IMC/Factory.hpp>
+#include <DUNE/IMC/Message.hpp>
+
+namespace DUNE
+{
+  namespace IMC
+  {
+    //! Reference counted handle to an immutable message. A message
+    //! published on the bus is cloned once and the same instance is
+    //! then shared by every recipient. The message is recycled (see
+    //! Factory::recycle) when the last handle referencing it is
+    //! released.
+    class SharedMessage
+    {
+    public:
+      //! Create a null handle.
+      SharedMessage(void):
+        m_msg(NULL)
+      { }
+
+      //! Create a handle that takes ownership of a heap allocated
+      //! message. The message must not be referenced by any other
+      //! handle and must not be deleted by the caller.
+      //! @param[in] msg message object.
+      explicit
+      SharedMessage(Message* msg):
+        m_msg(msg)
+      {
+        acquire();
+      }
+
+      //! Copy constructor.
+      //! @param[in] other handle to copy.
+      SharedMessage(const SharedMessage& other):
+        m_msg(other.m_msg)
+      {
+        acquire();
+      }
+
+      //! Destructor.
+      ~SharedMessage(void)
+      {
+        release();
+      }
+
+      //! Assignment operator.
+      //! @param[in] other handle to copy.
+      //! @return this handle.
+      SharedMessage&
+      operator=(const SharedMessage& other)
+      {
+        if (m_msg != other.m_msg)
+        {
+          release();
+          m_msg = other.m_msg;
+          acquire();
+        }
+
+        return *this;
+      }
+
+      //! Create a handle referencing a copy of a message.
+      //! @param[in] msg message to copy.
+      //! @return handle.
+      static SharedMessage
+      copy(const Message& msg)
+      {
+        return SharedMessage(Factory::clone(msg));
+      }
+
+      //! Release the referenced message, making this a null handle.
+      void
+      reset(void)
+      {
+        release();
+        m_msg = NULL;
+      }
+
+      //! Retrieve the referenced message.
+      //! @return message object or NULL.
+      const Message*
+      get(void) const
+      {
+        return m_msg;
+      }
+
+      //! Test if the handle does not reference a message.
+      //! @return true if handle is null, false otherwise.
+      bool
+      isNull(void) const
+      {
+        return m_msg == NULL;
+      }
+
+      const Message*
+      operator->(void) const
+      {
+        return m_msg;
+      }
+
+      const Message&
+      operator*(void) const
+      {
+        return *m_msg;
+      }
+
+      //! Retrieve the number of handles referencing the message.
+      //! @return reference count.
+      int
+      getReferenceCount(void) const
+      {
+        if (m_msg == NULL)
+          return 0;
+
+        return m_msg->m_refs.add(0);
+      }
+
+    private:
+      //! Referenced message.
+      Message* m_msg;
+
+      void
+      acquire(void)
+      {
+        if (m_msg != NULL)
+          m_msg->m_refs.add(1);
+      }
+
+      void
+      release(void)
+      {
+        if (m_msg == NULL)
+          return;
+
+        if (m_msg->m_refs.sub(1) == 0)
+          Factory::recycle(m_msg);
+      }
+    };
+  }
+}
+
+#endif
@@ -34,6 +34,7 @@
 // DUNE headers.
 #include <DUNE/Config.hpp>
 #include <DUNE/System/Error.hpp>
+#include <DUNE/Time/Clock.hpp>
 #include <DUNE/Time/Constants.hpp>
 #include <DUNE/Time/Utils.hpp>
 #include <DUNE/IO/Poll.hpp>
@@ -82,6 +83,11 @@ namespace DUNE
     bool
     Poll::poll(double timeout)
     {
+      // A thread woken by virtual time is done with its work when it
+      // blocks.
+      if (timeout != 0)
+        Time::Clock::setIdle();
+
 #if defined(DUNE_OS_WINDOWS)
       DWORD count = m_handles.size();
       m_rv = WaitForMultipleObjects(count, &m_handles[0], FALSE, timeout * 1000);
@@ -139,6 +145,9 @@ namespace DUNE
     bool
     Poll::poll(const NativeHandle& handle, double timeout)
     {
+      if (timeout != 0)
+        Time::Clock::setIdle();
+
 #if defined(DUNE_OS_WINDOWS)
       DWORD rv = WaitForSingleObjectEx(handle, timeout * 1000, FALSE);
       return rv == WAIT_OBJECT_0;
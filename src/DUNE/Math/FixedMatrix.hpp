@@ -0,0 +1,623 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+#ifndef DUNE_MATH_FIXED_MATRIX_HPP_INCLUDED_
+#define DUNE_MATH_FIXED_MATRIX_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <ostream>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/Math/General.hpp>
+#include <DUNE/Math/Matrix.hpp>
+
+//! Alignment of fixed size matrix storage. This is the alignment
+//! guaranteed by operator new, so fixed size matrices may be members
+//! of heap allocated objects.
+#define DUNE_MATH_FIXED_MATRIX_ALIGNMENT alignof(std::max_align_t)
+
+namespace DUNE
+{
+  namespace Math
+  {
+    //! Matrix with dimensions known at compile time. Elements are
+    //! stored in row-major order, like Matrix, inside the object, so
+    //! creating, copying and operating on fixed size matrices never
+    //! allocates memory. Indexes are not checked, dimensions of
+    //! operands are checked by the compiler.
+    template <unsigned R, unsigned C>
+    class FixedMatrix
+    {
+    public:
+      //! Number of rows.
+      static const unsigned c_rows = R;
+      //! Number of columns.
+      static const unsigned c_columns = C;
+      //! Number of elements.
+      static const unsigned c_size = R * C;
+
+      //! Constructor.
+      //! Construct a matrix filled with zeros.
+      FixedMatrix(void)
+      {
+        fill(0.0);
+      }
+
+      //! Constructor.
+      //! Construct a matrix filled with a constant value.
+      //! @param[in] value value used to initialize cells.
+      explicit FixedMatrix(double value)
+      {
+        fill(value);
+      }
+
+      //! Constructor.
+      //! Construct a matrix from row-major data.
+      //! @param[in] data pointer to R * C values.
+      explicit FixedMatrix(const double* data)
+      {
+        for (unsigned i = 0; i < c_size; ++i)
+          m_data[i] = data[i];
+      }
+
+      //! Constructor.
+      //! Construct a matrix from a dynamic matrix.
+      //! @param[in] m matrix with the same dimensions.
+      explicit FixedMatrix(const Matrix& m)
+      {
+        *this = m;
+      }
+
+      //! Copy the contents of a dynamic matrix.
+      //! @param[in] m matrix with the same dimensions.
+      //! @return reference to this matrix.
+      FixedMatrix&
+      operator=(const Matrix& m)
+      {
+        if ((size_t)m.rows() != R || (size_t)m.columns() != C)
+          throw Matrix::Error("Invalid dimension!");
+
+        const double* src = m.begin();
+        for (unsigned i = 0; i < c_size; ++i)
+          m_data[i] = src[i];
+
+        return *this;
+      }
+
+      //! Create a dynamic matrix with the same contents.
+      //! @return dynamic matrix.
+      Matrix
+      toMatrix(void) const
+      {
+        return Matrix(m_data, R, C);
+      }
+
+      //! Number of rows.
+      static unsigned
+      rows(void)
+      {
+        return R;
+      }
+
+      //! Number of columns.
+      static unsigned
+      columns(void)
+      {
+        return C;
+      }
+
+      //! Number of elements.
+      static unsigned
+      size(void)
+      {
+        return c_size;
+      }
+
+      //! Pointer to first element.
+      double*
+      begin(void)
+      {
+        return m_data;
+      }
+
+      //! Pointer to element after last element.
+      double*
+      end(void)
+      {
+        return m_data + c_size;
+      }
+
+      //! Pointer to first element.
+      const double*
+      begin(void) const
+      {
+        return m_data;
+      }
+
+      //! Pointer to element after last element.
+      const double*
+      end(void) const
+      {
+        return m_data + c_size;
+      }
+
+      //! Access an element.
+      //! @param[in] i row index.
+      //! @param[in] j column index.
+      //! @return reference to element.
+      double&
+      operator()(unsigned i, unsigned j)
+      {
+        return m_data[i * C + j];
+      }
+
+      //! Access an element.
+      //! @param[in] i row index.
+      //! @param[in] j column index.
+      //! @return element.
+      double
+      operator()(unsigned i, unsigned j) const
+      {
+        return m_data[i * C + j];
+      }
+
+      //! Access an element in row-major order.
+      //! @param[in] i element index.
+      //! @return reference to element.
+      double&
+      operator()(unsigned i)
+      {
+        return m_data[i];
+      }
+
+      //! Access an element in row-major order.
+      //! @param[in] i element index.
+      //! @return element.
+      double
+      operator()(unsigned i) const
+      {
+        return m_data[i];
+      }
+
+      //! Fill matrix with a constant value.
+      //! @param[in] value value.
+      void
+      fill(double value)
+      {
+        for (unsigned i = 0; i < c_size; ++i)
+          m_data[i] = value;
+      }
+
+      //! Make this matrix an identity matrix.
+      void
+      identity(void)
+      {
+        static_assert(R == C, "identity matrix must be square");
+
+        fill(0.0);
+        for (unsigned i = 0; i < R; ++i)
+          m_data[i * C + i] = 1.0;
+      }
+
+      //! Extract a submatrix.
+      //! @param[in] i row of the first element.
+      //! @param[in] j column of the first element.
+      //! @return submatrix.
+      template <unsigned R2, unsigned C2>
+      FixedMatrix<R2, C2>
+      get(unsigned i, unsigned j) const
+      {
+        FixedMatrix<R2, C2> m;
+        for (unsigned r = 0; r < R2; ++r)
+          for (unsigned c = 0; c < C2; ++c)
+            m(r, c) = m_data[(i + r) * C + j + c];
+
+        return m;
+      }
+
+      //! Overwrite a submatrix.
+      //! @param[in] i row of the first element.
+      //! @param[in] j column of the first element.
+      //! @param[in] m submatrix.
+      template <unsigned R2, unsigned C2>
+      void
+      put(unsigned i, unsigned j, const FixedMatrix<R2, C2>& m)
+      {
+        for (unsigned r = 0; r < R2; ++r)
+          for (unsigned c = 0; c < C2; ++c)
+            m_data[(i + r) * C + j + c] = m(r, c);
+      }
+
+      FixedMatrix&
+      operator+=(const FixedMatrix& m)
+      {
+        for (unsigned i = 0; i < c_size; ++i)
+          m_data[i] += m.m_data[i];
+
+        return *this;
+      }
+
+      FixedMatrix&
+      operator-=(const FixedMatrix& m)
+      {
+        for (unsigned i = 0; i < c_size; ++i)
+          m_data[i] -= m.m_data[i];
+
+        return *this;
+      }
+
+      FixedMatrix&
+      operator*=(double x)
+      {
+        for (unsigned i = 0; i < c_size; ++i)
+          m_data[i] *= x;
+
+        return *this;
+      }
+
+      FixedMatrix&
+      operator/=(double x)
+      {
+        return *this *= (1.0 / x);
+      }
+
+      FixedMatrix
+      operator-(void) const
+      {
+        FixedMatrix m(*this);
+        for (unsigned i = 0; i < c_size; ++i)
+          m.m_data[i] = -m.m_data[i];
+
+        return m;
+      }
+
+      bool
+      operator==(const FixedMatrix& m) const
+      {
+        for (unsigned i = 0; i < c_size; ++i)
+        {
+          if (m_data[i] != m.m_data[i])
+            return false;
+        }
+
+        return true;
+      }
+
+      //! Compute the sum of the diagonal elements.
+      //! @return trace.
+      double
+      trace(void) const
+      {
+        static_assert(R == C, "trace of a nonsquare matrix");
+
+        double t = 0;
+        for (unsigned i = 0; i < R; ++i)
+          t += m_data[i * C + i];
+
+        return t;
+      }
+
+      //! Compute the euclidean norm of the elements.
+      //! @return norm.
+      double
+      norm_2(void) const
+      {
+        double n = 0;
+        for (unsigned i = 0; i < c_size; ++i)
+          n += m_data[i] * m_data[i];
+
+        return std::sqrt(n);
+      }
+
+      //! Compute the matrix exponential using the same scaling and
+      //! squaring of the Taylor series as Matrix::expmts().
+      //! @param[in] tol series convergence tolerance.
+      //! @return matrix exponential.
+      FixedMatrix
+      expmts(double tol = 1e-05) const;
+
+    private:
+      //! Elements in row-major order.
+      alignas(DUNE_MATH_FIXED_MATRIX_ALIGNMENT) double m_data[c_size];
+    };
+
+    template <unsigned R, unsigned C>
+    inline FixedMatrix<R, C>
+    operator+(const FixedMatrix<R, C>& a, const FixedMatrix<R, C>& b)
+    {
+      FixedMatrix<R, C> m(a);
+      return m += b;
+    }
+
+    template <unsigned R, unsigned C>
+    inline FixedMatrix<R, C>
+    operator-(const FixedMatrix<R, C>& a, const FixedMatrix<R, C>& b)
+    {
+      FixedMatrix<R, C> m(a);
+      return m -= b;
+    }
+
+    template <unsigned R, unsigned C>
+    inline FixedMatrix<R, C>
+    operator*(double x, const FixedMatrix<R, C>& a)
+    {
+      FixedMatrix<R, C> m(a);
+      return m *= x;
+    }
+
+    template <unsigned R, unsigned C>
+    inline FixedMatrix<R, C>
+    operator*(const FixedMatrix<R, C>& a, double x)
+    {
+      FixedMatrix<R, C> m(a);
+      return m *= x;
+    }
+
+    template <unsigned R, unsigned C>
+    inline FixedMatrix<R, C>
+    operator/(const FixedMatrix<R, C>& a, double x)
+    {
+      FixedMatrix<R, C> m(a);
+      return m /= x;
+    }
+
+    //! Compute a * b into a given matrix, which must not be one of
+    //! the operands.
+    //! @param[in] a left operand.
+    //! @param[in] b right operand.
+    //! @param[out] out result.
+    template <unsigned R, unsigned K, unsigned C>
+    inline void
+    multiply(const FixedMatrix<R, K>& a, const FixedMatrix<K, C>& b, FixedMatrix<R, C>& out)
+    {
+      // Rows of b are traversed contiguously so that the inner loop
+      // vectorizes.
+      for (unsigned i = 0; i < R; ++i)
+      {
+        double* o = out.begin() + i * C;
+        for (unsigned j = 0; j < C; ++j)
+          o[j] = 0.0;
+
+        for (unsigned k = 0; k < K; ++k)
+        {
+          double aik = a(i, k);
+          const double* brow = b.begin() + k * C;
+          for (unsigned j = 0; j < C; ++j)
+            o[j] += aik * brow[j];
+        }
+      }
+    }
+
+    template <unsigned R, unsigned K, unsigned C>
+    inline FixedMatrix<R, C>
+    operator*(const FixedMatrix<R, K>& a, const FixedMatrix<K, C>& b)
+    {
+      FixedMatrix<R, C> m;
+      multiply(a, b, m);
+      return m;
+    }
+
+    //! Compute a * transpose(b) without forming the transpose.
+    //! @param[in] a left operand.
+    //! @param[in] b right operand.
+    //! @param[out] out result, must not be one of the operands.
+    template <unsigned R, unsigned K, unsigned C>
+    inline void
+    multiplyTransposed(const FixedMatrix<R, K>& a, const FixedMatrix<C, K>& b, FixedMatrix<R, C>& out)
+    {
+      for (unsigned i = 0; i < R; ++i)
+      {
+        const double* arow = a.begin() + i * K;
+        for (unsigned j = 0; j < C; ++j)
+        {
+          const double* brow = b.begin() + j * K;
+          double s = 0.0;
+          for (unsigned k = 0; k < K; ++k)
+            s += arow[k] * brow[k];
+
+          out(i, j) = s;
+        }
+      }
+    }
+
+    //! Compute a * p * transpose(a) + q for a symmetric matrix p,
+    //! the covariance propagation step of Kalman filters. Only the
+    //! upper triangle is computed and the result is exactly
+    //! symmetric.
+    //! @param[in] a transformation.
+    //! @param[in] p symmetric matrix.
+    //! @param[in] q symmetric matrix added to the result.
+    //! @param[out] out result, must not be one of the operands.
+    template <unsigned R, unsigned C>
+    inline void
+    congruence(const FixedMatrix<R, C>& a, const FixedMatrix<C, C>& p,
+               const FixedMatrix<R, R>& q, FixedMatrix<R, R>& out)
+    {
+      // a * p, whose rows are dotted with rows of a.
+      FixedMatrix<R, C> ap;
+      multiply(a, p, ap);
+
+      for (unsigned i = 0; i < R; ++i)
+      {
+        const double* aprow = ap.begin() + i * C;
+        for (unsigned j = i; j < R; ++j)
+        {
+          const double* arow = a.begin() + j * C;
+          double s = 0.0;
+          for (unsigned k = 0; k < C; ++k)
+            s += aprow[k] * arow[k];
+
+          out(i, j) = s + q(i, j);
+          out(j, i) = out(i, j);
+        }
+      }
+    }
+
+    template <unsigned R, unsigned C>
+    inline FixedMatrix<C, R>
+    transpose(const FixedMatrix<R, C>& a)
+    {
+      FixedMatrix<C, R> m;
+      for (unsigned i = 0; i < R; ++i)
+        for (unsigned j = 0; j < C; ++j)
+          m(j, i) = a(i, j);
+
+      return m;
+    }
+
+    //! Invert a square matrix using Gauss-Jordan elimination with
+    //! partial pivoting.
+    //! @param[in] a matrix.
+    //! @param[out] out inverse.
+    //! @return false if the matrix is singular, true otherwise.
+    template <unsigned N>
+    inline bool
+    inverse(const FixedMatrix<N, N>& a, FixedMatrix<N, N>& out)
+    {
+      FixedMatrix<N, N> m(a);
+      out.identity();
+
+      for (unsigned c = 0; c < N; ++c)
+      {
+        unsigned pivot = c;
+        for (unsigned r = c + 1; r < N; ++r)
+        {
+          if (std::fabs(m(r, c)) > std::fabs(m(pivot, c)))
+            pivot = r;
+        }
+
+        if (std::fabs(m(pivot, c)) < Matrix::get_precision())
+          return false;
+
+        if (pivot != c)
+        {
+          for (unsigned j = 0; j < N; ++j)
+          {
+            std::swap(m(c, j), m(pivot, j));
+            std::swap(out(c, j), out(pivot, j));
+          }
+        }
+
+        double f = 1.0 / m(c, c);
+        for (unsigned j = 0; j < N; ++j)
+        {
+          m(c, j) *= f;
+          out(c, j) *= f;
+        }
+
+        for (unsigned r = 0; r < N; ++r)
+        {
+          if (r == c || m(r, c) == 0.0)
+            continue;
+
+          double g = m(r, c);
+          for (unsigned j = 0; j < N; ++j)
+          {
+            m(r, j) -= g * m(c, j);
+            out(r, j) -= g * out(c, j);
+          }
+        }
+      }
+
+      return true;
+    }
+
+    template <unsigned N>
+    inline FixedMatrix<N, N>
+    inverse(const FixedMatrix<N, N>& a)
+    {
+      FixedMatrix<N, N> m;
+      if (!inverse(a, m))
+        throw Matrix::Error("Inversion error!");
+
+      return m;
+    }
+
+    template <unsigned R, unsigned C>
+    FixedMatrix<R, C>
+    FixedMatrix<R, C>::expmts(double tol) const
+    {
+      static_assert(R == C, "source matrix is not square");
+
+      unsigned m = computeNextPowerOfTwo((uint32_t)norm_2());
+
+      FixedMatrix<R, C> a(*this);
+      if (m > 1)
+        a *= (1.0 / m);
+
+      FixedMatrix<R, C> ea;
+      ea.identity();
+      FixedMatrix<R, C> p;
+      p.identity();
+      FixedMatrix<R, C> t;
+
+      double n2 = 1;
+      double inv_f = 1;
+      int i = 0;
+
+      while (true)
+      {
+        inv_f = inv_f * (1.0 / ++i);
+        multiply(p, a, t);
+        p = t;
+
+        for (unsigned k = 0; k < c_size; ++k)
+          ea.m_data[k] += inv_f * p.m_data[k];
+
+        double n2b = ea.norm_2();
+        if (std::fabs(n2b - n2) < tol)
+          break;
+
+        n2 = n2b;
+      }
+
+      // Squaring.
+      for (unsigned k = 1; k < m; k = k << 1)
+      {
+        multiply(ea, ea, t);
+        ea = t;
+      }
+
+      return ea;
+    }
+
+    template <unsigned R, unsigned C>
+    inline std::ostream&
+    operator<<(std::ostream& os, const FixedMatrix<R, C>& a)
+    {
+      return os << a.toMatrix();
+    }
+  }
+}
+
+#endif
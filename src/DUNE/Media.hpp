@@ -41,5 +41,6 @@ namespace DUNE
 #include <DUNE/Media/VideoIIDC1394.hpp>
 #include <DUNE/Media/BayerDecoder.hpp>
 #include <DUNE/Media/MJPG/Encoder.hpp>
+#include <DUNE/Media/FramePipeline.hpp>
 
 #endif
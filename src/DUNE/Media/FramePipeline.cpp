@@ -0,0 +1,360 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cstdio>
+#include <stdexcept>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/Media/FramePipeline.hpp>
+#include <DUNE/Concurrency/ScopedCondition.hpp>
+#include <DUNE/Concurrency/Thread.hpp>
+#include <DUNE/Streams/Terminal.hpp>
+#include <DUNE/System/Error.hpp>
+#include <DUNE/Time/Clock.hpp>
+
+namespace DUNE
+{
+  namespace Media
+  {
+    using Concurrency::ScopedCondition;
+
+    //! Worker thread.
+    class FramePipeline::Worker: public Concurrency::Thread
+    {
+    public:
+      Worker(FramePipeline& pipeline, Processor* processor):
+        m_pipeline(pipeline),
+        m_processor(processor)
+      { }
+
+    private:
+      FramePipeline& m_pipeline;
+      Processor* m_processor;
+
+      void
+      run(void)
+      {
+        m_pipeline.runWorker(m_processor);
+      }
+    };
+
+    //! Writer thread.
+    class FramePipeline::Output: public Concurrency::Thread
+    {
+    public:
+      Output(FramePipeline& pipeline):
+        m_pipeline(pipeline)
+      { }
+
+    private:
+      FramePipeline& m_pipeline;
+
+      void
+      run(void)
+      {
+        m_pipeline.runOutput();
+      }
+    };
+
+    void
+    FramePipeline::FileWriter::write(Frame& frame)
+    {
+      if (frame.getPath().empty())
+        return;
+
+      std::FILE* fd = std::fopen(frame.getPath().c_str(), "wb");
+      if (fd == NULL)
+        throw std::runtime_error(System::Error::getLastMessage());
+
+      Utils::ByteBuffer* bfr = frame.getOutput();
+      size_t rv = std::fwrite(bfr->getBuffer(), 1, bfr->getSize(), fd);
+      std::fclose(fd);
+
+      if (rv != bfr->getSize())
+        throw std::runtime_error(System::Error::getLastMessage());
+    }
+
+    FramePipeline::FramePipeline(unsigned frames, unsigned input_size, unsigned output_size, Writer* writer):
+      m_writer(writer),
+      m_output(NULL),
+      m_stopping(false),
+      m_value(0),
+      m_has_value(false),
+      m_drops(0),
+      m_writes(0)
+    {
+      if (m_writer == NULL)
+        m_writer = new FileWriter;
+
+      for (unsigned i = 0; i < frames; ++i)
+        m_frames.push_back(new Frame(input_size, output_size));
+
+      m_free = m_frames;
+    }
+
+    FramePipeline::~FramePipeline(void)
+    {
+      stop();
+
+      for (unsigned i = 0; i < m_processors.size(); ++i)
+        delete m_processors[i];
+
+      for (unsigned i = 0; i < m_frames.size(); ++i)
+        delete m_frames[i];
+
+      delete m_writer;
+    }
+
+    void
+    FramePipeline::addProcessor(Processor* processor)
+    {
+      m_processors.push_back(processor);
+    }
+
+    void
+    FramePipeline::start(void)
+    {
+      m_stopping = false;
+
+      for (unsigned i = 0; i < m_processors.size(); ++i)
+      {
+        m_workers.push_back(new Worker(*this, m_processors[i]));
+        m_workers.back()->start();
+      }
+
+      m_output = new Output(*this);
+      m_output->start();
+    }
+
+    bool
+    FramePipeline::flush(double timeout)
+    {
+      double deadline = Time::Clock::get() + timeout;
+
+      ScopedCondition l(m_free_cond);
+      while (m_free.size() < m_frames.size())
+      {
+        double remaining = deadline - Time::Clock::get();
+        if (remaining <= 0)
+          return false;
+
+        m_free_cond.wait(remaining);
+      }
+
+      return true;
+    }
+
+    void
+    FramePipeline::stop(void)
+    {
+      {
+        ScopedCondition l(m_cond);
+        m_stopping = true;
+        m_cond.broadcast();
+      }
+
+      for (unsigned i = 0; i < m_workers.size(); ++i)
+      {
+        m_workers[i]->stopAndJoin();
+        delete m_workers[i];
+      }
+
+      m_workers.clear();
+
+      if (m_output != NULL)
+      {
+        m_output->stopAndJoin();
+        delete m_output;
+        m_output = NULL;
+      }
+
+      // Discard pending frames.
+      ScopedCondition l(m_cond);
+      while (!m_process_queue.empty())
+      {
+        putFree(m_process_queue.front());
+        m_process_queue.pop_front();
+      }
+
+      while (!m_write_queue.empty())
+      {
+        putFree(m_write_queue.front());
+        m_write_queue.pop_front();
+      }
+    }
+
+    FramePipeline::Frame*
+    FramePipeline::getFreeFrame(void)
+    {
+      ScopedCondition l(m_free_cond);
+      if (m_free.empty())
+      {
+        ++m_drops;
+        return NULL;
+      }
+
+      Frame* frame = m_free.back();
+      m_free.pop_back();
+      frame->reset();
+      return frame;
+    }
+
+    void
+    FramePipeline::putFree(Frame* frame)
+    {
+      ScopedCondition l(m_free_cond);
+      m_free.push_back(frame);
+      m_free_cond.broadcast();
+    }
+
+    void
+    FramePipeline::put(Frame* frame)
+    {
+      ScopedCondition l(m_cond);
+      if (m_processors.empty())
+        m_write_queue.push_back(frame);
+      else
+        m_process_queue.push_back(frame);
+
+      m_cond.broadcast();
+    }
+
+    bool
+    FramePipeline::getValue(double& value)
+    {
+      ScopedCondition l(m_free_cond);
+      if (!m_has_value)
+        return false;
+
+      value = m_value;
+      m_has_value = false;
+      return true;
+    }
+
+    unsigned
+    FramePipeline::getDropCount(void)
+    {
+      ScopedCondition l(m_free_cond);
+      return m_drops;
+    }
+
+    unsigned
+    FramePipeline::getWriteCount(void)
+    {
+      ScopedCondition l(m_free_cond);
+      return m_writes;
+    }
+
+    unsigned
+    FramePipeline::getPendingCount(void)
+    {
+      ScopedCondition l(m_cond);
+      return m_process_queue.size() + m_write_queue.size();
+    }
+
+    FramePipeline::Frame*
+    FramePipeline::dequeue(std::deque<Frame*>& queue)
+    {
+      ScopedCondition l(m_cond);
+      while (queue.empty() && !m_stopping)
+        m_cond.wait();
+
+      if (m_stopping)
+        return NULL;
+
+      Frame* frame = queue.front();
+      queue.pop_front();
+      return frame;
+    }
+
+    void
+    FramePipeline::runWorker(Processor* processor)
+    {
+      while (true)
+      {
+        Frame* frame = dequeue(m_process_queue);
+        if (frame == NULL)
+          break;
+
+        try
+        {
+          processor->process(*frame);
+        }
+        catch (std::exception& e)
+        {
+          DUNE_ERR("FramePipeline", "failed to process frame: " << e.what());
+          putFree(frame);
+          continue;
+        }
+
+        ScopedCondition l(m_cond);
+        m_write_queue.push_back(frame);
+        m_cond.broadcast();
+      }
+    }
+
+    void
+    FramePipeline::runOutput(void)
+    {
+      while (true)
+      {
+        Frame* frame = dequeue(m_write_queue);
+        if (frame == NULL)
+          break;
+
+        bool stored = true;
+
+        try
+        {
+          m_writer->write(*frame);
+        }
+        catch (std::exception& e)
+        {
+          DUNE_ERR("FramePipeline", "failed to store frame: " << e.what());
+          stored = false;
+        }
+
+        ScopedCondition l(m_free_cond);
+        if (stored)
+          ++m_writes;
+
+        if (frame->hasValue())
+        {
+          m_value = frame->getValue();
+          m_has_value = true;
+        }
+
+        m_free.push_back(frame);
+        m_free_cond.broadcast();
+      }
+    }
+  }
+}
@@ -0,0 +1,350 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+#ifndef DUNE_MEDIA_FRAME_PIPELINE_HPP_INCLUDED_
+#define DUNE_MEDIA_FRAME_PIPELINE_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <deque>
+#include <string>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/Concurrency/Condition.hpp>
+#include <DUNE/Utils/ByteBuffer.hpp>
+
+namespace DUNE
+{
+  namespace Media
+  {
+    // Export DLL Symbol.
+    class DUNE_DLL_SYM FramePipeline;
+
+    //! Multi-threaded image processing pipeline.
+    //!
+    //! Frames are taken from a pool of preallocated buffers, filled by
+    //! the capture thread and handed to a set of worker threads that
+    //! run the processing stage (e.g., debayering and compression).
+    //! Processed frames are then stored by a single writer thread and
+    //! returned to the pool. When all frames are in use the capture
+    //! thread is not blocked: getFreeFrame() returns NULL and the frame
+    //! is accounted as dropped.
+    //!
+    //! With more than one worker, frames may reach the writer out of
+    //! order. Pipelines without processors are served in order.
+    class FramePipeline
+    {
+    public:
+      //! Pipeline frame.
+      class Frame
+      {
+      public:
+        //! Constructor.
+        //! @param[in] input_size initial capacity of the input buffer.
+        //! @param[in] output_size initial capacity of the output buffer.
+        Frame(unsigned input_size, unsigned output_size):
+          m_input(input_size),
+          m_output(output_size),
+          m_timestamp(-1),
+          m_value(0),
+          m_has_value(false)
+        { }
+
+        //! Prepare frame for a new capture.
+        void
+        reset(void)
+        {
+          m_input.setSize(0);
+          m_output.setSize(0);
+          m_path.clear();
+          m_timestamp = -1;
+          m_value = 0;
+          m_has_value = false;
+        }
+
+        //! Set capture time.
+        //! @param[in] timestamp capture time.
+        void
+        setTimeStamp(double timestamp)
+        {
+          m_timestamp = timestamp;
+        }
+
+        //! Get capture time.
+        //! @return capture time.
+        double
+        getTimeStamp(void) const
+        {
+          return m_timestamp;
+        }
+
+        //! Get raw image buffer, filled by the capture thread.
+        //! @return raw image buffer.
+        Utils::ByteBuffer*
+        getInput(void)
+        {
+          return &m_input;
+        }
+
+        //! Get processed image buffer, filled by the processor.
+        //! @return processed image buffer.
+        Utils::ByteBuffer*
+        getOutput(void)
+        {
+          return &m_output;
+        }
+
+        //! Set destination file of the processed image.
+        //! @param[in] path file path.
+        void
+        setPath(const std::string& path)
+        {
+          m_path = path;
+        }
+
+        //! Get destination file of the processed image.
+        //! @return file path.
+        const std::string&
+        getPath(void) const
+        {
+          return m_path;
+        }
+
+        //! Set value computed by the processor (e.g., exposure
+        //! correction) to be fed back to the capture thread.
+        //! @param[in] value computed value.
+        void
+        setValue(double value)
+        {
+          m_value = value;
+          m_has_value = true;
+        }
+
+        //! Get value computed by the processor.
+        //! @return computed value.
+        double
+        getValue(void) const
+        {
+          return m_value;
+        }
+
+        //! Test if the processor computed a value.
+        //! @return true if a value is available, false otherwise.
+        bool
+        hasValue(void) const
+        {
+          return m_has_value;
+        }
+
+      private:
+        //! Raw image.
+        Utils::ByteBuffer m_input;
+        //! Processed image.
+        Utils::ByteBuffer m_output;
+        //! Destination file.
+        std::string m_path;
+        //! Capture time.
+        double m_timestamp;
+        //! Computed value.
+        double m_value;
+        //! True if a value was computed.
+        bool m_has_value;
+      };
+
+      //! Processing stage. Each worker thread owns one processor, so
+      //! implementations may keep per-thread state (e.g., codecs).
+      class Processor
+      {
+      public:
+        virtual
+        ~Processor(void)
+        { }
+
+        //! Process a frame.
+        //! @param[in,out] frame frame.
+        virtual void
+        process(Frame& frame) = 0;
+      };
+
+      //! Storage stage, executed by the writer thread.
+      class Writer
+      {
+      public:
+        virtual
+        ~Writer(void)
+        { }
+
+        //! Store a processed frame.
+        //! @param[in] frame frame.
+        virtual void
+        write(Frame& frame) = 0;
+      };
+
+      //! Writer that stores the output buffer of each frame in the file
+      //! given by the frame path.
+      class FileWriter: public Writer
+      {
+      public:
+        void
+        write(Frame& frame);
+      };
+
+      //! Constructor.
+      //! @param[in] frames number of preallocated frames.
+      //! @param[in] input_size initial capacity of input buffers.
+      //! @param[in] output_size initial capacity of output buffers.
+      //! @param[in] writer storage stage. The pipeline takes ownership
+      //! of this object. If NULL a FileWriter is used.
+      FramePipeline(unsigned frames, unsigned input_size, unsigned output_size, Writer* writer = NULL);
+
+      //! Destructor. Stops all threads.
+      ~FramePipeline(void);
+
+      //! Add a processing stage served by its own worker thread. Must
+      //! be called before start(). The pipeline takes ownership of
+      //! the processor.
+      //! @param[in] processor processor.
+      void
+      addProcessor(Processor* processor);
+
+      //! Start worker and writer threads.
+      void
+      start(void);
+
+      //! Wait for all queued frames to be stored.
+      //! @param[in] timeout maximum amount of time to wait (s).
+      //! @return true if all frames were stored, false otherwise.
+      bool
+      flush(double timeout);
+
+      //! Stop and join all threads. Frames not yet stored are
+      //! discarded, call flush() beforehand to keep them.
+      void
+      stop(void);
+
+      //! Get an unused frame. Never blocks.
+      //! @return frame or NULL if all frames are in use.
+      Frame*
+      getFreeFrame(void);
+
+      //! Return an unused frame to the pool.
+      //! @param[in] frame frame.
+      void
+      putFree(Frame* frame);
+
+      //! Queue a frame for processing and storage.
+      //! @param[in] frame frame.
+      void
+      put(Frame* frame);
+
+      //! Get the most recent value computed by the processors. Each
+      //! value is returned only once.
+      //! @param[out] value computed value.
+      //! @return true if a new value was available, false otherwise.
+      bool
+      getValue(double& value);
+
+      //! Get number of frames that could not be captured because the
+      //! pipeline was full.
+      //! @return number of dropped frames.
+      unsigned
+      getDropCount(void);
+
+      //! Get number of frames stored so far.
+      //! @return number of stored frames.
+      unsigned
+      getWriteCount(void);
+
+      //! Get number of frames waiting to be processed or stored.
+      //! @return number of pending frames.
+      unsigned
+      getPendingCount(void);
+
+    private:
+      class Worker;
+      class Output;
+
+      //! Preallocated frames.
+      std::vector<Frame*> m_frames;
+      //! Unused frames.
+      std::vector<Frame*> m_free;
+      //! Frames waiting for processing.
+      std::deque<Frame*> m_process_queue;
+      //! Frames waiting for storage.
+      std::deque<Frame*> m_write_queue;
+      //! Condition guarding both queues.
+      Concurrency::Condition m_cond;
+      //! Condition guarding unused frames and counters.
+      Concurrency::Condition m_free_cond;
+      //! Processors, one per worker thread.
+      std::vector<Processor*> m_processors;
+      //! Worker threads.
+      std::vector<Worker*> m_workers;
+      //! Storage stage.
+      Writer* m_writer;
+      //! Writer thread.
+      Output* m_output;
+      //! True if threads must exit.
+      bool m_stopping;
+      //! Most recent computed value.
+      double m_value;
+      //! True if m_value was not yet read.
+      bool m_has_value;
+      //! Number of dropped frames.
+      unsigned m_drops;
+      //! Number of stored frames.
+      unsigned m_writes;
+
+      //! Wait for a frame in a queue.
+      //! @param[in] queue queue.
+      //! @return frame or NULL if the pipeline is stopping.
+      Frame*
+      dequeue(std::deque<Frame*>& queue);
+
+      //! Body of worker threads.
+      //! @param[in] processor processor.
+      void
+      runWorker(Processor* processor);
+
+      //! Body of the writer thread.
+      void
+      runOutput(void);
+
+      //! Non-copyable.
+      FramePipeline(const FramePipeline&);
+
+      //! Non-assignable.
+      FramePipeline&
+      operator=(const FramePipeline&);
+    };
+  }
+}
+
+#endif
@@ -37,9 +37,11 @@ namespace DUNE
   { }
 }
 
+#include <DUNE/Navigation/AbstractKalmanFilter.hpp>
 #include <DUNE/Navigation/BasicNavigation.hpp>
 #include <DUNE/Navigation/BeamFilter.hpp>
 #include <DUNE/Navigation/CompassCalibration.hpp>
+#include <DUNE/Navigation/FixedKalmanFilter.hpp>
 #include <DUNE/Navigation/KalmanFilter.hpp>
 #include <DUNE/Navigation/Ranging.hpp>
 #include <DUNE/Navigation/StreamEstimator.hpp>
@@ -0,0 +1,112 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: José Braga                                                       *
+//***************************************************************************
+
+#ifndef DUNE_NAVIGATION_ABSTRACT_KALMAN_FILTER_HPP_INCLUDED_
+#define DUNE_NAVIGATION_ABSTRACT_KALMAN_FILTER_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <cstddef>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/Math/Matrix.hpp>
+
+namespace DUNE
+{
+  namespace Navigation
+  {
+    // Export DLL Symbol.
+    class DUNE_DLL_SYM AbstractKalmanFilter;
+
+    //! Operations shared by Kalman filters with dynamic
+    //! (KalmanFilter) and fixed (FixedKalmanFilter) dimensions,
+    //! allowing generic navigation code to access either of them.
+    class AbstractKalmanFilter
+    {
+    public:
+      //! Destructor.
+      virtual
+      ~AbstractKalmanFilter(void)
+      { }
+
+      //! Get filter state value.
+      //! @param pos state index.
+      //! @return state value.
+      virtual double
+      getState(short pos) const = 0;
+
+      //! Set filter state value.
+      //! @param pos state index.
+      //! @param value state value.
+      virtual void
+      setState(short pos, double value) = 0;
+
+      //! Reset state vector.
+      virtual void
+      resetState(void) = 0;
+
+      //! Get covariance matrix value.
+      //! @param ln row index.
+      //! @param cl column index.
+      //! @return covariance matrix value.
+      virtual double
+      getCovariance(short ln, short cl) const = 0;
+
+      //! Get state covariance submatrix.
+      //! @param i1 lower row index.
+      //! @param i2 upper row index.
+      //! @param j1 lower column index.
+      //! @param j2 upper column index.
+      //! @return state covariance submatrix.
+      virtual Math::Matrix
+      getCovariance(size_t i1, size_t i2, size_t j1, size_t j2) const = 0;
+
+      //! Set observation model matrix value.
+      //! @param ln row index.
+      //! @param cl column index.
+      //! @param value observation model matrix value.
+      virtual void
+      setObservation(short ln, short cl, double value) = 0;
+
+      //! Set output vector value.
+      //! @param pos output index.
+      //! @param value output value.
+      virtual void
+      setOutput(short pos, double value) = 0;
+
+      //! Set innovation vector value.
+      //! @param pos output index.
+      //! @param value innovation value.
+      virtual void
+      setInnovation(short pos, double value) = 0;
+    };
+  }
+}
+
+#endif
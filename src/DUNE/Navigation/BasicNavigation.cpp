@@ -611,8 +611,8 @@ namespace DUNE
         m_estate.height = msg->height;
 
         // Set position estimate at the origin.
-        m_kal.setState(STATE_X, 0);
-        m_kal.setState(STATE_Y, 0);
+        getFilter().setState(STATE_X, 0);
+        getFilter().setState(STATE_Y, 0);
 
         spew("defined new navigation reference");
         return;
@@ -742,8 +742,8 @@ namespace DUNE
       m_ranging.getLocation(beacon, &x, &y, &z);
 
       // Compute expected range.
-      double dx = m_kal.getState(STATE_X) + m_dist_lbl_gps * std::cos(getEuler(AXIS_Z)) - x;
-      double dy = m_kal.getState(STATE_Y) + m_dist_lbl_gps * std::sin(getEuler(AXIS_Z)) - y;
+      double dx = getFilter().getState(STATE_X) + m_dist_lbl_gps * std::cos(getEuler(AXIS_Z)) - x;
+      double dy = getFilter().getState(STATE_Y) + m_dist_lbl_gps * std::sin(getEuler(AXIS_Z)) - y;
       double dz = getDepth() - z;
       double exp_range = std::sqrt(dx * dx + dy * dy + dz * dz);
 
@@ -889,7 +889,7 @@ namespace DUNE
       m_estate.height = m_origin->height;
 
       // Set position of the vehicle at the origin and reset filter state.
-      m_kal.resetState();
+      getFilter().resetState();
 
       // Possibly correct LBL locations.
       m_ranging.updateOrigin(m_origin);
@@ -928,7 +928,7 @@ namespace DUNE
       H(0, 0) = dx / exp_range;
       H(0, 1) = dy / exp_range;
       Math::Matrix P(2, 2, 0.0);
-      P = m_kal.getCovariance(STATE_X, STATE_Y, STATE_X, STATE_Y);
+      P = getFilter().getCovariance(STATE_X, STATE_Y, STATE_X, STATE_Y);
 
       double k = getLblRejectionValue(exp_range);
       double R = std::max(k, (H * P * transpose (H))(0));
@@ -948,12 +948,12 @@ namespace DUNE
         unsigned index = getNumberOutputs() + beacon;
 
         // Define measurements matrix.
-        m_kal.setObservation(index, STATE_X, dx / exp_range);
-        m_kal.setObservation(index, STATE_Y, dy / exp_range);
+        getFilter().setObservation(index, STATE_X, dx / exp_range);
+        getFilter().setObservation(index, STATE_Y, dy / exp_range);
 
         // Define Output matrix.
-        m_kal.setOutput(index, range);
-        m_kal.setInnovation(index, range - exp_range);
+        getFilter().setOutput(index, range);
+        getFilter().setInnovation(index, range - exp_range);
         m_lbl_ac.acceptance = IMC::LblRangeAcceptance::RR_ACCEPTED;
         dispatch(m_lbl_ac, DF_KEEP_TIME);
         m_lbl_reading = true;
@@ -972,13 +972,13 @@ namespace DUNE
 
       if (m_valid_gv)
       {
-        m_kal.setOutput(u, m_gvel.x);
-        m_kal.setOutput(v, m_gvel.y);
+        getFilter().setOutput(u, m_gvel.x);
+        getFilter().setOutput(v, m_gvel.y);
       }
       else if (m_valid_wv)
       {
-        m_kal.setOutput(u, m_wvel.x);
-        m_kal.setOutput(v, m_wvel.y);
+        getFilter().setOutput(u, m_wvel.x);
+        getFilter().setOutput(v, m_wvel.y);
       }
     }
 
@@ -993,8 +993,8 @@ namespace DUNE
     void
     BasicNavigation::onDispatchNavigation(void)
     {
-      m_estate.x = m_kal.getState(STATE_X);
-      m_estate.y = m_kal.getState(STATE_Y);
+      m_estate.x = getFilter().getState(STATE_X);
+      m_estate.y = getFilter().getState(STATE_Y);
       m_estate.z = m_last_z + getDepth();
       m_estate.phi = Math::Angles::normalizeRadian(getEuler(AXIS_X));
       m_estate.theta = Math::Angles::normalizeRadian(getEuler(AXIS_Y));
@@ -1009,8 +1009,8 @@ namespace DUNE
                                                    m_estate.u, m_estate.v, m_estate.w,
                                                    &m_estate.vx, &m_estate.vy, &m_estate.vz);
 
-      m_uncertainty.x = m_kal.getCovariance(STATE_X, STATE_X);
-      m_uncertainty.y = m_kal.getCovariance(STATE_Y, STATE_Y);
+      m_uncertainty.x = getFilter().getCovariance(STATE_X, STATE_X);
+      m_uncertainty.y = getFilter().getCovariance(STATE_Y, STATE_Y);
       m_navdata.cyaw = m_heading;
     }
 
@@ -1131,7 +1131,7 @@ namespace DUNE
     BasicNavigation::checkUncertainty(bool abort)
     {
       // Compute maximum horizontal position variance value.
-      float hpos_var = std::max(m_kal.getCovariance(STATE_X, STATE_X), m_kal.getCovariance(STATE_Y, STATE_Y));
+      float hpos_var = std::max(getFilter().getCovariance(STATE_X, STATE_X), getFilter().getCovariance(STATE_Y, STATE_Y));
 
       // Check if it exceeds the specified threshold value.
       if (hpos_var > m_max_hpos_var)
@@ -43,6 +43,7 @@
 #include <DUNE/Math/Angles.hpp>
 #include <DUNE/Math/Derivative.hpp>
 #include <DUNE/Math/MovingAverage.hpp>
+#include <DUNE/Navigation/AbstractKalmanFilter.hpp>
 #include <DUNE/Navigation/KalmanFilter.hpp>
 #include <DUNE/Navigation/Ranging.hpp>
 #include <DUNE/Navigation/StreamEstimator.hpp>
@@ -467,6 +468,11 @@ namespace DUNE
       virtual unsigned
       getNumberOutputs(void) = 0;
 
+      //! Get the EKF used by the navigation task.
+      //! @return Kalman filter.
+      virtual AbstractKalmanFilter&
+      getFilter(void) = 0;
+
       //! Routine called to assign common dispatch messages.
       void
       onDispatchNavigation(void);
@@ -517,8 +523,6 @@ namespace DUNE
       void
       checkDeclination(double lat, double lon, double height);
 
-      //! Kalman Filter matrices.
-      Navigation::KalmanFilter m_kal;
       //! Ranging data.
       Navigation::Ranging m_ranging;
       //! Stream Estimator.
@@ -0,0 +1,956 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: José Braga                                                       *
+//***************************************************************************
+// Kalman filter with dimensions known at compile time. Same model and      *
+// interface as KalmanFilter, but all matrices are FixedMatrix objects, so  *
+// prediction and update steps do not allocate memory.                      *
+//                                                                          *
+// Besides the dense update, outputs can be processed one at a time as      *
+// scalar measurements (O(n^2) each instead of inverting the innovation     *
+// covariance), either updating the covariance in Joseph form or keeping    *
+// it factorized as U * D * U' (Bierman update, Thornton time update).      *
+// Sequential updates treat measurement noise as uncorrelated (only the     *
+// diagonal of R is used) and skip outputs with null observation rows.      *
+//***************************************************************************
+
+#ifndef DUNE_NAVIGATION_FIXED_KALMAN_FILTER_HPP_INCLUDED_
+#define DUNE_NAVIGATION_FIXED_KALMAN_FILTER_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <stdexcept>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/Math/FixedMatrix.hpp>
+#include <DUNE/Navigation/AbstractKalmanFilter.hpp>
+
+namespace DUNE
+{
+  namespace Navigation
+  {
+    //! Kalman filter with N states and up to M outputs. The number of
+    //! active outputs may change at runtime (see resize()); inactive
+    //! outputs have null observation rows and innovations and unit
+    //! measurement noise, so they do not change the estimate.
+    template <unsigned N, unsigned M>
+    class FixedKalmanFilter: public AbstractKalmanFilter
+    {
+    public:
+      //! Measurement update methods.
+      enum UpdateMethod
+      {
+        //! Joint update of all outputs.
+        UM_DENSE,
+        //! Scalar updates, covariance in Joseph form.
+        UM_SEQUENTIAL,
+        //! Scalar updates, covariance factorized as U * D * U'.
+        UM_SQUARE_ROOT
+      };
+
+      //! State vector type.
+      typedef Math::FixedMatrix<N, 1> StateVector;
+      //! Output vector type.
+      typedef Math::FixedMatrix<M, 1> OutputVector;
+      //! State matrix type.
+      typedef Math::FixedMatrix<N, N> StateMatrix;
+      //! Observation model type.
+      typedef Math::FixedMatrix<M, N> ObservationMatrix;
+      //! Output matrix type.
+      typedef Math::FixedMatrix<M, M> OutputMatrix;
+
+      //! Constructor.
+      FixedKalmanFilter(void):
+        m_method(UM_DENSE)
+      {
+        reset(N, M);
+      }
+
+      //! Select the measurement update method.
+      //! @param method update method.
+      void
+      setUpdateMethod(UpdateMethod method)
+      {
+        writeCovariance();
+        m_method = method;
+      }
+
+      //! Get the measurement update method.
+      //! @return update method.
+      UpdateMethod
+      getUpdateMethod(void) const
+      {
+        return m_method;
+      }
+
+      //! Set initial conditions (state and covariance matrix).
+      //! @param x0 state.
+      //! @param P0 covariance.
+      void
+      initialize(const StateVector& x0, const StateMatrix& P0)
+      {
+        m_x = x0;
+        writeCovariance() = P0;
+      }
+
+      //! Reset all matrices.
+      //! @param num_states number of filter states, must be N.
+      //! @param num_outputs number of active outputs, up to M.
+      void
+      reset(short num_states, short num_outputs)
+      {
+        if (num_states != (short)N || num_outputs < 0 || num_outputs > (short)M)
+          throw std::runtime_error(DTR("invalid dimensions"));
+
+        m_x.fill(0.0);
+        m_y.fill(0.0);
+        m_ax.identity();
+        m_ap.identity();
+        m_c.fill(0.0);
+        m_p.fill(0.0);
+        m_p_valid = true;
+        m_ud_valid = false;
+        m_q.fill(0.0);
+        m_q_valid = false;
+        m_r.fill(0.0);
+        m_innov.fill(0.0);
+        m_outputs = 0;
+        resize(num_outputs);
+      }
+
+      //! Change the number of active outputs, keeping the values of
+      //! outputs that remain active.
+      //! @param num_outputs number of active outputs, up to M.
+      //! @return true if resized, false otherwise.
+      bool
+      resize(short num_outputs)
+      {
+        if (num_outputs < 0 || num_outputs > (short)M)
+          throw std::runtime_error(DTR("invalid dimensions"));
+
+        if ((unsigned)num_outputs == m_outputs)
+          return false;
+
+        m_outputs = num_outputs;
+
+        for (unsigned i = m_outputs; i < M; ++i)
+        {
+          m_y(i) = 0.0;
+          m_innov(i) = 0.0;
+
+          for (unsigned j = 0; j < N; ++j)
+            m_c(i, j) = 0.0;
+
+          for (unsigned j = 0; j < M; ++j)
+          {
+            m_r(i, j) = 0.0;
+            m_r(j, i) = 0.0;
+          }
+
+          m_r(i, i) = 1.0;
+        }
+
+        return true;
+      }
+
+      //! Get number of active outputs.
+      //! @return number of outputs.
+      unsigned
+      getOutputCount(void) const
+      {
+        return m_outputs;
+      }
+
+      //! Keep the state covariance matrix symmetric.
+      void
+      normalize(void)
+      {
+        // Factorized covariances are symmetric by construction.
+        if (m_method == UM_SQUARE_ROOT)
+          return;
+
+        for (unsigned i = 0; i < N; ++i)
+        {
+          for (unsigned j = i + 1; j < N; ++j)
+          {
+            double v = 0.5 * (m_p(i, j) + m_p(j, i));
+            m_p(i, j) = v;
+            m_p(j, i) = v;
+          }
+        }
+      }
+
+      //! Predict the state at the next timestep subject to control input.
+      //! @param b control input matrix.
+      //! @param u input vector.
+      template <unsigned K>
+      void
+      predict(const Math::FixedMatrix<N, K>& b, const Math::FixedMatrix<K, 1>& u)
+      {
+        predict();
+
+        Math::multiply(b, u, m_tx);
+        m_x += m_tx;
+      }
+
+      //! Predict the state at the next timestep assuming no input.
+      void
+      predict(void)
+      {
+        Math::multiply(m_ax, m_x, m_tx);
+        m_x = m_tx;
+
+        if (m_method == UM_SQUARE_ROOT)
+        {
+          predictFactors();
+          return;
+        }
+
+        Math::congruence(m_ap, m_p, m_q, m_tp);
+        m_p = m_tp;
+      }
+
+      //! Kalman Filter update function. With sequential methods the
+      //! threshold applies to the normalized innovation of each output
+      //! and rejected outputs are skipped.
+      //! @param threshold threshold to reject large state innovations.
+      //! @return 0 if update is successful, -1 otherwise.
+      int
+      update(float threshold)
+      {
+        if (m_method != UM_DENSE)
+          return updateSequential(threshold);
+
+        // Measurement prediction covariance.
+        Math::congruence(m_c, m_p, m_r, m_s);
+
+        // Inverse of the measurement prediction covariance.
+        if (!Math::inverse(m_s, m_s_1))
+          throw std::runtime_error(DTR("matrix inversion error"));
+
+        // Check if innovation is above a threshold value.
+        // Set threshold to 0 to accept everything.
+        if (threshold != 0)
+        {
+          Math::multiply(m_s_1, m_innov, m_ty);
+
+          double level = 0;
+          for (unsigned i = 0; i < m_outputs; ++i)
+            level += m_innov(i) * m_ty(i);
+
+          if (level >= threshold)
+            return -1;
+        }
+
+        // Kalman Gain.
+        Math::multiplyTransposed(m_p, m_c, m_pct);
+        Math::multiply(m_pct, m_s_1, m_k);
+
+        // State update.
+        Math::multiply(m_k, m_innov, m_tx);
+        m_x += m_tx;
+
+        // State Covariance update.
+        Math::multiply(m_c, m_p, m_cp);
+        Math::multiply(m_k, m_cp, m_tp);
+        m_p -= m_tp;
+
+        return 0;
+      }
+
+      //! Get filter state value.
+      //! @param pos state index.
+      //! @return state value.
+      double
+      getState(short pos) const
+      {
+        if (pos < 0 || (unsigned)pos >= N)
+          throw std::runtime_error(DTR("invalid index"));
+
+        return m_x(pos);
+      }
+
+      //! Get state vector.
+      //! @return state vector.
+      const StateVector&
+      getState(void) const
+      {
+        return m_x;
+      }
+
+      //! Set filter state value.
+      //! @param pos state index.
+      //! @param value state value.
+      void
+      setState(short pos, double value)
+      {
+        if (pos < 0 || (unsigned)pos >= N)
+          throw std::runtime_error(DTR("invalid index"));
+
+        m_x(pos) = value;
+      }
+
+      //! Reset state vector.
+      void
+      resetState(void)
+      {
+        m_x.fill(0.0);
+      }
+
+      //! Get state transition matrix.
+      //! @return state transition matrix.
+      const StateMatrix&
+      getStateTransition(void) const
+      {
+        return m_ax;
+      }
+
+      //! Set state transition matrix.
+      //! @param a state transition matrix.
+      void
+      setStateTransition(const StateMatrix& a)
+      {
+        m_ax = a;
+      }
+
+      //! Get state covariance transition matrix.
+      //! @return state covariance transition matrix.
+      const StateMatrix&
+      getCovarianceTransition(void) const
+      {
+        return m_ap;
+      }
+
+      //! Set state covariance transition matrix.
+      //! @param a state covariance transition matrix.
+      void
+      setCovarianceTransition(const StateMatrix& a)
+      {
+        m_ap = a;
+      }
+
+      //! Set transition matrices.
+      //! @param a state transition matrix.
+      void
+      setTransitions(const StateMatrix& a)
+      {
+        m_ax = a;
+        m_ap = a;
+      }
+
+      //! Reset output vector, innovations and observation model.
+      void
+      resetOutputs(void)
+      {
+        m_y.fill(0.0);
+        m_innov.fill(0.0);
+        m_c.fill(0.0);
+      }
+
+      //! Get output vector value.
+      //! @param pos output index.
+      //! @return output value.
+      double
+      getOutput(short pos) const
+      {
+        checkOutput(pos);
+        return m_y(pos);
+      }
+
+      //! Set output vector value.
+      //! @param pos output index.
+      //! @param value output value.
+      void
+      setOutput(short pos, double value)
+      {
+        checkOutput(pos);
+        m_y(pos) = value;
+      }
+
+      //! Get innovation vector value.
+      //! @param pos output index.
+      //! @return innovation value.
+      double
+      getInnovation(short pos) const
+      {
+        checkOutput(pos);
+        return m_innov(pos);
+      }
+
+      //! Set innovation vector value.
+      //! @param pos output index.
+      //! @param value innovation value.
+      void
+      setInnovation(short pos, double value)
+      {
+        checkOutput(pos);
+        m_innov(pos) = value;
+      }
+
+      //! Get observation model.
+      //! @return observation model.
+      const ObservationMatrix&
+      getObservation(void) const
+      {
+        return m_c;
+      }
+
+      //! Set observation model matrix value.
+      //! @param ln row index.
+      //! @param cl column index.
+      //! @param value observation model matrix value.
+      void
+      setObservation(short ln, short cl, double value)
+      {
+        checkOutput(ln);
+        checkState(cl);
+        m_c(ln, cl) = value;
+      }
+
+      //! Get covariance matrix value.
+      //! @param ln row index.
+      //! @param cl column index.
+      //! @return covariance matrix value.
+      double
+      getCovariance(short ln, short cl) const
+      {
+        checkState(ln);
+        checkState(cl);
+        return readCovariance()(ln, cl);
+      }
+
+      //! Get covariance matrix diagonal value.
+      //! @param in row and column index.
+      //! @return covariance matrix value.
+      double
+      getCovariance(short in) const
+      {
+        return getCovariance(in, in);
+      }
+
+      //! Get state covariance submatrix.
+      //! @param i1 lower row index.
+      //! @param i2 upper row index.
+      //! @param j1 lower column index.
+      //! @param j2 upper column index.
+      //! @return state covariance submatrix.
+      Math::Matrix
+      getCovariance(size_t i1, size_t i2, size_t j1, size_t j2) const
+      {
+        return readCovariance().toMatrix().get(i1, i2, j1, j2);
+      }
+
+      //! Get state covariance matrix.
+      //! @return state covariance matrix.
+      const StateMatrix&
+      getCovariance(void) const
+      {
+        return readCovariance();
+      }
+
+      //! Set state covariance matrix value.
+      //! @param ln row index.
+      //! @param cl column index.
+      //! @param value state covariance matrix value.
+      void
+      setCovariance(short ln, short cl, double value)
+      {
+        checkState(ln);
+        checkState(cl);
+        writeCovariance()(ln, cl) = value;
+      }
+
+      //! Set state covariance matrix diagonal value.
+      //! @param in row and column index.
+      //! @param value state covariance matrix value.
+      void
+      setCovariance(short in, double value)
+      {
+        setCovariance(in, in, value);
+      }
+
+      //! Set all state covariance matrix diagonal values.
+      //! @param value state covariance matrix value.
+      void
+      setCovariance(double value)
+      {
+        StateMatrix& p = writeCovariance();
+        for (unsigned i = 0; i < N; ++i)
+          p(i, i) = value;
+      }
+
+      //! Reset the covariances of a state.
+      //! @param in state index.
+      void
+      resetCovariance(short in)
+      {
+        checkState(in);
+        StateMatrix& p = writeCovariance();
+        for (unsigned i = 0; i < N; ++i)
+        {
+          p(i, in) = 0.0;
+          p(in, i) = 0.0;
+        }
+      }
+
+      //! Set process noise covariance matrix value.
+      //! @param ln row index.
+      //! @param cl column index.
+      //! @param value process noise covariance matrix value.
+      void
+      setProcessNoise(short ln, short cl, double value)
+      {
+        checkState(ln);
+        checkState(cl);
+        m_q(ln, cl) = value;
+        m_q_valid = false;
+      }
+
+      //! Set process noise covariance matrix diagonal value.
+      //! @param in row and column index.
+      //! @param value process noise covariance matrix value.
+      void
+      setProcessNoise(short in, double value)
+      {
+        setProcessNoise(in, in, value);
+      }
+
+      //! Set all process noise covariance matrix diagonal values.
+      //! @param value process noise covariance matrix value.
+      void
+      setProcessNoise(double value)
+      {
+        for (unsigned i = 0; i < N; ++i)
+          m_q(i, i) = value;
+
+        m_q_valid = false;
+      }
+
+      //! Set measurement noise covariance matrix value.
+      //! @param ln row index.
+      //! @param cl column index.
+      //! @param value measurement noise covariance matrix value.
+      void
+      setMeasurementNoise(short ln, short cl, double value)
+      {
+        checkOutput(ln);
+        checkOutput(cl);
+        m_r(ln, cl) = value;
+      }
+
+      //! Set measurement noise covariance matrix diagonal value.
+      //! @param in row and column index.
+      //! @param value measurement noise covariance matrix value.
+      void
+      setMeasurementNoise(short in, double value)
+      {
+        setMeasurementNoise(in, in, value);
+      }
+
+      //! Set all active measurement noise covariance matrix diagonal
+      //! values.
+      //! @param value measurement noise covariance matrix value.
+      void
+      setMeasurementNoise(double value)
+      {
+        for (unsigned i = 0; i < m_outputs; ++i)
+          m_r(i, i) = value;
+      }
+
+    private:
+      //! Measurement update method.
+      UpdateMethod m_method;
+      //! Number of active outputs.
+      unsigned m_outputs;
+      //! State vector.
+      StateVector m_x;
+      //! Output vector.
+      OutputVector m_y;
+      //! State transition matrix.
+      StateMatrix m_ax;
+      //! State covariance transition matrix.
+      StateMatrix m_ap;
+      //! Output transition matrix.
+      ObservationMatrix m_c;
+      //! State covariance matrix, rebuilt from its factors on demand.
+      mutable StateMatrix m_p;
+      //! True if m_p is up to date.
+      mutable bool m_p_valid;
+      //! Unit upper triangular factor of the state covariance.
+      StateMatrix m_u;
+      //! Diagonal factor of the state covariance.
+      StateVector m_d;
+      //! True if m_u and m_d are up to date.
+      bool m_ud_valid;
+      //! Factors of the process noise covariance.
+      StateMatrix m_qu;
+      StateVector m_qd;
+      //! True if m_qu and m_qd are up to date.
+      bool m_q_valid;
+      //! Process noise covariance matrix.
+      StateMatrix m_q;
+      //! Measurement noise covariance matrix.
+      OutputMatrix m_r;
+      //! Innovation vector.
+      OutputVector m_innov;
+      //! Workspace: measurement prediction covariance and its inverse.
+      OutputMatrix m_s;
+      OutputMatrix m_s_1;
+      //! Workspace: Kalman gain and P * C'.
+      Math::FixedMatrix<N, M> m_k;
+      Math::FixedMatrix<N, M> m_pct;
+      //! Workspace: C * P.
+      ObservationMatrix m_cp;
+      //! Workspace: scalar update vectors.
+      StateVector m_ty_state;
+      StateVector m_k_state;
+      //! Workspace: state sized temporaries.
+      StateVector m_tx;
+      StateMatrix m_tp;
+      OutputVector m_ty;
+      //! Workspace: weighted Gram-Schmidt rows and weights.
+      Math::FixedMatrix<N, 2 * N> m_w;
+      Math::FixedMatrix<2 * N, 1> m_dw;
+
+      //! Get the state covariance, rebuilding it from its factors
+      //! if needed.
+      //! @return state covariance.
+      const StateMatrix&
+      readCovariance(void) const
+      {
+        if (!m_p_valid)
+        {
+          // P = U * D * U'
+          for (unsigned i = 0; i < N; ++i)
+          {
+            for (unsigned j = i; j < N; ++j)
+            {
+              double v = 0.0;
+              for (unsigned k = j; k < N; ++k)
+                v += m_u(i, k) * m_d(k) * m_u(j, k);
+
+              m_p(i, j) = v;
+              m_p(j, i) = v;
+            }
+          }
+
+          m_p_valid = true;
+        }
+
+        return m_p;
+      }
+
+      //! Get the state covariance for modification, invalidating its
+      //! factors.
+      //! @return state covariance.
+      StateMatrix&
+      writeCovariance(void)
+      {
+        readCovariance();
+        m_ud_valid = false;
+        return m_p;
+      }
+
+      //! Factorize a symmetric positive semidefinite matrix as
+      //! U * D * U'. Non-positive pivots are treated as zero.
+      //! @param[in] p matrix.
+      //! @param[out] u unit upper triangular factor.
+      //! @param[out] d diagonal factor.
+      static void
+      factorize(const StateMatrix& p, StateMatrix& u, StateVector& d)
+      {
+        u.identity();
+
+        for (int j = N - 1; j >= 0; --j)
+        {
+          double dj = p(j, j);
+          for (unsigned k = j + 1; k < N; ++k)
+            dj -= d(k) * u(j, k) * u(j, k);
+
+          d(j) = (dj > 0.0) ? dj : 0.0;
+
+          for (int i = 0; i < j; ++i)
+          {
+            if (d(j) == 0.0)
+            {
+              u(i, j) = 0.0;
+              continue;
+            }
+
+            double v = p(i, j);
+            for (unsigned k = j + 1; k < N; ++k)
+              v -= d(k) * u(i, k) * u(j, k);
+
+            u(i, j) = v / d(j);
+          }
+        }
+      }
+
+      //! Make sure the covariance factors are up to date.
+      void
+      readFactors(void)
+      {
+        if (!m_ud_valid)
+        {
+          factorize(m_p, m_u, m_d);
+          m_ud_valid = true;
+        }
+      }
+
+      //! Propagate the covariance factors through the covariance
+      //! transition matrix (Thornton's modified weighted Gram-Schmidt).
+      void
+      predictFactors(void)
+      {
+        readFactors();
+
+        if (!m_q_valid)
+        {
+          factorize(m_q, m_qu, m_qd);
+          m_q_valid = true;
+        }
+
+        // W = [Ap * U, Uq], Dw = [D, Dq].
+        Math::multiply(m_ap, m_u, m_tp);
+        m_w.put(0, 0, m_tp);
+        m_w.put(0, N, m_qu);
+        for (unsigned k = 0; k < N; ++k)
+        {
+          m_dw(k) = m_d(k);
+          m_dw(N + k) = m_qd(k);
+        }
+
+        m_u.identity();
+
+        for (int j = N - 1; j >= 0; --j)
+        {
+          double dj = 0.0;
+          for (unsigned k = 0; k < 2 * N; ++k)
+            dj += m_w(j, k) * m_w(j, k) * m_dw(k);
+
+          m_d(j) = dj;
+
+          for (int i = 0; i < j; ++i)
+          {
+            if (dj <= 0.0)
+            {
+              m_u(i, j) = 0.0;
+              continue;
+            }
+
+            double v = 0.0;
+            for (unsigned k = 0; k < 2 * N; ++k)
+              v += m_w(i, k) * m_dw(k) * m_w(j, k);
+
+            v /= dj;
+            m_u(i, j) = v;
+
+            for (unsigned k = 0; k < 2 * N; ++k)
+              m_w(i, k) -= v * m_w(j, k);
+          }
+        }
+
+        m_p_valid = false;
+      }
+
+      //! Process each active output with a non-null observation row
+      //! as a scalar measurement.
+      //! @param threshold threshold to reject large innovations.
+      //! @return 0 if all outputs were used, -1 otherwise.
+      int
+      updateSequential(float threshold)
+      {
+        if (m_method == UM_SQUARE_ROOT)
+          readFactors();
+
+        // Innovations were computed with the prior state.
+        StateVector& prior = m_tx;
+        prior = m_x;
+        int rv = 0;
+
+        for (unsigned i = 0; i < m_outputs; ++i)
+        {
+          const double* h = m_c.begin() + i * N;
+
+          bool observed = false;
+          double correction = 0.0;
+          for (unsigned j = 0; j < N; ++j)
+          {
+            if (h[j] != 0.0)
+            {
+              observed = true;
+              correction += h[j] * (m_x(j) - prior(j));
+            }
+          }
+
+          if (!observed)
+            continue;
+
+          double innov = m_innov(i) - correction;
+          bool accepted;
+          if (m_method == UM_SQUARE_ROOT)
+            accepted = updateFactors(h, m_r(i, i), innov, threshold);
+          else
+            accepted = updateJoseph(h, m_r(i, i), innov, threshold);
+
+          if (!accepted)
+            rv = -1;
+        }
+
+        return rv;
+      }
+
+      //! Scalar measurement update of the state covariance in Joseph
+      //! form, P = (I - K * h) * P * (I - K * h)' + K * r * K', which
+      //! for a single measurement reduces to rank-one corrections.
+      //! @param[in] h observation row.
+      //! @param[in] r measurement noise variance.
+      //! @param[in] innov innovation.
+      //! @param[in] threshold threshold to reject large innovations.
+      //! @return true if the measurement was used.
+      bool
+      updateJoseph(const double* h, double r, double innov, float threshold)
+      {
+        // b = P * h'
+        StateVector& b = m_ty_state;
+        for (unsigned j = 0; j < N; ++j)
+        {
+          double v = 0.0;
+          for (unsigned k = 0; k < N; ++k)
+            v += m_p(j, k) * h[k];
+
+          b(j) = v;
+        }
+
+        double s = r;
+        for (unsigned j = 0; j < N; ++j)
+          s += h[j] * b(j);
+
+        if (s <= 0.0)
+          return false;
+
+        if (threshold != 0 && innov * innov / s >= threshold)
+          return false;
+
+        // K = b / s
+        StateVector& k = m_k_state;
+        for (unsigned j = 0; j < N; ++j)
+          k(j) = b(j) / s;
+
+        for (unsigned j = 0; j < N; ++j)
+          m_x(j) += k(j) * innov;
+
+        // P - K * b' - b * K' + s * K * K'
+        for (unsigned i = 0; i < N; ++i)
+        {
+          for (unsigned j = i; j < N; ++j)
+          {
+            double v = m_p(i, j) - k(i) * b(j) - b(i) * k(j) + s * k(i) * k(j);
+            m_p(i, j) = v;
+            m_p(j, i) = v;
+          }
+        }
+
+        return true;
+      }
+
+      //! Scalar measurement update of the covariance factors
+      //! (Bierman).
+      //! @param[in] h observation row.
+      //! @param[in] r measurement noise variance.
+      //! @param[in] innov innovation.
+      //! @param[in] threshold threshold to reject large innovations.
+      //! @return true if the measurement was used.
+      bool
+      updateFactors(const double* h, double r, double innov, float threshold)
+      {
+        // f = U' * h', g = D * f
+        StateVector& f = m_ty_state;
+        StateVector& g = m_k_state;
+        for (unsigned j = 0; j < N; ++j)
+        {
+          double v = 0.0;
+          for (unsigned k = 0; k <= j; ++k)
+            v += m_u(k, j) * h[k];
+
+          f(j) = v;
+          g(j) = m_d(j) * v;
+        }
+
+        double s = r;
+        for (unsigned j = 0; j < N; ++j)
+          s += f(j) * g(j);
+
+        if (s <= 0.0 || r <= 0.0)
+          return false;
+
+        if (threshold != 0 && innov * innov / s >= threshold)
+          return false;
+
+        // Unnormalized gain accumulates in g.
+        double alpha = r;
+        for (unsigned j = 0; j < N; ++j)
+        {
+          double beta = alpha;
+          alpha += f(j) * g(j);
+          double lambda = -f(j) / beta;
+          m_d(j) *= beta / alpha;
+
+          double gj = g(j);
+          for (unsigned i = 0; i < j; ++i)
+          {
+            double uij = m_u(i, j);
+            m_u(i, j) = uij + g(i) * lambda;
+            g(i) += gj * uij;
+          }
+        }
+
+        for (unsigned j = 0; j < N; ++j)
+          m_x(j) += g(j) / alpha * innov;
+
+        m_p_valid = false;
+        return true;
+      }
+
+      void
+      checkState(short pos) const
+      {
+        if (pos < 0 || (unsigned)pos >= N)
+          throw std::runtime_error(DTR("invalid index"));
+      }
+
+      void
+      checkOutput(short pos) const
+      {
+        if (pos < 0 || (unsigned)pos >= m_outputs)
+          throw std::runtime_error(DTR("invalid index"));
+      }
+    };
+  }
+}
+
+#endif
@@ -50,6 +50,7 @@
 // DUNE headers.
 #include <DUNE/Config.hpp>
 #include <DUNE/Math.hpp>
+#include <DUNE/Navigation/AbstractKalmanFilter.hpp>
 
 namespace DUNE
 {
@@ -58,7 +59,7 @@ namespace DUNE
     // Export DLL Symbol.
     class DUNE_DLL_SYM KalmanFilter;
 
-    class KalmanFilter
+    class KalmanFilter: public AbstractKalmanFilter
     {
     public:
       //! Constructor.
@@ -28,7 +28,9 @@
 //***************************************************************************
 
 // ISO C++ 98 headers.
+#include <algorithm>
 #include <cerrno>
+#include <cstring>
 
 // DUNE headers.
 #include <DUNE/Config.hpp>
@@ -93,6 +95,9 @@ namespace DUNE
 {
   namespace Network
   {
+    //! Maximum number of datagrams per system call.
+    static const size_t c_batch_size = 64;
+
     UDPSocket::UDPSocket(void):
       m_con_port(0)
     {
@@ -220,16 +225,121 @@ namespace DUNE
       int rv = sendto(m_handle, (const char*)buffer, size, 0, (::sockaddr*)&host_sai, (::socklen_t)sock_len);
 
       if (rv == -1)
+        throwWriteError(host);
+
+      return rv;
+    }
+
+    size_t
+    UDPSocket::write(const Datagram* datagrams, size_t count)
+    {
+      size_t sent = 0;
+#if defined(DUNE_SYS_HAS_SENDMMSG)
+      size_t done = 0;
+
+      while (done < count)
       {
-        if (errno == EHOSTUNREACH)
-          throw HostUnreachable(host.str());
-        else if (errno == ENETUNREACH)
-          throw NetworkUnreachable(host.str());
-        else
-          throw NetworkError(DTR("error sending data"), DUNE_SOCKET_ERROR);
+        mmsghdr msgs[c_batch_size];
+        iovec iovs[c_batch_size];
+        sockaddr_in hosts[c_batch_size];
+        size_t n = std::min(count - done, c_batch_size);
+
+        std::memset(msgs, 0, sizeof(msgs));
+        for (size_t i = 0; i < n; ++i)
+        {
+          const Datagram& dgram = datagrams[done + i];
+          hosts[i].sin_family = AF_INET;
+          hosts[i].sin_port = Utils::ByteCopy::toBE(dgram.port);
+          hosts[i].sin_addr.s_addr = dgram.address.toInteger();
+          iovs[i].iov_base = dgram.data;
+          iovs[i].iov_len = dgram.size;
+          msgs[i].msg_hdr.msg_name = &hosts[i];
+          msgs[i].msg_hdr.msg_namelen = sizeof(hosts[i]);
+          msgs[i].msg_hdr.msg_iov = &iovs[i];
+          msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int rv = sendmmsg(m_handle, msgs, n, 0);
+        if (rv > 0)
+        {
+          sent += rv;
+          done += rv;
+        }
+        else if (errno != EINTR)
+        {
+          // sendmmsg stops at the first datagram that fails: skip it
+          // and carry on with the rest of the batch.
+          ++done;
+        }
+      }
+#else
+      for (size_t i = 0; i < count; ++i)
+      {
+        try
+        {
+          write(datagrams[i].data, datagrams[i].size, datagrams[i].address, datagrams[i].port);
+          ++sent;
+        }
+        catch (Exception&)
+        { }
+      }
+#endif
+
+      return sent;
+    }
+
+    size_t
+    UDPSocket::read(Datagram* datagrams, size_t count)
+    {
+      if (count == 0)
+        return 0;
+
+#if defined(DUNE_SYS_HAS_RECVMMSG)
+      mmsghdr msgs[c_batch_size];
+      iovec iovs[c_batch_size];
+      sockaddr_in hosts[c_batch_size];
+      size_t n = std::min(count, c_batch_size);
+
+      std::memset(msgs, 0, sizeof(msgs));
+      std::memset(hosts, 0, sizeof(hosts));
+      for (size_t i = 0; i < n; ++i)
+      {
+        iovs[i].iov_base = datagrams[i].data;
+        iovs[i].iov_len = datagrams[i].size;
+        msgs[i].msg_hdr.msg_name = &hosts[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(hosts[i]);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+      }
+
+      int rv = recvmmsg(m_handle, msgs, n, MSG_WAITFORONE, NULL);
+      if (rv <= 0)
+        throw NetworkError(DTR("error receiving data"), DUNE_SOCKET_ERROR);
+
+      for (int i = 0; i < rv; ++i)
+      {
+        datagrams[i].size = msgs[i].msg_len;
+        datagrams[i].address = (::sockaddr*)&hosts[i];
+        datagrams[i].port = Utils::ByteCopy::fromBE(hosts[i].sin_port);
       }
 
       return rv;
+#else
+      datagrams[0].size = read(datagrams[0].data, datagrams[0].size,
+                               &datagrams[0].address, &datagrams[0].port);
+      return 1;
+#endif
+    }
+
+    void
+    UDPSocket::throwWriteError(const Address& host)
+    {
+      if (errno == EHOSTUNREACH)
+        throw HostUnreachable(host.str());
+      else if (errno == ENETUNREACH)
+        throw NetworkUnreachable(host.str());
+      else
+        throw NetworkError(DTR("error sending data"), DUNE_SOCKET_ERROR);
     }
 
     void
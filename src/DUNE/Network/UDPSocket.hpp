@@ -51,6 +51,20 @@ namespace DUNE
     class UDPSocket: public IO::Handle
     {
     public:
+      //! Datagram of a batched transfer.
+      struct Datagram
+      {
+        //! Datagram data.
+        uint8_t* data;
+        //! Datagram size. When reading, buffer capacity on input and
+        //! datagram size on output.
+        size_t size;
+        //! Destination or source address.
+        Address address;
+        //! Destination or source port.
+        uint16_t port;
+      };
+
       //! Create an unbound UDP socket.
       UDPSocket(void);
 
@@ -97,6 +111,25 @@ namespace DUNE
       size_t
       read(uint8_t* buffer, size_t size, Address* addr = NULL, uint16_t* port = NULL);
 
+      //! Send several UDP datagrams, using a single system call where
+      //! supported.
+      //! @param datagrams datagrams to send.
+      //! @param count number of datagrams.
+      //! A datagram that cannot be sent is skipped and the remaining
+      //! ones are still sent.
+      //! @return number of datagrams sent.
+      size_t
+      write(const Datagram* datagrams, size_t count);
+
+      //! Receive the UDP datagrams waiting in the socket, up to a
+      //! given number, using a single system call where supported.
+      //! Blocks until at least one datagram is available.
+      //! @param datagrams destination datagrams.
+      //! @param count maximum number of datagrams.
+      //! @return number of datagrams received.
+      size_t
+      read(Datagram* datagrams, size_t count);
+
     private:
       //! Platform specific handle.
 #if defined(DUNE_OS_WINDOWS)
@@ -136,6 +169,11 @@ namespace DUNE
       void
       createEventHandle(void);
 
+      //! Throw the exception matching a failed send.
+      //! @param host destination address.
+      static void
+      throwWriteError(const Address& host);
+
       //! Non - copyable.
       UDPSocket(const UDPSocket&);
 
@@ -38,6 +38,7 @@ namespace DUNE
 }
 
 #include <DUNE/System/Resources.hpp>
+#include <DUNE/System/Allocator.hpp>
 #include <DUNE/System/Error.hpp>
 #include <DUNE/System/DynamicLoader.hpp>
 #include <DUNE/System/Environment.hpp>
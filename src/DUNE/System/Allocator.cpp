@@ -0,0 +1,561 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/System/Allocator.hpp>
+#include <DUNE/System/Resources.hpp>
+
+#if defined(DUNE_USING_TLSF) && defined(DUNE_OS_LINUX)
+#  define DUNE_ALLOCATOR_TLSF
+#  include <pthread.h>
+#  include <tlsf/tlsf.h>
+#endif
+
+//! Size of the process-wide arena.
+#if !defined(DUNE_MEMORY_SIZE)
+#  define DUNE_MEMORY_SIZE (16 * 1024 * 1024)
+#endif
+
+namespace DUNE
+{
+  namespace System
+  {
+#if defined(DUNE_ALLOCATOR_TLSF)
+    // This code runs inside operator new, possibly before any static
+    // constructor. Everything here is plain data initialized at
+    // compile time and locks are raw POSIX mutexes.
+    //
+    // Thread arenas are only used by their owner, so allocations and
+    // frees by the owner take no lock. Blocks released by other
+    // threads are pushed to a lock-free list and returned to TLSF by
+    // the owner. Threads without an arena keep small blocks of the
+    // process-wide arena in a private cache and only take the
+    // process-wide lock when the cache is empty or full.
+
+    //! Cache size class granularity (bytes).
+    static const size_t c_cache_granularity = 16;
+    //! Number of cache size classes. Larger blocks are not cached.
+    static const size_t c_cache_classes = 64;
+    //! Maximum number of bytes cached by each thread.
+    static const size_t c_cache_bytes = 32 * 1024;
+
+    //! TLSF arena.
+    struct Arena
+    {
+      //! Arena lock, only used by the process-wide arena.
+      pthread_mutex_t lock;
+      //! Memory managed by TLSF.
+      char* memory;
+      //! Memory size.
+      size_t size;
+      //! Usage statistics.
+      Allocator::Statistics stats;
+      //! Blocks released by threads other than the owner.
+      void* remote;
+      //! True if the owner thread exited.
+      bool orphan;
+      //! Next arena in the list of arenas.
+      Arena* next;
+    };
+
+    //! Header stored before every block. Its size keeps blocks
+    //! aligned like TLSF does (two pointers).
+    struct BlockHeader
+    {
+      //! Owner arena or NULL if allocated by the C library.
+      Arena* arena;
+      //! Block size including this header.
+      size_t size;
+    };
+
+    //! Allocator state of a thread.
+    struct ThreadState
+    {
+      //! Arena owned by the thread or NULL.
+      Arena* arena;
+      //! Cached blocks of the process-wide arena, per size class.
+      void* cache[c_cache_classes];
+      //! Number of cached bytes.
+      size_t cached;
+      //! True if the thread exit handler is installed.
+      bool registered;
+      //! True if the thread is exiting.
+      bool exiting;
+    };
+
+    //! Memory of the process-wide arena.
+    static char s_memory[DUNE_MEMORY_SIZE] __attribute__((aligned(16)));
+    //! Process-wide arena.
+    static Arena s_global = {PTHREAD_MUTEX_INITIALIZER, s_memory, sizeof(s_memory), {0, 0, 0, 0, 0}, NULL, false, NULL};
+    //! Initialization of the process-wide arena.
+    static pthread_once_t s_global_once = PTHREAD_ONCE_INIT;
+    //! Lock of the list of arenas.
+    static pthread_mutex_t s_arenas_lock = PTHREAD_MUTEX_INITIALIZER;
+    //! True if arenas must be locked in memory.
+    static bool s_lock_memory = false;
+    //! Key used to run the thread exit handler.
+    static pthread_key_t s_exit_key;
+    //! Creation of s_exit_key.
+    static pthread_once_t s_exit_key_once = PTHREAD_ONCE_INIT;
+    //! State of the calling thread.
+    static __thread ThreadState t_state;
+
+    static void
+    initializeGlobalArena(void)
+    {
+      init_memory_pool(s_global.size, s_global.memory);
+      s_global.stats.size = s_global.size;
+    }
+
+    //! Get the next block of a free list.
+    static inline void*&
+    nextBlock(void* block)
+    {
+      return *reinterpret_cast<void**>(static_cast<BlockHeader*>(block) + 1);
+    }
+
+    //! Allocate from the process-wide arena.
+    //! @param[in] total block size including header.
+    //! @return block or NULL if the arena is exhausted.
+    static void*
+    allocateGlobal(size_t total)
+    {
+      pthread_once(&s_global_once, initializeGlobalArena);
+
+      pthread_mutex_lock(&s_global.lock);
+      void* ptr = malloc_ex(total, s_global.memory);
+      ++s_global.stats.allocations;
+      if (ptr != NULL)
+      {
+        s_global.stats.used += total;
+        if (s_global.stats.used > s_global.stats.peak)
+          s_global.stats.peak = s_global.stats.used;
+      }
+      else
+      {
+        ++s_global.stats.fallbacks;
+      }
+      pthread_mutex_unlock(&s_global.lock);
+
+      return ptr;
+    }
+
+    //! Release a block of the process-wide arena.
+    //! @param[in] hdr block.
+    static void
+    deallocateGlobal(BlockHeader* hdr)
+    {
+      pthread_mutex_lock(&s_global.lock);
+      s_global.stats.used -= hdr->size;
+      free_ex(hdr, s_global.memory);
+      pthread_mutex_unlock(&s_global.lock);
+    }
+
+    //! Return blocks released by other threads to an arena. Must be
+    //! called by the owner or, for orphan arenas, with the list of
+    //! arenas locked.
+    //! @param[in] arena arena.
+    static void
+    drainRemote(Arena* arena)
+    {
+      void* block = __atomic_exchange_n(&arena->remote, (void*)NULL, __ATOMIC_ACQUIRE);
+      while (block != NULL)
+      {
+        void* next = nextBlock(block);
+        arena->stats.used -= static_cast<BlockHeader*>(block)->size;
+        free_ex(block, arena->memory);
+        block = next;
+      }
+    }
+
+    //! Release an arena with no allocated blocks. Must be called with
+    //! the list of arenas locked.
+    //! @param[in] arena arena.
+    static void
+    destroyArena(Arena* arena)
+    {
+      Arena* prev = &s_global;
+      while (prev->next != arena)
+        prev = prev->next;
+      prev->next = arena->next;
+
+      pthread_mutex_destroy(&arena->lock);
+      destroy_memory_pool(arena->memory);
+      std::free(arena->memory);
+      std::free(arena);
+    }
+
+    //! Thread exit handler: return cached blocks to the process-wide
+    //! arena and release or orphan the thread arena.
+    static void
+    onThreadExit(void* data)
+    {
+      ThreadState* ts = static_cast<ThreadState*>(data);
+      ts->exiting = true;
+
+      for (size_t i = 0; i < c_cache_classes; ++i)
+      {
+        void* block = ts->cache[i];
+        while (block != NULL)
+        {
+          void* next = nextBlock(block);
+          deallocateGlobal(static_cast<BlockHeader*>(block));
+          block = next;
+        }
+
+        ts->cache[i] = NULL;
+      }
+
+      ts->cached = 0;
+
+      Arena* arena = ts->arena;
+      if (arena == NULL)
+        return;
+
+      ts->arena = NULL;
+
+      pthread_mutex_lock(&s_arenas_lock);
+      drainRemote(arena);
+      // Blocks still referenced elsewhere keep the arena alive until
+      // another thread adopts it.
+      if (arena->stats.used == 0)
+        destroyArena(arena);
+      else
+        arena->orphan = true;
+      pthread_mutex_unlock(&s_arenas_lock);
+    }
+
+    static void
+    createExitKey(void)
+    {
+      pthread_key_create(&s_exit_key, onThreadExit);
+    }
+
+    //! Make sure onThreadExit() runs when the calling thread exits.
+    //! @param[in] ts thread state.
+    static void
+    registerThread(ThreadState* ts)
+    {
+      if (ts->registered)
+        return;
+
+      ts->registered = true;
+      pthread_once(&s_exit_key_once, createExitKey);
+      pthread_setspecific(s_exit_key, ts);
+    }
+
+    //! Get the cache size class of a block.
+    //! @param[in] total block size including header.
+    //! @return size class or c_cache_classes if not cached.
+    static inline size_t
+    getCacheClass(size_t total)
+    {
+      size_t sc = (total + c_cache_granularity - 1) / c_cache_granularity;
+      return (sc == 0 || sc > c_cache_classes) ? c_cache_classes : sc - 1;
+    }
+#endif
+
+    bool
+    Allocator::isAvailable(void)
+    {
+#if defined(DUNE_ALLOCATOR_TLSF)
+      return true;
+#else
+      return false;
+#endif
+    }
+
+    void*
+    Allocator::allocate(size_t size)
+    {
+#if defined(DUNE_ALLOCATOR_TLSF)
+      ThreadState* ts = &t_state;
+      Arena* arena = ts->arena;
+      // Released blocks are linked through their first word.
+      size_t total = std::max(size, sizeof(void*)) + sizeof(BlockHeader);
+      void* ptr = NULL;
+
+      if (arena != NULL)
+      {
+        if (__atomic_load_n(&arena->remote, __ATOMIC_RELAXED) != NULL)
+          drainRemote(arena);
+
+        ptr = malloc_ex(total, arena->memory);
+        ++arena->stats.allocations;
+        if (ptr != NULL)
+        {
+          arena->stats.used += total;
+          if (arena->stats.used > arena->stats.peak)
+            arena->stats.peak = arena->stats.used;
+        }
+        else
+        {
+          ++arena->stats.fallbacks;
+        }
+      }
+      else
+      {
+        arena = &s_global;
+
+        // Cached blocks are rounded up to their size class.
+        size_t sc = getCacheClass(total);
+        if (sc < c_cache_classes)
+        {
+          total = (sc + 1) * c_cache_granularity;
+          ptr = ts->cache[sc];
+          if (ptr != NULL)
+          {
+            ts->cache[sc] = nextBlock(ptr);
+            ts->cached -= total;
+            return static_cast<BlockHeader*>(ptr) + 1;
+          }
+        }
+
+        ptr = allocateGlobal(total);
+      }
+
+      if (ptr == NULL)
+      {
+        ptr = std::malloc(total);
+        if (ptr == NULL)
+          return NULL;
+        arena = NULL;
+      }
+
+      BlockHeader* hdr = static_cast<BlockHeader*>(ptr);
+      hdr->arena = arena;
+      hdr->size = total;
+      return hdr + 1;
+#else
+      return std::malloc(size);
+#endif
+    }
+
+    void
+    Allocator::deallocate(void* ptr)
+    {
+      if (ptr == NULL)
+        return;
+
+#if defined(DUNE_ALLOCATOR_TLSF)
+      BlockHeader* hdr = static_cast<BlockHeader*>(ptr) - 1;
+      Arena* arena = hdr->arena;
+      if (arena == NULL)
+      {
+        std::free(hdr);
+        return;
+      }
+
+      ThreadState* ts = &t_state;
+
+      if (arena != &s_global)
+      {
+        if (arena == ts->arena)
+        {
+          arena->stats.used -= hdr->size;
+          free_ex(hdr, arena->memory);
+          return;
+        }
+
+        // Owned by another thread (or orphan): hand it over.
+        void* head = __atomic_load_n(&arena->remote, __ATOMIC_RELAXED);
+        do
+        {
+          nextBlock(hdr) = head;
+        }
+        while (!__atomic_compare_exchange_n(&arena->remote, &head, (void*)hdr, true,
+                                            __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+        return;
+      }
+
+      // Only threads allocating from the process-wide arena cache
+      // its blocks.
+      size_t sc = getCacheClass(hdr->size);
+      if (sc < c_cache_classes && ts->arena == NULL && !ts->exiting
+          && ts->cached + hdr->size <= c_cache_bytes)
+      {
+        registerThread(ts);
+        nextBlock(hdr) = ts->cache[sc];
+        ts->cache[sc] = hdr;
+        ts->cached += hdr->size;
+        return;
+      }
+
+      deallocateGlobal(hdr);
+#else
+      std::free(ptr);
+#endif
+    }
+
+    bool
+    Allocator::createThreadArena(size_t size)
+    {
+#if defined(DUNE_ALLOCATOR_TLSF)
+      ThreadState* ts = &t_state;
+      if (ts->arena != NULL || ts->exiting)
+        return false;
+
+      // Adopt the arena of an exited thread, releasing unused ones.
+      Arena* arena = NULL;
+      pthread_mutex_lock(&s_arenas_lock);
+      Arena* itr = s_global.next;
+      while (itr != NULL)
+      {
+        Arena* next = itr->next;
+        if (itr->orphan)
+        {
+          drainRemote(itr);
+          if (arena == NULL && itr->size == size)
+          {
+            arena = itr;
+            arena->orphan = false;
+            arena->stats.peak = arena->stats.used;
+            arena->stats.allocations = 0;
+            arena->stats.fallbacks = 0;
+          }
+          else if (itr->stats.used == 0)
+          {
+            destroyArena(itr);
+          }
+        }
+
+        itr = next;
+      }
+      bool lock_memory = s_lock_memory;
+      pthread_mutex_unlock(&s_arenas_lock);
+
+      if (arena != NULL)
+      {
+        registerThread(ts);
+        ts->arena = arena;
+        return true;
+      }
+
+      arena = static_cast<Arena*>(std::malloc(sizeof(Arena)));
+      char* memory = static_cast<char*>(std::malloc(size));
+      if (arena == NULL || memory == NULL)
+      {
+        std::free(arena);
+        std::free(memory);
+        return false;
+      }
+
+      // TLSF reuses pools that carry its signature.
+      std::memset(memory, 0, std::min(size, (size_t)64));
+      if (init_memory_pool(size, memory) == (size_t)-1)
+      {
+        std::free(arena);
+        std::free(memory);
+        return false;
+      }
+
+      pthread_mutex_init(&arena->lock, NULL);
+      arena->memory = memory;
+      arena->size = size;
+      std::memset(&arena->stats, 0, sizeof(arena->stats));
+      arena->stats.size = size;
+      arena->remote = NULL;
+      arena->orphan = false;
+
+      // Arenas created after lockMemory() must be resident too.
+      if (lock_memory)
+      {
+        try
+        {
+          Resources::lockMemory(memory, size);
+        }
+        catch (...)
+        {
+          pthread_mutex_destroy(&arena->lock);
+          destroy_memory_pool(memory);
+          std::free(arena);
+          std::free(memory);
+          return false;
+        }
+      }
+
+      pthread_mutex_lock(&s_arenas_lock);
+      arena->next = s_global.next;
+      s_global.next = arena;
+      pthread_mutex_unlock(&s_arenas_lock);
+
+      registerThread(ts);
+      ts->arena = arena;
+      return true;
+#else
+      (void)size;
+      return false;
+#endif
+    }
+
+    bool
+    Allocator::getThreadStatistics(Statistics& stats)
+    {
+#if defined(DUNE_ALLOCATOR_TLSF)
+      Arena* arena = t_state.arena;
+      if (arena != NULL)
+      {
+        drainRemote(arena);
+        stats = arena->stats;
+        return true;
+      }
+
+      pthread_once(&s_global_once, initializeGlobalArena);
+      pthread_mutex_lock(&s_global.lock);
+      stats = s_global.stats;
+      pthread_mutex_unlock(&s_global.lock);
+      return false;
+#else
+      std::memset(&stats, 0, sizeof(stats));
+      return false;
+#endif
+    }
+
+    void
+    Allocator::lockMemory(void)
+    {
+#if defined(DUNE_ALLOCATOR_TLSF)
+      pthread_mutex_lock(&s_arenas_lock);
+      s_lock_memory = true;
+      Arena* arena = &s_global;
+      for (; arena != NULL; arena = arena->next)
+        Resources::lockMemory(arena->memory, arena->size);
+      pthread_mutex_unlock(&s_arenas_lock);
+#else
+      Resources::lockMemory();
+#endif
+    }
+  }
+}
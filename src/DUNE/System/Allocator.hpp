@@ -0,0 +1,128 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+#ifndef DUNE_SYSTEM_ALLOCATOR_HPP_INCLUDED_
+#define DUNE_SYSTEM_ALLOCATOR_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <cstddef>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+
+namespace DUNE
+{
+  namespace System
+  {
+    // Export DLL Symbol.
+    class DUNE_DLL_SYM Allocator;
+
+    //! O(1) memory allocator backed by TLSF arenas. Allocations are
+    //! served from the arena of the calling thread, or from the
+    //! process-wide arena if the thread has none. Blocks can be
+    //! released by any thread. When an arena is exhausted the C
+    //! library allocator is used instead and the event is counted.
+    //!
+    //! A thread arena is only used by its owner and takes no lock;
+    //! blocks released by other threads are handed back through a
+    //! lock-free list. Threads without an arena cache small blocks of
+    //! the process-wide arena and only lock it to refill or trim
+    //! their cache. Statistics of the process-wide arena count cached
+    //! blocks as used.
+    //!
+    //! The allocator is only available if DUNE was configured with
+    //! the TLSF option; otherwise all requests go to the C library
+    //! and arenas are never created. The dune executable routes the
+    //! global operator new and delete through this class.
+    class Allocator
+    {
+    public:
+      //! Arena usage statistics.
+      struct Statistics
+      {
+        //! Arena size in bytes.
+        size_t size;
+        //! Bytes currently allocated.
+        size_t used;
+        //! Maximum number of bytes allocated at any time.
+        size_t peak;
+        //! Number of allocations.
+        unsigned long allocations;
+        //! Number of allocations served by the C library because the
+        //! arena was exhausted.
+        unsigned long fallbacks;
+      };
+
+      //! Check if the TLSF allocator is available.
+      //! @return true if available, false otherwise.
+      static bool
+      isAvailable(void);
+
+      //! Allocate memory.
+      //! @param[in] size number of bytes.
+      //! @return memory block or NULL if no memory is available.
+      static void*
+      allocate(size_t size);
+
+      //! Release memory previously returned by allocate().
+      //! @param[in] ptr memory block (may be NULL).
+      static void
+      deallocate(void* ptr);
+
+      //! Create an arena for the calling thread. Memory allocated
+      //! afterwards by this thread is taken from the new arena. When
+      //! the thread exits, the arena is released as soon as all its
+      //! blocks are; until then it may be reused by another thread
+      //! creating an arena of the same size.
+      //! @param[in] size arena size in bytes.
+      //! If lockMemory() was called, the arena is locked in memory as
+      //! well.
+      //! @return true if the arena was created, false if the
+      //! allocator is not available, the thread already has one or
+      //! the arena could not be locked.
+      static bool
+      createThreadArena(size_t size);
+
+      //! Retrieve the statistics of the arena used by the calling
+      //! thread.
+      //! @param[out] stats statistics.
+      //! @return true if the thread has its own arena, false if it
+      //! uses the process-wide arena (whose statistics are returned).
+      static bool
+      getThreadStatistics(Statistics& stats);
+
+      //! Make the memory of every arena resident, including arenas
+      //! created afterwards.
+      static void
+      lockMemory(void);
+    };
+  }
+}
+
+#endif
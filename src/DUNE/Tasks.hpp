@@ -43,6 +43,7 @@ namespace DUNE
 #include <DUNE/Tasks/Periodic.hpp>
 #include <DUNE/Tasks/Profiles.hpp>
 #include <DUNE/Tasks/Task.hpp>
+#include <DUNE/Tasks/LogWriter.hpp>
 #include <DUNE/Tasks/Context.hpp>
 #include <DUNE/Tasks/Manager.hpp>
 #include <DUNE/Tasks/AbstractConsumer.hpp>
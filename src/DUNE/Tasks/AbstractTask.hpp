@@ -37,6 +37,7 @@
 // DUNE headers.
 #include <DUNE/Concurrency/Thread.hpp>
 #include <DUNE/IMC/Message.hpp>
+#include <DUNE/IMC/SharedMessage.hpp>
 
 namespace DUNE
 {
@@ -61,6 +62,11 @@ namespace DUNE
       virtual void
       receive(const IMC::Message* msg) = 0;
 
+      //! Queue a shared message for later consumption.
+      //! @param msg shared message handle.
+      virtual void
+      receive(const IMC::SharedMessage& msg) = 0;
+
       //! Retrieve task name.
       //! @return task name.
       virtual const char*
@@ -0,0 +1,764 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// ISO C++ 11 headers.
+#include <atomic>
+#include <cstdint>
+
+// DUNE headers.
+#include <DUNE/Concurrency/Futex.hpp>
+#include <DUNE/Concurrency/Mutex.hpp>
+#include <DUNE/Concurrency/ScopedMutex.hpp>
+#include <DUNE/Concurrency/Thread.hpp>
+#include <DUNE/Concurrency/TLS.hpp>
+#include <DUNE/IMC/Definitions.hpp>
+#include <DUNE/Streams/Terminal.hpp>
+#include <DUNE/Tasks/LogWriter.hpp>
+#include <DUNE/Tasks/Task.hpp>
+#include <DUNE/Time/Clock.hpp>
+
+namespace DUNE
+{
+  namespace Tasks
+  {
+    //! Maximum size of a formatted entry (same as LogBookEntry text).
+    static const size_t c_max_text = 1024;
+    //! Maximum size of a queued entry.
+    static const size_t c_max_entry = 2048;
+    //! Size of each thread's ring (power of two).
+    static const size_t c_ring_size = 32768;
+    //! Ring marker telling the consumer to restart at the beginning.
+    static const uint32_t c_wrap = 0xffffffff;
+    //! Maximum time the background thread sleeps.
+    static const double c_idle_period = 0.05;
+
+    //! Argument tags.
+    enum ArgumentTag
+    {
+      ARG_INT,
+      ARG_UINT,
+      ARG_DOUBLE,
+      ARG_LDOUBLE,
+      ARG_PTR,
+      ARG_STR
+    };
+
+    //! Conversion specification of a printf-style format.
+    struct Spec
+    {
+      //! Flags.
+      const char* flags;
+      //! Number of flag characters.
+      size_t flags_size;
+      //! Literal width, or -1.
+      int width;
+      //! True if the width is an argument.
+      bool width_arg;
+      //! Literal precision, or -1.
+      int precision;
+      //! True if the precision is an argument.
+      bool precision_arg;
+      //! Length modifier ('H' for hh and 'q' for ll).
+      char length;
+      //! Conversion character.
+      char conversion;
+    };
+
+    //! Entry header.
+    struct Header
+    {
+      //! Originating task.
+      Task* task;
+      //! Time of the log call.
+      double time;
+      //! Log book entry type.
+      uint8_t type;
+      //! True if the entry holds formatted text instead of a format
+      //! and arguments.
+      uint8_t text;
+      //! Size of the format string, including the terminator.
+      uint16_t format_size;
+    };
+
+    //! Single producer, single consumer ring of variable size entries.
+    struct Ring
+    {
+      //! Entries.
+      char data[c_ring_size];
+      //! Consumer offset.
+      std::atomic<size_t> head;
+      //! Producer offset.
+      std::atomic<size_t> tail;
+      //! Entries dropped since last checked by the consumer.
+      std::atomic<unsigned> drops;
+      //! True when the owning thread has exited.
+      std::atomic<bool> closed;
+
+      Ring(void):
+        head(0),
+        tail(0),
+        drops(0),
+        closed(false)
+      { }
+    };
+
+    //! Per thread ring reference, closes the ring on thread exit.
+    struct RingOwner
+    {
+      Ring* ring;
+
+      RingOwner(void):
+        ring(NULL)
+      { }
+
+      ~RingOwner(void)
+      {
+        if (ring != NULL)
+          ring->closed.store(true);
+      }
+    };
+
+    //! True while the background thread is running.
+    static std::atomic<bool> s_running(false);
+    //! Total number of dropped entries.
+    static std::atomic<unsigned long> s_drops(0);
+    //! Rings of all logging threads.
+    static std::vector<Ring*> s_rings;
+    //! Lock for the list of rings.
+    static Concurrency::Mutex s_rings_lock;
+    //! Lock serializing consumers.
+    static Concurrency::Mutex s_consumer_lock;
+    //! Background thread wake up.
+    static Concurrency::Futex s_futex;
+    //! Background thread.
+    static Concurrency::Thread* s_thread = NULL;
+    //! Rings of the calling thread.
+    static Concurrency::TLS<RingOwner> s_owner;
+
+    static size_t
+    align(size_t size)
+    {
+      return (size + 7) & ~(size_t)7;
+    }
+
+    //! Parse a conversion specification.
+    //! @param[in] str characters after '%'.
+    //! @param[out] spec specification.
+    //! @return pointer past the conversion character, or NULL if the
+    //! specification is not supported.
+    static const char*
+    parseSpec(const char* str, Spec& spec)
+    {
+      spec.flags = str;
+      while (*str != 0 && std::strchr("-+ #0", *str) != NULL)
+        ++str;
+      spec.flags_size = str - spec.flags;
+
+      spec.width = -1;
+      spec.width_arg = false;
+      if (*str == '*')
+      {
+        spec.width_arg = true;
+        ++str;
+      }
+      else if (*str >= '0' && *str <= '9')
+      {
+        spec.width = 0;
+        while (*str >= '0' && *str <= '9')
+          spec.width = spec.width * 10 + (*str++ - '0');
+      }
+
+      spec.precision = -1;
+      spec.precision_arg = false;
+      if (*str == '.')
+      {
+        ++str;
+        if (*str == '*')
+        {
+          spec.precision_arg = true;
+          ++str;
+        }
+        else
+        {
+          spec.precision = 0;
+          while (*str >= '0' && *str <= '9')
+            spec.precision = spec.precision * 10 + (*str++ - '0');
+        }
+      }
+
+      spec.length = 0;
+      if (str[0] == 'h' && str[1] == 'h')
+      {
+        spec.length = 'H';
+        str += 2;
+      }
+      else if (str[0] == 'l' && str[1] == 'l')
+      {
+        spec.length = 'q';
+        str += 2;
+      }
+      else if (*str != 0 && std::strchr("hljztL", *str) != NULL)
+      {
+        spec.length = *str++;
+      }
+
+      spec.conversion = *str;
+      if (spec.conversion == 0 || std::strchr("diouxXcs" "eEfFgGaA" "p", spec.conversion) == NULL)
+        return NULL;
+
+      // Wide characters and strings are not supported.
+      if ((spec.conversion == 'c' || spec.conversion == 's') && spec.length != 0)
+        return NULL;
+
+      return str + 1;
+    }
+
+    //! Buffer writer that fails when full.
+    struct Writer
+    {
+      char* ptr;
+      char* end;
+
+      bool
+      put(const void* data, size_t size)
+      {
+        if ((size_t)(end - ptr) < size)
+          return false;
+
+        std::memcpy(ptr, data, size);
+        ptr += size;
+        return true;
+      }
+
+      template <typename T>
+      bool
+      put(uint8_t tag, T value)
+      {
+        return put(&tag, 1) && put(&value, sizeof(value));
+      }
+    };
+
+    int
+    LogWriter::capture(char* bfr, size_t size, const char* format, std::va_list ap)
+    {
+      Writer w = {bfr, bfr + size};
+
+      for (const char* ptr = format; *ptr != 0; ++ptr)
+      {
+        if (*ptr != '%')
+          continue;
+
+        if (ptr[1] == '%')
+        {
+          ++ptr;
+          continue;
+        }
+
+        Spec spec;
+        const char* next = parseSpec(ptr + 1, spec);
+        if (next == NULL)
+          return -1;
+
+        if (spec.width_arg && !w.put(ARG_INT, (long long)va_arg(ap, int)))
+          return -1;
+
+        int precision = spec.precision;
+        if (spec.precision_arg)
+        {
+          precision = va_arg(ap, int);
+          if (!w.put(ARG_INT, (long long)precision))
+            return -1;
+        }
+
+        bool ok = true;
+        switch (spec.conversion)
+        {
+          case 'd':
+          case 'i':
+            {
+              long long v = 0;
+              switch (spec.length)
+              {
+                case 'H': v = (signed char)va_arg(ap, int); break;
+                case 'h': v = (short)va_arg(ap, int); break;
+                case 'l': v = va_arg(ap, long); break;
+                case 'q': v = va_arg(ap, long long); break;
+                case 'j': v = va_arg(ap, intmax_t); break;
+                case 'z': v = (long long)va_arg(ap, size_t); break;
+                case 't': v = va_arg(ap, ptrdiff_t); break;
+                case 'L': return -1;
+                default: v = va_arg(ap, int); break;
+              }
+              ok = w.put(ARG_INT, v);
+            }
+            break;
+
+          case 'o':
+          case 'u':
+          case 'x':
+          case 'X':
+            {
+              unsigned long long v = 0;
+              switch (spec.length)
+              {
+                case 'H': v = (unsigned char)va_arg(ap, unsigned); break;
+                case 'h': v = (unsigned short)va_arg(ap, unsigned); break;
+                case 'l': v = va_arg(ap, unsigned long); break;
+                case 'q': v = va_arg(ap, unsigned long long); break;
+                case 'j': v = va_arg(ap, uintmax_t); break;
+                case 'z': v = va_arg(ap, size_t); break;
+                case 't': v = (unsigned long long)va_arg(ap, ptrdiff_t); break;
+                case 'L': return -1;
+                default: v = va_arg(ap, unsigned); break;
+              }
+              ok = w.put(ARG_UINT, v);
+            }
+            break;
+
+          case 'c':
+            ok = w.put(ARG_INT, (long long)va_arg(ap, int));
+            break;
+
+          case 'p':
+            ok = w.put(ARG_PTR, va_arg(ap, void*));
+            break;
+
+          case 's':
+            {
+              const char* str = va_arg(ap, const char*);
+              if (str == NULL)
+                str = "(null)";
+
+              // Strings need not be terminated if a precision is
+              // given, longer strings would be truncated anyway.
+              size_t limit = c_max_text;
+              if (precision >= 0 && (size_t)precision < limit)
+                limit = precision;
+
+              size_t len = strnlen(str, limit);
+
+              uint8_t tag = ARG_STR;
+              uint16_t len16 = (uint16_t)len;
+              ok = w.put(&tag, 1) && w.put(&len16, sizeof(len16)) && w.put(str, len);
+            }
+            break;
+
+          default:
+            if (spec.length == 'L')
+              ok = w.put(ARG_LDOUBLE, va_arg(ap, long double));
+            else
+              ok = w.put(ARG_DOUBLE, va_arg(ap, double));
+            break;
+        }
+
+        if (!ok)
+          return -1;
+
+        ptr = next - 1;
+      }
+
+      return (int)(w.ptr - bfr);
+    }
+
+    //! Read an integer argument.
+    static long long
+    getInt(const char*& args)
+    {
+      long long v;
+      std::memcpy(&v, args + 1, sizeof(v));
+      args += 1 + sizeof(v);
+      return v;
+    }
+
+    void
+    LogWriter::render(char* bfr, size_t size, const char* format, const char* args)
+    {
+      size_t pos = 0;
+      char spec_str[64];
+
+      for (const char* ptr = format; *ptr != 0 && pos + 1 < size; ++ptr)
+      {
+        if (*ptr != '%')
+        {
+          bfr[pos++] = *ptr;
+          continue;
+        }
+
+        if (ptr[1] == '%')
+        {
+          bfr[pos++] = '%';
+          ++ptr;
+          continue;
+        }
+
+        Spec spec;
+        const char* next = parseSpec(ptr + 1, spec);
+
+        int width = spec.width_arg ? (int)getInt(args) : spec.width;
+        int precision = spec.precision_arg ? (int)getInt(args) : spec.precision;
+
+        // Rebuild the specification with literal width and precision
+        // and the length modifier of the stored argument.
+        int n = std::snprintf(spec_str, sizeof(spec_str), "%%%.*s%s",
+                              (int)spec.flags_size, spec.flags,
+                              (width < 0 && spec.width_arg) ? "-" : "");
+        if (width >= 0 || spec.width_arg)
+          n += std::snprintf(spec_str + n, sizeof(spec_str) - n, "%d", width < 0 ? -width : width);
+        if (precision >= 0)
+          n += std::snprintf(spec_str + n, sizeof(spec_str) - n, ".%d", precision);
+
+        const char* length = "";
+        uint8_t tag = (uint8_t)*args;
+        if (tag == ARG_INT || tag == ARG_UINT)
+          length = (spec.conversion == 'c') ? "" : "ll";
+        else if (tag == ARG_LDOUBLE)
+          length = "L";
+        std::snprintf(spec_str + n, sizeof(spec_str) - n, "%s%c", length, spec.conversion);
+
+        int rv = 0;
+        size_t avail = size - pos;
+        switch (tag)
+        {
+          case ARG_INT:
+            {
+              long long v = getInt(args);
+              if (spec.conversion == 'c')
+                rv = std::snprintf(bfr + pos, avail, spec_str, (int)v);
+              else
+                rv = std::snprintf(bfr + pos, avail, spec_str, v);
+            }
+            break;
+
+          case ARG_UINT:
+            {
+              unsigned long long v;
+              std::memcpy(&v, args + 1, sizeof(v));
+              args += 1 + sizeof(v);
+              rv = std::snprintf(bfr + pos, avail, spec_str, v);
+            }
+            break;
+
+          case ARG_DOUBLE:
+            {
+              double v;
+              std::memcpy(&v, args + 1, sizeof(v));
+              args += 1 + sizeof(v);
+              rv = std::snprintf(bfr + pos, avail, spec_str, v);
+            }
+            break;
+
+          case ARG_LDOUBLE:
+            {
+              long double v;
+              std::memcpy(&v, args + 1, sizeof(v));
+              args += 1 + sizeof(v);
+              rv = std::snprintf(bfr + pos, avail, spec_str, v);
+            }
+            break;
+
+          case ARG_PTR:
+            {
+              void* v;
+              std::memcpy(&v, args + 1, sizeof(v));
+              args += 1 + sizeof(v);
+              rv = std::snprintf(bfr + pos, avail, spec_str, v);
+            }
+            break;
+
+          case ARG_STR:
+            {
+              uint16_t len;
+              std::memcpy(&len, args + 1, sizeof(len));
+              const char* str = args + 1 + sizeof(len);
+              args = str + len;
+
+              // Strings are not terminated, bound the precision.
+              int prec = (precision >= 0 && precision < (int)len) ? precision : (int)len;
+              n = std::snprintf(spec_str, sizeof(spec_str), "%%%.*s%s",
+                                (int)spec.flags_size, spec.flags,
+                                (width < 0 && spec.width_arg) ? "-" : "");
+              if (width >= 0 || spec.width_arg)
+                n += std::snprintf(spec_str + n, sizeof(spec_str) - n, "%d", width < 0 ? -width : width);
+              std::snprintf(spec_str + n, sizeof(spec_str) - n, ".*s");
+              rv = std::snprintf(bfr + pos, avail, spec_str, prec, str);
+            }
+            break;
+        }
+
+        if (rv > 0)
+          pos += ((size_t)rv < avail) ? rv : avail - 1;
+
+        ptr = next - 1;
+      }
+
+      bfr[pos] = 0;
+    }
+
+    //! Retrieve the ring of the calling thread.
+    static Ring*
+    getRing(void)
+    {
+      RingOwner& owner = s_owner.value();
+      if (owner.ring == NULL)
+      {
+        owner.ring = new Ring;
+        Concurrency::ScopedMutex l(s_rings_lock);
+        s_rings.push_back(owner.ring);
+      }
+
+      return owner.ring;
+    }
+
+    //! Append an entry to a ring.
+    //! @return false if there is no space.
+    static bool
+    push(Ring* ring, const char* entry, uint32_t size)
+    {
+      size_t need = align(sizeof(uint32_t) + size);
+      size_t tail = ring->tail.load(std::memory_order_relaxed);
+      size_t head = ring->head.load(std::memory_order_acquire);
+      size_t free = c_ring_size - (tail - head);
+      size_t pos = tail & (c_ring_size - 1);
+      size_t till_end = c_ring_size - pos;
+
+      if (need > till_end)
+      {
+        if (free < till_end + need)
+          return false;
+
+        std::memcpy(ring->data + pos, &c_wrap, sizeof(c_wrap));
+        tail += till_end;
+        pos = 0;
+      }
+      else if (free < need)
+      {
+        return false;
+      }
+
+      std::memcpy(ring->data + pos, &size, sizeof(size));
+      std::memcpy(ring->data + pos + sizeof(size), entry, size);
+      ring->tail.store(tail + need, std::memory_order_release);
+      return true;
+    }
+
+    void
+    LogWriter::process(const char* entry)
+    {
+      Header hdr;
+      std::memcpy(&hdr, entry, sizeof(hdr));
+      const char* format = entry + sizeof(hdr);
+
+      if (hdr.text)
+      {
+        hdr.task->writeLog(hdr.type, hdr.time, format);
+        return;
+      }
+
+      char text[c_max_text];
+      render(text, sizeof(text), format, format + hdr.format_size);
+      hdr.task->writeLog(hdr.type, hdr.time, text);
+    }
+
+    size_t
+    LogWriter::flush(void)
+    {
+      Concurrency::ScopedMutex c(s_consumer_lock);
+
+      std::vector<Ring*> rings;
+      {
+        Concurrency::ScopedMutex l(s_rings_lock);
+        rings = s_rings;
+      }
+
+      size_t count = 0;
+      for (size_t i = 0; i < rings.size(); ++i)
+      {
+        Ring* ring = rings[i];
+
+        unsigned drops = ring->drops.exchange(0);
+        if (drops > 0)
+          DUNE_WRN("Log", drops << " entries dropped");
+
+        size_t head = ring->head.load(std::memory_order_relaxed);
+        size_t tail = ring->tail.load(std::memory_order_acquire);
+
+        while (head != tail)
+        {
+          size_t pos = head & (c_ring_size - 1);
+          uint32_t size;
+          std::memcpy(&size, ring->data + pos, sizeof(size));
+
+          if (size == c_wrap)
+          {
+            head += c_ring_size - pos;
+            continue;
+          }
+
+          process(ring->data + pos + sizeof(size));
+          head += align(sizeof(size) + size);
+          ++count;
+        }
+
+        ring->head.store(head, std::memory_order_release);
+
+        // Release rings of threads that have exited.
+        if (ring->closed.load() && ring->tail.load() == head)
+        {
+          Concurrency::ScopedMutex l(s_rings_lock);
+          for (size_t j = 0; j < s_rings.size(); ++j)
+          {
+            if (s_rings[j] == ring)
+            {
+              s_rings.erase(s_rings.begin() + j);
+              delete ring;
+              break;
+            }
+          }
+        }
+      }
+
+      return count;
+    }
+
+    //! Background thread.
+    class LogThread: public Concurrency::Thread
+    {
+    private:
+      void
+      run(void)
+      {
+        while (!isStopping())
+        {
+          int seq = s_futex.value();
+          if (LogWriter::flush() == 0)
+            s_futex.wait(seq, c_idle_period);
+        }
+      }
+    };
+
+    void
+    LogWriter::start(void)
+    {
+      if (s_thread != NULL)
+        return;
+
+      s_thread = new LogThread;
+      s_thread->start();
+      s_running.store(true);
+    }
+
+    void
+    LogWriter::stop(void)
+    {
+      if (s_thread == NULL)
+        return;
+
+      s_running.store(false);
+      s_thread->stop();
+      s_futex.wake();
+      s_thread->join();
+      delete s_thread;
+      s_thread = NULL;
+
+      flush();
+    }
+
+    bool
+    LogWriter::isRunning(void)
+    {
+      return s_running.load();
+    }
+
+    bool
+    LogWriter::write(Task* task, unsigned type, const char* format, std::va_list ap)
+    {
+      char entry[c_max_entry];
+      Header hdr;
+      hdr.task = task;
+      hdr.time = Time::Clock::getSinceEpoch();
+      hdr.type = (uint8_t)type;
+      hdr.text = 0;
+
+      size_t format_size = std::strlen(format) + 1;
+      int size = -1;
+
+      if (format_size <= c_max_text)
+      {
+        std::va_list aq;
+        va_copy(aq, ap);
+        size = capture(entry + sizeof(hdr) + format_size,
+                       sizeof(entry) - sizeof(hdr) - format_size, format, aq);
+        va_end(aq);
+      }
+
+      if (size >= 0)
+      {
+        std::memcpy(entry + sizeof(hdr), format, format_size);
+        size += format_size;
+      }
+      else
+      {
+        // Unsupported format, format it right away.
+        std::vsnprintf(entry + sizeof(hdr), c_max_text, format, ap);
+        hdr.text = 1;
+        format_size = std::strlen(entry + sizeof(hdr)) + 1;
+        size = format_size;
+      }
+
+      hdr.format_size = (uint16_t)format_size;
+      std::memcpy(entry, &hdr, sizeof(hdr));
+      size += sizeof(hdr);
+
+      Ring* ring = getRing();
+      if (!push(ring, entry, size))
+      {
+        ring->drops.fetch_add(1);
+        s_drops.fetch_add(1);
+        return false;
+      }
+
+      // Errors are written as soon as possible.
+      if (type == IMC::LogBookEntry::LBET_ERROR || type == IMC::LogBookEntry::LBET_CRITICAL)
+        s_futex.wake();
+
+      return true;
+    }
+
+    unsigned long
+    LogWriter::getDropCount(void)
+    {
+      return s_drops.load();
+    }
+  }
+}
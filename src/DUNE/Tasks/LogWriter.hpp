@@ -0,0 +1,119 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+#ifndef DUNE_TASKS_LOG_WRITER_HPP_INCLUDED_
+#define DUNE_TASKS_LOG_WRITER_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <cstdarg>
+#include <cstddef>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+
+namespace DUNE
+{
+  namespace Tasks
+  {
+    // Export DLL Symbol.
+    class DUNE_DLL_SYM LogWriter;
+
+    // Forward declarations.
+    class Task;
+
+    //! Asynchronous task log writer. Each logging thread owns a
+    //! lock-free ring where log calls store a copy of the format
+    //! string and of its arguments. A background thread formats the
+    //! entries, writes them to the terminal and publishes them as
+    //! LogBookEntry messages. When a ring is full entries are
+    //! dropped and counted instead of blocking the caller.
+    class LogWriter
+    {
+    public:
+      //! Start the background thread. Until it is started, and after
+      //! it is stopped, entries are written synchronously.
+      static void
+      start(void);
+
+      //! Write all pending entries and stop the background thread.
+      static void
+      stop(void);
+
+      //! Test if the background thread is running.
+      //! @return true if the background thread is running.
+      static bool
+      isRunning(void);
+
+      //! Write all pending entries, from the calling thread.
+      //! @return number of entries written.
+      static size_t
+      flush(void);
+
+      //! Queue a log entry.
+      //! @param[in] task originating task.
+      //! @param[in] type log book entry type.
+      //! @param[in] format printf-style format.
+      //! @param[in] ap format arguments.
+      //! @return true if the entry was queued, false if it was
+      //! dropped.
+      static bool
+      write(Task* task, unsigned type, const char* format, std::va_list ap);
+
+      //! Retrieve the number of entries dropped since the program
+      //! started.
+      //! @return number of dropped entries.
+      static unsigned long
+      getDropCount(void);
+
+      //! Copy the arguments of a printf-style format to a buffer.
+      //! @param[out] bfr destination buffer.
+      //! @param[in] size size of the destination buffer.
+      //! @param[in] format printf-style format.
+      //! @param[in] ap format arguments.
+      //! @return number of bytes used, or -1 if the format is not
+      //! supported or the arguments do not fit.
+      static int
+      capture(char* bfr, size_t size, const char* format, std::va_list ap);
+
+      //! Format arguments copied with capture().
+      //! @param[out] bfr destination buffer.
+      //! @param[in] size size of the destination buffer.
+      //! @param[in] format printf-style format.
+      //! @param[in] args copied arguments.
+      static void
+      render(char* bfr, size_t size, const char* format, const char* args);
+
+    private:
+      static void
+      process(const char* entry);
+    };
+  }
+}
+
+#endif
@@ -66,7 +66,14 @@ namespace DUNE
         delay = (1.0 / m_frequency);
 
         if (next_inv > now)
-          Time::Delay::wait(next_inv - now);
+        {
+          // A lockstep clock driver only advances once all queued
+          // messages were consumed.
+          if (Time::Clock::isVirtual())
+            waitVirtual(next_inv - now);
+          else
+            Time::Delay::wait(next_inv - now);
+        }
 
         next_inv += delay;
         now = Time::Clock::get();
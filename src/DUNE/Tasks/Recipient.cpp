@@ -29,32 +29,257 @@
 
 // ISO C++ 98 headers.
 #include <cstddef>
+#include <deque>
+
+// ISO C++ 11 headers.
+#include <memory>
 
 // DUNE headers.
+#include <DUNE/Concurrency/Condition.hpp>
+#include <DUNE/Concurrency/ScopedCondition.hpp>
+#include <DUNE/Concurrency/ScopedRWLock.hpp>
 #include <DUNE/IMC/Bus.hpp>
 #include <DUNE/IMC/Factory.hpp>
 #include <DUNE/Tasks/Context.hpp>
 #include <DUNE/Tasks/Recipient.hpp>
+#include <DUNE/Time/Clock.hpp>
 
 namespace DUNE
 {
   namespace Tasks
   {
+    //! Maximum amount of time a producer is blocked by a full queue
+    //! (s). The incoming message is dropped afterwards.
+    static const double c_block_timeout = 1.0;
+
+    //! Queue of a message type with limits. Messages are kept here
+    //! and the main queue holds at most one token (a message of the
+    //! same type) signaling that this queue is not empty. Messages
+    //! of this type already in the main queue when the limit was set
+    //! are not tokens and are consumed normally.
+    struct Backlog: public std::enable_shared_from_this<Backlog>
+    {
+      Backlog(uint32_t message_id, size_t max, QueuePolicy pol,
+              Concurrency::Mailbox<IMC::SharedMessage>& main_queue,
+              std::atomic<unsigned>& main_arrivals):
+        id(message_id),
+        limit(max),
+        policy(pol),
+        mqueue(main_queue),
+        arrivals(main_arrivals),
+        token(NULL),
+        dropped(0),
+        coalesced(0),
+        blocked(0),
+        changed(false),
+        closed(false)
+      { }
+
+      //! Queue an incoming message, applying the overflow policy.
+      //! @param[in] msg message.
+      //! @param[in] may_block false if the producer is the consumer
+      //! thread and must not be blocked.
+      //! @param[out] discarded true if a message was discarded or
+      //! replaced.
+      //! @param[out] deferred true if the queue is full and the
+      //! producer must call wait() once it is outside the bus.
+      //! @return true if a token must be added to the main queue.
+      bool
+      put(const IMC::SharedMessage& msg, bool may_block, bool& discarded, bool& deferred)
+      {
+        Concurrency::ScopedCondition l(cond);
+        discarded = false;
+        deferred = false;
+
+        if (queue.size() >= limit)
+        {
+          changed = true;
+
+          switch (policy)
+          {
+            case QP_DROP_OLDEST:
+              queue.pop_front();
+              ++dropped;
+              discarded = true;
+              break;
+
+            case QP_DROP_NEWEST:
+              ++dropped;
+              discarded = true;
+              return false;
+
+            case QP_COALESCE:
+              queue.back() = msg;
+              ++coalesced;
+              discarded = true;
+              return false;
+
+            case QP_BLOCK:
+              // Waiting would stall the only thread able to make room.
+              if (!may_block)
+              {
+                ++dropped;
+                discarded = true;
+                return false;
+              }
+
+              ++blocked;
+              deferred = true;
+              return false;
+          }
+        }
+
+        queue.push_back(msg);
+
+        if (token != NULL)
+          return false;
+
+        token = msg.get();
+        return true;
+      }
+
+      //! Wait for room and queue a message deferred by put(). The
+      //! main queue is updated with the lock held, so that it cannot
+      //! be destroyed meanwhile (see close()).
+      //! @param[in] msg message.
+      //! @param[in] deadline time at which the message is discarded.
+      //! @return true if the message was queued, false if it was
+      //! discarded.
+      bool
+      wait(const IMC::SharedMessage& msg, double deadline)
+      {
+        Concurrency::ScopedCondition l(cond);
+
+        while (!closed && policy == QP_BLOCK && queue.size() >= limit)
+        {
+          double remaining = deadline - Time::Clock::get();
+          if (remaining <= 0 || !cond.wait(remaining))
+            break;
+        }
+
+        if (closed || (policy == QP_BLOCK && queue.size() >= limit))
+        {
+          ++dropped;
+          changed = true;
+          return false;
+        }
+
+        queue.push_back(msg);
+
+        if (token == NULL)
+        {
+          token = msg.get();
+          mqueue.push(msg);
+
+          if (Time::Clock::isVirtual())
+            Time::Clock::notifyVirtual(arrivals);
+        }
+
+        return true;
+      }
+
+      //! Release producers waiting for room, the main queue is about
+      //! to be destroyed.
+      void
+      close(void)
+      {
+        Concurrency::ScopedCondition l(cond);
+        closed = true;
+        cond.broadcast();
+      }
+
+      //! Exchange a token taken from the main queue with the oldest
+      //! queued message.
+      //! @param[in,out] msg message taken from the main queue, left
+      //! untouched if it is not a token.
+      //! @return true if this queue is still not empty and msg must
+      //! be added to the main queue as the new token.
+      bool
+      take(IMC::SharedMessage& msg)
+      {
+        Concurrency::ScopedCondition l(cond);
+
+        if (msg.get() != token)
+          return false;
+
+        if (queue.empty())
+        {
+          msg.reset();
+          token = NULL;
+          return false;
+        }
+
+        msg = queue.front();
+        queue.pop_front();
+
+        if (policy == QP_BLOCK)
+          cond.broadcast();
+
+        token = queue.empty() ? NULL : msg.get();
+        return token != NULL;
+      }
+
+      //! Message identification number.
+      uint32_t id;
+      //! Maximum number of queued messages.
+      size_t limit;
+      //! Overflow policy.
+      QueuePolicy policy;
+      //! Main queue of the recipient.
+      Concurrency::Mailbox<IMC::SharedMessage>& mqueue;
+      //! Arrivals counter of the recipient.
+      std::atomic<unsigned>& arrivals;
+      //! Queued messages.
+      std::deque<IMC::SharedMessage> queue;
+      //! Token in the main queue or NULL.
+      const IMC::Message* token;
+      //! Number of discarded messages.
+      unsigned dropped;
+      //! Number of replaced messages.
+      unsigned coalesced;
+      //! Number of times a producer was blocked.
+      unsigned blocked;
+      //! True if statistics changed since last report.
+      bool changed;
+      //! True if the recipient is being destroyed.
+      bool closed;
+      //! Lock and condition used to block producers.
+      Concurrency::Condition cond;
+    };
+
+    //! Message held back by a full queue with policy QP_BLOCK.
+    struct Deferred
+    {
+      //! Queue.
+      std::shared_ptr<Backlog> backlog;
+      //! Message.
+      IMC::SharedMessage msg;
+      //! Bus accounting the message or NULL.
+      IMC::Bus* bus;
+    };
+
+    //! Messages held back while the calling thread was dispatching.
+    static thread_local std::vector<Deferred> t_deferred;
+
     Recipient::Recipient(AbstractTask* task, Context& ctx):
       m_task(task),
-      m_ctx(ctx)
+      m_ctx(ctx),
+      m_has_backlogs(false),
+      m_consumer(std::thread::id()),
+      m_arrivals(0)
     { }
 
     Recipient::~Recipient(void)
     {
       unbindAll();
 
-      while (!m_mqueue.empty())
-      {
-        IMC::Message* msg = m_mqueue.pop();
-        if (msg)
-          delete msg;
-      }
+      std::map<uint32_t, std::shared_ptr<Backlog> >::iterator itr = m_backlogs.begin();
+      for (; itr != m_backlogs.end(); ++itr)
+        itr->second->close();
+
+      IMC::SharedMessage msg;
+      while (m_mqueue.pop(msg))
+        msg.reset();
     }
 
     void
@@ -86,32 +311,220 @@ namespace DUNE
     void
     Recipient::waitForMessages(double timeout)
     {
+      // Waiting for messages means the task is done with the work
+      // triggered by virtual time.
+      if (Time::Clock::isVirtual())
+        Time::Clock::setIdle();
+
       if (m_mqueue.waitForItems(timeout))
         runCallBacks();
     }
 
+    void
+    Recipient::waitVirtual(uint64_t nsec)
+    {
+      uint64_t deadline = Time::Clock::getNsec() + nsec;
+
+      while (true)
+      {
+        unsigned seen = m_arrivals.load();
+
+        // Tokens exchanged by runCallBacks() stay in the queue.
+        while (!m_mqueue.empty())
+          runCallBacks();
+
+        uint64_t now = Time::Clock::getNsec();
+        if (now >= deadline)
+          return;
+
+        if (Time::Clock::waitVirtual(deadline - now, m_arrivals, seen))
+          return;
+      }
+    }
+
     void
     Recipient::put(const IMC::Message* msg)
     {
-      m_mqueue.push(msg->clone());
+      if (m_ctx.mbus.isTracking())
+        m_ctx.mbus.addPending(1);
+
+      m_mqueue.push(IMC::SharedMessage::copy(*msg));
+      notifyArrival();
+    }
+
+    void
+    Recipient::put(const IMC::SharedMessage& msg)
+    {
+      bool tracking = m_ctx.mbus.isTracking();
+      if (tracking)
+        m_ctx.mbus.addPending(1);
+
+      Backlog* backlog = getBacklog(msg->getId());
+      if (backlog == NULL)
+      {
+        m_mqueue.push(msg);
+        notifyArrival();
+        return;
+      }
+
+      bool may_block = m_consumer.load(std::memory_order_relaxed) != std::this_thread::get_id();
+      bool discarded = false;
+      bool deferred = false;
+      if (backlog->put(msg, may_block, discarded, deferred))
+      {
+        m_mqueue.push(msg);
+        notifyArrival();
+      }
+
+      if (discarded && tracking)
+        m_ctx.mbus.addPending(-1);
+
+      // Producers are blocked by deliverDeferred(), once the bus is
+      // no longer being read.
+      if (deferred)
+      {
+        Deferred entry;
+        entry.backlog = backlog->shared_from_this();
+        entry.msg = msg;
+        entry.bus = tracking ? &m_ctx.mbus : NULL;
+        t_deferred.push_back(entry);
+      }
+    }
+
+    void
+    Recipient::deliverDeferred(void)
+    {
+      if (t_deferred.empty())
+        return;
+
+      double deadline = Time::Clock::get() + c_block_timeout;
+
+      for (size_t i = 0; i < t_deferred.size(); ++i)
+      {
+        Deferred& entry = t_deferred[i];
+        if (!entry.backlog->wait(entry.msg, deadline) && entry.bus != NULL)
+          entry.bus->addPending(-1);
+      }
+
+      t_deferred.clear();
+    }
+
+    void
+    Recipient::setQueuePolicy(uint32_t id, size_t limit, QueuePolicy policy)
+    {
+      if (limit == 0)
+        limit = 1;
+
+      Concurrency::ScopedRWLock l(m_backlogs_lock, true);
+
+      std::map<uint32_t, std::shared_ptr<Backlog> >::iterator itr = m_backlogs.find(id);
+      if (itr != m_backlogs.end())
+      {
+        Concurrency::ScopedCondition c(itr->second->cond);
+        itr->second->limit = limit;
+        itr->second->policy = policy;
+        itr->second->cond.broadcast();
+        return;
+      }
+
+      m_backlogs[id] = std::make_shared<Backlog>(id, limit, policy, m_mqueue, m_arrivals);
+      m_has_backlogs = true;
+    }
+
+    bool
+    Recipient::getQueueStatistics(std::vector<QueueStatistics>& stats)
+    {
+      if (!m_has_backlogs)
+        return false;
+
+      size_t count = stats.size();
+      Concurrency::ScopedRWLock l(m_backlogs_lock);
+
+      std::map<uint32_t, std::shared_ptr<Backlog> >::iterator itr = m_backlogs.begin();
+      for (; itr != m_backlogs.end(); ++itr)
+      {
+        Backlog* backlog = itr->second.get();
+        Concurrency::ScopedCondition c(backlog->cond);
+        if (!backlog->changed)
+          continue;
+
+        QueueStatistics entry;
+        entry.id = backlog->id;
+        entry.limit = backlog->limit;
+        entry.policy = backlog->policy;
+        entry.size = backlog->queue.size();
+        entry.dropped = backlog->dropped;
+        entry.coalesced = backlog->coalesced;
+        entry.blocked = backlog->blocked;
+        stats.push_back(entry);
+        backlog->changed = false;
+      }
+
+      return stats.size() > count;
+    }
+
+    Backlog*
+    Recipient::getBacklog(uint32_t id)
+    {
+      if (!m_has_backlogs)
+        return NULL;
+
+      Concurrency::ScopedRWLock l(m_backlogs_lock);
+      std::map<uint32_t, std::shared_ptr<Backlog> >::iterator itr = m_backlogs.find(id);
+      if (itr == m_backlogs.end())
+        return NULL;
+
+      return itr->second.get();
+    }
+
+    void
+    Recipient::consume(const IMC::Message* msg)
+    {
+      uint32_t id = msg->getId();
+      for (size_t j = 0; j < m_cbacks[id].size(); ++j)
+        m_cbacks[id][j]->consume(msg);
+    }
+
+    void
+    Recipient::notifyArrival(void)
+    {
+      if (Time::Clock::isVirtual())
+        Time::Clock::notifyVirtual(m_arrivals);
     }
 
     void
     Recipient::runCallBacks(void)
     {
-      unsigned int size = m_mqueue.size();
+      setConsumerThread();
+
+      // Reuse the batch storage, taking care of consumers that
+      // recursively consume messages.
+      std::vector<IMC::SharedMessage> batch;
+      batch.swap(m_batch);
 
-      for (unsigned int i = 0; i < size; ++i)
+      m_mqueue.drain(batch, m_mqueue.size());
+
+      for (size_t i = 0; i < batch.size(); ++i)
       {
-        const IMC::Message* msg = m_mqueue.pop();
-        if (msg)
+        IMC::SharedMessage& msg = batch[i];
+        Backlog* backlog = getBacklog(msg->getId());
+
+        // Tokens are exchanged with the oldest message of their type,
+        // which also becomes the new token if there are more.
+        if (backlog != NULL && backlog->take(msg))
+          m_mqueue.push(msg);
+
+        if (!msg.isNull())
         {
-          uint32_t id = msg->getId();
-          for (size_t j = 0; j < m_cbacks[id].size(); ++j)
-            m_cbacks[id][j]->consume(msg);
-          delete msg;
+          consume(msg.get());
+
+          if (m_ctx.mbus.isTracking())
+            m_ctx.mbus.addPending(-1);
         }
       }
+
+      batch.clear();
+      batch.swap(m_batch);
     }
   }
 }
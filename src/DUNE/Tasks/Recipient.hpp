@@ -34,8 +34,15 @@
 #include <map>
 #include <vector>
 
+// ISO C++ 11 headers.
+#include <atomic>
+#include <memory>
+#include <thread>
+
 // DUNE headers.
-#include <DUNE/Concurrency/TSQueue.hpp>
+#include <DUNE/Concurrency/Mailbox.hpp>
+#include <DUNE/Concurrency/RWLock.hpp>
+#include <DUNE/IMC/SharedMessage.hpp>
 #include <DUNE/Tasks/Consumer.hpp>
 #include <DUNE/Tasks/AbstractTask.hpp>
 
@@ -45,6 +52,47 @@ namespace DUNE
   {
     // Forward declarations.
     struct Context;
+    struct Backlog;
+
+    //! Action taken when a message arrives and the number of queued
+    //! messages of the same type reached the configured limit.
+    enum QueuePolicy
+    {
+      //! Discard the oldest queued message.
+      QP_DROP_OLDEST,
+      //! Discard the incoming message.
+      QP_DROP_NEWEST,
+      //! Replace the newest queued message with the incoming one.
+      QP_COALESCE,
+      //! Block the producer until there is room in the queue, at
+      //! most one second, then discard the incoming message. The
+      //! producer waits after the message was delivered to all other
+      //! recipients and outside the bus (see deliverDeferred()), so
+      //! neither other recipients nor bus updates are delayed.
+      //! Messages produced by the consumer thread itself (e.g.,
+      //! dispatched with DF_LOOP_BACK) never block and are discarded
+      //! if the queue is full.
+      QP_BLOCK
+    };
+
+    //! Queue statistics of a given message type.
+    struct QueueStatistics
+    {
+      //! Message identification number.
+      unsigned id;
+      //! Queue limit.
+      size_t limit;
+      //! Overflow policy.
+      QueuePolicy policy;
+      //! Number of messages currently queued.
+      size_t size;
+      //! Number of discarded messages.
+      unsigned dropped;
+      //! Number of replaced messages.
+      unsigned coalesced;
+      //! Number of times a producer was blocked.
+      unsigned blocked;
+    };
 
     // Export DLL Symbol.
     class DUNE_DLL_SYM Recipient;
@@ -61,18 +109,61 @@ namespace DUNE
       void
       unbindAll(void);
 
+      //! Queue a copy of a message.
+      //! @param msg message object.
+      void
+      put(const IMC::Message* msg);
+
+      //! Queue a shared message without copying it.
+      //! @param msg shared message handle.
       void
-      put(const IMC::Message*);
+      put(const IMC::SharedMessage& msg);
 
       void
       bind(uint32_t id, AbstractConsumer* c);
 
+      //! Queue the messages that the calling thread could not queue
+      //! while dispatching because a queue with policy QP_BLOCK was
+      //! full, waiting for room for at most one second. Called by the
+      //! bus after each dispatch, with no bus lock held.
+      static void
+      deliverDeferred(void);
+
       void
       waitForMessages(double timeout);
 
+      //! Suspend the calling thread until virtual time advances by a
+      //! given amount, consuming messages as they arrive so that they
+      //! are never left pending while the clock waits for consumers.
+      //! @param nsec amount of virtual time in nanoseconds.
+      void
+      waitVirtual(uint64_t nsec);
+
       void
       runCallBacks(void);
 
+      //! Declare the calling thread as the consumer of this
+      //! recipient. Also done by runCallBacks().
+      void
+      setConsumerThread(void)
+      {
+        m_consumer.store(std::this_thread::get_id(), std::memory_order_relaxed);
+      }
+
+      //! Limit the number of queued messages of a given type.
+      //! @param[in] id message identification number.
+      //! @param[in] limit maximum number of queued messages.
+      //! @param[in] policy action taken when the limit is reached.
+      void
+      setQueuePolicy(uint32_t id, size_t limit, QueuePolicy policy);
+
+      //! Retrieve the statistics of message types with a queue limit
+      //! that changed since the last call to this function.
+      //! @param[out] stats statistics.
+      //! @return true if at least one entry was retrieved.
+      bool
+      getQueueStatistics(std::vector<QueueStatistics>& stats);
+
     private:
       //! Task.
       AbstractTask* m_task;
@@ -81,7 +172,34 @@ namespace DUNE
       //! Callbacks.
       std::map<uint32_t, std::vector<AbstractConsumer*> > m_cbacks;
       //! Message queue.
-      Concurrency::TSQueue<IMC::Message*> m_mqueue;
+      Concurrency::Mailbox<IMC::SharedMessage> m_mqueue;
+      //! Messages being consumed by runCallBacks().
+      std::vector<IMC::SharedMessage> m_batch;
+      //! Per message type queues with limits.
+      std::map<uint32_t, std::shared_ptr<Backlog> > m_backlogs;
+      //! Lock of per message type queues table.
+      Concurrency::RWLock m_backlogs_lock;
+      //! True if at least one message type has a queue limit.
+      std::atomic<bool> m_has_backlogs;
+      //! Thread consuming messages.
+      std::atomic<std::thread::id> m_consumer;
+      //! Number of messages queued, used to wake waitVirtual().
+      std::atomic<unsigned> m_arrivals;
+
+      //! Find the queue of a message type with limits.
+      //! @param[in] id message identification number.
+      //! @return queue or NULL if the type has no limits.
+      Backlog*
+      getBacklog(uint32_t id);
+
+      //! Consume a message.
+      //! @param[in] msg message.
+      void
+      consume(const IMC::Message* msg);
+
+      //! Wake the consumer thread if it is in waitVirtual().
+      void
+      notifyArrival(void);
     };
   }
 }
@@ -38,7 +38,9 @@ namespace DUNE
   {
     SimpleTransport::SimpleTransport(const std::string& name, Tasks::Context& ctx):
       Tasks::Task(name, ctx),
-      m_buf(2048)
+      m_buf(2048),
+      m_frame_used(0),
+      m_frame_time(0)
     {
       param("Transports", m_gargs.transports)
       .defaultValue("")
@@ -58,6 +60,19 @@ namespace DUNE
       param("Trace - Outgoing Messages", m_gargs.trace_out)
       .defaultValue("false")
       .description("Enable verbose output regarding outgoing messages");
+
+      param("Aggregation - Frame Size", m_gargs.frame_size)
+      .defaultValue("0")
+      .maximumValue("65535")
+      .units(Units::Byte)
+      .description("Write consecutive messages in frames of up to this size."
+                   " Set to 0 to write each message as it is consumed");
+
+      param("Aggregation - Deadline", m_gargs.frame_deadline)
+      .defaultValue("0.05")
+      .minimumValue("0.0")
+      .units(Units::Second)
+      .description("Maximum time outgoing messages are held for aggregation");
     }
 
     SimpleTransport::~SimpleTransport(void)
@@ -71,16 +86,42 @@ namespace DUNE
 
       unsigned int n = msg->getSerializationSize();
 
-      m_buf.grow(n);
+      if (m_gargs.trace_out)
+        inf(DTR("outgoing: %s"), msg->getName());
 
-      uint8_t* p = m_buf.getBuffer();
+      if (m_gargs.frame_size == 0)
+      {
+        m_buf.grow(n);
+        uint8_t* p = m_buf.getBuffer();
+        IMC::Packet::serialize(msg, p, n);
+        onDataTransmission(p, n);
+        return;
+      }
 
-      IMC::Packet::serialize(msg, p, n);
+      // Packets are written back to back; receivers parse the
+      // stream one packet at a time.
+      if (m_frame_used > 0 && m_frame_used + n > m_gargs.frame_size)
+        transmitFrame();
 
-      if (m_gargs.trace_out)
-        inf(DTR("outgoing: %s"), msg->getName());
+      if (m_frame_used == 0)
+        m_frame_time = Time::Clock::get();
 
-      onDataTransmission(p, n);
+      m_frame.grow(m_frame_used + n);
+      IMC::Packet::serialize(msg, m_frame.getBuffer() + m_frame_used, n);
+      m_frame_used += n;
+
+      if (m_frame_used >= m_gargs.frame_size)
+        transmitFrame();
+    }
+
+    void
+    SimpleTransport::transmitFrame(void)
+    {
+      if (m_frame_used == 0)
+        return;
+
+      onDataTransmission(m_frame.getBuffer(), m_frame_used);
+      m_frame_used = 0;
     }
 
     void
@@ -94,6 +135,9 @@ namespace DUNE
       {
         consumeMessages();
 
+        if (m_frame_used > 0 && Time::Clock::get() - m_frame_time >= m_gargs.frame_deadline)
+          transmitFrame();
+
         onDataReception(m_buf.getBuffer(), m_buf.getCapacity(), 0.005);
       }
     }
@@ -71,6 +71,10 @@ namespace DUNE
       handleData(IMC::Parser& parser, const uint8_t* p, unsigned int n);
 
     private:
+      //! Transmit the pending aggregation frame.
+      void
+      transmitFrame(void);
+
       struct GArguments
       {
         // List of messages to publish.
@@ -83,9 +87,19 @@ namespace DUNE
         bool trace_in;
         // Trace outgoing messages.
         bool trace_out;
+        // Maximum size of aggregated frames (0 to disable).
+        unsigned frame_size;
+        // Maximum time messages wait for aggregation.
+        double frame_deadline;
       };
       GArguments m_gargs;
       Utils::ByteBuffer m_buf;
+      //! Outgoing aggregation frame.
+      Utils::ByteBuffer m_frame;
+      //! Number of bytes in the aggregation frame.
+      unsigned m_frame_used;
+      //! Time at which the first message of the frame was queued.
+      double m_frame_time;
       MessageFilter m_rl;
     };
   }
@@ -39,6 +39,7 @@
 #include <DUNE/Time/PeriodicDelay.hpp>
 #include <DUNE/Time/Counter.hpp>
 #include <DUNE/Status/Messages.hpp>
+#include <DUNE/System/Allocator.hpp>
 #include <DUNE/Tasks/Context.hpp>
 #include <DUNE/Tasks/Exceptions.hpp>
 #include <DUNE/Tasks/Task.hpp>
@@ -56,6 +57,10 @@ namespace DUNE
   {
     //! Maximum size of a log book entry message.
     const static size_t c_log_message_max_size = 1024;
+    //! Minimum interval between queue statistics reports (s).
+    const static double c_queue_stats_period = 5.0;
+    //! Names of queue overflow policies.
+    const static char* c_queue_policy_names[] = {"Drop Oldest", "Drop Newest", "Coalesce", "Block"};
 
     Task::Task(const std::string& n, Context& ctx):
       m_ctx(ctx),
@@ -63,9 +68,13 @@ namespace DUNE
       m_name(n),
       m_entity(NULL),
       m_debug_level(DEBUG_LEVEL_NONE),
-      m_honours_active(false)
+      m_honours_active(false),
+      m_queue_stats_timer(c_queue_stats_period),
+      m_arena_allocations(0),
+      m_log_drops_reported(0)
     {
       m_args.priority = 10;
+      m_args.arena_size = 0;
       m_args.act_time = 0;
       m_args.deact_time = 0;
       m_args.active = false;
@@ -78,6 +87,13 @@ namespace DUNE
       .defaultValue("10")
       .description(DTR("Execution priority"));
 
+      param(DTR_RT("Memory Arena Size"), m_args.arena_size)
+      .defaultValue("0")
+      .units(Units::Kibibyte)
+      .description(DTR("Size of a private memory arena for this task."
+                       " Set to 0 to allocate from the process-wide arena."
+                       " Requires a build with the TLSF option"));
+
       param(DTR_RT("Activation Time"), m_args.act_time)
       .defaultValue("0");
 
@@ -145,6 +161,93 @@ namespace DUNE
       onReportEntityState();
     }
 
+    void
+    Task::reportQueueStatistics(void)
+    {
+      if (!m_queue_stats_timer.overflow())
+        return;
+
+      m_queue_stats_timer.reset();
+      reportMemoryStatistics();
+      reportLogStatistics();
+
+      m_queue_stats.clear();
+      if (!m_recipient->getQueueStatistics(m_queue_stats))
+        return;
+
+      for (size_t i = 0; i < m_queue_stats.size(); ++i)
+      {
+        const QueueStatistics& qs = m_queue_stats[i];
+        reportStatistics("Queue Statistics",
+                         "MESSAGE=%s;POLICY=%s;LIMIT=%u;SIZE=%u;"
+                         "DROPPED=%u;COALESCED=%u;BLOCKED=%u",
+                         IMC::Factory::getAbbrevFromId(qs.id).c_str(),
+                         c_queue_policy_names[qs.policy],
+                         (unsigned)qs.limit, (unsigned)qs.size,
+                         qs.dropped, qs.coalesced, qs.blocked);
+      }
+    }
+
+    void
+    Task::reportMemoryStatistics(void)
+    {
+      System::Allocator::Statistics stats;
+      if (m_args.arena_size == 0 || !System::Allocator::getThreadStatistics(stats))
+        return;
+
+      if (stats.allocations == m_arena_allocations)
+        return;
+
+      m_arena_allocations = stats.allocations;
+
+      reportStatistics("Memory Statistics",
+                       "SIZE=%lu;USED=%lu;PEAK=%lu;ALLOCATIONS=%lu;FALLBACKS=%lu",
+                       (unsigned long)stats.size,
+                       (unsigned long)stats.used,
+                       (unsigned long)stats.peak,
+                       stats.allocations, stats.fallbacks);
+    }
+
+    void
+    Task::reportLogStatistics(void)
+    {
+      int drops = m_log_drops.add(0);
+      if (drops == m_log_drops_reported)
+        return;
+
+      m_log_drops_reported = drops;
+
+      reportStatistics("Log Statistics", "DROPPED=%d", drops);
+    }
+
+    void
+    Task::reportStatistics(const char* topic, const char* format, ...)
+    {
+      char bfr[c_log_message_max_size] = {0};
+      std::va_list ap;
+      va_start(ap, format);
+
+#if defined(DUNE_SYS_HAS_VSNPRINTF)
+      vsnprintf(bfr, sizeof(bfr), format, ap);
+#elif defined(DUNE_SYS_HAS_VSNPRINTF_S)
+      vsnprintf_s(bfr, sizeof(bfr), sizeof(bfr) - 1, format, ap);
+#else
+      std::vsprintf(bfr, format, ap);
+#endif
+
+      va_end(ap);
+
+      IMC::Event ev;
+      ev.topic = topic;
+      ev.data = "TASK=";
+      ev.data += getName();
+      ev.data += ';';
+      ev.data += bfr;
+      dispatch(ev);
+
+      debug("%s: %s", topic, ev.data.c_str());
+    }
+
     void
     Task::consume(const IMC::QueryEntityState* msg)
     {
@@ -350,6 +453,8 @@ namespace DUNE
     void
     Task::run(void)
     {
+      m_recipient->setConsumerThread();
+
 #if defined(DUNE_OS_LINUX)
       prctl(PR_SET_NAME, getName(), 0, 0, 0);
 #endif
@@ -361,6 +466,14 @@ namespace DUNE
       catch (...)
       { }
 
+      if (m_args.arena_size > 0)
+      {
+        if (!System::Allocator::isAvailable())
+          war(DTR("memory arenas are not available in this build"));
+        else if (!System::Allocator::createThreadArena(m_args.arena_size * 1024))
+          war(DTR("failed to create memory arena"));
+      }
+
       while (!stopping())
       {
         try
@@ -641,6 +754,13 @@ namespace DUNE
     void
     Task::log(IMC::LogBookEntry::TypeEnum type, const char* format, std::va_list arg_list)
     {
+      if (LogWriter::isRunning())
+      {
+        if (!LogWriter::write(this, type, format, arg_list))
+          m_log_drops.add(1);
+        return;
+      }
+
       char bfr[c_log_message_max_size] = {0};
 
 #if defined(DUNE_SYS_HAS_VSNPRINTF)
@@ -653,35 +773,41 @@ namespace DUNE
       std::vsprintf(bfr, format, arg_list);
 #endif
 
+      writeLog(type, Time::Clock::getSinceEpoch(), bfr);
+    }
+
+    void
+    Task::writeLog(unsigned type, double time, const char* text)
+    {
       IMC::LogBookEntry log_entry;
       log_entry.setSourceEntity(getEntityId());
       log_entry.type = type;
-      log_entry.text = bfr;
+      log_entry.text = text;
       log_entry.context = getName();
-      log_entry.htime = Time::Clock::getSinceEpoch();
+      log_entry.htime = time;
 
       dispatch(log_entry);
 
       switch (type)
       {
         case IMC::LogBookEntry::LBET_INFO:
-          DUNE_MSG(getName(), bfr);
+          DUNE_MSG(getName(), text);
           break;
 
         case IMC::LogBookEntry::LBET_WARNING:
-          DUNE_WRN(getName(), bfr);
+          DUNE_WRN(getName(), text);
           break;
 
         case IMC::LogBookEntry::LBET_ERROR:
-          DUNE_ERR(getName(), bfr);
+          DUNE_ERR(getName(), text);
           break;
 
         case IMC::LogBookEntry::LBET_CRITICAL:
-          DUNE_ERR(getName(), bfr);
+          DUNE_ERR(getName(), text);
           break;
 
         case IMC::LogBookEntry::LBET_DEBUG:
-          DUNE_DEV(getName(), bfr);
+          DUNE_DEV(getName(), text);
           break;
       }
     }
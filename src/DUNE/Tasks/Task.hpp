@@ -41,6 +41,7 @@
 #include <DUNE/Config.hpp>
 #include <DUNE/Concurrency/Thread.hpp>
 #include <DUNE/Concurrency/TSQueue.hpp>
+#include <DUNE/Concurrency/AtomicCounter.hpp>
 #include <DUNE/Tasks/Recipient.hpp>
 #include <DUNE/Tasks/Consumer.hpp>
 #include <DUNE/IMC/Constants.hpp>
@@ -50,8 +51,11 @@
 #include <DUNE/Concurrency/TLS.hpp>
 #include <DUNE/Parsers/BasicStringReader.hpp>
 #include <DUNE/Parsers/BasicStringWriter.hpp>
+#include <DUNE/Time/Counter.hpp>
+#include <DUNE/Time/Constants.hpp>
 #include <DUNE/Tasks/AbstractTask.hpp>
 #include <DUNE/Tasks/Context.hpp>
+#include <DUNE/Tasks/LogWriter.hpp>
 #include <DUNE/Tasks/BasicParameterParser.hpp>
 #include <DUNE/Tasks/ParameterTable.hpp>
 #include <DUNE/Entities/BasicEntity.hpp>
@@ -109,6 +113,8 @@ namespace DUNE
     //! Task.
     class Task: public AbstractTask
     {
+      friend class LogWriter;
+
     public:
       //! Construct a task object.
       //! @param[in] name name of the task.
@@ -119,6 +125,9 @@ namespace DUNE
       virtual
       ~Task(void)
       {
+        // Write pending log entries while the task is still valid.
+        LogWriter::flush();
+
         while (!m_entities.empty())
         {
           delete m_entities.back();
@@ -336,6 +345,14 @@ namespace DUNE
         m_recipient->put(msg);
       }
 
+      //! Queue a shared message for later consumption.
+      //! @param msg shared message handle.
+      void
+      receive(const IMC::SharedMessage& msg)
+      {
+        m_recipient->put(msg);
+      }
+
       //! Instruct task to reserve all entity identifiers that it
       //! needs for normal execution.
       void
@@ -494,6 +511,7 @@ namespace DUNE
       waitForMessages(double timeout)
       {
         m_recipient->waitForMessages(timeout);
+        reportQueueStatistics();
       }
 
       //! Call the consumers of all messages currently in the
@@ -502,6 +520,45 @@ namespace DUNE
       consumeMessages(void)
       {
         m_recipient->runCallBacks();
+        reportQueueStatistics();
+      }
+
+      //! Wait until virtual time advances by a given amount, calling
+      //! the consumers of messages as they arrive. Used instead of
+      //! Time::Delay::wait() by tasks that consume messages at the
+      //! end of each delay, so that queued messages do not stall a
+      //! lockstep clock driver.
+      //! @param[in] delay amount of virtual time in seconds.
+      void
+      waitVirtual(double delay)
+      {
+        m_recipient->waitVirtual((uint64_t)(delay * Time::c_nsec_per_sec_fp));
+        reportQueueStatistics();
+      }
+
+      //! Limit the number of messages of a given type waiting in the
+      //! receiving queue. Changes in the number of discarded,
+      //! replaced or blocked messages are periodically reported with
+      //! Event messages (topic 'Queue Statistics').
+      //! @tparam M message type.
+      //! @param[in] limit maximum number of queued messages.
+      //! @param[in] policy action taken when the limit is reached.
+      template <typename M>
+      void
+      setQueuePolicy(size_t limit, QueuePolicy policy)
+      {
+        setQueuePolicy(M::getIdStatic(), limit, policy);
+      }
+
+      //! Limit the number of messages of a given type waiting in the
+      //! receiving queue.
+      //! @param[in] message_id message identifier.
+      //! @param[in] limit maximum number of queued messages.
+      //! @param[in] policy action taken when the limit is reached.
+      void
+      setQueuePolicy(unsigned int message_id, size_t limit, QueuePolicy policy)
+      {
+        m_recipient->setQueuePolicy(message_id, limit, policy);
       }
 
       //! Declare a configuration parameter that can be parsed using
@@ -779,6 +836,8 @@ namespace DUNE
         uint16_t deact_time;
         //! Scheduling priority.
         unsigned int priority;
+        //! Size of the private memory arena (KiB).
+        unsigned int arena_size;
         //! True if task is active.
         bool active;
         //! Scope of 'Active' parameter.
@@ -807,6 +866,16 @@ namespace DUNE
       bool m_honours_active;
       //! Name of parameter section editor.
       std::string m_param_editor;
+      //! Queue statistics report timer.
+      Time::Counter<double> m_queue_stats_timer;
+      //! Queue statistics.
+      std::vector<QueueStatistics> m_queue_stats;
+      //! Number of arena allocations at the last memory report.
+      unsigned long m_arena_allocations;
+      //! Number of log entries dropped by the asynchronous log writer.
+      Concurrency::AtomicCounter m_log_drops;
+      //! Number of dropped log entries at the last report.
+      int m_log_drops_reported;
 
       //! Report current entity states by dispatching EntityState
       //! messages. This function will at least report the state of
@@ -814,9 +883,42 @@ namespace DUNE
       void
       reportEntityState(void);
 
+      //! Report statistics of message types with a queue limit that
+      //! changed since the last report, along with memory statistics.
+      void
+      reportQueueStatistics(void);
+
+      //! Report usage of the private memory arena, if the task has
+      //! one and it was used since the last report.
+      void
+      reportMemoryStatistics(void);
+
+      //! Report the number of log entries dropped by the asynchronous
+      //! log writer, if it changed since the last report.
+      void
+      reportLogStatistics(void);
+
+      //! Dispatch task statistics in an Event message. The event
+      //! data is a list of 'KEY=VALUE' pairs separated by ';', always
+      //! starting with 'TASK=<task name>', so that all statistics
+      //! topics are parsed the same way. The report is also written
+      //! to the debug log.
+      //! @param[in] topic event topic.
+      //! @param[in] format printf-like format of the remaining pairs.
+      void
+      reportStatistics(const char* topic, const char* format, ...) DUNE_PRINTF_FORMAT(3, 4);
+
       void
       log(IMC::LogBookEntry::TypeEnum type, const char* format, std::va_list arg_list);
 
+      //! Write a formatted log entry to the terminal and publish it
+      //! as a LogBookEntry message.
+      //! @param[in] type log book entry type.
+      //! @param[in] time time of the log call.
+      //! @param[in] text log text.
+      void
+      writeLog(unsigned type, double time, const char* text);
+
       void
       run(void);
 
@@ -31,12 +31,19 @@
 #include <ctime>
 #include <cstring>
 #include <cerrno>
+#include <list>
+#include <algorithm>
+
+// ISO C++ 11 headers.
+#include <atomic>
 
 // DUNE headers.
 #include <DUNE/Config.hpp>
 #include <DUNE/Time/Constants.hpp>
 #include <DUNE/Time/Clock.hpp>
 #include <DUNE/System/Error.hpp>
+#include <DUNE/Concurrency/Condition.hpp>
+#include <DUNE/Concurrency/ScopedCondition.hpp>
 
 // Platform headers.
 #if defined(DUNE_SYS_HAS_SYS_TIME_H)
@@ -59,9 +66,142 @@ namespace DUNE
     uint64_t Clock::s_starttime_mono = getNsecRT();
     double Clock::s_time_multiplier = 1.0;
 
+    //! Thread suspended until a virtual deadline.
+    struct VirtualWaiter
+    {
+      //! Monotonic deadline (ns).
+      uint64_t deadline;
+      //! Event counter that also wakes the thread or NULL.
+      const std::atomic<unsigned>* events;
+      //! True if the thread must resume.
+      bool woken;
+    };
+
+    //! Virtual time state.
+    struct VirtualClock
+    {
+      VirtualClock(void):
+        enabled(false),
+        mono(0),
+        epoch(0),
+        busy(0),
+        generation(0)
+      { }
+
+      //! True if the clock is virtual.
+      std::atomic<bool> enabled;
+      //! Monotonic time (ns).
+      std::atomic<uint64_t> mono;
+      //! Time since the UNIX Epoch (ns).
+      std::atomic<uint64_t> epoch;
+      //! Number of busy threads.
+      unsigned busy;
+      //! Incremented every time virtual time is disabled.
+      unsigned generation;
+      //! Suspended threads.
+      std::list<VirtualWaiter*> waiters;
+      //! Lock and condition protecting the fields above.
+      Concurrency::Condition cond;
+    };
+
+    //! Return the virtual time state, constructed on first use.
+    static VirtualClock&
+    getVirtualClock(void)
+    {
+      static VirtualClock clock;
+      return clock;
+    }
+
+    //! Set virtual time and wake threads whose deadlines were
+    //! reached. Must be called with the virtual clock lock held.
+    //! @param vc virtual time state.
+    //! @param epoch time since the UNIX Epoch (ns).
+    static void
+    wakeVirtualWaiters(VirtualClock& vc, uint64_t epoch)
+    {
+      uint64_t mono = vc.mono + (epoch - vc.epoch);
+      vc.epoch = epoch;
+      vc.mono = mono;
+
+      bool woken = false;
+      std::list<VirtualWaiter*>::iterator itr = vc.waiters.begin();
+      while (itr != vc.waiters.end())
+      {
+        if ((*itr)->deadline > mono)
+        {
+          ++itr;
+          continue;
+        }
+
+        (*itr)->woken = true;
+        ++vc.busy;
+        itr = vc.waiters.erase(itr);
+        woken = true;
+      }
+
+      if (woken)
+        vc.cond.broadcast();
+    }
+
+    //! True if the calling thread was woken by a virtual deadline and
+    //! did not become idle yet.
+    static thread_local bool t_busy = false;
+    //! Virtual clock generation in which t_busy was set.
+    static thread_local unsigned t_generation = 0;
+
+    //! Suspend the calling thread until a virtual deadline or an
+    //! event. Must be called with the virtual clock lock held.
+    //! @param vc virtual time state.
+    //! @param nsec amount of virtual time in nanoseconds.
+    //! @param events event counter or NULL.
+    //! @param seen value of the event counter read by the caller.
+    //! @return true if the deadline was reached or the clock is not
+    //! virtual, false if the thread was woken by an event.
+    static bool
+    suspendVirtual(VirtualClock& vc, uint64_t nsec, const std::atomic<unsigned>* events, unsigned seen)
+    {
+      if (t_busy)
+      {
+        t_busy = false;
+        if (t_generation == vc.generation && vc.busy > 0)
+          --vc.busy;
+      }
+
+      if (!vc.enabled)
+        return true;
+
+      VirtualWaiter waiter;
+      waiter.deadline = vc.mono + nsec;
+      waiter.events = events;
+      waiter.woken = false;
+
+      // Deadline already reached or events pending: the thread keeps
+      // running.
+      if (waiter.deadline <= vc.mono || (events != NULL && events->load() != seen))
+      {
+        ++vc.busy;
+      }
+      else
+      {
+        vc.waiters.push_back(&waiter);
+        while (!waiter.woken)
+          vc.cond.wait();
+
+        if (!vc.enabled)
+          return true;
+      }
+
+      t_busy = true;
+      t_generation = vc.generation;
+      return vc.mono >= waiter.deadline;
+    }
+
     uint64_t
     Clock::getNsec(void)
     {
+      if (isVirtual())
+        return getVirtualClock().mono.load();
+
       uint64_t time = getNsecRT();
       if (Clock::s_time_multiplier != 1.0) {
         double ellapsed_time = (time - s_starttime_mono);
@@ -97,6 +237,9 @@ namespace DUNE
     uint64_t
     Clock::getSinceEpochNsec(void)
     {
+      if (isVirtual())
+        return getVirtualClock().epoch.load();
+
       uint64_t time = getSinceEpochNsecRT();
       if (Clock::s_time_multiplier != 1.0) {
         double ellapsed_time = (time - s_starttime_epoch);
@@ -108,6 +251,12 @@ namespace DUNE
     void
     Clock::set(double value)
     {
+      if (isVirtual())
+      {
+        advance(value);
+        return;
+      }
+
       if (Clock::s_time_multiplier != 1.0) {
         s_starttime_epoch = value * c_nsec_per_sec;
         setTimeMultiplier(Clock::s_time_multiplier);
@@ -178,11 +327,151 @@ namespace DUNE
     double
     Clock::toSimTime(double timestamp)
     {
+      if (isVirtual())
+        return timestamp;
+
       double starttime = s_starttime_epoch / c_nsec_per_sec_fp;
       if (timestamp < starttime)
         return timestamp;
 
       return ((timestamp - starttime) * Time::Clock::s_time_multiplier) + starttime;
     }
+
+    void
+    Clock::setVirtual(double value)
+    {
+      VirtualClock& vc = getVirtualClock();
+      Concurrency::ScopedCondition l(vc.cond);
+
+      if (!vc.enabled)
+        vc.mono = getNsec();
+
+      vc.epoch = (uint64_t)(value * c_nsec_per_sec_fp);
+      vc.enabled = true;
+    }
+
+    void
+    Clock::clearVirtual(void)
+    {
+      VirtualClock& vc = getVirtualClock();
+      Concurrency::ScopedCondition l(vc.cond);
+
+      if (!vc.enabled)
+        return;
+
+      vc.enabled = false;
+      vc.busy = 0;
+      ++vc.generation;
+
+      std::list<VirtualWaiter*>::iterator itr = vc.waiters.begin();
+      for (; itr != vc.waiters.end(); ++itr)
+        (*itr)->woken = true;
+
+      vc.waiters.clear();
+      vc.cond.broadcast();
+    }
+
+    bool
+    Clock::isVirtual(void)
+    {
+      return getVirtualClock().enabled.load(std::memory_order_relaxed);
+    }
+
+    void
+    Clock::advance(double value)
+    {
+      VirtualClock& vc = getVirtualClock();
+      Concurrency::ScopedCondition l(vc.cond);
+
+      uint64_t epoch = (uint64_t)(value * c_nsec_per_sec_fp);
+      if (!vc.enabled || epoch <= vc.epoch)
+        return;
+
+      wakeVirtualWaiters(vc, epoch);
+    }
+
+    void
+    Clock::waitVirtual(uint64_t nsec)
+    {
+      VirtualClock& vc = getVirtualClock();
+      Concurrency::ScopedCondition l(vc.cond);
+      suspendVirtual(vc, nsec, NULL, 0);
+    }
+
+    bool
+    Clock::waitVirtual(uint64_t nsec, const std::atomic<unsigned>& events, unsigned seen)
+    {
+      VirtualClock& vc = getVirtualClock();
+      Concurrency::ScopedCondition l(vc.cond);
+      return suspendVirtual(vc, nsec, &events, seen);
+    }
+
+    void
+    Clock::notifyVirtual(std::atomic<unsigned>& events)
+    {
+      // The waiter checks the counter with the lock held, so it either
+      // sees the increment or is already in the list.
+      events.fetch_add(1);
+
+      if (!isVirtual())
+        return;
+
+      VirtualClock& vc = getVirtualClock();
+      Concurrency::ScopedCondition l(vc.cond);
+
+      std::list<VirtualWaiter*>::iterator itr = vc.waiters.begin();
+      for (; itr != vc.waiters.end(); ++itr)
+      {
+        if ((*itr)->events != &events)
+          continue;
+
+        (*itr)->woken = true;
+        ++vc.busy;
+        vc.waiters.erase(itr);
+        vc.cond.broadcast();
+        return;
+      }
+    }
+
+    void
+    Clock::setIdle(void)
+    {
+      if (!t_busy)
+        return;
+
+      t_busy = false;
+
+      VirtualClock& vc = getVirtualClock();
+      Concurrency::ScopedCondition l(vc.cond);
+      if (t_generation == vc.generation && vc.busy > 0)
+        --vc.busy;
+    }
+
+    unsigned
+    Clock::getBusyCount(void)
+    {
+      VirtualClock& vc = getVirtualClock();
+      Concurrency::ScopedCondition l(vc.cond);
+      return vc.busy;
+    }
+
+    double
+    Clock::advanceToNextDeadline(double max_step)
+    {
+      VirtualClock& vc = getVirtualClock();
+      Concurrency::ScopedCondition l(vc.cond);
+
+      if (!vc.enabled)
+        return 0;
+
+      uint64_t mono = vc.mono + (uint64_t)(max_step * c_nsec_per_sec_fp);
+      std::list<VirtualWaiter*>::const_iterator itr = vc.waiters.begin();
+      for (; itr != vc.waiters.end(); ++itr)
+        mono = std::min(mono, (*itr)->deadline);
+
+      uint64_t delta = mono - vc.mono;
+      wakeVirtualWaiters(vc, vc.epoch + delta);
+      return delta / c_nsec_per_sec_fp;
+    }
   }
 }
@@ -30,6 +30,9 @@
 #ifndef DUNE_TIME_CLOCK_HPP_INCLUDED_
 #define DUNE_TIME_CLOCK_HPP_INCLUDED_
 
+// ISO C++ 11 headers.
+#include <atomic>
+
 // DUNE headers.
 #include <DUNE/Config.hpp>
 #include <DUNE/Time/Constants.hpp>
@@ -183,6 +186,77 @@ namespace DUNE
       static double
       toSimTime(double timestamp);
 
+      //! Drive the clock from virtual time. Until clearVirtual() is
+      //! called, the clock only changes when advance() is called and
+      //! Delay::wait() suspends the calling thread until the virtual
+      //! deadline is reached.
+      //! @param value initial time in seconds since the UNIX Epoch.
+      static void
+      setVirtual(double value);
+
+      //! Return the clock to real time, waking all threads suspended
+      //! on virtual deadlines.
+      static void
+      clearVirtual(void);
+
+      //! Test if the clock is driven by virtual time.
+      //! @return true if the clock is virtual, false otherwise.
+      static bool
+      isVirtual(void);
+
+      //! Advance virtual time, waking threads whose deadlines were
+      //! reached. Time never moves backwards.
+      //! @param value time in seconds since the UNIX Epoch.
+      static void
+      advance(double value);
+
+      //! Suspend the calling thread until virtual time advances by a
+      //! given amount. The thread is accounted as busy from the moment
+      //! it is woken until it waits again, blocks on a condition,
+      //! futex or I/O poll, or calls setIdle().
+      //! @param nsec amount of virtual time in nanoseconds.
+      static void
+      waitVirtual(uint64_t nsec);
+
+      //! Suspend the calling thread until virtual time advances by a
+      //! given amount or notifyVirtual() is called for a given event
+      //! counter. The thread is accounted as busy once it resumes, as
+      //! with waitVirtual().
+      //! @param nsec amount of virtual time in nanoseconds.
+      //! @param events event counter.
+      //! @param seen value of the event counter read by the caller
+      //! before checking for events, the thread is not suspended if
+      //! the counter changed meanwhile.
+      //! @return true if the deadline was reached or the clock is not
+      //! virtual, false if the thread was woken by an event.
+      static bool
+      waitVirtual(uint64_t nsec, const std::atomic<unsigned>& events, unsigned seen);
+
+      //! Increment an event counter and wake the thread waiting on it
+      //! with waitVirtual(), if any.
+      //! @param events event counter.
+      static void
+      notifyVirtual(std::atomic<unsigned>& events);
+
+      //! Mark the calling thread as idle, i.e., done with the work
+      //! triggered by its last virtual deadline.
+      static void
+      setIdle(void);
+
+      //! Retrieve the number of threads woken by virtual deadlines
+      //! that have not yet become idle.
+      //! @return number of busy threads.
+      static unsigned
+      getBusyCount(void);
+
+      //! Advance virtual time to the earliest deadline of the threads
+      //! suspended on virtual time, waking them, but never by more
+      //! than a given amount.
+      //! @param max_step maximum amount of time to advance in seconds.
+      //! @return amount of time advanced in seconds.
+      static double
+      advanceToNextDeadline(double max_step);
+
     private:
       static uint64_t s_starttime_epoch;
       static uint64_t s_starttime_mono;
@@ -70,7 +70,9 @@ namespace DUNE
       }
 
       //! Suspends the execution of the calling thread for the
-      //! specified amount of time (in seconds).
+      //! specified amount of time (in seconds). If the clock is
+      //! virtual, the thread is suspended until virtual time advances
+      //! by the given amount.
       //! @param s the amount of time to suspend.
       static void
       wait(double s)
@@ -78,6 +80,12 @@ namespace DUNE
         uint64_t secs = (uint64_t)s;
         uint64_t nsecs = secs * c_nsec_per_sec + (uint64_t)((s - secs) * c_nsec_per_sec_fp);
 
+        if (Time::Clock::isVirtual())
+        {
+          Time::Clock::waitVirtual(nsecs);
+          return;
+        }
+
         nsecs /= Time::Clock::getTimeMultiplier();
         waitNsec(nsecs);
       }
@@ -252,8 +252,8 @@ main(int argc, char** argv)
   // If requested, lock memory.
   if (!options.value("--lock-memory").empty())
   {
-#if defined(DUNE_USING_TLSF) && defined(DUNE_CLIB_GNU)
-    Resources::lockMemory(c_memory, c_memory_size);
+#if defined(DUNE_USING_TLSF) && defined(DUNE_OS_LINUX)
+    Allocator::lockMemory();
 #else
     Resources::lockMemory();
 #endif
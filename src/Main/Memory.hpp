@@ -30,51 +30,75 @@
 #ifndef MAIN_MEMORY_HPP_INCLUDED_
 #define MAIN_MEMORY_HPP_INCLUDED_
 
-#if defined(DUNE_USING_TLSF) && defined(DUNE_CLIB_GNU)
-#  include <malloc.h>
-#  include <tlsf/tlsf.h>
+// The global operator new and delete are routed through the TLSF
+// arenas of System::Allocator. Only the C++ allocation functions are
+// replaced; the C library allocator is left untouched.
+#if defined(DUNE_USING_TLSF) && defined(DUNE_OS_LINUX)
+#  include <new>
+#  include <DUNE/System/Allocator.hpp>
 
-#  if !defined(DUNE_MEMORY_SIZE)
-#    define DUNE_MEMORY_SIZE (16 * 1024 * 1024)
-#  endif
+void*
+operator new(std::size_t size)
+{
+  void* ptr = DUNE::System::Allocator::allocate(size);
+  if (ptr == NULL)
+    throw std::bad_alloc();
+  return ptr;
+}
 
-static const unsigned c_memory_size = DUNE_MEMORY_SIZE;
-static char c_memory[c_memory_size];
+void*
+operator new[](std::size_t size)
+{
+  return operator new(size);
+}
 
-static void*
-tlsf_malloc_hook(size_t s, const void* c)
+void*
+operator new(std::size_t size, const std::nothrow_t&) throw()
 {
-  return tlsf_malloc(s);
+  return DUNE::System::Allocator::allocate(size);
 }
 
-static void
-tlsf_free_hook(void* p, const void* c)
+void*
+operator new[](std::size_t size, const std::nothrow_t&) throw()
 {
-  tlsf_free(p);
+  return DUNE::System::Allocator::allocate(size);
 }
 
-static void*
-tlsf_realloc_hook(void* p, size_t s, const void* c)
+void
+operator delete(void* ptr) throw()
 {
-  return tlsf_realloc(p, s);
+  DUNE::System::Allocator::deallocate(ptr);
 }
 
-static void
-tlsf_init_hook(void)
+void
+operator delete[](void* ptr) throw()
 {
-  init_memory_pool(c_memory_size, c_memory);
-  __malloc_hook = tlsf_malloc_hook;
-  __free_hook = tlsf_free_hook;
-  __realloc_hook = tlsf_realloc_hook;
+  DUNE::System::Allocator::deallocate(ptr);
 }
 
-// Override initializing hook from the C library.
-#  if (__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 15)
-void(*volatile __malloc_initialize_hook) (void) = tlsf_init_hook;
-#  else
-void (* __malloc_initialize_hook)(void) = tlsf_init_hook;
-#  endif
+void
+operator delete(void* ptr, std::size_t) throw()
+{
+  DUNE::System::Allocator::deallocate(ptr);
+}
 
-#endif
+void
+operator delete[](void* ptr, std::size_t) throw()
+{
+  DUNE::System::Allocator::deallocate(ptr);
+}
+
+void
+operator delete(void* ptr, const std::nothrow_t&) throw()
+{
+  DUNE::System::Allocator::deallocate(ptr);
+}
 
+void
+operator delete[](void* ptr, const std::nothrow_t&) throw()
+{
+  DUNE::System::Allocator::deallocate(ptr);
+}
+
+#endif
 #endif
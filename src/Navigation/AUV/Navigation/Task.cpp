@@ -170,11 +170,20 @@ namespace Navigation
         double speed_relation_limit_value;
         //!  Distance of Depth sensor to the veicle pitch rotation axis 
         float distance_depth_sensor;
+        //! Kalman Filter measurement update method.
+        std::string update_method;
 
       };
 
+      //! Extended Kalman Filter with room for all LBL transponders.
+      typedef DUNE::Navigation::FixedKalmanFilter<NUM_STATE, NUM_OUT + DUNE::Navigation::c_max_transponders> Filter;
+
       struct Task: public DUNE::Navigation::BasicNavigation
       {
+        //! Extended Kalman Filter matrices.
+        Filter m_kal;
+        //! State transition model workspace.
+        Filter::StateMatrix m_a;
         //! Periodic GPS fix reading check.
         bool m_gps_reading;
         //! USBL fix reading check.
@@ -290,6 +299,12 @@ namespace Navigation
           .maximumValue("100")
           .description("speed to rpm maximum diference between estimation and speed model");
 
+          param("Kalman Filter Update", m_args.update_method)
+          .defaultValue("Dense")
+          .values("Dense, Sequential, Square Root")
+          .description("Kalman Filter measurement update method. Sequential"
+                       " methods process each available output separately");
+
           // Extended Kalman Filter initialization.
           m_kal.reset(NUM_STATE, NUM_OUT);
           resetKalman();
@@ -304,6 +319,16 @@ namespace Navigation
         {
           BasicNavigation::onUpdateParameters();
 
+          if (paramChanged(m_args.update_method))
+          {
+            if (m_args.update_method == "Sequential")
+              m_kal.setUpdateMethod(Filter::UM_SEQUENTIAL);
+            else if (m_args.update_method == "Square Root")
+              m_kal.setUpdateMethod(Filter::UM_SQUARE_ROOT);
+            else
+              m_kal.setUpdateMethod(Filter::UM_DENSE);
+          }
+
           // Initialize Process and Measure Covariances matrices
           m_kal.setProcessNoise(STATE_X, m_process_noise[PN_POSITION]);
           m_kal.setProcessNoise(STATE_Y, m_process_noise[PN_POSITION]);
@@ -551,6 +576,12 @@ namespace Navigation
           return NUM_OUT;
         }
 
+        DUNE::Navigation::AbstractKalmanFilter&
+        getFilter(void)
+        {
+          return m_kal;
+        }
+
         void
         task(void)
         {
@@ -565,23 +596,21 @@ namespace Navigation
 
           // Kalman Filter
           // Reset and Discretize A matrix
-          Matrix a(NUM_STATE, NUM_STATE, 0.0);
-          setTransition(a);
+          setTransition(m_a);
 
-          Matrix x(NUM_STATE, 1, 0.0);
-          x = m_kal.getState();
+          const Filter::StateVector& x = m_kal.getState();
 
-          m_kal.setStateTransition((a * tstep).expmts());
+          m_kal.setStateTransition((m_a * tstep).expmts());
 
           // Modify covariance state transition matrix.
           double yaw = m_kal.getState(STATE_PSI);
 
-          a(STATE_X, STATE_PSI) = (- x(STATE_U) * std::sin(yaw)
-                                   - x(STATE_V) * std::cos(yaw));
-          a(STATE_Y, STATE_PSI) = (x(STATE_U) * std::cos(yaw)
-                                   - x(STATE_V) * std::sin(yaw));
+          m_a(STATE_X, STATE_PSI) = (- x(STATE_U) * std::sin(yaw)
+                                     - x(STATE_V) * std::cos(yaw));
+          m_a(STATE_Y, STATE_PSI) = (x(STATE_U) * std::cos(yaw)
+                                     - x(STATE_V) * std::sin(yaw));
 
-          m_kal.setCovarianceTransition((a * tstep).expmts());
+          m_kal.setCovarianceTransition((m_a * tstep).expmts());
 
           // Kalman Prediction.
           m_kal.predict();
@@ -764,7 +793,7 @@ namespace Navigation
 
         // Reinitialize Extended Kalman Filter transition matrix function.
         void
-        setTransition(Matrix& A)
+        setTransition(Filter::StateMatrix& A)
         {
           A.fill(0.0);
 
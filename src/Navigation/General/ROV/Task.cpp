@@ -94,6 +94,8 @@ namespace Navigation
 
       struct Task: public DUNE::Navigation::BasicNavigation
       {
+        //! Kalman Filter matrices.
+        DUNE::Navigation::KalmanFilter m_kal;
         //! Periodic GPS fix reading check.
         bool m_gps_reading;
 
@@ -180,6 +182,12 @@ namespace Navigation
           return NUM_OUT;
         }
 
+        DUNE::Navigation::AbstractKalmanFilter&
+        getFilter(void)
+        {
+          return m_kal;
+        }
+
         void
         getSpeedOutputStates(unsigned* u, unsigned* v)
         {
@@ -0,0 +1,278 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <csignal>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+namespace Simulators
+{
+  //! Discrete-event scheduler that runs simulations faster than real
+  //! time.
+  //!
+  //! The task drives the clock from virtual time. Periodic tasks
+  //! (simulators, controllers, navigation) suspend on virtual
+  //! deadlines and the clock is advanced to the next deadline as
+  //! soon as all woken tasks finished their step and all dispatched
+  //! messages were consumed. Simulations thus run in lockstep, as
+  //! fast as the CPU allows or capped at a maximum speed-up.
+  //!
+  //! Message waits with timeouts still expire in real time, hence
+  //! the amount of virtual time advanced at once is bounded.
+  //!
+  //! @author Ricardo Martins
+  namespace Scheduler
+  {
+    using DUNE_NAMESPACES;
+
+    //! Number of times the idle loop yields before sleeping.
+    static const unsigned c_spins = 100;
+    //! Idle loop sleep period (ns).
+    static const uint64_t c_sleep = 100000;
+    //! Statistics report period (real time, s).
+    static const double c_report_period = 10.0;
+
+    //! %Task arguments.
+    struct Arguments
+    {
+      //! Real time to wait before switching to virtual time.
+      double start_delay;
+      //! Maximum amount of virtual time advanced at once.
+      double max_step;
+      //! Maximum ratio between virtual and real time.
+      double max_speed_up;
+      //! Virtual time after which the system is terminated.
+      double duration;
+      //! Maximum real time to wait for tasks to become idle.
+      double step_timeout;
+    };
+
+    struct Task: public DUNE::Tasks::Task
+    {
+      //! Task arguments.
+      Arguments m_args;
+      //! True if the clock is being driven by this task.
+      bool m_virtual;
+      //! True if a step timeout was already reported.
+      bool m_timeout_warned;
+      //! Virtual time when virtual time was enabled.
+      double m_virtual_start;
+      //! Real time when virtual time was enabled.
+      double m_real_start;
+      //! Number of steps.
+      unsigned long m_steps;
+      //! Statistics report timer (real time).
+      double m_next_report;
+
+      Task(const std::string& name, Tasks::Context& ctx):
+        DUNE::Tasks::Task(name, ctx),
+        m_virtual(false),
+        m_timeout_warned(false),
+        m_virtual_start(0),
+        m_real_start(0),
+        m_steps(0),
+        m_next_report(0)
+      {
+        param("Start Delay", m_args.start_delay)
+        .units(Units::Second)
+        .minimumValue("0.0")
+        .defaultValue("2.0")
+        .description("Real time to wait before switching to virtual time,"
+                     " allowing tasks to initialize");
+
+        param("Maximum Step", m_args.max_step)
+        .units(Units::Second)
+        .minimumValue("0.001")
+        .defaultValue("0.1")
+        .description("Maximum amount of virtual time advanced at once, also"
+                     " used when no task is waiting on virtual time");
+
+        param("Maximum Speed-Up", m_args.max_speed_up)
+        .minimumValue("0.0")
+        .defaultValue("0.0")
+        .description("Maximum ratio between virtual and real time."
+                     " Set to 0 to run as fast as possible");
+
+        param("Duration", m_args.duration)
+        .units(Units::Second)
+        .minimumValue("0.0")
+        .defaultValue("0.0")
+        .description("Amount of virtual time after which the system is"
+                     " terminated. Set to 0 to run indefinitely");
+
+        param("Step Timeout", m_args.step_timeout)
+        .units(Units::Second)
+        .minimumValue("0.1")
+        .defaultValue("5.0")
+        .description("Maximum amount of real time to wait for tasks to"
+                     " finish a step");
+      }
+
+      void
+      onResourceInitialization(void)
+      {
+        setEntityState(IMC::EntityState::ESTA_NORMAL, Status::CODE_IDLE);
+      }
+
+      void
+      onResourceRelease(void)
+      {
+        stopVirtual();
+      }
+
+      //! Switch the clock to virtual time.
+      void
+      startVirtual(void)
+      {
+        m_virtual_start = Clock::getSinceEpoch();
+        m_real_start = Clock::getRT();
+        m_next_report = m_real_start + c_report_period;
+        m_steps = 0;
+
+        Clock::setVirtual(m_virtual_start);
+        m_ctx.mbus.setTracking(true);
+        m_virtual = true;
+
+        setEntityState(IMC::EntityState::ESTA_NORMAL, Status::CODE_ACTIVE);
+        inf(DTR("running on virtual time"));
+      }
+
+      //! Return the clock to real time.
+      void
+      stopVirtual(void)
+      {
+        if (!m_virtual)
+          return;
+
+        m_ctx.mbus.setTracking(false);
+        Clock::clearVirtual();
+        m_virtual = false;
+      }
+
+      //! Wait until all messages dispatched so far were consumed and
+      //! all tasks woken by the virtual clock are idle.
+      void
+      waitForTasks(void)
+      {
+        double deadline = Clock::getRT() + m_args.step_timeout;
+
+        for (unsigned spins = 0; !stopping(); ++spins)
+        {
+          consumeMessages();
+
+          if (m_ctx.mbus.isDrained() && Clock::getBusyCount() == 0)
+            return;
+
+          if (Clock::getRT() >= deadline)
+          {
+            if (!m_timeout_warned)
+            {
+              war(DTR("tasks did not finish step in time, some tasks may not be idle"));
+              m_timeout_warned = true;
+            }
+            return;
+          }
+
+          if (spins < c_spins)
+            Concurrency::Scheduler::yield();
+          else
+            Delay::waitNsec(c_sleep);
+        }
+      }
+
+      //! Wait, in real time, until the speed-up is below the maximum.
+      void
+      limitSpeedUp(void)
+      {
+        if (m_args.max_speed_up <= 0)
+          return;
+
+        double elapsed = Clock::getSinceEpoch() - m_virtual_start;
+        double delta = m_real_start + elapsed / m_args.max_speed_up - Clock::getRT();
+        if (delta > 0)
+          Delay::waitNsec((uint64_t)(delta * c_nsec_per_sec_fp));
+      }
+
+      void
+      reportStatistics(void)
+      {
+        double now = Clock::getRT();
+        if (now < m_next_report)
+          return;
+
+        m_next_report = now + c_report_period;
+
+        double elapsed = Clock::getSinceEpoch() - m_virtual_start;
+        debug("virtual time: %0.1f s | speed-up: x%0.1f | steps: %lu",
+              elapsed, elapsed / (now - m_real_start), m_steps);
+      }
+
+      void
+      onMain(void)
+      {
+        double start = Clock::getRT() + m_args.start_delay;
+        while (!stopping() && Clock::getRT() < start)
+          waitForMessages(std::min(1.0, std::max(0.0, start - Clock::getRT())));
+
+        if (stopping())
+          return;
+
+        startVirtual();
+
+        while (!stopping())
+        {
+          waitForTasks();
+
+          if (m_args.duration > 0 && Clock::getSinceEpoch() - m_virtual_start >= m_args.duration)
+          {
+            inf(DTR("simulation duration reached, terminating"));
+            stopVirtual();
+            setEntityState(IMC::EntityState::ESTA_NORMAL, Status::CODE_IDLE);
+            std::raise(SIGTERM);
+            break;
+          }
+
+          limitSpeedUp();
+          Clock::advanceToNextDeadline(m_args.max_step);
+          ++m_steps;
+
+          reportStatistics();
+        }
+
+        while (!stopping())
+          waitForMessages(1.0);
+      }
+    };
+  }
+}
+
+DUNE_TASK
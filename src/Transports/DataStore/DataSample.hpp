@@ -0,0 +1,84 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Universidade do Porto. For licensing   *
+// terms, conditions, and further information contact lsts@fe.up.pt.        *
+//                                                                          *
+// European Union Public Licence - EUPL v.1.1 Usage                         *
+// Alternatively, this file may be used under the terms of the EUPL,        *
+// Version 1.1 only (the "Licence"), appearing in the file LICENCE.md       *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Jose Pinto                                                       *
+//***************************************************************************
+// Author: Jose Pinto                                                       *
+//***************************************************************************
+
+#ifndef SRC_TRANSPORTS_DATASTORE_DATASAMPLE_HPP_
+#define SRC_TRANSPORTS_DATASTORE_DATASAMPLE_HPP_
+
+#define BASE_HISTORY_SIZE 36
+#define MINIMUM_SAMPLE_SIZE 15
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+namespace Transports
+{
+  namespace DataStore
+  {
+    using DUNE_NAMESPACES;
+
+    //! Class used to store a single sample.
+    //! All samples have a location, timestamp, priority and a message (IMC).
+    class DataSample
+    {
+    public:
+      //! Sample global coordinates
+      double latDegs, lonDegs, zMeters, timestamp;
+
+      //! Priority of the sample (higher priority samples are transmitted first)
+      int priority;
+
+      //! The system that generated this sample
+      int source;
+
+      //! Actual data gathered at these coords
+      IMC::Message* sample;
+
+      DataSample(void)
+      {
+        latDegs = lonDegs = zMeters = timestamp = 0;
+        priority = source = -1;
+        sample = NULL;
+      }
+
+      ~DataSample(void)
+      {
+        if (sample != NULL)
+          delete sample;
+      }
+
+      int
+      serializationSize(void) const
+      {
+        return sample->getPayloadSerializationSize() + MINIMUM_SAMPLE_SIZE;
+      }
+    };
+  }
+}
+
+#endif
@@ -28,67 +28,24 @@
 #ifndef SRC_TRANSPORTS_DATASTORE_DATASTORE_HPP_
 #define SRC_TRANSPORTS_DATASTORE_DATASTORE_HPP_
 
-#define BASE_HISTORY_SIZE 36
-#define MINIMUM_SAMPLE_SIZE 15
-
 // ISO C++ 98 headers.
+#include <map>
 #include <string>
+#include <vector>
 
 // DUNE headers.
 #include <DUNE/DUNE.hpp>
 
+// Local headers.
+#include "DataSample.hpp"
+#include "Storage.hpp"
+
 namespace Transports
 {
   namespace DataStore
   {
     using DUNE_NAMESPACES;
 
-    //! Class used to store a single sample.
-    //! All samples have a location, timestamp, priority and a message (IMC).
-    class DataSample
-    {
-    public:
-      //! Sample global coordinates
-      double latDegs, lonDegs, zMeters, timestamp;
-
-      //! Priority of the sample (higher priority samples are transmitted first)
-      int priority;
-
-      //! The system that generated this sample
-      int source;
-
-      //! Actual data gathered at these coords
-      IMC::Message* sample;
-
-      DataSample(void)
-      {
-        latDegs = lonDegs = zMeters = timestamp = 0;
-        priority = source = -1;
-        sample = NULL;
-      }
-
-      ~DataSample(void)
-      {
-        if (sample != NULL)
-          delete sample;
-      }
-
-      int
-      serializationSize(void)
-      {
-        return sample->getPayloadSerializationSize() + MINIMUM_SAMPLE_SIZE;
-      }
-    };
-
-    class CompareSamples
-    {
-    public:
-      bool operator()(const DataSample* p1, const DataSample* p2) const
-      {
-        return p1->priority <= p2->priority && p1->timestamp < p2->timestamp;
-      }
-    };
-
     //! Translate a (global coordinates) Data Sample into an IMC HistoricSample message
     HistoricSample*
     parse(DataSample* sample, double base_lat, double base_lon, long base_time)
@@ -146,31 +103,62 @@ namespace Transports
       }
     }
 
-    //! This class is used to store samples locally until they are forwarded to other node
+    //! This class is used to store samples locally until they are forwarded to other node.
+    //! Samples are kept on disk and survive restarts; samples handed out for
+    //! forwarding remain stored until their batch is released.
     class DataStore
     {
     public:
       DataStore(Task* task):
+        m_storage(task),
+        m_batch(0),
         m_task(task)
-    { }
+      { }
 
       ~DataStore(void)
       {
-        Concurrency::ScopedRWLock(m_lock, true);
-        while (!m_samples.empty())
-        {
-          delete m_samples.top();
-          m_samples.pop();
-        }
+        close();
+      }
+
+      //! Open the sample storage, recovering samples stored before.
+      //! @param[in] folder storage folder.
+      //! @param[in] segment_size segment size in bytes.
+      //! @param[in] max_size maximum amount of stored samples in bytes.
+      void
+      open(const Path& folder, uint32_t segment_size, uint64_t max_size)
+      {
+        Concurrency::ScopedRWLock l(m_lock, true);
+        m_batches.clear();
+        m_storage.open(folder, segment_size, max_size);
+      }
+
+      //! Close the sample storage. Samples of unreleased batches
+      //! will be forwarded again.
+      void
+      close(void)
+      {
+        Concurrency::ScopedRWLock l(m_lock, true);
+        m_batches.clear();
+        m_storage.close();
+      }
+
+      //! Make sure stored samples reach the storage device.
+      void
+      flush(void)
+      {
+        Concurrency::ScopedRWLock l(m_lock, true);
+        m_storage.flush();
       }
 
       //! Add sample to this store
       void
       addSample(DataSample* sample)
       {
-        Concurrency::ScopedRWLock(m_lock, true);
+        Concurrency::ScopedRWLock l(m_lock, true);
         m_task->debug("Adding sample %d/%f", sample->sample->getId(), sample->timestamp);
-        m_samples.push(sample);
+        if (!m_storage.add(sample))
+          m_task->war("Unable to store sample of type %s.", sample->sample->getName());
+        delete sample;
       }
 
       //! Add a series of historic samples packed as an HistoricData message
@@ -247,64 +235,106 @@ namespace Transports
           return ret;
       }
 
-      //! Retrieve a series of sample that take up to 'size'
+      //! Retrieve a series of sample that take up to 'size'.
+      //! Samples stay stored until the batch is released.
+      //! @param[in] size maximum serialization size.
+      //! @param[out] batch batch identifier.
+      //! @return samples or NULL if no sample fits.
       IMC::HistoricData*
-      pollSamples(int size)
+      pollSamples(int size, unsigned& batch)
       {
-
         size -= BASE_HISTORY_SIZE; // base fields from HistoricData
-        IMC::HistoricData* ret = new IMC::HistoricData();
 
-        std::vector<DataSample*> added, rejected;
+        Concurrency::ScopedRWLock l(m_lock, true);
+        Storage::Queue& queue = m_storage.getQueue();
+        std::vector<StoredSample*> added;
 
-        Concurrency::ScopedRWLock(m_lock, true);
-        while (!m_samples.empty() && size > MINIMUM_SAMPLE_SIZE)
+        // select samples that fit, in forwarding order
+        Storage::Queue::iterator itr = queue.begin();
+        while (itr != queue.end() && size > MINIMUM_SAMPLE_SIZE)
         {
-          // pop next sample
-          DataSample* sample = m_samples.top();
-          m_samples.pop();
+          if ((*itr)->size > size)
+          {
+            ++itr;
+            continue;
+          }
+
+          size -= (*itr)->size;
+          added.push_back(*itr);
+          queue.erase(itr++);
+        }
 
-          // check if there is space left for this sample
-          int sample_size = sample->serializationSize();
-          if (sample_size > size)
+        IMC::HistoricData* ret = NULL;
+        std::vector<StoredSample*> loaded;
+
+        for (size_t i = 0; i < added.size(); ++i)
+        {
+          DataSample sample;
+          if (!m_storage.load(added[i], sample))
           {
-            rejected.push_back(sample);
+            m_task->war("Dropping unreadable sample.");
+            m_storage.remove(added[i]);
+            continue;
           }
-          else
+
+          if (ret == NULL)
           {
-            size -= sample_size;
-            added.push_back(sample);
+            ret = new IMC::HistoricData();
+            ret->base_lat = sample.latDegs;
+            ret->base_lon = sample.lonDegs;
+            ret->base_time = sample.timestamp;
           }
-        }
 
-        // add back samples that didn't fit on the message
-        std::vector<DataSample *>::iterator it;
-        for (it = rejected.begin(); it != rejected.end(); it++)
-        {
-          m_samples.push(*it);
+          ret->data.push_back(parse(&sample, ret->base_lat, ret->base_lon, ret->base_time));
+          loaded.push_back(added[i]);
         }
 
         // no data can be added
-        if (added.empty())
+        if (ret == NULL)
           return NULL;
 
-        ret->base_lat = added.at(0)->latDegs;
-        ret->base_lon = added.at(0)->lonDegs;
-        ret->base_time = added.at(0)->timestamp;
+        batch = ++m_batch;
+        m_batches[batch].swap(loaded);
+        return ret;
+      }
 
-        for (it = added.begin(); it != added.end(); it++)
-        {
-          DataSample * sample = *it;
-          ret->data.push_back(
-              parse(sample, ret->base_lat, ret->base_lon, ret->base_time));
-          delete sample;
-        }
+      //! Remove the samples of a batch that was delivered.
+      //! @param[in] batch batch identifier.
+      void
+      release(unsigned batch)
+      {
+        Concurrency::ScopedRWLock l(m_lock, true);
+        std::map<unsigned, std::vector<StoredSample*> >::iterator itr = m_batches.find(batch);
+        if (itr == m_batches.end())
+          return;
 
-        return ret;
+        for (size_t i = 0; i < itr->second.size(); ++i)
+          m_storage.remove(itr->second[i]);
+
+        m_batches.erase(itr);
+      }
+
+      //! Queue the samples of a batch that was not delivered again.
+      //! @param[in] batch batch identifier.
+      void
+      restore(unsigned batch)
+      {
+        Concurrency::ScopedRWLock l(m_lock, true);
+        std::map<unsigned, std::vector<StoredSample*> >::iterator itr = m_batches.find(batch);
+        if (itr == m_batches.end())
+          return;
+
+        m_storage.getQueue().insert(itr->second.begin(), itr->second.end());
+        m_batches.erase(itr);
       }
 
     private:
-      std::priority_queue<DataSample *, std::vector<DataSample *> , CompareSamples> m_samples;
+      //! Persistent sample storage.
+      Storage m_storage;
+      //! Samples handed out for forwarding, by batch.
+      std::map<unsigned, std::vector<StoredSample*> > m_batches;
+      //! Last batch identifier.
+      unsigned m_batch;
       std::vector<RemoteCommand* > m_commands;
       Concurrency::RWLock m_lock;
       Task* m_task;
@@ -233,7 +233,8 @@ namespace Transports
 
       void iridiumUpload(DataStore* store)
       {
-        IMC::HistoricData* data = store->pollSamples(c_max_size_iridium);
+        unsigned batch = 0;
+        IMC::HistoricData* data = store->pollSamples(c_max_size_iridium, batch);
         if (data == NULL)
           return;
 
@@ -245,6 +246,7 @@ namespace Transports
         tr.req_id               = createInternalId();
         m_parent->inf("Requesting upload of %u samples via Iridium.", (uint32_t) data->data.size());
         m_parent->dispatch(tr);
+        store->release(batch);
         Memory::clear(data);        
       }
 
@@ -0,0 +1,944 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Universidade do Porto. For licensing   *
+// terms, conditions, and further information contact lsts@fe.up.pt.        *
+//                                                                          *
+// European Union Public Licence - EUPL v.1.1 Usage                         *
+// Alternatively, this file may be used under the terms of the EUPL,        *
+// Version 1.1 only (the "Licence"), appearing in the file LICENCE.md       *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Jose Pinto                                                       *
+//***************************************************************************
+// Author: Jose Pinto                                                       *
+//***************************************************************************
+
+#ifndef SRC_TRANSPORTS_DATASTORE_STORAGE_HPP_
+#define SRC_TRANSPORTS_DATASTORE_STORAGE_HPP_
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// POSIX headers.
+#if defined(DUNE_SYS_HAS_FDATASYNC)
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+// Local headers.
+#include "DataSample.hpp"
+
+namespace Transports
+{
+  namespace DataStore
+  {
+    using DUNE_NAMESPACES;
+
+    //! Synchronization number of storage records.
+    static const uint16_t c_record_sync = 0xD5A7;
+    //! Size of the record header: sync, type, payload size and CRC.
+    static const unsigned c_record_header = 9;
+    //! Size of the fixed fields of sample records.
+    static const unsigned c_sample_fields = 44;
+    //! Extension of segment files.
+    static const char* const c_segment_ext = ".dsg";
+    //! Segment number of samples kept in memory.
+    static const uint32_t c_memory_segment = 0xffffffff;
+    //! Time between attempts to write to an unavailable storage.
+    static const double c_retry_period = 30.0;
+
+    //! Record types.
+    enum RecordType
+    {
+      //! Sample record.
+      RT_SAMPLE = 1,
+      //! Removal of previously stored samples.
+      RT_REMOVE = 2
+    };
+
+    //! Location and ordering keys of a sample kept on disk.
+    struct StoredSample
+    {
+      //! Sample identifier.
+      uint32_t id;
+      //! Sample priority.
+      int priority;
+      //! Sample timestamp.
+      double timestamp;
+      //! Serialization size inside an HistoricData message.
+      int size;
+      //! Segment holding the sample.
+      uint32_t segment;
+      //! Offset of the record in the segment.
+      uint32_t offset;
+      //! Size of the record, including header.
+      uint32_t length;
+      //! Record of a sample kept in memory, while the storage device
+      //! cannot be written.
+      std::vector<uint8_t> record;
+    };
+
+    //! Forwarding order: higher priority first, then newer samples.
+    struct CompareStoredSamples
+    {
+      bool
+      operator()(const StoredSample* a, const StoredSample* b) const
+      {
+        if (a->priority != b->priority)
+          return a->priority > b->priority;
+
+        if (a->timestamp != b->timestamp)
+          return a->timestamp > b->timestamp;
+
+        return a->id < b->id;
+      }
+    };
+
+    //! Append-only, segmented sample storage. Samples and their
+    //! removals are appended as checksummed records to segment files;
+    //! only their location and ordering keys are kept in memory.
+    //! Stored samples are replayed when the storage is reopened and
+    //! truncated or corrupted records, from an interrupted write, are
+    //! discarded. The oldest segment is deleted when none of its
+    //! samples remain and compacted, by copying its remaining samples
+    //! to the newest segment, when most of it is dead. When the
+    //! storage device cannot be written, new samples are kept in
+    //! memory and written once it becomes available again.
+    class Storage
+    {
+    public:
+      //! Samples waiting to be forwarded.
+      typedef std::set<StoredSample*, CompareStoredSamples> Queue;
+
+      //! Constructor.
+      //! @param[in] task parent task.
+      Storage(Task* task):
+        m_task(task),
+        m_segment_size(0),
+        m_max_size(0),
+        m_current(0),
+        m_current_size(0),
+        m_next_id(0),
+        m_live(0),
+        m_reader_segment(0),
+        m_dirty(false),
+        m_fd(-1),
+        m_degraded(false),
+        m_retry(c_retry_period)
+      { }
+
+      //! Destructor.
+      ~Storage(void)
+      {
+        close();
+      }
+
+      //! Open the storage, replaying samples stored in a previous
+      //! run. Writing always resumes on a new segment.
+      //! @param[in] folder storage folder.
+      //! @param[in] segment_size segment size in bytes.
+      //! @param[in] max_size maximum amount of stored samples in bytes.
+      void
+      open(const Path& folder, uint32_t segment_size, uint64_t max_size)
+      {
+        close();
+
+        m_folder = folder;
+        m_segment_size = segment_size;
+        m_max_size = max_size;
+
+        std::vector<uint32_t> segments;
+        try
+        {
+          m_folder.create();
+
+          Directory dir(m_folder);
+          const char* entry = NULL;
+          while ((entry = dir.readEntry()) != NULL)
+          {
+            unsigned number = 0;
+            char ext[8] = {0};
+            if (std::sscanf(entry, "%08x%7s", &number, ext) == 2 && std::strcmp(ext, c_segment_ext) == 0)
+              segments.push_back(number);
+          }
+        }
+        catch (std::exception& e)
+        {
+          degrade(e.what());
+        }
+
+        std::sort(segments.begin(), segments.end());
+
+        for (size_t i = 0; i < segments.size(); ++i)
+          replay(segments[i]);
+
+        std::map<uint32_t, StoredSample*>::iterator itr = m_samples.begin();
+        for (; itr != m_samples.end(); ++itr)
+          m_queue.insert(itr->second);
+
+        m_current = segments.empty() ? 0 : segments.back() + 1;
+        if (!m_degraded)
+        {
+          try
+          {
+            openSegment();
+          }
+          catch (std::exception& e)
+          {
+            degrade(e.what());
+          }
+        }
+
+        reclaim();
+        evict();
+
+        if (!m_samples.empty())
+          m_task->inf(DTR("recovered %u samples from %u segments"),
+                      (unsigned)m_samples.size(), (unsigned)segments.size());
+      }
+
+      //! Close the storage, synchronizing pending writes.
+      void
+      close(void)
+      {
+        flush();
+        m_writer.close();
+        m_writer.clear();
+        m_reader.close();
+
+#if defined(DUNE_SYS_HAS_FDATASYNC)
+        if (m_fd >= 0)
+          ::close(m_fd);
+        m_fd = -1;
+#endif
+
+        std::map<uint32_t, StoredSample*>::iterator itr = m_samples.begin();
+        for (; itr != m_samples.end(); ++itr)
+          delete itr->second;
+
+        m_samples.clear();
+        m_queue.clear();
+        m_segments.clear();
+        m_live = 0;
+        m_degraded = false;
+      }
+
+      //! Make sure appended records reach the storage device. While
+      //! the storage device cannot be written, periodically try to
+      //! write the samples kept in memory.
+      void
+      flush(void)
+      {
+        if (m_degraded && m_retry.overflow())
+          resume();
+
+        if (!m_dirty)
+          return;
+
+        m_writer.flush();
+
+#if defined(DUNE_SYS_HAS_FDATASYNC)
+        if (m_fd >= 0)
+          ::fdatasync(m_fd);
+#endif
+
+        m_dirty = false;
+      }
+
+      //! Store a sample and add it to the queue.
+      //! @param[in] sample sample.
+      //! @return true if the sample was stored, false if it is too large.
+      bool
+      add(const DataSample* sample)
+      {
+        uint8_t* bfr = getBuffer(c_sample_fields + DUNE_IMC_CONST_MAX_SIZE) + c_record_header;
+        uint16_t n = 0;
+
+        try
+        {
+          n = IMC::Packet::serialize(sample->sample, bfr + c_sample_fields,
+                                     DUNE_IMC_CONST_MAX_SIZE);
+        }
+        catch (std::exception& e)
+        {
+          m_task->war(DTR("failed to store sample: %s"), e.what());
+          return false;
+        }
+
+        // Payloads are loaded with 16-bit sizes.
+        if (c_sample_fields + n > 0xffff)
+          return false;
+
+        StoredSample* s = new StoredSample;
+        s->id = m_next_id++;
+        s->priority = sample->priority;
+        s->timestamp = sample->timestamp;
+        s->size = sample->serializationSize();
+
+        bfr += IMC::serialize(s->id, bfr);
+        bfr += IMC::serialize(sample->latDegs, bfr);
+        bfr += IMC::serialize(sample->lonDegs, bfr);
+        bfr += IMC::serialize((fp32_t)sample->zMeters, bfr);
+        bfr += IMC::serialize(sample->timestamp, bfr);
+        bfr += IMC::serialize((int32_t)sample->priority, bfr);
+        bfr += IMC::serialize((int32_t)sample->source, bfr);
+        bfr += IMC::serialize((int32_t)s->size, bfr);
+
+        store(RT_SAMPLE, c_sample_fields + n, s);
+        m_samples[s->id] = s;
+        m_queue.insert(s);
+        addLive(s);
+        evict();
+        return true;
+      }
+
+      //! Load a stored sample.
+      //! @param[in] s stored sample.
+      //! @param[out] sample loaded sample.
+      //! @return true if the sample was loaded, false otherwise.
+      bool
+      load(const StoredSample* s, DataSample& sample)
+      {
+        uint8_t* bfr = getBuffer(s->length);
+        if (!readRecord(s, bfr))
+          return false;
+
+        const uint8_t* ptr = bfr + c_record_header;
+        uint16_t len = s->length - c_record_header;
+        uint32_t id = 0;
+        fp32_t z = 0;
+        int32_t v = 0;
+
+        ptr += IMC::deserialize(id, ptr, len);
+        ptr += IMC::deserialize(sample.latDegs, ptr, len);
+        ptr += IMC::deserialize(sample.lonDegs, ptr, len);
+        ptr += IMC::deserialize(z, ptr, len);
+        ptr += IMC::deserialize(sample.timestamp, ptr, len);
+        ptr += IMC::deserialize(v, ptr, len);
+        sample.priority = v;
+        ptr += IMC::deserialize(v, ptr, len);
+        sample.source = v;
+        ptr += IMC::deserialize(v, ptr, len);
+        sample.zMeters = z;
+
+        if (id != s->id)
+          return false;
+
+        try
+        {
+          sample.sample = IMC::Packet::deserialize(ptr, len);
+        }
+        catch (std::exception& e)
+        {
+          m_task->war(DTR("failed to load sample %u: %s"), s->id, e.what());
+          return false;
+        }
+
+        return true;
+      }
+
+      //! Permanently remove a sample. The sample must not be queued.
+      //! Samples removed while the storage device cannot be written
+      //! are forwarded again after a restart.
+      //! @param[in] s stored sample.
+      void
+      remove(StoredSample* s)
+      {
+        if (s->segment != c_memory_segment && !m_degraded)
+        {
+          uint8_t* bfr = getBuffer(sizeof(uint32_t));
+          IMC::serialize(s->id, bfr + c_record_header);
+
+          try
+          {
+            uint32_t segment = 0;
+            uint32_t offset = 0;
+            append(RT_REMOVE, sizeof(uint32_t), segment, offset);
+          }
+          catch (std::exception& e)
+          {
+            degrade(e.what());
+          }
+        }
+
+        removeLive(s);
+        m_samples.erase(s->id);
+        delete s;
+
+        reclaim();
+      }
+
+      //! Get queued samples.
+      //! @return queue.
+      Queue&
+      getQueue(void)
+      {
+        return m_queue;
+      }
+
+      //! Get the number of stored samples, including those not queued.
+      //! @return number of samples.
+      size_t
+      getCount(void) const
+      {
+        return m_samples.size();
+      }
+
+    private:
+      //! Segment accounting.
+      struct Segment
+      {
+        //! Segment size.
+        uint64_t size;
+        //! Size of records holding stored samples.
+        uint64_t live;
+
+        Segment(void):
+          size(0),
+          live(0)
+        { }
+      };
+
+      //! Parent task.
+      Task* m_task;
+      //! Storage folder.
+      Path m_folder;
+      //! Segment size.
+      uint32_t m_segment_size;
+      //! Maximum amount of stored samples.
+      uint64_t m_max_size;
+      //! Segment being written.
+      uint32_t m_current;
+      //! Size of the segment being written.
+      uint32_t m_current_size;
+      //! Next sample identifier.
+      uint32_t m_next_id;
+      //! Amount of stored samples.
+      uint64_t m_live;
+      //! Stored samples by identifier.
+      std::map<uint32_t, StoredSample*> m_samples;
+      //! Queued samples.
+      Queue m_queue;
+      //! Existing segments.
+      std::map<uint32_t, Segment> m_segments;
+      //! Record buffer.
+      std::vector<uint8_t> m_bfr;
+      //! Segment being written.
+      std::ofstream m_writer;
+      //! Segment being read.
+      std::ifstream m_reader;
+      //! Segment opened for reading.
+      uint32_t m_reader_segment;
+      //! True if there are unsynchronized records.
+      bool m_dirty;
+      //! Descriptor used to synchronize the segment being written.
+      int m_fd;
+      //! True if the storage device cannot be written.
+      bool m_degraded;
+      //! Timer of attempts to write to an unavailable storage.
+      Time::Counter<double> m_retry;
+
+      //! Get the record buffer, with room for a record header.
+      //! @param[in] size payload size.
+      //! @return buffer.
+      uint8_t*
+      getBuffer(size_t size)
+      {
+        if (m_bfr.size() < size + c_record_header)
+          m_bfr.resize(size + c_record_header);
+
+        return &m_bfr[0];
+      }
+
+      //! Get the path of a segment.
+      //! @param[in] segment segment number.
+      //! @return path.
+      Path
+      getPath(uint32_t segment) const
+      {
+        return m_folder / String::str("%08x%s", segment, c_segment_ext);
+      }
+
+      //! Compute the checksum of a record payload.
+      static uint16_t
+      checksum(const uint8_t* bfr, uint32_t size)
+      {
+        uint16_t crc = 0;
+        while (size > 0)
+        {
+          uint16_t n = (uint16_t)std::min<uint32_t>(size, 0xffff);
+          crc = Algorithms::CRC16::compute(bfr, n, crc);
+          bfr += n;
+          size -= n;
+        }
+
+        return crc;
+      }
+
+      //! Fill the header of the record whose payload is in the record
+      //! buffer.
+      //! @param[in] type record type.
+      //! @param[in] size payload size.
+      //! @return record size.
+      uint32_t
+      seal(uint8_t type, uint32_t size)
+      {
+        uint8_t* bfr = &m_bfr[0];
+        uint8_t* ptr = bfr;
+        ptr += IMC::serialize(c_record_sync, ptr);
+        ptr += IMC::serialize(type, ptr);
+        ptr += IMC::serialize(size, ptr);
+        IMC::serialize(checksum(bfr + c_record_header, size), ptr);
+        return c_record_header + size;
+      }
+
+      //! Append a record whose payload is in the record buffer.
+      //! @param[in] type record type.
+      //! @param[in] size payload size.
+      //! @param[out] segment segment holding the record, only
+      //! changed if the record is written.
+      //! @param[out] offset offset of the record, only changed if the
+      //! record is written.
+      //! @return record size.
+      //! @throw std::runtime_error if the record cannot be written.
+      uint32_t
+      append(uint8_t type, uint32_t size, uint32_t& segment, uint32_t& offset)
+      {
+        uint32_t length = seal(type, size);
+        if (m_current_size > 0 && m_current_size + length > m_segment_size)
+          openSegment(m_current + 1);
+
+        m_writer.write((const char*)&m_bfr[0], length);
+        m_writer.flush();
+        if (!m_writer)
+          throw std::runtime_error(Utils::String::str(DTR("failed to write to %s"),
+                                                      getPath(m_current).c_str()));
+
+        segment = m_current;
+        offset = m_current_size;
+        m_current_size += length;
+        m_segments[m_current].size = m_current_size;
+        m_dirty = true;
+        return length;
+      }
+
+      //! Store a sample record whose payload is in the record buffer,
+      //! keeping it in memory if the storage device cannot be written.
+      //! @param[in] type record type.
+      //! @param[in] size payload size.
+      //! @param[in] s stored sample.
+      void
+      store(uint8_t type, uint32_t size, StoredSample* s)
+      {
+        if (!m_degraded)
+        {
+          try
+          {
+            s->length = append(type, size, s->segment, s->offset);
+            return;
+          }
+          catch (std::exception& e)
+          {
+            degrade(e.what());
+          }
+        }
+
+        s->length = seal(type, size);
+        s->segment = c_memory_segment;
+        s->offset = 0;
+        s->record.assign(m_bfr.begin(), m_bfr.begin() + s->length);
+      }
+
+      //! Keep new samples in memory until the storage device can be
+      //! written again.
+      //! @param[in] reason failure description.
+      void
+      degrade(const char* reason)
+      {
+        m_task->err(DTR("unable to write samples, keeping them in memory: %s"), reason);
+        m_degraded = true;
+        m_dirty = false;
+        m_retry.reset();
+      }
+
+      //! Try to resume writing to the storage device, writing the
+      //! samples kept in memory.
+      void
+      resume(void)
+      {
+        m_retry.reset();
+
+        try
+        {
+          m_folder.create();
+          openSegment(m_current + 1);
+
+          unsigned count = 0;
+          std::map<uint32_t, StoredSample*>::iterator itr = m_samples.begin();
+          for (; itr != m_samples.end(); ++itr)
+          {
+            StoredSample* s = itr->second;
+            if (s->segment != c_memory_segment)
+              continue;
+
+            uint8_t* bfr = getBuffer(s->length);
+            std::memcpy(bfr, &s->record[0], s->length);
+
+            uint32_t segment = 0;
+            uint32_t offset = 0;
+            append(RT_SAMPLE, s->length - c_record_header, segment, offset);
+            removeLive(s);
+            s->segment = segment;
+            s->offset = offset;
+            addLive(s);
+            std::vector<uint8_t>().swap(s->record);
+            ++count;
+          }
+
+          m_degraded = false;
+          m_task->inf(DTR("storage available again, wrote %u samples kept in memory"), count);
+        }
+        catch (std::exception& e)
+        {
+          m_task->debug("storage still unavailable: %s", e.what());
+        }
+      }
+
+      //! Start writing a new segment.
+      void
+      openSegment(void)
+      {
+        Path path = getPath(m_current);
+        m_writer.open(path.c_str(), std::ios::binary | std::ios::trunc);
+        if (!m_writer.is_open())
+          throw std::runtime_error(Utils::String::str(DTR("failed to open %s"), path.c_str()));
+
+#if defined(DUNE_SYS_HAS_FDATASYNC)
+        m_fd = ::open(path.c_str(), O_RDONLY);
+#endif
+
+        m_current_size = 0;
+        m_segments[m_current] = Segment();
+      }
+
+      //! Close the segment being written and start the next one.
+      //! @param[in] segment next segment number.
+      void
+      openSegment(uint32_t segment)
+      {
+        flush();
+        m_writer.close();
+
+#if defined(DUNE_SYS_HAS_FDATASYNC)
+        if (m_fd >= 0)
+          ::close(m_fd);
+        m_fd = -1;
+#endif
+
+        m_current = segment;
+        openSegment();
+      }
+
+      //! Read a record into a buffer.
+      //! @param[in] s stored sample.
+      //! @param[out] bfr destination buffer.
+      //! @return true if the record is valid, false otherwise.
+      bool
+      readRecord(const StoredSample* s, uint8_t* bfr)
+      {
+        if (s->length < c_record_header)
+          return false;
+
+        if (s->segment == c_memory_segment)
+        {
+          std::memcpy(bfr, &s->record[0], s->length);
+          return true;
+        }
+
+        if (!m_reader.is_open() || m_reader_segment != s->segment)
+        {
+          m_reader.close();
+          m_reader.clear();
+          m_reader.open(getPath(s->segment).c_str(), std::ios::binary);
+          m_reader_segment = s->segment;
+        }
+
+        m_reader.clear();
+        m_reader.seekg(s->offset);
+        m_reader.read((char*)bfr, s->length);
+        if (!m_reader)
+        {
+          m_reader.close();
+          return false;
+        }
+
+        return checkRecord(bfr, s->length) == s->length;
+      }
+
+      //! Check a record.
+      //! @param[in] bfr record.
+      //! @param[in] size available bytes.
+      //! @return record size or 0 if the record is invalid or
+      //! incomplete.
+      static uint32_t
+      checkRecord(const uint8_t* bfr, uint32_t size)
+      {
+        if (size < c_record_header)
+          return 0;
+
+        uint16_t sync = 0;
+        uint8_t type = 0;
+        uint32_t length = 0;
+        uint16_t crc = 0;
+        uint16_t n = c_record_header;
+
+        bfr += IMC::deserialize(sync, bfr, n);
+        bfr += IMC::deserialize(type, bfr, n);
+        bfr += IMC::deserialize(length, bfr, n);
+        bfr += IMC::deserialize(crc, bfr, n);
+
+        if (sync != c_record_sync || length > size - c_record_header)
+          return 0;
+
+        if (checksum(bfr, length) != crc)
+          return 0;
+
+        return c_record_header + length;
+      }
+
+      //! Replay the records of a segment.
+      //! @param[in] segment segment number.
+      void
+      replay(uint32_t segment)
+      {
+        Path path = getPath(segment);
+        std::ifstream ifs(path.c_str(), std::ios::binary);
+        std::vector<char> data((std::istreambuf_iterator<char>(ifs)),
+                               std::istreambuf_iterator<char>());
+
+        const uint8_t* bfr = data.empty() ? NULL : (const uint8_t*)&data[0];
+        uint32_t offset = 0;
+        m_segments[segment].size = data.size();
+
+        while (offset < data.size())
+        {
+          uint32_t length = checkRecord(bfr + offset, data.size() - offset);
+          if (length == 0)
+          {
+            m_task->war(DTR("discarding %u bytes of %s"),
+                        (unsigned)(data.size() - offset), path.c_str());
+            break;
+          }
+
+          const uint8_t* payload = bfr + offset + c_record_header;
+          uint16_t len = std::min<uint32_t>(length - c_record_header, 0xffff);
+          uint8_t type = bfr[offset + 2];
+
+          if (type == RT_SAMPLE && len >= c_sample_fields)
+          {
+            uint32_t id = 0;
+            double timestamp = 0;
+            int32_t priority = 0;
+            int32_t size = 0;
+            IMC::deserialize(id, payload, len);
+            IMC::deserialize(timestamp, payload + 24, len);
+            IMC::deserialize(priority, payload + 32, len);
+            IMC::deserialize(size, payload + 40, len);
+
+            // Samples copied by compaction replace older copies.
+            StoredSample* s = NULL;
+            std::map<uint32_t, StoredSample*>::iterator itr = m_samples.find(id);
+            if (itr != m_samples.end())
+            {
+              s = itr->second;
+              removeLive(s);
+            }
+            else
+            {
+              s = new StoredSample;
+              m_samples[id] = s;
+            }
+
+            s->id = id;
+            s->priority = priority;
+            s->timestamp = timestamp;
+            s->size = size;
+            s->segment = segment;
+            s->offset = offset;
+            s->length = length;
+            addLive(s);
+            m_next_id = std::max(m_next_id, id + 1);
+          }
+          else if (type == RT_REMOVE)
+          {
+            for (uint32_t i = 0; i + sizeof(uint32_t) <= len; i += sizeof(uint32_t))
+            {
+              uint32_t id = 0;
+              uint16_t n = sizeof(uint32_t);
+              IMC::deserialize(id, payload + i, n);
+              m_next_id = std::max(m_next_id, id + 1);
+
+              std::map<uint32_t, StoredSample*>::iterator itr = m_samples.find(id);
+              if (itr != m_samples.end())
+              {
+                removeLive(itr->second);
+                delete itr->second;
+                m_samples.erase(itr);
+              }
+            }
+          }
+
+          offset += length;
+        }
+      }
+
+      //! Account for a stored sample.
+      void
+      addLive(const StoredSample* s)
+      {
+        if (s->segment != c_memory_segment)
+          m_segments[s->segment].live += s->length;
+        m_live += s->length;
+      }
+
+      //! Account for a removed sample.
+      void
+      removeLive(const StoredSample* s)
+      {
+        if (s->segment != c_memory_segment)
+          m_segments[s->segment].live -= s->length;
+        m_live -= s->length;
+      }
+
+      //! Drop the least important queued samples while the storage
+      //! limit is exceeded.
+      void
+      evict(void)
+      {
+        unsigned count = 0;
+        while (m_live > m_max_size && !m_queue.empty())
+        {
+          Queue::iterator itr = m_queue.end();
+          --itr;
+          StoredSample* s = *itr;
+          m_queue.erase(itr);
+          remove(s);
+          ++count;
+        }
+
+        if (count > 0)
+          m_task->war(DTR("storage full, dropped %u samples"), count);
+      }
+
+      //! Delete or compact the oldest segment while possible. Segments
+      //! are deleted in order, so removal records are never lost
+      //! before the samples they refer to.
+      void
+      reclaim(void)
+      {
+        while (!m_degraded && m_segments.size() > 1)
+        {
+          std::map<uint32_t, Segment>::iterator oldest = m_segments.begin();
+          if (oldest->first == m_current)
+            break;
+
+          if (oldest->second.live > 0)
+          {
+            if (oldest->second.live * 2 > oldest->second.size)
+              break;
+
+            try
+            {
+              compact(oldest->first);
+            }
+            catch (std::exception& e)
+            {
+              degrade(e.what());
+              break;
+            }
+
+            flush();
+          }
+
+          getPath(oldest->first).remove();
+          m_segments.erase(oldest);
+        }
+      }
+
+      //! Copy the samples of a segment to the segment being written.
+      //! @param[in] segment segment number.
+      void
+      compact(uint32_t segment)
+      {
+        std::vector<StoredSample*> moved;
+        std::map<uint32_t, StoredSample*>::iterator itr = m_samples.begin();
+        for (; itr != m_samples.end(); ++itr)
+        {
+          if (itr->second->segment == segment)
+            moved.push_back(itr->second);
+        }
+
+        for (size_t i = 0; i < moved.size(); ++i)
+        {
+          StoredSample* s = moved[i];
+          uint8_t* bfr = getBuffer(s->length);
+          bool valid = readRecord(s, bfr);
+          removeLive(s);
+
+          // Unreadable samples fail to load and are removed by
+          // their owner.
+          if (!valid)
+          {
+            m_task->war(DTR("sample %u is unreadable"), s->id);
+            s->segment = m_current;
+            s->offset = 0;
+            s->length = 0;
+            continue;
+          }
+
+          try
+          {
+            append(RT_SAMPLE, s->length - c_record_header, s->segment, s->offset);
+          }
+          catch (...)
+          {
+            addLive(s);
+            m_reader.close();
+            throw;
+          }
+
+          addLive(s);
+        }
+
+        m_reader.close();
+      }
+    };
+  }
+}
+
+#endif
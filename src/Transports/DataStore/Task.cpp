@@ -71,6 +71,15 @@ namespace Transports
       //! Variable priorities will result in older
       //! data being sent through low bandwidth connections
       bool variable_priorities;
+
+      //! Folder where samples are stored
+      std::string storage_folder;
+
+      //! Size of storage segments, in KiB
+      unsigned segment_size;
+
+      //! Maximum amount of stored samples, in MiB
+      unsigned max_storage;
     };
 
     struct Task: public DUNE::Tasks::Task
@@ -87,8 +96,8 @@ namespace Transports
       //! priority for each message type
       std::map<std::string, int> m_priorities;
 
-      //! messages currently on the way to their destination
-      std::map<std::pair<int, int>, IMC::HistoricData*> m_sending;
+      //! batches currently on the way to their destination
+      std::map<std::pair<int, int>, unsigned> m_sending;
 
       //! Timer used for forwarding data over acoustic modem
       Time::Counter<double> m_acoustic_forward_timer;
@@ -111,6 +120,9 @@ namespace Transports
       typedef std::map<uint16_t, IMC::TransmissionRequest*> MessagesQueued;
       MessagesQueued m_transmission_requests;
 
+      //! batches of pending transmission requests
+      std::map<uint16_t, unsigned> m_transmission_batches;
+
       Task(const std::string& name, Tasks::Context& ctx):
         DUNE::Tasks::Task(name, ctx),
         m_store(this),
@@ -156,6 +168,24 @@ namespace Transports
         .description("Apply variable priorities to local samples")
         .defaultValue("true");
 
+        param("Storage Folder", m_args.storage_folder)
+        .description("Folder where samples are kept until forwarded."
+                     " Relative to the database folder")
+        .defaultValue("DataStore");
+
+        param("Storage Segment Size", m_args.segment_size)
+        .description("Size of each storage file")
+        .units(Units::Kibibyte)
+        .minimumValue("4")
+        .defaultValue("256");
+
+        param("Maximum Storage Size", m_args.max_storage)
+        .description("Maximum amount of stored samples. Least important"
+                     " samples are dropped when exceeded")
+        .units(Units::Mebibyte)
+        .minimumValue("1")
+        .defaultValue("64");
+
         m_wifi_forward_timer.setTop(m_args.wifi_forward_period);
         m_acoustic_forward_timer.setTop(m_args.acoustic_forward_period);
         m_any_forward_timer.setTop(m_args.any_forward_period);
@@ -208,6 +238,22 @@ namespace Transports
         m_iridium_upload_timer.setTop(m_args.iridium_upload_period);
       }
 
+      void
+      onResourceAcquisition(void)
+      {
+        m_store.open(m_ctx.dir_db / m_args.storage_folder,
+                     m_args.segment_size * 1024,
+                     (uint64_t)m_args.max_storage * 1024 * 1024);
+      }
+
+      void
+      onResourceRelease(void)
+      {
+        m_sending.clear();
+        m_transmission_batches.clear();
+        m_store.close();
+      }
+
       void
       onResourceInitialization(void)
       {
@@ -300,7 +346,8 @@ namespace Transports
             case IMC::TransmissionStatus::TSTAT_TEMPORARY_FAILURE:
               war("not possible to forward data through %s by any mean at this time.",
                   m_args.any_gateway.c_str());
-              m_store.addData((IMC::HistoricData*)req->msg_data.get());
+              m_store.restore(m_transmission_batches[msg->req_id]);
+              m_transmission_batches.erase(msg->req_id);
               m_transmission_requests.erase(msg->req_id);
               Memory::clear(req);
               break;
@@ -308,6 +355,8 @@ namespace Transports
             case IMC::TransmissionStatus::TSTAT_SENT:
               inf("Routed samples to %s using any mean available",
                   m_args.any_gateway.c_str());
+              m_store.release(m_transmission_batches[msg->req_id]);
+              m_transmission_batches.erase(msg->req_id);
               m_transmission_requests.erase(msg->req_id);
               Memory::clear(req);
               break;
@@ -315,7 +364,8 @@ namespace Transports
             case IMC::TransmissionStatus::TSTAT_INPUT_FAILURE:
               war("not possible to forward data through %s by any mean at this time.",
                   m_args.any_gateway.c_str());
-              m_store.addData((IMC::HistoricData*)req->msg_data.get());
+              m_store.restore(m_transmission_batches[msg->req_id]);
+              m_transmission_batches.erase(msg->req_id);
               m_transmission_requests.erase(msg->req_id);
               Memory::clear(req);
               break;
@@ -323,7 +373,8 @@ namespace Transports
             case IMC::TransmissionStatus::TSTAT_PERMANENT_FAILURE:
               war("not possible to forward data through %s by any mean at this time.",
                   m_args.any_gateway.c_str());
-              m_store.addData((IMC::HistoricData*)req->msg_data.get());
+              m_store.restore(m_transmission_batches[msg->req_id]);
+              m_transmission_batches.erase(msg->req_id);
               m_transmission_requests.erase(msg->req_id);
               Memory::clear(req);
               break;
@@ -365,16 +416,16 @@ namespace Transports
           if (m_sending.find(source) != m_sending.end())
           {
             debug("Adding back data previously queried from same peer as it wasn't cleared with HRTYPE_CLEAR.");
-            m_store.addData(m_sending[source]);
-            delete m_sending[source];
+            m_store.restore(m_sending[source]);
             m_sending.erase(source);
           }
 
           IMC::HistoricDataQuery reply;
-          IMC::HistoricData* data = m_store.pollSamples(msg->max_size);
+          unsigned batch = 0;
+          IMC::HistoricData* data = m_store.pollSamples(msg->max_size, batch);
           if (data != NULL)
           {
-            m_sending[source] = static_cast<IMC::HistoricData*>(data->clone());
+            m_sending[source] = batch;
             reply.data.set(data);
             Memory::clear(data);
           }
@@ -402,6 +453,7 @@ namespace Transports
           if (m_sending.find(source) != m_sending.end())
           {
             debug("Clearing previously queried data from store");
+            m_store.release(m_sending[source]);
             m_sending.erase(source);
           }
           else
@@ -417,7 +469,10 @@ namespace Transports
       {
         inf("forwarding to gateway over any mean");
 
-        IMC::HistoricData* data = m_store.pollSamples(1000);
+        unsigned batch = 0;
+        IMC::HistoricData* data = m_store.pollSamples(1000, batch);
+        if (data == NULL)
+          return;
 
         uint16_t newId = m_router.createInternalId();
 
@@ -435,6 +490,7 @@ namespace Transports
 
         dispatch(tr);
         m_transmission_requests[newId] = tr.clone();
+        m_transmission_batches[newId] = batch;
 
         Memory::clear(data);
       }
@@ -442,7 +498,8 @@ namespace Transports
       void
       acousticRouting()
       {
-        IMC::HistoricData* data = m_store.pollSamples(m_args.acoustic_mtu);
+        unsigned batch = 0;
+        IMC::HistoricData* data = m_store.pollSamples(m_args.acoustic_mtu, batch);
         int size = 0;
         if (data != NULL)
           size = (int)data->data.size();
@@ -453,9 +510,10 @@ namespace Transports
         {
           war("not possible to forward data through %s acoustically at this time.",
               m_args.acoustic_gateway.c_str());
-          m_store.addData(data);
+          m_store.restore(batch);
         }
         else {
+          m_store.release(batch);
           inf("Routed %d samples to %s using Acoustic Modem", size, m_args.acoustic_gateway.c_str());
         }
 
@@ -468,16 +526,20 @@ namespace Transports
 
         debug("forwarding to gateway over wifi");
 
-        IMC::HistoricData* data = m_store.pollSamples(32 * 1024);
+        unsigned batch = 0;
+        IMC::HistoricData* data = m_store.pollSamples(32 * 1024, batch);
         if (data == NULL)
           return;
         if (!m_router.routeOverWifi(m_args.wifi_gateway, data))
         {
           war("not possible to forward data over WiFi through %s at this time.", m_args.wifi_gateway.c_str());
-          m_store.addData(data);
+          m_store.restore(batch);
         }
         else
+        {
+          m_store.release(batch);
           inf("Routed %u samples to %s using UDP", (uint32_t) data->data.size(), m_args.wifi_gateway.c_str());
+        }
 
         Memory::clear(data);
       }
@@ -489,6 +551,9 @@ namespace Transports
         {
           waitForMessages(1.0);
 
+          // samples stored since the last iteration are synchronized once
+          m_store.flush();
+
           std::stringstream ss;
 
           if (m_args.any_forward_period > 0 && m_any_forward_timer.overflow())
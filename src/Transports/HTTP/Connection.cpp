@@ -0,0 +1,491 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+// DUNE headers.
+#include <DUNE/Config.hpp>
+#include <DUNE/Network/Exceptions.hpp>
+
+// Platform headers.
+#if defined(DUNE_OS_POSIX)
+#  include <sys/socket.h>
+#endif
+
+#if defined(DUNE_SYS_HAS_POLL_H)
+#  include <poll.h>
+#endif
+
+#if defined(DUNE_SYS_HAS_FCNTL_H)
+#  include <fcntl.h>
+#endif
+
+#if defined(DUNE_SYS_HAS_UNISTD_H)
+#  include <unistd.h>
+#endif
+
+#if defined(DUNE_OS_LINUX) && defined(DUNE_SYS_HAS_SYS_SENDFILE_H)
+#  include <sys/sendfile.h>
+#  define HTTP_USE_SENDFILE
+#endif
+
+// Local headers.
+#include "Connection.hpp"
+
+namespace Transports
+{
+  namespace HTTP
+  {
+    using DUNE_NAMESPACES;
+
+    //! Initial size of the receive buffer.
+    static const size_t c_initial_size = 4096;
+    //! Maximum size of a request header.
+    static const size_t c_max_header_size = 8192;
+    //! Maximum size of a request body.
+    static const size_t c_max_body_size = 1024 * 1024;
+    //! Maximum amount of time to wait for the client to accept data.
+    static const double c_write_timeout = 10.0;
+    //! Maximum amount of file data transferred at once.
+    static const size_t c_file_block_size = 128 * 1024;
+    //! Interim response to requests expecting it.
+    static const char c_continue[] = "HTTP/1.1 100 Continue\r\n\r\n";
+
+    //! Retrieve the value of a request header field.
+    //! @param[in] hdr request header.
+    //! @param[in] size size of the header.
+    //! @param[in] name lower case field name, followed by a colon.
+    //! @param[out] value field value.
+    //! @return true if the field was found, false otherwise.
+    static bool
+    getField(const char* hdr, size_t size, const char* name, std::string& value)
+    {
+      size_t len = std::strlen(name);
+      const char* end = hdr + size;
+
+      // Skip the request line.
+      const char* line = std::find(hdr, end, '\n');
+
+      while (line < end)
+      {
+        ++line;
+        const char* eol = std::find(line, end, '\n');
+
+        if ((size_t)(eol - line) > len)
+        {
+          size_t i = 0;
+          for (; i < len; ++i)
+          {
+            if (std::tolower(line[i]) != name[i])
+              break;
+          }
+
+          if (i == len)
+          {
+            const char* beg = line + len;
+            while (beg < eol && (*beg == ' ' || *beg == '\t'))
+              ++beg;
+
+            const char* last = eol;
+            while (last > beg && (last[-1] == '\r' || last[-1] == ' '))
+              --last;
+
+            value.assign(beg, last);
+            return true;
+          }
+        }
+
+        line = eol;
+      }
+
+      return false;
+    }
+
+    Connection::Connection(TCPSocket* sock):
+      m_sock(sock),
+      m_state(ST_IDLE),
+      m_activity(Clock::get()),
+      m_bfr(c_initial_size),
+      m_size(0),
+      m_scan(0),
+      m_hdr_size(0),
+      m_body_size(0),
+      m_body_read(0),
+      m_continued(false),
+      m_continue_rem(0),
+      m_keep_alive(false),
+      m_streaming(false),
+      m_file_fd(-1),
+      m_file_off(0),
+      m_file_rem(0)
+    {
+      m_sock->setNoDelay(true);
+
+#if defined(DUNE_OS_POSIX) && defined(DUNE_SYS_HAS_FCNTL_H)
+      int fd = getNative();
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    }
+
+    Connection::~Connection(void)
+    {
+      closeFile();
+      delete m_sock;
+    }
+
+    bool
+    Connection::fill(void)
+    {
+      m_activity = Clock::get();
+
+      while (true)
+      {
+        if (m_size == m_bfr.size())
+        {
+          if (m_bfr.size() >= c_max_header_size + c_max_body_size)
+            break;
+
+          m_bfr.resize(m_bfr.size() * 2);
+        }
+
+#if defined(DUNE_OS_POSIX)
+        ssize_t rv = ::recv(getNative(), &m_bfr[m_size], m_bfr.size() - m_size, MSG_DONTWAIT);
+        if (rv == 0)
+          return false;
+
+        if (rv < 0)
+        {
+          if (errno == EINTR)
+            continue;
+
+          if (errno == EAGAIN || errno == EWOULDBLOCK)
+            break;
+
+          return false;
+        }
+#else
+        if (!IO::Poll::poll(*m_sock, 0))
+          break;
+
+        size_t rv = 0;
+        try
+        {
+          rv = m_sock->read(&m_bfr[m_size], m_bfr.size() - m_size);
+        }
+        catch (std::exception&)
+        {
+          return false;
+        }
+#endif
+
+        m_size += rv;
+      }
+
+      // Header is too large.
+      if (m_hdr_size == 0 && !hasRequest() && m_size > c_max_header_size)
+        return false;
+
+      return true;
+    }
+
+    bool
+    Connection::hasRequest(void)
+    {
+      if (m_hdr_size == 0)
+      {
+        for (size_t i = m_scan; i + 3 < m_size; ++i)
+        {
+          if (m_bfr[i] == '\r' && m_bfr[i + 1] == '\n' && m_bfr[i + 2] == '\r' && m_bfr[i + 3] == '\n')
+          {
+            m_hdr_size = i + 4;
+            break;
+          }
+        }
+
+        if (m_hdr_size == 0)
+        {
+          m_scan = (m_size > 3) ? m_size - 3 : 0;
+          return false;
+        }
+
+        std::string value;
+        if (getField(&m_bfr[0], m_hdr_size, "content-length:", value))
+        {
+          if (!castLexical(value, m_body_size) || m_body_size > c_max_body_size)
+            throw std::runtime_error(DTR("invalid request body size"));
+        }
+      }
+
+      if (m_size >= m_hdr_size + m_body_size)
+        return true;
+
+      // The interim response must not block the caller: whatever
+      // the client does not accept now is sent before the response.
+      if (!m_continued)
+      {
+        std::string value;
+        if (getField(&m_bfr[0], m_hdr_size, "expect:", value) && value == "100-continue")
+        {
+          m_continue_rem = sizeof(c_continue) - 1;
+          flushContinue(false);
+        }
+
+        m_continued = true;
+      }
+
+      return false;
+    }
+
+    size_t
+    Connection::read(char* bfr, size_t size)
+    {
+      size = std::min(size, m_body_size - m_body_read);
+      std::memcpy(bfr, &m_bfr[m_hdr_size + m_body_read], size);
+      m_body_read += size;
+      return size;
+    }
+
+    void
+    Connection::consumeRequest(void)
+    {
+      size_t total = std::min(m_size, m_hdr_size + m_body_size);
+      if (total < m_size)
+        std::memmove(&m_bfr[0], &m_bfr[total], m_size - total);
+
+      m_size -= total;
+      m_scan = 0;
+      m_hdr_size = 0;
+      m_body_size = 0;
+      m_body_read = 0;
+      m_continued = false;
+    }
+
+    void
+    Connection::flushContinue(bool block)
+    {
+      if (m_continue_rem == 0)
+        return;
+
+      const char* data = c_continue + (sizeof(c_continue) - 1 - m_continue_rem);
+      size_t size = m_continue_rem;
+      m_continue_rem = 0;
+
+      if (block)
+      {
+        write(data, size);
+        return;
+      }
+
+      m_continue_rem = size - tryWrite(data, size);
+    }
+
+    void
+    Connection::write(const char* data, size_t size)
+    {
+      flushContinue(true);
+
+      m_activity = Clock::get();
+
+#if defined(DUNE_OS_POSIX)
+      int flags = 0;
+#  if defined(MSG_NOSIGNAL)
+      flags = MSG_NOSIGNAL;
+#  endif
+
+      while (size > 0)
+      {
+        ssize_t rv = ::send(getNative(), data, size, flags);
+        if (rv >= 0)
+        {
+          data += rv;
+          size -= rv;
+          continue;
+        }
+
+        if (errno == EINTR)
+          continue;
+
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+          throw ConnectionClosed();
+
+        // Wait until the client accepts more data.
+        pollfd pfd;
+        pfd.fd = getNative();
+        pfd.events = POLLOUT;
+        pfd.revents = 0;
+        int prv = ::poll(&pfd, 1, (int)(c_write_timeout * 1000.0));
+        if (prv < 0 && errno == EINTR)
+          continue;
+
+        if (prv <= 0)
+          throw ConnectionTimeout();
+      }
+#else
+      while (size > 0)
+      {
+        size_t rv = m_sock->write(data, size);
+        data += rv;
+        size -= rv;
+      }
+#endif
+    }
+
+    size_t
+    Connection::tryWrite(const char* data, size_t size)
+    {
+      flushContinue(false);
+      if (m_continue_rem > 0)
+        return 0;
+
+#if defined(DUNE_OS_POSIX)
+      int flags = MSG_DONTWAIT;
+#  if defined(MSG_NOSIGNAL)
+      flags |= MSG_NOSIGNAL;
+#  endif
+
+      size_t sent = 0;
+      while (sent < size)
+      {
+        ssize_t rv = ::send(getNative(), data + sent, size - sent, flags);
+        if (rv >= 0)
+        {
+          sent += rv;
+          continue;
+        }
+
+        if (errno == EINTR)
+          continue;
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+          break;
+
+        throw ConnectionClosed();
+      }
+
+      if (sent > 0)
+        m_activity = Clock::get();
+
+      return sent;
+#else
+      write(data, size);
+      return size;
+#endif
+    }
+
+    bool
+    Connection::sendFile(const std::string& file, int64_t off_beg, int64_t off_end)
+    {
+      closeFile();
+
+#if defined(HTTP_USE_SENDFILE)
+      m_file_fd = open64(file.c_str(), O_RDONLY);
+      if (m_file_fd < 0)
+        return false;
+
+      m_file_off = off_beg;
+      m_file_rem = off_end - off_beg + 1;
+      return true;
+#else
+      std::ifstream ifs(file.c_str(), std::ios::binary);
+      if (!ifs.is_open())
+        return false;
+
+      ifs.seekg(off_beg, std::ios::beg);
+      int64_t remaining = off_end - off_beg + 1;
+      std::vector<char> bfr(c_file_block_size);
+
+      while (remaining > 0 && ifs.good())
+      {
+        ifs.read(&bfr[0], std::min((int64_t)bfr.size(), remaining));
+        write(&bfr[0], ifs.gcount());
+        remaining -= ifs.gcount();
+      }
+
+      return remaining == 0;
+#endif
+    }
+
+    bool
+    Connection::transferFile(void)
+    {
+#if defined(HTTP_USE_SENDFILE)
+      m_activity = Clock::get();
+
+      while (m_file_rem > 0)
+      {
+        off64_t offset = m_file_off;
+        size_t count = (size_t)std::min((int64_t)c_file_block_size, m_file_rem);
+        ssize_t rv = sendfile64(getNative(), m_file_fd, &offset, count);
+
+        if (rv < 0)
+        {
+          if (errno == EINTR)
+            continue;
+
+          // Socket buffer is full.
+          if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return true;
+
+          closeFile();
+          return false;
+        }
+
+        // File was truncated.
+        if (rv == 0)
+        {
+          closeFile();
+          return false;
+        }
+
+        m_file_off += rv;
+        m_file_rem -= rv;
+      }
+#endif
+
+      closeFile();
+      return true;
+    }
+
+    void
+    Connection::closeFile(void)
+    {
+#if defined(HTTP_USE_SENDFILE)
+      if (m_file_fd >= 0)
+        close(m_file_fd);
+#endif
+
+      m_file_fd = -1;
+      m_file_rem = 0;
+    }
+  }
+}
@@ -0,0 +1,264 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+#ifndef TRANSPORTS_HTTP_CONNECTION_HPP_INCLUDED_
+#define TRANSPORTS_HTTP_CONNECTION_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+namespace Transports
+{
+  namespace HTTP
+  {
+    //! Client connection. Incoming data is buffered and split into
+    //! requests, allowing several requests to be sent over the same
+    //! connection (keep-alive) without waiting for responses
+    //! (pipelining).
+    class Connection
+    {
+    public:
+      //! Connection states.
+      enum State
+      {
+        //! Waiting for data from the client.
+        ST_IDLE,
+        //! Being serviced by a worker thread.
+        ST_BUSY,
+        //! Transferring a file to the client.
+        ST_SENDING,
+        //! Handed over to an event stream.
+        ST_STREAMING,
+        //! Closed, waiting to be destroyed.
+        ST_CLOSED
+      };
+
+      //! Constructor.
+      //! @param[in] sock connected socket, owned by this object.
+      Connection(DUNE::Network::TCPSocket* sock);
+
+      //! Destructor.
+      ~Connection(void);
+
+      //! Retrieve the native handle of the socket.
+      //! @return native handle.
+      DUNE::IO::NativeHandle
+      getNative(void) const
+      {
+        return m_sock->getNative();
+      }
+
+      //! Retrieve the connection state.
+      //! @return connection state.
+      State
+      getState(void) const
+      {
+        return m_state;
+      }
+
+      //! Set the connection state.
+      //! @param[in] state connection state.
+      void
+      setState(State state)
+      {
+        m_state = state;
+      }
+
+      //! Retrieve the time of the last activity in this connection.
+      //! @return monotonic time in seconds.
+      double
+      getLastActivity(void) const
+      {
+        return m_activity;
+      }
+
+      //! Read all data available in the socket, without blocking.
+      //! @return false if the connection was closed or the request
+      //! is too large, true otherwise.
+      bool
+      fill(void);
+
+      //! Test if at least one complete request is buffered.
+      //! @return true if a complete request is buffered.
+      bool
+      hasRequest(void);
+
+      //! Retrieve the header of the buffered request, terminated by
+      //! an empty line.
+      //! @return request header.
+      const char*
+      getHeader(void) const
+      {
+        return &m_bfr[0];
+      }
+
+      //! Retrieve the size of the header of the buffered request.
+      //! @return header size, including the terminating empty line.
+      size_t
+      getHeaderSize(void) const
+      {
+        return m_hdr_size;
+      }
+
+      //! Read the body of the buffered request.
+      //! @param[out] bfr destination buffer.
+      //! @param[in] size number of bytes to read.
+      //! @return number of bytes read.
+      size_t
+      read(char* bfr, size_t size);
+
+      //! Discard the buffered request, including any unread body.
+      void
+      consumeRequest(void);
+
+      //! Write data to the client, waiting until all data is sent.
+      //! @param[in] data data buffer.
+      //! @param[in] size number of bytes to write.
+      void
+      write(const char* data, size_t size);
+
+      //! Write as much data as the client accepts without blocking.
+      //! @param[in] data data buffer.
+      //! @param[in] size number of bytes to write.
+      //! @return number of bytes written.
+      size_t
+      tryWrite(const char* data, size_t size);
+
+      //! Queue part of a file to be sent after the response header.
+      //! The transfer is performed by the server, without blocking.
+      //! @param[in] file file name.
+      //! @param[in] off_beg offset of the first byte.
+      //! @param[in] off_end offset of the last byte.
+      //! @return true if the file was opened, false otherwise.
+      bool
+      sendFile(const std::string& file, int64_t off_beg, int64_t off_end);
+
+      //! Test if a file transfer is pending.
+      //! @return true if a file transfer is pending.
+      bool
+      isSending(void) const
+      {
+        return m_file_fd >= 0;
+      }
+
+      //! Transfer as much of the pending file as the socket accepts
+      //! without blocking.
+      //! @return false if the transfer failed, true otherwise.
+      bool
+      transferFile(void);
+
+      //! Define whether the connection is kept open after the current
+      //! request.
+      //! @param[in] enabled true to keep the connection open.
+      void
+      setKeepAlive(bool enabled)
+      {
+        m_keep_alive = enabled;
+      }
+
+      //! Test if the connection is kept open after the current
+      //! request.
+      //! @return true if the connection is kept open.
+      bool
+      getKeepAlive(void) const
+      {
+        return m_keep_alive;
+      }
+
+      //! Define whether the connection is handed over to an event
+      //! stream after the current request.
+      //! @param[in] enabled true to hand over the connection.
+      void
+      setStreaming(bool enabled)
+      {
+        m_streaming = enabled;
+      }
+
+      //! Test if the connection is handed over to an event stream
+      //! after the current request.
+      //! @return true if the connection is handed over.
+      bool
+      isStreaming(void) const
+      {
+        return m_streaming;
+      }
+
+    private:
+      //! Socket.
+      DUNE::Network::TCPSocket* m_sock;
+      //! Connection state.
+      State m_state;
+      //! Time of last activity.
+      double m_activity;
+      //! Received data.
+      std::vector<char> m_bfr;
+      //! Amount of received data.
+      size_t m_size;
+      //! Offset where the search for the end of the header resumes.
+      size_t m_scan;
+      //! Size of the header of the buffered request.
+      size_t m_hdr_size;
+      //! Size of the body of the buffered request.
+      size_t m_body_size;
+      //! Amount of the body already read.
+      size_t m_body_read;
+      //! True if "100 Continue" was handled for the buffered request.
+      bool m_continued;
+      //! Number of bytes of "100 Continue" still to be sent.
+      size_t m_continue_rem;
+      //! Keep connection open after the current request.
+      bool m_keep_alive;
+      //! Hand over connection to an event stream.
+      bool m_streaming;
+      //! File being transferred.
+      int m_file_fd;
+      //! Offset of the next byte of the file to transfer.
+      int64_t m_file_off;
+      //! Number of bytes of the file left to transfer.
+      int64_t m_file_rem;
+
+      void
+      closeFile(void);
+
+      //! Send the part of "100 Continue" not accepted by the client
+      //! yet.
+      //! @param[in] block true to wait until it is sent, false to send
+      //! only what the client accepts without blocking.
+      void
+      flushContinue(bool block);
+    };
+  }
+}
+
+#endif
@@ -41,7 +41,10 @@ namespace Transports
 
     MessageMonitor::MessageMonitor(const std::string& system, uint64_t uid):
       m_uid(uid),
-      m_last_msgs_json(0),
+      m_generation(1),
+      m_snapshot_generation(0),
+      m_snapshot_gz_generation(0),
+      m_last_snapshot_gz(0),
       m_last_logbook_json(0),
       m_log_entry(100)
     {
@@ -59,107 +62,136 @@ namespace Transports
     {
       ScopedMutex l(m_mutex);
 
-      {
-        std::map<unsigned, IMC::Message*>::iterator itr = m_msgs.begin();
-        for (; itr != m_msgs.end(); ++itr)
-          delete itr->second;
-      }
-
-      {
-        for (PowerChannelMap::iterator itr = m_power_channels.begin(); itr != m_power_channels.end(); ++itr)
-          delete itr->second;
-      }
-
-      {
-        for(unsigned int itr = 0; itr < m_logbook.size(); ++itr)
-          delete m_logbook[itr];
-      }
+      for (unsigned int itr = 0; itr < m_logbook.size(); ++itr)
+        delete m_logbook[itr];
     }
 
     void
     MessageMonitor::setEntities(const std::map<unsigned, std::string>& entities)
     {
-      ScopedMutex l(m_mutex);
-      m_entities = entities;
-    }
-
-    ByteBuffer*
-    MessageMonitor::messagesJSON(void)
-    {
-      ScopedMutex l(m_mutex);
-
-      uint64_t now = Clock::getMsec();
-
-      if ((now - m_last_msgs_json) > 2000)
-        m_last_msgs_json = now;
-      else
-        return &m_msgs_json;
-
-      if (m_msgs.empty())
-        return &m_msgs_json;
-
       std::ostringstream os;
-      os << m_meta
-         << "  'dune_time_current': '" << std::setprecision(12) << Clock::getSinceEpoch() << "',\n";
-
-      if (m_entities.empty())
+      if (entities.empty())
       {
         os << "  'dune_entities': { },\n";
       }
       else
       {
         os << "  'dune_entities': {\n";
-        EntityMap::iterator itr = m_entities.begin();
+        EntityMap::const_iterator itr = entities.begin();
         os << itr->first << " : {" << "\"label\": \"" << itr->second << "\"}";
         ++itr;
-        for (; itr != m_entities.end(); ++itr)
+        for (; itr != entities.end(); ++itr)
           os << ",\n" << itr->first << " : {" << "\"label\": \"" << itr->second << "\"}";
         os << "\n},";
       }
 
-      os << "  'dune_messages': [\n";
+      Fragment json(new std::string(os.str()));
 
-      std::map<unsigned, IMC::Message*>::iterator itr = m_msgs.begin();
-      itr->second->toJSON(os);
-      ++itr;
+      ScopedMutex l(m_mutex);
+      m_entities.swap(json);
+      ++m_generation;
+    }
 
-      for (; itr != m_msgs.end(); ++itr)
+    void
+    MessageMonitor::messagesJSON(std::string& data, bool compressed)
+    {
+      std::ostringstream os;
+      os << m_meta
+         << "  'dune_time_current': '" << std::setprecision(12) << Clock::getSinceEpoch() << "',\n";
+
+      ScopedMutex l(m_snapshot_mutex);
+
+      buildSnapshot();
+
+      if (!compressed)
       {
-        os << ",\n";
-        itr->second->toJSON(os);
+        data = os.str();
+        data += m_snapshot;
+        return;
       }
 
-      for (PowerChannelMap::iterator pitr = m_power_channels.begin(); pitr != m_power_channels.end(); ++pitr)
+      // Compression is expensive, refresh at most every two seconds.
+      uint64_t now = Clock::getMsec();
+      if (m_snapshot_gz_generation != m_snapshot_generation && (now - m_last_snapshot_gz) > 2000)
       {
-        os << ",\n";
-        pitr->second->toJSON(os);
+        std::string str = os.str();
+        str += m_snapshot;
+
+        GzipCompressor cmp;
+        cmp.compress(m_snapshot_gz, (char*)str.c_str(), (unsigned long)str.size());
+        m_snapshot_gz_generation = m_snapshot_generation;
+        m_last_snapshot_gz = now;
       }
 
-      os << "\n]"
-         << "\n};";
+      data.assign(m_snapshot_gz.getBufferSigned(), m_snapshot_gz.getSize());
+    }
 
-      GzipCompressor cmp;
-      std::string str = os.str();
-      cmp.compress(m_msgs_json, (char*)str.c_str(), (unsigned long)str.size());
+    void
+    MessageMonitor::buildSnapshot(void)
+    {
+      // Fragments are immutable, so only their references are copied
+      // under the lock and messages keep being updated while the
+      // snapshot is concatenated.
+      std::vector<Fragment> fragments;
+      Fragment entities;
+      uint64_t generation = 0;
+
+      {
+        ScopedMutex l(m_mutex);
+
+        if (m_snapshot_generation == m_generation)
+          return;
+
+        generation = m_generation;
+        entities = m_entities;
+        fragments.reserve(m_msgs.size() + m_power_channels.size());
+
+        for (FragmentMap::iterator itr = m_msgs.begin(); itr != m_msgs.end(); ++itr)
+          fragments.push_back(itr->second);
+
+        for (PowerChannelMap::iterator itr = m_power_channels.begin(); itr != m_power_channels.end(); ++itr)
+          fragments.push_back(itr->second);
+      }
 
-      return &m_msgs_json;
+      m_snapshot.clear();
+
+      if (entities)
+        m_snapshot += *entities;
+      else
+        m_snapshot += "  'dune_entities': { },\n";
+
+      m_snapshot += "  'dune_messages': [\n";
+
+      for (size_t i = 0; i < fragments.size(); ++i)
+      {
+        if (i > 0)
+          m_snapshot += ",\n";
+        m_snapshot += *fragments[i];
+      }
+
+      m_snapshot += "\n]"
+                    "\n};";
+
+      m_snapshot_generation = generation;
     }
 
     void
     MessageMonitor::updateMessage(const IMC::Message* msg)
     {
-      ScopedMutex l(m_mutex);
+      // Encode outside the lock, so requests are not delayed.
+      std::ostringstream os;
+      msg->toJSON(os);
+      Fragment json(new std::string(os.str()));
 
-      if (msg->getId() == DUNE_IMC_POWERCHANNELSTATE)
-        updatePowerChannel(static_cast<const IMC::PowerChannelState*>(msg));
+      uint64_t key = (uint64_t)msg->getId() << 24 | (uint64_t)msg->getSubId() << 8 | msg->getSourceEntity();
 
-      IMC::Message* tmsg = msg->clone();
-      unsigned key = tmsg->getId() << 24 | tmsg->getSubId() << 8 | tmsg->getSourceEntity();
+      ScopedMutex l(m_mutex);
 
-      if (m_msgs[key])
-        delete m_msgs[key];
+      if (msg->getId() == DUNE_IMC_POWERCHANNELSTATE)
+        m_power_channels[static_cast<const IMC::PowerChannelState*>(msg)->name] = json;
 
-      m_msgs[key] = tmsg;
+      m_msgs[key].swap(json);
+      ++m_generation;
     }
 
     ByteBuffer*
@@ -213,15 +245,5 @@ namespace Transports
 
       m_logbook.push_back(new IMC::LogBookEntry(*msg));
     }
-
-    void
-    MessageMonitor::updatePowerChannel(const IMC::PowerChannelState* msg)
-    {
-      std::map<std::string, IMC::PowerChannelState*>::iterator itr = m_power_channels.find(msg->name);
-      if (itr != m_power_channels.end())
-        *itr->second = *msg;
-      else
-        m_power_channels[msg->name] = new IMC::PowerChannelState(*msg);
-    }
   }
 }
@@ -33,6 +33,10 @@
 // ISO C++ 98 headers.
 #include <map>
 #include <string>
+#include <vector>
+
+// ISO C++ 11 headers.
+#include <memory>
 
 // DUNE headers.
 #include <DUNE/DUNE.hpp>
@@ -51,8 +55,12 @@ namespace Transports
       void
       setEntities(const std::map<unsigned, std::string>& entities);
 
-      DUNE::Utils::ByteBuffer*
-      messagesJSON(void);
+      //! Retrieve the JSON snapshot of the latest messages.
+      //! @param[out] data snapshot.
+      //! @param[in] compressed true to retrieve the gzip compressed
+      //! snapshot, false otherwise.
+      void
+      messagesJSON(std::string& data, bool compressed);
 
       DUNE::Utils::ByteBuffer*
       logbookJSON(void);
@@ -63,39 +71,41 @@ namespace Transports
       void
       updateMessage(const DUNE::IMC::Message* msg);
 
-      void
-      readLock(void)
-      {
-        m_mutex.lock();
-      }
-
-      void
-      readUnlock(void)
-      {
-        m_mutex.unlock();
-      }
-
     private:
-      //! Convenience type definition for a map of power channels.
-      typedef std::map<std::string, DUNE::IMC::PowerChannelState*> PowerChannelMap;
+      //! Immutable JSON fragment, shared with snapshots being built.
+      typedef std::shared_ptr<const std::string> Fragment;
+      //! Convenience type definition for a map of JSON fragments.
+      typedef std::map<uint64_t, Fragment> FragmentMap;
+      //! Convenience type definition for a map of power channels' JSON.
+      typedef std::map<std::string, Fragment> PowerChannelMap;
       // Convenience type definition for a map of entity labels.
       typedef std::map<unsigned, std::string> EntityMap;
       // Software meta information.
       std::string m_meta;
-      // Table of messages.
-      std::map<unsigned, DUNE::IMC::Message*> m_msgs;
-      // Entity map.
-      EntityMap m_entities;
+      // JSON fragments of the latest messages.
+      FragmentMap m_msgs;
+      // Entities' JSON fragment.
+      Fragment m_entities;
       // Concurrency mutex.
       DUNE::Concurrency::Mutex m_mutex;
       // DUNE's UID.
       uint64_t m_uid;
-      // JSON messages.
-      DUNE::Utils::ByteBuffer m_msgs_json;
-      // Last JSON messages refresh.
-      uint64_t m_last_msgs_json;
-      //! Power channels.
+      //! Generation of the JSON fragments, incremented on every change.
+      uint64_t m_generation;
+      //! Power channels' JSON fragments.
       PowerChannelMap m_power_channels;
+      //! Lock serializing snapshot refreshes.
+      DUNE::Concurrency::Mutex m_snapshot_mutex;
+      //! Entities and messages part of the snapshot.
+      std::string m_snapshot;
+      //! Generation of the snapshot.
+      uint64_t m_snapshot_generation;
+      //! Compressed snapshot.
+      DUNE::Utils::ByteBuffer m_snapshot_gz;
+      //! Generation of the compressed snapshot.
+      uint64_t m_snapshot_gz_generation;
+      //! Last compressed snapshot refresh.
+      uint64_t m_last_snapshot_gz;
       // Logbook messages.
       std::vector<DUNE::IMC::LogBookEntry*> m_logbook;
       // Logbook messages' JSON.
@@ -106,7 +116,7 @@ namespace Transports
       unsigned int m_log_entry;
 
       void
-      updatePowerChannel(const DUNE::IMC::PowerChannelState* msg);
+      buildSnapshot(void);
     };
   }
 }
@@ -28,18 +28,23 @@
 //***************************************************************************
 
 // ISO C++ 98 headers.
-#include <sstream>
-#include <fstream>
-#include <queue>
-#include <iostream>
+#include <cerrno>
+#include <cstring>
 
 // DUNE headers.
+#include <DUNE/Config.hpp>
 #include <DUNE/Streams/Terminal.hpp>
 #include <DUNE/Concurrency/TSQueue.hpp>
-#include <DUNE/Concurrency/Condition.hpp>
 #include <DUNE/Concurrency/Mutex.hpp>
+#include <DUNE/Concurrency/ScopedMutex.hpp>
 #include <DUNE/Network.hpp>
 
+// Platform headers.
+#if defined(DUNE_SYS_HAS_SYS_EPOLL_H)
+#  include <sys/epoll.h>
+#  include <unistd.h>
+#endif
+
 // Local headers.
 #include "Server.hpp"
 
@@ -47,17 +52,22 @@ namespace Transports
 {
   namespace HTTP
   {
+    //! Maximum number of events handled per poll.
+    static const int c_max_events = 64;
+    //! Maximum time to wait for events when epoll is not available.
+    static const double c_fallback_timeout = 0.01;
+
     class Handler: public Concurrency::Thread
     {
     public:
-      Handler(RequestHandler& hdler, Concurrency::TSQueue<TCPSocket*>& queue):
-        m_handler(hdler),
+      Handler(Server& server, Concurrency::TSQueue<Connection*>& queue):
+        m_server(server),
         m_queue(queue)
       { }
 
     private:
-      RequestHandler& m_handler;
-      Concurrency::TSQueue<TCPSocket*>& m_queue;
+      Server& m_server;
+      Concurrency::TSQueue<Connection*>& m_queue;
 
       void
       run(void)
@@ -70,32 +80,40 @@ namespace Transports
           if (m_queue.closed())
             break;
 
-          TCPSocket* sock = m_queue.pop();
-          if (!sock)
-            continue;
-
-          try
-          {
-            m_handler.handleRequest(sock);
-          }
-          catch (...)
-          { }
-
-          delete sock;
+          Connection* conn = m_queue.pop();
+          if (conn)
+            m_server.service(conn);
         }
       }
     };
 
-    Server::Server(int port, unsigned threads, RequestHandler& handler):
-      m_handler(handler)
+    Server::Server(int port, unsigned threads, double keep_alive, RequestHandler& handler):
+      m_handler(handler),
+      m_keep_alive(keep_alive)
     {
       m_sock.bind(port);
       m_sock.listen(1024);
-      m_poll.add(m_sock);
+
+#if defined(DUNE_SYS_HAS_SYS_EPOLL_H)
+      m_epoll = epoll_create1(EPOLL_CLOEXEC);
+      if (m_epoll < 0)
+        throw std::runtime_error(System::Error::getLastMessage());
+
+      // Listening socket is level-triggered and always armed.
+      epoll_event ev;
+      std::memset(&ev, 0, sizeof(ev));
+      ev.events = EPOLLIN;
+      ev.data.ptr = NULL;
+      if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_sock.getNative(), &ev) < 0)
+      {
+        ::close(m_epoll);
+        throw std::runtime_error(System::Error::getLastMessage());
+      }
+#endif
 
       for (unsigned int i = 0; i < threads; ++i)
       {
-        Concurrency::Thread* t = new Handler(handler, m_queue);
+        Concurrency::Thread* t = new Handler(*this, m_queue);
         m_pool.push_back(t);
         t->start();
       }
@@ -117,30 +135,248 @@ namespace Transports
         delete m_pool[i];
       }
 
-      while (!m_queue.empty())
+      std::list<Connection*>::iterator itr = m_conns.begin();
+      for (; itr != m_conns.end(); ++itr)
+        delete *itr;
+
+#if defined(DUNE_SYS_HAS_SYS_EPOLL_H)
+      ::close(m_epoll);
+#endif
+    }
+
+    void
+    Server::poll(double timeout)
+    {
+#if defined(DUNE_SYS_HAS_SYS_EPOLL_H)
+      epoll_event events[c_max_events];
+      int rv = epoll_wait(m_epoll, events, c_max_events, (int)(timeout * 1000.0));
+
+      for (int i = 0; i < rv; ++i)
       {
-        TCPSocket* sock = m_queue.pop();
-        if (sock)
-          delete sock;
+        if (events[i].data.ptr == NULL)
+          accept();
+        else
+          onEvent(static_cast<Connection*>(events[i].data.ptr));
       }
+#else
+      IO::Poll iop;
+      iop.add(m_sock);
+
+      std::list<Connection*>::iterator itr = m_conns.begin();
+      for (; itr != m_conns.end(); ++itr)
+      {
+        Concurrency::ScopedMutex l(m_lock);
+        if ((*itr)->getState() == Connection::ST_IDLE)
+          iop.add((*itr)->getNative());
+      }
+
+      if (iop.poll(std::min(timeout, c_fallback_timeout)))
+      {
+        if (iop.wasTriggered(m_sock))
+          accept();
+
+        for (itr = m_conns.begin(); itr != m_conns.end(); ++itr)
+        {
+          if (iop.wasTriggered((*itr)->getNative()))
+            onEvent(*itr);
+        }
+      }
+
+      for (itr = m_conns.begin(); itr != m_conns.end(); ++itr)
+      {
+        bool sending = false;
+        {
+          Concurrency::ScopedMutex l(m_lock);
+          sending = ((*itr)->getState() == Connection::ST_SENDING);
+        }
+
+        if (sending)
+          onEvent(*itr);
+      }
+#endif
+
+      purge();
     }
 
     void
-    Server::poll(double timeout)
+    Server::service(Connection* conn)
+    {
+      bool error = false;
+
+      try
+      {
+        // Pipelined requests are answered in order.
+        while (conn->hasRequest())
+        {
+          m_handler.handleRequest(conn);
+
+          if (conn->isSending() || conn->isStreaming() || !conn->getKeepAlive())
+            break;
+        }
+      }
+      catch (std::exception& e)
+      {
+        DUNE_DBG("Server", e.what());
+        error = true;
+      }
+
+      Concurrency::ScopedMutex l(m_lock);
+
+      if (error)
+        close(conn);
+      else if (conn->isStreaming())
+        detach(conn);
+      else if (conn->isSending())
+        wait(conn, true);
+      else if (!conn->getKeepAlive())
+        close(conn);
+      else
+        wait(conn, false);
+    }
+
+    void
+    Server::accept(void)
+    {
+      Connection* conn = NULL;
+
+      try
+      {
+        conn = new Connection(m_sock.accept());
+      }
+      catch (std::runtime_error& e)
+      {
+        DUNE_ERR("Server", e.what());
+        return;
+      }
+
+      m_conns.push_back(conn);
+
+#if defined(DUNE_SYS_HAS_SYS_EPOLL_H)
+      epoll_event ev;
+      std::memset(&ev, 0, sizeof(ev));
+      ev.events = EPOLLIN | EPOLLONESHOT;
+      ev.data.ptr = conn;
+      if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, conn->getNative(), &ev) < 0)
+        conn->setState(Connection::ST_CLOSED);
+#endif
+    }
+
+    void
+    Server::onEvent(Connection* conn)
     {
-      if (m_poll.poll(timeout))
+      Concurrency::ScopedMutex l(m_lock);
+
+      try
       {
-        if (m_poll.wasTriggered(m_sock))
+        switch (conn->getState())
+        {
+          case Connection::ST_IDLE:
+            if (conn->fill())
+              dispatchOrWait(conn);
+            else
+              close(conn);
+            break;
+
+          case Connection::ST_SENDING:
+            if (!conn->transferFile())
+              close(conn);
+            else if (conn->isSending())
+              wait(conn, true);
+            else if (!conn->getKeepAlive())
+              close(conn);
+            else
+              dispatchOrWait(conn);
+            break;
+
+          default:
+            break;
+        }
+      }
+      catch (std::exception& e)
+      {
+        DUNE_DBG("Server", e.what());
+        close(conn);
+      }
+    }
+
+    void
+    Server::dispatchOrWait(Connection* conn)
+    {
+      if (conn->hasRequest())
+      {
+        conn->setState(Connection::ST_BUSY);
+        m_queue.push(conn);
+      }
+      else
+      {
+        wait(conn, false);
+      }
+    }
+
+    void
+    Server::wait(Connection* conn, bool output)
+    {
+      conn->setState(output ? Connection::ST_SENDING : Connection::ST_IDLE);
+
+#if defined(DUNE_SYS_HAS_SYS_EPOLL_H)
+      epoll_event ev;
+      std::memset(&ev, 0, sizeof(ev));
+      ev.events = (output ? EPOLLOUT : EPOLLIN) | EPOLLONESHOT;
+      ev.data.ptr = conn;
+      if (epoll_ctl(m_epoll, EPOLL_CTL_MOD, conn->getNative(), &ev) < 0)
+        close(conn);
+#endif
+    }
+
+    void
+    Server::close(Connection* conn)
+    {
+      conn->setState(Connection::ST_CLOSED);
+
+#if defined(DUNE_SYS_HAS_SYS_EPOLL_H)
+      epoll_ctl(m_epoll, EPOLL_CTL_DEL, conn->getNative(), NULL);
+#endif
+    }
+
+    void
+    Server::detach(Connection* conn)
+    {
+      conn->setState(Connection::ST_STREAMING);
+
+#if defined(DUNE_SYS_HAS_SYS_EPOLL_H)
+      epoll_ctl(m_epoll, EPOLL_CTL_DEL, conn->getNative(), NULL);
+#endif
+    }
+
+    void
+    Server::purge(void)
+    {
+      double now = Clock::get();
+
+      Concurrency::ScopedMutex l(m_lock);
+
+      std::list<Connection*>::iterator itr = m_conns.begin();
+      while (itr != m_conns.end())
+      {
+        Connection* conn = *itr;
+
+        if (conn->getState() == Connection::ST_IDLE
+            && (now - conn->getLastActivity()) > m_keep_alive)
+          close(conn);
+
+        if (conn->getState() == Connection::ST_CLOSED)
+        {
+          delete conn;
+          itr = m_conns.erase(itr);
+        }
+        else if (conn->getState() == Connection::ST_STREAMING)
+        {
+          itr = m_conns.erase(itr);
+          m_handler.handleStream(conn);
+        }
+        else
         {
-          try
-          {
-            TCPSocket* nc = m_sock.accept();
-            m_queue.push(nc);
-          }
-          catch (std::runtime_error& e)
-          {
-            DUNE_ERR("Server", e.what());
-          }
+          ++itr;
         }
       }
     }
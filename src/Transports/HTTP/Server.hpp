@@ -31,33 +31,49 @@
 #define TRANSPORTS_HTTP_SERVER_HPP_INCLUDED_
 
 // ISO C++ 98 headers.
+#include <list>
 #include <vector>
 
 // DUNE headers.
 #include <DUNE/DUNE.hpp>
 
 // Local headers.
+#include "Connection.hpp"
 #include "RequestHandler.hpp"
 
 namespace Transports
 {
   namespace HTTP
   {
+    //! Event driven HTTP server. Connections are multiplexed by the
+    //! thread calling poll(), which reads incoming data and transfers
+    //! files, while complete requests are serviced by a pool of
+    //! worker threads.
     class Server
     {
     public:
       //! Constructor.
       //! @param port listening port.
       //! @param threads number of worker threads.
+      //! @param keep_alive time after which idle persistent
+      //! connections are closed.
       //! @param handler HTTP request handler.
-      Server(int port, unsigned threads, RequestHandler& handler);
+      Server(int port, unsigned threads, double keep_alive, RequestHandler& handler);
 
       //! Destructor.
       ~Server(void);
 
+      //! Wait for and process connection events.
+      //! @param timeout maximum amount of time to wait.
       void
       poll(double timeout);
 
+      //! Service all buffered requests of a connection. Called by
+      //! worker threads.
+      //! @param conn connection.
+      void
+      service(Connection* conn);
+
     private:
       //! HTTP request handler.
       RequestHandler& m_handler;
@@ -65,10 +81,39 @@ namespace Transports
       TCPSocket m_sock;
       //! Worker threads pool.
       std::vector<Concurrency::Thread*> m_pool;
-      //! Socket queue.
-      Concurrency::TSQueue<TCPSocket*> m_queue;
-      //! I/O multiplexing.
-      IO::Poll m_poll;
+      //! Queue of connections with complete requests.
+      Concurrency::TSQueue<Connection*> m_queue;
+      //! Open connections.
+      std::list<Connection*> m_conns;
+      //! Time after which idle persistent connections are closed.
+      double m_keep_alive;
+      //! Lock serializing connection state changes.
+      Concurrency::Mutex m_lock;
+#if defined(DUNE_SYS_HAS_SYS_EPOLL_H)
+      //! epoll instance.
+      int m_epoll;
+#endif
+
+      void
+      accept(void);
+
+      void
+      onEvent(Connection* conn);
+
+      void
+      dispatchOrWait(Connection* conn);
+
+      void
+      wait(Connection* conn, bool output);
+
+      void
+      close(Connection* conn);
+
+      void
+      detach(Connection* conn);
+
+      void
+      purge(void);
     };
   }
 }
@@ -0,0 +1,254 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+// ISO C++ 98 headers.
+#include <sstream>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Streamer.hpp"
+
+namespace Transports
+{
+  namespace HTTP
+  {
+    using DUNE_NAMESPACES;
+
+    //! Keep-alive comment.
+    static const char c_heartbeat[] = ":\n\n";
+
+    Streamer::Streamer(double heartbeat):
+      m_heartbeat(heartbeat)
+    { }
+
+    Streamer::~Streamer(void)
+    {
+      clear();
+    }
+
+    void
+    Streamer::subscribe(Connection* conn, const std::set<unsigned>& ids, double period, Format format)
+    {
+      Client* client = new Client;
+      client->conn = conn;
+      client->ids = ids;
+      client->period = period;
+      client->format = format;
+      client->out_off = 0;
+      client->last_write = Clock::get();
+
+      ScopedMutex l(m_mutex);
+      std::map<Connection*, Client*>::iterator itr = m_pending.find(conn);
+      if (itr != m_pending.end())
+      {
+        delete itr->second;
+        itr->second = client;
+      }
+      else
+      {
+        m_pending[conn] = client;
+      }
+    }
+
+    void
+    Streamer::attach(Connection* conn)
+    {
+      Client* client = NULL;
+
+      {
+        ScopedMutex l(m_mutex);
+        std::map<Connection*, Client*>::iterator itr = m_pending.find(conn);
+        if (itr != m_pending.end())
+        {
+          client = itr->second;
+          m_pending.erase(itr);
+        }
+      }
+
+      if (client == NULL)
+      {
+        delete conn;
+        return;
+      }
+
+      m_clients.push_back(client);
+    }
+
+    void
+    Streamer::publish(const IMC::Message* msg)
+    {
+      if (m_clients.empty())
+        return;
+
+      unsigned id = msg->getId();
+      // Identifier (16 bit), sub-identifier (16 bit) and entity (8 bit).
+      uint64_t key = (uint64_t)id << 24 | (uint64_t)msg->getSubId() << 8 | msg->getSourceEntity();
+
+      std::string frames[2];
+      bool encoded[2] = {false, false};
+
+      std::list<Client*>::iterator itr = m_clients.begin();
+      for (; itr != m_clients.end(); ++itr)
+      {
+        Client* client = *itr;
+        if (!client->ids.empty() && client->ids.find(id) == client->ids.end())
+          continue;
+
+        if (!encoded[client->format])
+        {
+          encode(msg, client->format, frames[client->format]);
+          encoded[client->format] = true;
+        }
+
+        Frame& frame = client->frames[key];
+        frame.data = frames[client->format];
+        frame.pending = true;
+      }
+    }
+
+    void
+    Streamer::flush(void)
+    {
+      double now = Clock::get();
+
+      std::list<Client*>::iterator itr = m_clients.begin();
+      while (itr != m_clients.end())
+      {
+        Client* client = *itr;
+
+        try
+        {
+          // Gather frames due once the previous ones were written.
+          if (client->out_off == client->out.size())
+          {
+            client->out.clear();
+            client->out_off = 0;
+
+            std::map<uint64_t, Frame>::iterator fitr = client->frames.begin();
+            for (; fitr != client->frames.end(); ++fitr)
+            {
+              Frame& frame = fitr->second;
+              if (!frame.pending || (now - frame.last) < client->period)
+                continue;
+
+              client->out += frame.data;
+              frame.pending = false;
+              frame.last = now;
+            }
+
+            if (client->out.empty() && (now - client->last_write) >= m_heartbeat)
+              client->out = c_heartbeat;
+          }
+
+          if (client->out_off < client->out.size())
+          {
+            size_t rv = client->conn->tryWrite(client->out.data() + client->out_off,
+                                               client->out.size() - client->out_off);
+            client->out_off += rv;
+            if (rv > 0)
+              client->last_write = now;
+          }
+
+          ++itr;
+        }
+        catch (std::exception&)
+        {
+          destroy(client);
+          itr = m_clients.erase(itr);
+        }
+      }
+    }
+
+    bool
+    Streamer::empty(void)
+    {
+      ScopedMutex l(m_mutex);
+      return m_clients.empty() && m_pending.empty();
+    }
+
+    void
+    Streamer::clear(void)
+    {
+      std::list<Client*>::iterator itr = m_clients.begin();
+      for (; itr != m_clients.end(); ++itr)
+        destroy(*itr);
+      m_clients.clear();
+
+      // Connections of pending subscriptions belong to the server.
+      ScopedMutex l(m_mutex);
+      std::map<Connection*, Client*>::iterator pitr = m_pending.begin();
+      for (; pitr != m_pending.end(); ++pitr)
+        delete pitr->second;
+      m_pending.clear();
+    }
+
+    void
+    Streamer::encode(const IMC::Message* msg, Format format, std::string& frame)
+    {
+      std::ostringstream os;
+
+      if (format == FMT_IMC)
+      {
+        ByteBuffer bfr;
+        uint16_t size = IMC::Packet::serialize(msg, bfr);
+        os << "event: imc\n"
+           << "data: " << Algorithms::Base64::encode(bfr.getBuffer(), size) << "\n\n";
+      }
+      else
+      {
+        std::ostringstream json;
+        msg->toJSON(json);
+
+        // Each line of the payload must be prefixed with the field name.
+        std::string str = json.str();
+        os << "event: " << msg->getName() << "\n"
+           << "data: ";
+        for (size_t i = 0; i < str.size(); ++i)
+        {
+          if (str[i] == '\n')
+            os << "\ndata: ";
+          else
+            os << str[i];
+        }
+        os << "\n\n";
+      }
+
+      frame = os.str();
+    }
+
+    void
+    Streamer::destroy(Client* client)
+    {
+      delete client->conn;
+      delete client;
+    }
+  }
+}
@@ -0,0 +1,166 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+#ifndef TRANSPORTS_HTTP_STREAMER_HPP_INCLUDED_
+#define TRANSPORTS_HTTP_STREAMER_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "Connection.hpp"
+
+namespace Transports
+{
+  namespace HTTP
+  {
+    //! Pushes messages to subscribed clients as Server-Sent Events.
+    //! Each message is encoded once per format and the frame is
+    //! shared by all interested clients. Clients receive at most
+    //! one frame per message type and entity per period, and frames
+    //! that cannot be sent in time are superseded by newer ones.
+    class Streamer
+    {
+    public:
+      //! Frame formats.
+      enum Format
+      {
+        //! JSON representation.
+        FMT_JSON,
+        //! Base64 encoded IMC packet.
+        FMT_IMC
+      };
+
+      //! Constructor.
+      //! @param[in] heartbeat period of keep-alive comments sent to
+      //! idle clients.
+      Streamer(double heartbeat);
+
+      //! Destructor.
+      ~Streamer(void);
+
+      //! Register a subscription. The subscription becomes active
+      //! when the connection is attached.
+      //! @param[in] conn client connection.
+      //! @param[in] ids message identifiers, empty for all.
+      //! @param[in] period minimum time between frames of the same
+      //! message type and entity.
+      //! @param[in] format frame format.
+      void
+      subscribe(Connection* conn, const std::set<unsigned>& ids, double period, Format format);
+
+      //! Activate the subscription of a connection, taking ownership
+      //! of the connection.
+      //! @param[in] conn client connection.
+      void
+      attach(Connection* conn);
+
+      //! Queue a message to all interested clients.
+      //! @param[in] msg message.
+      void
+      publish(const DUNE::IMC::Message* msg);
+
+      //! Write queued frames to clients, without blocking. Clients
+      //! that have disconnected are removed.
+      void
+      flush(void);
+
+      //! Test if there are clients.
+      //! @return true if there are no clients.
+      bool
+      empty(void);
+
+      //! Remove all clients.
+      void
+      clear(void);
+
+    private:
+      //! Latest frame of a message type and entity.
+      struct Frame
+      {
+        //! Encoded frame.
+        std::string data;
+        //! Time of last transmission.
+        double last;
+        //! True if the frame was not transmitted yet.
+        bool pending;
+
+        Frame(void):
+          last(0),
+          pending(false)
+        { }
+      };
+
+      //! Subscribed client.
+      struct Client
+      {
+        //! Connection.
+        Connection* conn;
+        //! Message identifiers, empty for all.
+        std::set<unsigned> ids;
+        //! Minimum time between frames.
+        double period;
+        //! Frame format.
+        Format format;
+        //! Latest frames, by message identifier, sub-identifier and
+        //! source entity.
+        std::map<uint64_t, Frame> frames;
+        //! Data being written.
+        std::string out;
+        //! Amount of data already written.
+        size_t out_off;
+        //! Time of last write.
+        double last_write;
+      };
+
+      //! Active clients.
+      std::list<Client*> m_clients;
+      //! Subscriptions waiting for their connection.
+      std::map<Connection*, Client*> m_pending;
+      //! Lock for pending subscriptions.
+      DUNE::Concurrency::Mutex m_mutex;
+      //! Heartbeat period.
+      double m_heartbeat;
+
+      static void
+      encode(const DUNE::IMC::Message* msg, Format format, std::string& frame);
+
+      static void
+      destroy(Client* client);
+    };
+  }
+}
+
+#endif
@@ -28,6 +28,7 @@
 //***************************************************************************
 
 // ISO C++ 98 headers.
+#include <set>
 #include <vector>
 #include <stdexcept>
 #include <fstream>
@@ -43,6 +44,7 @@
 #include "MessageMonitor.hpp"
 #include "RequestHandler.hpp"
 #include "Server.hpp"
+#include "Streamer.hpp"
 
 namespace Transports
 {
@@ -59,6 +61,8 @@ namespace Transports
       unsigned port;
       //! Number of worker threads.
       unsigned threads;
+      //! Time after which idle persistent connections are closed.
+      double keep_alive;
       //! List of messages to transport.
       std::vector<std::string> messages;
     };
@@ -67,6 +71,12 @@ namespace Transports
     static const unsigned c_buffer_len = 4096;
     //! Maximum number of ports to try before giving up.
     static const int c_max_port_tries = 10;
+    //! Maximum number of queued messages of each transported type.
+    static const unsigned c_queue_limit = 32;
+    //! Period of keep-alive comments sent to idle stream clients.
+    static const double c_stream_heartbeat = 15.0;
+    //! Server poll timeout while there are stream clients.
+    static const double c_stream_poll = 0.01;
 
     struct Task: public Tasks::Task, public RequestHandler
     {
@@ -78,6 +88,8 @@ namespace Transports
       std::string m_agent;
       //! Message Monitor.
       MessageMonitor m_msg_mon;
+      //! Message streamer.
+      Streamer m_streamer;
       //! Task arguments.
       Arguments m_args;
 
@@ -85,7 +97,8 @@ namespace Transports
         Tasks::Task(name, ctx),
         RequestHandler(),
         m_server(NULL),
-        m_msg_mon(getSystemName(), ctx.uid)
+        m_msg_mon(getSystemName(), ctx.uid),
+        m_streamer(c_stream_heartbeat)
       {
         // Define configuration parameters.
         param("Port", m_args.port)
@@ -96,6 +109,11 @@ namespace Transports
         .defaultValue("5")
         .description("Number of worker threads");
 
+        param("Keep-Alive Timeout", m_args.keep_alive)
+        .defaultValue("15.0")
+        .units(Units::Second)
+        .description("Time after which idle persistent connections are closed");
+
         param("Transports", m_args.messages)
         .defaultValue("")
         .description("List of messages to transport");
@@ -111,6 +129,13 @@ namespace Transports
       {
         bind(this, m_args.messages);
 
+        // Only recent messages are relevant to HTTP clients.
+        for (unsigned i = 0; i < m_args.messages.size(); ++i)
+        {
+          setQueuePolicy(IMC::Factory::getIdFromAbbrev(m_args.messages[i]),
+                         c_queue_limit, Tasks::QP_DROP_OLDEST);
+        }
+
         uint16_t last_port = m_args.port + c_max_port_tries;
 
         for (uint16_t port = m_args.port; port < last_port; ++port)
@@ -118,7 +143,7 @@ namespace Transports
           try
           {
             inf(DTR("listening on %s:%u"), Address(Address::Any).c_str(), port);
-            m_server = new Server(port, m_args.threads, *this);
+            m_server = new Server(port, m_args.threads, m_args.keep_alive, *this);
 
             // Initialize and dispatch AnnounceService.
             std::vector<Interface> itfs = Interface::get();
@@ -152,6 +177,7 @@ namespace Transports
       onResourceRelease(void)
       {
         Memory::clear(m_server);
+        m_streamer.clear();
       }
 
       void
@@ -164,7 +190,10 @@ namespace Transports
       consume(const IMC::Message* msg)
       {
         if (msg->getSource() == getSystemId())
+        {
           m_msg_mon.updateMessage(msg);
+          m_streamer.publish(msg);
+        }
       }
 
       void
@@ -192,26 +221,28 @@ namespace Transports
       }
 
       void
-      handleGET(TCPSocket* sock, TupleList& headers, const char* uri)
+      handleGET(Connection* conn, TupleList& headers, const char* uri)
       {
         debug("GET request: %s", uri);
 
         if (isSpecialURI(uri))
         {
           if (matchURL(uri, "/dune/time/set", true))
-            setTime(sock, headers, uri);
+            setTime(conn, headers, uri);
           else if (matchURL(uri, "/dune/version.js"))
-            sendVersionJSON(sock, headers, uri);
+            sendVersionJSON(conn, headers, uri);
           else if (matchURL(uri, "/dune/agent.js"))
-            sendAgentJSON(sock, headers, uri);
+            sendAgentJSON(conn, headers, uri);
           else if (matchURL(uri, "/dune/state/messages.js"))
-            showMessages(sock, headers, uri);
+            showMessages(conn, headers, uri);
           else if (matchURL(uri, "/dune/power/channel/", true))
-            handlePowerChannel(sock, headers, uri);
+            handlePowerChannel(conn, headers, uri);
           else if (matchURL(uri, "/dune/state/logbook.js", true))
-            showLogBook(sock, headers, uri);
+            showLogBook(conn, headers, uri);
+          else if (matchURL(uri, "/dune/stream/", true))
+            startStream(conn, headers, uri);
           else
-            sendResponse404(sock);
+            sendResponse404(conn);
         }
         else
         {
@@ -221,30 +252,30 @@ namespace Transports
           else
             path = m_ctx.dir_www / uri;
 
-          sendStaticFile(sock, headers, path);
+          sendStaticFile(conn, headers, path);
         }
       }
 
       void
-      handlePOST(TCPSocket* sock, TupleList& headers, const char* uri)
+      handlePOST(Connection* conn, TupleList& headers, const char* uri)
       {
         debug("POST request: %s", uri);
 
         if (isSpecialURI(uri))
         {
           if (matchURL(uri, "/dune/messages/imc/", true))
-            getMessage(sock, headers, uri);
+            getMessage(conn, headers, uri);
           else
-            sendResponse403(sock);
+            sendResponse403(conn);
         }
         else
         {
-          sendResponse403(sock);
+          sendResponse403(conn);
         }
       }
 
       void
-      handlePUT(TCPSocket* sock, TupleList& headers, const char* uri)
+      handlePUT(Connection* conn, TupleList& headers, const char* uri)
       {
         debug("PUT request: %s", uri);
 
@@ -252,16 +283,16 @@ namespace Transports
 
         if (isSpecialURI(uri))
         {
-          sendResponse403(sock);
+          sendResponse403(conn);
         }
         else
         {
-          sendResponse403(sock);
+          sendResponse403(conn);
         }
       }
 
       void
-      sendStaticFile(TCPSocket* sock, TupleList& headers, const Path& file)
+      sendStaticFile(Connection* conn, TupleList& headers, const Path& file)
       {
         int64_t beg = -1;
         int64_t end = -1;
@@ -288,26 +319,26 @@ namespace Transports
         else if (ext == "js")
           hdr["Content-Type"] = "text/javascript";
 
-        sendFile(sock, file.str(), hdr, beg, end);
+        sendFile(conn, file.str(), hdr, beg, end);
       }
 
       void
-      getMessage(TCPSocket* sock, TupleList& headers, const char* uri)
+      getMessage(Connection* conn, TupleList& headers, const char* uri)
       {
         (void)uri;
 
         unsigned int size = headers.get("content-length", 0);
         char* bfr = new char[size];
-        sock->read(bfr, size);
+        conn->read(bfr, size);
         IMC::Message* msg = IMC::Packet::deserialize((uint8_t*)bfr, size);
         dispatch(msg, DF_KEEP_TIME);
         std::ostringstream ss;
         msg->toText(ss);
-        sendData(sock, ss.str());
+        sendData(conn, ss.str());
       }
 
       void
-      setTime(TCPSocket* sock, TupleList& headers, const char* uri)
+      setTime(Connection* conn, TupleList& headers, const char* uri)
       {
         (void)headers;
 
@@ -318,30 +349,100 @@ namespace Transports
         ss >> secs;
         if (ss.fail())
         {
-          sendResponse500(sock);
+          sendResponse500(conn);
           return;
         }
 
-        sendResponse200(sock);
+        sendResponse200(conn);
         Clock::set(secs);
       }
 
+      //! Subscribe to messages pushed as Server-Sent Events. The URI
+      //! is /dune/stream/FORMAT[/RATE[/ABBREV,...]], where FORMAT is
+      //! either 'json' or 'imc', RATE is the maximum number of frames
+      //! per second of each message type and entity (0 for unlimited)
+      //! and the list of message abbreviations defaults to all
+      //! transported messages.
       void
-      showMessages(TCPSocket* sock, TupleList& headers, const char* uri)
+      startStream(Connection* conn, TupleList& headers, const char* uri)
       {
         (void)headers;
+
+        std::string prefix = String::getRemaining("/dune/stream/", uri);
+        std::vector<std::string> parts;
+        String::split(prefix, "/", parts);
+
+        if (parts.empty() || parts.size() > 3)
+        {
+          sendResponse404(conn);
+          return;
+        }
+
+        Streamer::Format format;
+        if (parts[0] == "json")
+          format = Streamer::FMT_JSON;
+        else if (parts[0] == "imc")
+          format = Streamer::FMT_IMC;
+        else
+        {
+          sendResponse404(conn);
+          return;
+        }
+
+        double rate = 0;
+        if (parts.size() > 1 && (!castLexical(parts[1], rate) || rate < 0))
+        {
+          sendResponse404(conn);
+          return;
+        }
+
+        std::set<unsigned> ids;
+        if (parts.size() > 2)
+        {
+          std::vector<std::string> abbrevs;
+          String::split(parts[2], ",", abbrevs);
+
+          for (unsigned i = 0; i < abbrevs.size(); ++i)
+          {
+            if (std::find(m_args.messages.begin(), m_args.messages.end(), abbrevs[i]) == m_args.messages.end())
+            {
+              sendResponse404(conn, "Message Not Transported");
+              return;
+            }
+
+            ids.insert(IMC::Factory::getIdFromAbbrev(abbrevs[i]));
+          }
+        }
+
+        sendStreamHeader(conn);
+        m_streamer.subscribe(conn, ids, (rate > 0) ? 1.0 / rate : 0.0, format);
+      }
+
+      void
+      handleStream(Connection* conn)
+      {
+        m_streamer.attach(conn);
+      }
+
+      void
+      showMessages(Connection* conn, TupleList& headers, const char* uri)
+      {
         (void)uri;
 
         RequestHandler::HeaderFieldsMap hdr;
         hdr["Content-Type"] = "text/javascript";
-        hdr["Content-Encoding"] = "gzip";
 
-        ByteBuffer* bfr = m_msg_mon.messagesJSON();
-        sendData(sock, bfr->getBufferSigned(), bfr->getSize(), &hdr);
+        bool gzip = headers.get("Accept-Encoding").find("gzip") != std::string::npos;
+        if (gzip)
+          hdr["Content-Encoding"] = "gzip";
+
+        std::string data;
+        m_msg_mon.messagesJSON(data, gzip);
+        sendData(conn, data, &hdr);
       }
 
       void
-      showLogBook(TCPSocket* sock, TupleList& headers, const char* uri)
+      showLogBook(Connection* conn, TupleList& headers, const char* uri)
       {
         (void)headers;
         (void)uri;
@@ -351,11 +452,11 @@ namespace Transports
         hdr["Content-Encoding"] = "gzip";
 
         ByteBuffer* bfr = m_msg_mon.logbookJSON();
-        sendData(sock, bfr->getBufferSigned(), bfr->getSize(), &hdr);
+        sendData(conn, bfr->getBufferSigned(), bfr->getSize(), &hdr);
       }
 
       void
-      sendVersionJSON(TCPSocket* sock, TupleList& headers, const char* uri)
+      sendVersionJSON(Connection* conn, TupleList& headers, const char* uri)
       {
         (void)headers;
         (void)uri;
@@ -364,11 +465,11 @@ namespace Transports
         os << "var systemVersion = '" << getFullVersion() << " - " << getCompileDate() << "';";
         RequestHandler::HeaderFieldsMap hdr;
         hdr["Content-Type"] = "text/javascript";
-        sendData(sock, os.str(), &hdr);
+        sendData(conn, os.str(), &hdr);
       }
 
       void
-      sendAgentJSON(TCPSocket* sock, TupleList& headers, const char* uri)
+      sendAgentJSON(Connection* conn, TupleList& headers, const char* uri)
       {
         (void)headers;
         (void)uri;
@@ -377,11 +478,11 @@ namespace Transports
         os << "var systemName = '" << m_agent << "';";
         RequestHandler::HeaderFieldsMap hdr;
         hdr["Content-Type"] = "text/javascript";
-        sendData(sock, os.str(), &hdr);
+        sendData(conn, os.str(), &hdr);
       }
 
       void
-      handlePowerChannel(TCPSocket* sock, TupleList& headers, const char* uri)
+      handlePowerChannel(Connection* conn, TupleList& headers, const char* uri)
       {
         (void)headers;
 
@@ -391,7 +492,7 @@ namespace Transports
 
         if (parts.size() != 2 && parts.size() != 5)
         {
-          sendResponse500(sock);
+          sendResponse500(conn);
           return;
         }
 
@@ -401,7 +502,7 @@ namespace Transports
           unsigned t = 0;
           if (!castLexical(parts[2], t))
           {
-            sendResponse500(sock);
+            sendResponse500(conn);
             return;
           }
           else
@@ -409,7 +510,7 @@ namespace Transports
 
           if (!castLexical(parts[3], t))
           {
-            sendResponse500(sock);
+            sendResponse500(conn);
             return;
           }
           else
@@ -417,7 +518,7 @@ namespace Transports
 
           if (!castLexical(parts[4], t))
           {
-            sendResponse500(sock);
+            sendResponse500(conn);
             return;
           }
           else
@@ -444,7 +545,7 @@ namespace Transports
           pcc.sched_time = sched_time;
         }
 
-        sendResponse200(sock);
+        sendResponse200(conn);
         dispatch(pcc);
       }
 
@@ -454,8 +555,9 @@ namespace Transports
         while (!stopping())
         {
           setEntityState(IMC::EntityState::ESTA_NORMAL, Status::CODE_ACTIVE);
-          m_server->poll(1.0);
+          m_server->poll(m_streamer.empty() ? 1.0 : c_stream_poll);
           consumeMessages();
+          m_streamer.flush();
         }
       }
     };
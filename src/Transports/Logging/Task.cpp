@@ -37,12 +37,17 @@
 // DUNE headers.
 #include <DUNE/DUNE.hpp>
 
+// Local headers.
+#include "Writer.hpp"
+
 namespace Transports
 {
   namespace Logging
   {
     using DUNE_NAMESPACES;
 
+    // Bytes per Kibibyte.
+    static const unsigned c_bytes_per_kib = 1024U;
     // Bytes per Mebibyte.
     static const unsigned c_bytes_per_mib = 1048576U;
 
@@ -58,6 +63,12 @@ namespace Transports
       unsigned lsf_volume_size;
       // Compression method.
       std::string lsf_compression;
+      // Size of write blocks.
+      unsigned block_size;
+      // Maximum amount of data waiting to be written.
+      unsigned max_buffered;
+      // Write LSF index.
+      bool lsf_index;
     };
 
     struct Task: public Tasks::Task
@@ -72,8 +83,8 @@ namespace Transports
       std::string m_volume_dir;
       // Compression format.
       Compression::Methods m_compression;
-      // Output file stream for LSF/LSF_GZ formats.
-      std::ostream* m_lsf;
+      // Asynchronous writer for LSF/LSF_GZ formats.
+      Writer* m_lsf;
       // Path to LSF file.
       Path m_lsf_file;
       // Serialization buffer.
@@ -97,9 +108,30 @@ namespace Transports
         .units(Units::Second)
         .description("Number of second to wait before forcing data to be written to disk");
 
+        param("Block Size", m_args.block_size)
+        .defaultValue("128")
+        .minimumValue("1")
+        .units(Units::Kibibyte)
+        .description("Amount of data handed to the compression and write thread at once."
+                     " Each block is compressed independently");
+
+        param("Maximum Buffered Data", m_args.max_buffered)
+        .defaultValue("4096")
+        .minimumValue("1")
+        .units(Units::Kibibyte)
+        .description("Maximum amount of data waiting to be compressed and written."
+                     " Logging blocks while this limit is exceeded");
+
         param("LSF Compression Method", m_args.lsf_compression)
         .defaultValue("none")
-        .description("Compression method");
+        .values("none, gzip, bzip2, zlib, lz4")
+        .description("Compression method. LZ4 is recommended when CPU time"
+                     " is scarce, gzip and bzip2 when storage is");
+
+        param("LSF Index", m_args.lsf_index)
+        .defaultValue("true")
+        .description("Write an index of messages and compressed blocks"
+                     " alongside the LSF file, allowing fast seeks");
 
         param("LSF Volume Size", m_args.lsf_volume_size)
         .units(Units::Mebibyte)
@@ -292,7 +324,7 @@ namespace Transports
         while (!ifs.eof())
         {
           ifs.read(bfr, sizeof(bfr));
-          m_lsf->write(bfr, ifs.gcount());
+          m_lsf->write(bfr, (size_t)ifs.gcount());
         }
       }
 
@@ -350,10 +382,10 @@ namespace Transports
 
         m_lsf_file = m_dir / "Data.lsf" + Compression::Factory::extension(m_compression);
 
-        if (m_compression == METHOD_UNKNOWN)
-          m_lsf = new std::ofstream(m_lsf_file.c_str(), std::ios::binary);
-        else
-          m_lsf = new Compression::FileOutput(m_lsf_file.c_str(), m_compression);
+        m_lsf = new Writer(m_lsf_file.str(), m_compression,
+                           m_args.block_size * c_bytes_per_kib,
+                           m_args.max_buffered * c_bytes_per_kib,
+                           m_args.lsf_index);
 
         // Log LoggingControl to facilitate posterior conversion to LLF.
         m_log_ctl.op = IMC::LoggingControl::COP_STARTED;
@@ -425,6 +457,7 @@ namespace Transports
           return;
 
         IMC::Packet::serialize(msg, m_buffer);
+        m_lsf->index(msg);
         m_lsf->write(m_buffer.getBufferSigned(), m_buffer.getSize());
       }
 
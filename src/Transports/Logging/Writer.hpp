@@ -0,0 +1,427 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+#ifndef TRANSPORTS_LOGGING_WRITER_HPP_INCLUDED_
+#define TRANSPORTS_LOGGING_WRITER_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// POSIX headers.
+#if defined(DUNE_SYS_HAS_FDATASYNC)
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+namespace Transports
+{
+  namespace Logging
+  {
+    using DUNE_NAMESPACES;
+
+    //! Asynchronous LSF writer. Serialized packets are appended to
+    //! large blocks in the caller's thread. Full blocks are
+    //! compressed and written to disk by a separate thread, which
+    //! also synchronizes the file with the storage device when a
+    //! flush is requested. Each block is compressed independently
+    //! and, optionally, an index of messages and compressed blocks is
+    //! written alongside the LSF file (see IMC::LsfIndex).
+    class Writer: public Concurrency::Thread
+    {
+    public:
+      //! Constructor.
+      //! @param[in] file output file.
+      //! @param[in] method compression method.
+      //! @param[in] block_size size of each block in bytes.
+      //! @param[in] max_buffered maximum number of bytes waiting to
+      //! be written, callers block while this limit is exceeded.
+      //! @param[in] index true to write an index of the file.
+      Writer(const std::string& file, Compression::Methods method,
+             size_t block_size, size_t max_buffered, bool index):
+        m_com(NULL),
+        m_fd(-1),
+        m_index(index),
+        m_offset(0),
+        m_file_offset(0),
+        m_max_time(0),
+        m_block_size(block_size),
+        m_max_buffered(std::max(max_buffered, block_size)),
+        m_block(NULL),
+        m_buffered(0),
+        m_sync(false),
+        m_closing(false)
+      {
+        m_out.open(file.c_str(), std::ios::binary);
+        if (!m_out.is_open())
+          throw std::runtime_error(DTR("failed to open log file"));
+
+        if (method != Compression::METHOD_UNKNOWN)
+          m_com = Compression::Factory::compressor(method);
+
+        if (m_index)
+        {
+          uint8_t hdr[IMC::LsfIndex::c_header_size];
+          IMC::LsfIndex::encodeHeader(hdr);
+          m_idx.open(IMC::LsfIndex::getPath(file).c_str(), std::ios::binary);
+          m_idx.write((char*)hdr, sizeof(hdr));
+
+          if (m_com != NULL)
+          {
+            IMC::LsfIndex::encodeBlockHeader(hdr);
+            m_blk.open(IMC::LsfIndex::getBlockPath(file).c_str(), std::ios::binary);
+            m_blk.write((char*)hdr, sizeof(hdr));
+          }
+        }
+
+#if defined(DUNE_SYS_HAS_FDATASYNC)
+        m_fd = ::open(file.c_str(), O_RDONLY);
+#endif
+
+        m_block = getBlock();
+        start();
+      }
+
+      //! Destructor. Pending data is written before returning.
+      ~Writer(void)
+      {
+        {
+          ScopedCondition l(m_cond);
+          queueBlock();
+          m_closing = true;
+          m_cond.broadcast();
+        }
+
+        join();
+
+        {
+          ScopedCondition l(m_cond);
+          while (!m_free.empty())
+          {
+            delete m_free.back();
+            m_free.pop_back();
+          }
+        }
+
+        delete m_block;
+        delete m_com;
+
+#if defined(DUNE_SYS_HAS_FDATASYNC)
+        if (m_fd >= 0)
+          ::close(m_fd);
+#endif
+      }
+
+      //! Add a message to the index. Must be called before writing
+      //! the serialized message.
+      //! @param[in] msg message.
+      void
+      index(const IMC::Message* msg)
+      {
+        if (!m_index)
+          return;
+
+        IMC::LsfIndex::Entry entry;
+        entry.timestamp = msg->getTimeStamp();
+        if (m_offset == 0 || entry.timestamp > m_max_time)
+          m_max_time = entry.timestamp;
+        entry.max_time = m_max_time;
+        entry.offset = m_offset;
+        entry.id = msg->getId();
+        entry.src = msg->getSource();
+        entry.src_ent = msg->getSourceEntity();
+
+        size_t size = m_block->index.size();
+        m_block->index.resize(size + IMC::LsfIndex::c_record_size);
+        IMC::LsfIndex::encode(entry, &m_block->index[size]);
+      }
+
+      //! Append data to the output.
+      //! @param[in] data data.
+      //! @param[in] size size of data in bytes.
+      void
+      write(const char* data, size_t size)
+      {
+        while (size > 0)
+        {
+          size_t room = m_block_size - m_block->data.size();
+          size_t count = std::min(room, size);
+          m_block->data.insert(m_block->data.end(), data, data + count);
+          m_offset += count;
+          data += count;
+          size -= count;
+
+          if (m_block->data.size() >= m_block_size)
+          {
+            ScopedCondition l(m_cond);
+            queueBlock();
+          }
+        }
+      }
+
+      //! Hand the current block to the writer thread and request
+      //! the output to be flushed and synchronized.
+      //! @throw std::runtime_error if the writer thread failed.
+      void
+      flush(void)
+      {
+        ScopedCondition l(m_cond);
+
+        if (!m_error.empty())
+          throw std::runtime_error(m_error);
+
+        queueBlock();
+        m_sync = true;
+        m_cond.broadcast();
+      }
+
+      //! Retrieve the number of bytes waiting to be written.
+      //! @return number of bytes.
+      size_t
+      getBufferedSize(void)
+      {
+        ScopedCondition l(m_cond);
+        return m_buffered + m_block->data.size();
+      }
+
+    private:
+      //! Block of data and respective index records.
+      struct Block
+      {
+        //! Offset of the block in the uncompressed stream.
+        uint64_t offset;
+        //! Uncompressed data.
+        std::vector<char> data;
+        //! Index records of messages starting in this block.
+        std::vector<uint8_t> index;
+      };
+
+      //! Output stream.
+      std::ofstream m_out;
+      //! Message index output stream.
+      std::ofstream m_idx;
+      //! Block index output stream.
+      std::ofstream m_blk;
+      //! Compressor or NULL if data is written uncompressed.
+      Compression::Compressor* m_com;
+      //! Compressed data.
+      Utils::ByteBuffer m_com_bfr;
+      //! File descriptor used to synchronize the output file.
+      int m_fd;
+      //! True if the index is written.
+      bool m_index;
+      //! Number of bytes written to the uncompressed stream.
+      uint64_t m_offset;
+      //! Number of bytes written to the output file.
+      uint64_t m_file_offset;
+      //! Highest timestamp of indexed messages.
+      double m_max_time;
+      //! Block size.
+      size_t m_block_size;
+      //! Maximum number of buffered bytes.
+      size_t m_max_buffered;
+      //! Block being filled.
+      Block* m_block;
+      //! Blocks waiting to be written.
+      std::deque<Block*> m_queue;
+      //! Blocks available for reuse.
+      std::vector<Block*> m_free;
+      //! Number of bytes in queued blocks.
+      size_t m_buffered;
+      //! True if a flush was requested.
+      bool m_sync;
+      //! True if the writer is closing.
+      bool m_closing;
+      //! Last error of the writer thread.
+      std::string m_error;
+      //! Lock and condition protecting the fields above.
+      Condition m_cond;
+
+      //! Get an empty block. Must be called with the lock held.
+      //! @return block.
+      Block*
+      getBlock(void)
+      {
+        Block* block = NULL;
+
+        if (m_free.empty())
+        {
+          block = new Block;
+          block->data.reserve(m_block_size);
+        }
+        else
+        {
+          block = m_free.back();
+          m_free.pop_back();
+        }
+
+        block->offset = m_offset;
+        return block;
+      }
+
+      //! Queue the current block, waiting for room if the maximum
+      //! amount of buffered data was reached. Must be called with the
+      //! lock held.
+      void
+      queueBlock(void)
+      {
+        if (m_block->data.empty())
+          return;
+
+        while (m_buffered + m_block->data.size() > m_max_buffered && m_error.empty())
+          m_cond.wait();
+
+        m_buffered += m_block->data.size();
+        m_queue.push_back(m_block);
+        m_block = getBlock();
+        m_cond.broadcast();
+      }
+
+      //! Compress and write a block, followed by its index records.
+      //! @param[in] block block.
+      void
+      writeBlock(Block* block)
+      {
+        if (m_com == NULL)
+        {
+          m_out.write(&block->data[0], block->data.size());
+          m_file_offset += block->data.size();
+        }
+        else
+        {
+          if (m_index)
+          {
+            IMC::LsfIndex::Block blk;
+            blk.offset = block->offset;
+            blk.file_offset = m_file_offset;
+
+            uint8_t rec[IMC::LsfIndex::c_block_record_size];
+            IMC::LsfIndex::encode(blk, rec);
+            m_blk.write((char*)rec, sizeof(rec));
+          }
+
+          m_com->compress(m_com_bfr, &block->data[0], block->data.size());
+          m_out.write(m_com_bfr.getBufferSigned(), m_com_bfr.getSize());
+          m_file_offset += m_com_bfr.getSize();
+        }
+
+        if (m_index && !block->index.empty())
+          m_idx.write((char*)&block->index[0], block->index.size());
+      }
+
+      //! Flush the output streams and synchronize the file.
+      void
+      sync(void)
+      {
+        m_out.flush();
+
+        if (m_index)
+        {
+          m_idx.flush();
+
+          if (m_blk.is_open())
+            m_blk.flush();
+        }
+
+#if defined(DUNE_SYS_HAS_FDATASYNC)
+        if (m_fd >= 0)
+          ::fdatasync(m_fd);
+#endif
+      }
+
+      void
+      run(void)
+      {
+        while (true)
+        {
+          Block* block = NULL;
+          bool sync_requested = false;
+
+          {
+            ScopedCondition l(m_cond);
+
+            while (m_queue.empty() && !m_sync && !m_closing)
+              m_cond.wait();
+
+            if (!m_queue.empty())
+            {
+              block = m_queue.front();
+              m_queue.pop_front();
+            }
+            else if (m_sync)
+            {
+              sync_requested = true;
+              m_sync = false;
+            }
+            else
+            {
+              break;
+            }
+          }
+
+          try
+          {
+            if (block != NULL)
+              writeBlock(block);
+            else if (sync_requested)
+              sync();
+
+            if (m_out.fail())
+              throw std::runtime_error(DTR("failed to write log data"));
+          }
+          catch (std::exception& e)
+          {
+            ScopedCondition l(m_cond);
+            m_error = e.what();
+          }
+
+          if (block != NULL)
+          {
+            ScopedCondition l(m_cond);
+            m_buffered -= block->data.size();
+            block->data.clear();
+            block->index.clear();
+            m_free.push_back(block);
+            m_cond.broadcast();
+          }
+        }
+
+        sync();
+      }
+    };
+  }
+}
+
+#endif
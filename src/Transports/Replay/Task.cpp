@@ -31,6 +31,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
 #include <fstream>
 
 // DUNE headers.
@@ -49,9 +50,15 @@ namespace Transports
       std::vector<std::string> ents;
       double time_multiplier;
       double initial_log_skip_seconds;
+      std::string mode;
+      double lockstep_timeout;
     };
 
     static const int c_stats_period = 10;
+    // Number of times the lockstep loop yields before sleeping.
+    static const unsigned c_lockstep_spins = 100;
+    // Lockstep loop sleep period (ns).
+    static const uint64_t c_lockstep_sleep = 100000;
 
     struct Task: public DUNE::Tasks::Task
     {
@@ -68,14 +75,24 @@ namespace Transports
 
       typedef std::map<std::string, bool> ReplayMsg;
       ReplayMsg m_replay;
+      // Identifiers of replayed messages.
+      std::set<uint16_t> m_replay_ids;
 
       double m_ts_delta;
       double m_start_time;
 
-      // Replay file handle
-      std::istream* m_is;
+      // Replay file reader.
+      IMC::LsfReader* m_reader;
+      // Replay file index (if available).
+      IMC::LsfIndex* m_index;
       // last state from replay file
       IMC::EstimatedState m_estate;
+      // True to replay in lockstep with a virtual clock.
+      bool m_lockstep;
+      // True if the clock is being driven by this task.
+      bool m_virtual;
+      // True if a lockstep timeout was already reported.
+      bool m_lockstep_warned;
 
       struct Stats
       {
@@ -98,7 +115,11 @@ namespace Transports
 
       Task(const std::string& name, Tasks::Context& ctx):
         Tasks::Task(name, ctx),
-        m_is(0)
+        m_reader(0),
+        m_index(0),
+        m_lockstep(false),
+        m_virtual(false),
+        m_lockstep_warned(false)
       {
         param("Load At Start", m_args.startup_file)
         .defaultValue("")
@@ -121,6 +142,24 @@ namespace Transports
         .defaultValue("0")
         .description("Number of seconds to skip in the beginning of the log");
 
+        param("Replay Mode", m_args.mode)
+        .values("Real Time, Lockstep")
+        .defaultValue("Real Time")
+        .description("In 'Real Time' mode messages are dispatched at the"
+                     " pace they were logged, scaled by the time multiplier."
+                     " In 'Lockstep' mode the clock is virtual and advanced"
+                     " to the time stamp of each message, which is only"
+                     " dispatched after all subscribers consumed the previous"
+                     " one, so the log is replayed as fast as possible and"
+                     " periodic tasks run on virtual time");
+
+        param("Lockstep Timeout", m_args.lockstep_timeout)
+        .units(Units::Second)
+        .minimumValue("0.1")
+        .defaultValue("5.0")
+        .description("Maximum amount of real time to wait for subscribers"
+                     " to consume a message in lockstep mode");
+
         bind<IMC::ReplayControl>(this);
       }
 
@@ -128,14 +167,32 @@ namespace Transports
       onUpdateParameters(void)
       {
         for (unsigned i = 0; i < m_args.msgs.size(); ++i)
+        {
           m_replay[m_args.msgs[i]] = true;
 
+          try
+          {
+            m_replay_ids.insert(IMC::Factory::getIdFromAbbrev(m_args.msgs[i]));
+          }
+          catch (std::exception& e)
+          {
+            war("%s: %s", DTR("invalid message"), e.what());
+          }
+        }
+
         if (m_replay.find("EstimatedState") == m_replay.end())
           bind<IMC::EstimatedState>(this);
 
         reset();
 
-        if (m_args.time_multiplier != 1.0)
+        m_lockstep = (m_args.mode == "Lockstep");
+
+        if (m_lockstep)
+        {
+          if (m_args.time_multiplier != 1.0)
+            war(DTR("time multiplier is ignored in lockstep mode"));
+        }
+        else if (m_args.time_multiplier != 1.0)
         {
           Time::Clock::setTimeMultiplier(m_args.time_multiplier);
           war("Using time multiplier: x%.2f", Time::Clock::getTimeMultiplier());
@@ -240,11 +297,7 @@ namespace Transports
 
         try
         {
-          Compression::Methods method = Compression::Factory::detect(file.c_str());
-          if (method == Compression::METHOD_UNKNOWN)
-            m_is = new std::ifstream(file.c_str(), std::ios::binary);
-          else
-            m_is = new Compression::FileInput(file.c_str(), method);
+          m_reader = new IMC::LsfReader(file);
         }
         catch (std::exception& e)
         {
@@ -252,11 +305,25 @@ namespace Transports
           return;
         }
 
+        Memory::clear(m_index);
+        if (Path(IMC::LsfIndex::getPath(file)).isFile())
+        {
+          try
+          {
+            m_index = new IMC::LsfIndex(file);
+            debug("using index with %u messages", (unsigned)m_index->getEntryCount());
+          }
+          catch (std::exception& e)
+          {
+            war("%s: %s", DTR("ignoring index"), e.what());
+          }
+        }
+
         IMC::Message* m = 0;
 
         try
         {
-          m = IMC::Packet::deserialize(*m_is);
+          m = m_reader->read();
         }
         catch (std::exception& e)
         {
@@ -284,6 +351,15 @@ namespace Transports
 
         m_ts_delta = lc->getTimeStamp();
 
+        // In lockstep mode messages keep their original time stamps.
+        if (m_lockstep)
+        {
+          Clock::setVirtual(m_ts_delta + m_args.initial_log_skip_seconds);
+          m_ctx.mbus.setTracking(true);
+          m_virtual = true;
+          m_lockstep_warned = false;
+        }
+
         size_t spos = lc->name.find_last_of('/');
         if (spos != std::string::npos)
           lc->name = lc->name.substr(spos + 1);
@@ -315,26 +391,78 @@ namespace Transports
         war("%s '%s'", DTR("started replay of"), file.c_str());
       }
 
+      //! Use the index to move the replay stream close to the first
+      //! message after the skipped time, reading only the entity
+      //! information found before it.
+      void
+      seekWithIndex(double time)
+      {
+        size_t target = m_index->findTime(time);
+        if (target >= m_index->getEntryCount())
+          return;
+
+        for (size_t i = m_index->findMessage(DUNE_IMC_ENTITYINFO, 0, target);
+             i < target;
+             i = m_index->findMessage(DUNE_IMC_ENTITYINFO, i + 1, target))
+        {
+          m_index->seek(*m_reader, i);
+          IMC::Message* m = m_reader->read();
+          if (m)
+          {
+            updateEntityMap(m);
+            delete m;
+          }
+        }
+
+        m_index->seek(*m_reader, target);
+      }
+
+      //! Read the next message that may be replayed. Other messages
+      //! are skipped without being deserialized.
+      //! @return message or NULL at the end of the log.
+      IMC::Message*
+      readMessage(void)
+      {
+        // Replay may have been stopped while consuming messages.
+        if (m_reader == NULL)
+          return NULL;
+
+        while (m_reader->next())
+        {
+          uint16_t id = m_reader->getHeader().mgid;
+          if (id == DUNE_IMC_ESTIMATEDSTATE
+              || id == DUNE_IMC_ENTITYINFO
+              || id == DUNE_IMC_ENTITYSTATE
+              || m_replay_ids.find(id) != m_replay_ids.end())
+            return m_reader->decode();
+        }
+
+        return NULL;
+      }
+
       IMC::Message*
       getFirstMessageAfterSkip(double time_to_skip)
       {
         IMC::Message* m = 0;
         double time_origin = m_ts_delta;
-        m = IMC::Packet::deserialize(*m_is);
-        while (m)
+        if (m_index)
+          seekWithIndex(time_origin + time_to_skip);
+
+        while (m_reader->next())
         {
-          if (m->getTimeStamp() - time_origin >= time_to_skip)
-            return m;
+          const IMC::Header& hdr = m_reader->getHeader();
+          if (hdr.timestamp - time_origin >= time_to_skip)
+            return m_reader->decode();
+
           // Do not miss information from EntityInfo
-          if (m->getId() == DUNE_IMC_ENTITYINFO)
+          if (hdr.mgid == DUNE_IMC_ENTITYINFO)
           {
+            m = m_reader->decode();
             updateEntityMap(m);
+            if (getDebugLevel() >= DEBUG_LEVEL_SPEW)
+              m->toText(std::cout);
+            delete m;
           }
-
-          delete m;
-          m = IMC::Packet::deserialize(*m_is);
-          if(getDebugLevel() >= DEBUG_LEVEL_SPEW)
-            m->toText(std::cout);
         }
         return NULL;
       }
@@ -384,14 +512,79 @@ namespace Transports
       {
         requestDeactivation();
 
-        if (m_is)
-        {
-          delete m_is;
-          m_is = 0;
-        }
+        Memory::clear(m_reader);
+
+        Memory::clear(m_index);
         m_eid2eid.clear();
         m_tstats.clear();
         m_tgstats = Stats();
+
+        if (m_virtual)
+        {
+          m_ctx.mbus.setTracking(false);
+          Clock::clearVirtual();
+          m_virtual = false;
+        }
+      }
+
+      //! Wait until all messages dispatched so far were consumed and
+      //! all tasks woken by the virtual clock are idle.
+      void
+      waitForSubscribers(void)
+      {
+        double deadline = Clock::getRT() + m_args.lockstep_timeout;
+
+        for (unsigned spins = 0; !stopping(); ++spins)
+        {
+          consumeMessages();
+
+          if (!m_virtual)
+            return;
+
+          if (m_ctx.mbus.isDrained() && Clock::getBusyCount() == 0)
+            return;
+
+          if (Clock::getRT() >= deadline)
+          {
+            if (!m_lockstep_warned)
+            {
+              war(DTR("subscribers did not consume messages in time, some tasks may not be idle"));
+              m_lockstep_warned = true;
+            }
+            return;
+          }
+
+          if (spins < c_lockstep_spins)
+            Concurrency::Scheduler::yield();
+          else
+            Delay::waitNsec(c_lockstep_sleep);
+        }
+      }
+
+      void
+      dispatchInLockstep(IMC::Message* m)
+      {
+        // Let periodic tasks run up to the time of this message.
+        Clock::advance(m->getTimeStamp());
+        waitForSubscribers();
+
+        if (!m_virtual)
+          return;
+
+        updateStats(m_tstats[m->getName()], 0);
+        updateStats(m_tgstats, 0);
+
+        dispatch(m, DF_KEEP_TIME);
+        waitForSubscribers();
+
+        if (Clock::getSinceEpoch() >= m_next_stats)
+        {
+          displayStats();
+          m_next_stats += c_stats_period;
+        }
+
+        spew("%s %0.4f %s", m->getName(), (m->getTimeStamp() - m_start_time),
+             m_eid2name[m->getSourceEntity()].c_str());
       }
 
       void
@@ -407,6 +600,12 @@ namespace Transports
         double new_ts = original_ts + m_ts_delta;
         m->setTimeStamp(new_ts);
 
+        if (m_virtual)
+        {
+          dispatchInLockstep(m);
+          return;
+        }
+
         // Wait till the time is right
         double now = Clock::getSinceEpoch();
         double delta = new_ts - now;
@@ -465,7 +664,7 @@ namespace Transports
 
           IMC::Message* m = 0;
 
-          while (!stopping() && (m = DUNE::IMC::Packet::deserialize(*m_is)) != 0 && !m_is->eof())
+          while (!stopping() && (m = readMessage()) != 0)
           {
             consumeMessages();
 
@@ -486,6 +685,9 @@ namespace Transports
             {
               dispatchWithNewTime(m);
             }
+
+            IMC::Factory::recycle(m);
+            m = NULL;
           }
 
           stopReplay();
@@ -31,6 +31,7 @@
 #define TRANSPORTS_UDP_LISTENER_HPP_INCLUDED_
 
 // ISO C++ 98 headers.
+#include <algorithm>
 #include <map>
 #include <vector>
 
@@ -80,6 +81,8 @@ namespace Transports
     private:
       // Buffer capacity.
       static const int c_bfr_size = 65535;
+      // Maximum number of datagrams read at once.
+      static const int c_batch_size = 16;
       // Poll timeout in milliseconds.
       static const int c_poll_tout = 1000;
       // Parent task.
@@ -98,52 +101,105 @@ namespace Transports
       void
       run(void)
       {
-        Address addr;
-        uint8_t* bfr = new uint8_t[c_bfr_size];
+        uint8_t* bfr = new uint8_t[c_bfr_size * c_batch_size];
+        UDPSocket::Datagram dgrams[c_batch_size];
         double poll_tout = c_poll_tout / 1000.0;
 
         while (!isStopping())
         {
+          size_t count = 0;
+
           try
           {
             if (!Poll::poll(m_sock, poll_tout))
               continue;
 
-            uint16_t rv = m_sock.read(bfr, c_bfr_size, &addr);
-            IMC::Message* msg = IMC::Packet::deserialize(bfr, rv);
-
-            if (m_lcomms->isActive())
+            for (int i = 0; i < c_batch_size; ++i)
             {
-              if (msg->getId() == DUNE_IMC_ANNOUNCE)
-              {
-                m_lcomms->setAnnounce(static_cast<IMC::Announce*>(msg));
-              }
-
-              if (!m_lcomms->isNodeWithinRange(msg->getSource(), msg->getId()))
-              {
-                delete msg;
-                continue;
-              }
+              dgrams[i].data = bfr + i * c_bfr_size;
+              dgrams[i].size = c_bfr_size;
             }
 
-            m_contacts_lock.lockWrite();
-            m_contacts.update(msg->getSource(), addr);
-            m_contacts_lock.unlock();
+            count = m_sock.read(dgrams, c_batch_size);
+          }
+          catch (std::exception & e)
+          {
+            m_task.debug("error while receiving messages: %s", e.what());
+            continue;
+          }
+
+          for (size_t i = 0; i < count; ++i)
+            handle(dgrams[i]);
+        }
+
+        delete [] bfr;
+      }
 
-            m_task.dispatch(msg, DF_KEEP_TIME | DF_KEEP_SRC_EID);
+      //! Unpack all IMC packets contained in a datagram. A datagram
+      //! may hold several packets concatenated back to back when the
+      //! sender aggregates outgoing messages.
+      //! @param[in] dgram received datagram.
+      void
+      handle(const UDPSocket::Datagram& dgram)
+      {
+        const uint8_t* ptr = dgram.data;
+        size_t left = dgram.size;
 
-            if (m_trace)
-              msg->toText(std::cerr);
+        while (left >= DUNE_IMC_CONST_HEADER_SIZE + DUNE_IMC_CONST_FOOTER_SIZE)
+        {
+          uint16_t len = (uint16_t)std::min(left, (size_t)UINT16_MAX);
 
-            delete msg;
+          try
+          {
+            IMC::Header hdr;
+            IMC::Packet::deserializeHeader(hdr, ptr, len);
+            size_t size = DUNE_IMC_CONST_HEADER_SIZE + hdr.size + DUNE_IMC_CONST_FOOTER_SIZE;
+            if (size > left)
+              throw IMC::BufferTooShort();
+
+            IMC::Message* msg = IMC::Packet::deserializePayload(hdr, ptr, size, NULL);
+            ptr += size;
+            left -= size;
+            handle(msg, dgram.address);
           }
           catch (std::exception & e)
           {
             m_task.debug("error while unpacking message: %s",e.what());
+            return;
           }
         }
+      }
 
-        delete [] bfr;
+      //! Process one unpacked message.
+      //! @param[in] msg message (recycled by this function).
+      //! @param[in] addr address of the sender.
+      void
+      handle(IMC::Message* msg, const Address& addr)
+      {
+        if (m_lcomms->isActive())
+        {
+          if (msg->getId() == DUNE_IMC_ANNOUNCE)
+          {
+            m_lcomms->setAnnounce(static_cast<IMC::Announce*>(msg));
+          }
+
+          if (!m_lcomms->isNodeWithinRange(msg->getSource(), msg->getId()))
+          {
+            IMC::Factory::recycle(msg);
+            return;
+          }
+        }
+
+        m_contacts_lock.lockWrite();
+        m_contacts.update(msg->getSource(), addr);
+        m_contacts_lock.unlock();
+
+        m_task.dispatch(msg, DF_KEEP_TIME | DF_KEEP_SRC_EID);
+
+        if (m_trace)
+          msg->toText(std::cerr);
+
+        IMC::Factory::recycle(msg);
       }
     };
   }
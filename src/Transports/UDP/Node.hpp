@@ -137,22 +137,25 @@ namespace Transports
         return true;
       }
 
-      //! Send data to node.
+      //! Send datagrams to node.
       //! @param[in] sock UDP destination socket.
-      //! @param[in] data data to be transmitted.
-      //! @param[in] data_len length of data to be transmitted.
-      void
-      send(UDPSocket& sock, const uint8_t* data, unsigned data_len)
+      //! @param[in] dgrams datagrams to be transmitted, addressed
+      //! to this node by this function.
+      //! @param[in] count number of datagrams.
+      //! @return number of datagrams that could not be sent.
+      unsigned
+      send(UDPSocket& sock, UDPSocket::Datagram* dgrams, unsigned count)
       {
-        if (m_active == m_addrs.end())
-          return;
+        if (m_active == m_addrs.end() || count == 0)
+          return 0;
 
-        try
+        for (unsigned i = 0; i < count; ++i)
         {
-          sock.write(data, data_len, m_active->first, m_active->second);
+          dgrams[i].address = m_active->first;
+          dgrams[i].port = m_active->second;
         }
-        catch (...)
-        { }
+
+        return count - sock.write(dgrams, count);
       }
 
     private:
@@ -34,6 +34,7 @@
 #include <string>
 #include <map>
 #include <cstdio>
+#include <vector>
 
 // DUNE headers.
 #include <DUNE/DUNE.hpp>
@@ -96,25 +97,36 @@ namespace Transports
         return m_active_count;
       }
 
-      void
-      send(UDPSocket& sock, const uint8_t* data, unsigned data_len, unsigned msgid)
+      //! Send datagrams to all nodes, one batch per node.
+      //! @param[in] sock UDP socket.
+      //! @param[in] dgrams datagrams.
+      //! @param[in] msgids message identifiers of the datagrams.
+      //! @return number of datagrams that could not be sent.
+      unsigned
+      send(UDPSocket& sock, const std::vector<UDPSocket::Datagram>& dgrams,
+           const std::vector<unsigned>& msgids)
       {
-        if (m_lcomms != NULL)
+        unsigned failed = 0;
+
+        if (dgrams.empty())
+          return failed;
+
+        bool limited = (m_lcomms != NULL && m_lcomms->isActive());
+
+        for (Table::iterator itr = m_table.begin(); itr != m_table.end(); ++itr)
         {
-          if (m_lcomms->isActive())
+          m_batch.clear();
+          for (unsigned i = 0; i < dgrams.size(); ++i)
           {
-            for (Table::iterator itr = m_table.begin(); itr != m_table.end(); ++itr)
-            {
-              if (m_lcomms->isNodeWithinRange(itr->first, msgid))
-                itr->second.send(sock, data, data_len);
-            }
-
-            return;
+            if (!limited || m_lcomms->isNodeWithinRange(itr->first, msgids[i]))
+              m_batch.push_back(dgrams[i]);
           }
+
+          if (!m_batch.empty())
+            failed += itr->second.send(sock, &m_batch[0], m_batch.size());
         }
 
-        for (Table::iterator itr = m_table.begin(); itr != m_table.end(); ++itr)
-          itr->second.send(sock, data, data_len);
+        return failed;
       }
 
       void
@@ -131,6 +143,8 @@ namespace Transports
       Table m_table;
       // Limited Comms object
       LimitedComms* m_lcomms;
+      // Datagrams addressed to one node.
+      std::vector<UDPSocket::Datagram> m_batch;
     };
   }
 }
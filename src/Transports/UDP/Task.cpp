@@ -84,17 +84,35 @@ namespace Transports
       bool only_local;
       // Optional custom service type
       std::string custom_service;
+      // Maximum size of aggregated datagrams (0 to disable).
+      unsigned frame_size;
+      // Maximum time messages wait for aggregation.
+      double frame_deadline;
     };
 
     // Internal buffer size.
     static const int c_bfr_size = 65535;
+    // Size of the buffer of outgoing datagrams.
+    static const int c_batch_bfr_size = 256 * 1024;
+    // Maximum number of outgoing datagrams sent at once.
+    static const unsigned c_batch_size = 64;
     // Port bind retries.
     static const int c_port_retries = 5;
+    // Minimum time between reports of datagrams that failed to be sent.
+    static const float c_send_error_period = 5.0f;
 
     struct Task: public DUNE::Tasks::Task
     {
-      //! Serialization buffer.
+      //! Serialization buffer of outgoing datagrams.
       uint8_t* m_bfr;
+      //! Number of used bytes of the serialization buffer.
+      unsigned m_bfr_used;
+      //! Outgoing datagrams.
+      std::vector<UDPSocket::Datagram> m_dgrams;
+      //! Message identifiers of outgoing datagrams.
+      std::vector<unsigned> m_msgids;
+      //! Time at which the oldest outgoing datagram was queued.
+      double m_queued_time;
       //! UDP Socket.
       UDPSocket m_sock;
       //! Set of static nodes.
@@ -111,6 +129,10 @@ namespace Transports
       Listener* m_listener;
       //! Contact refresh counter.
       Time::Counter<float> m_contacts_refresh_counter;
+      //! Number of datagrams that failed to be sent since the last report.
+      unsigned m_send_errors;
+      //! Send error report counter.
+      Time::Counter<float> m_send_error_counter;
       //! LimitedComms object
       LimitedComms* m_lcomms;
       //! Message Filter
@@ -119,7 +141,11 @@ namespace Transports
       Task(const std::string& name, Tasks::Context& ctx):
         DUNE::Tasks::Task(name, ctx),
         m_bfr(NULL),
+        m_bfr_used(0),
+        m_queued_time(0),
         m_listener(NULL),
+        m_send_errors(0),
+        m_send_error_counter(c_send_error_period),
         m_lcomms(NULL)
       {
         param("Local Port", m_args.port)
@@ -184,8 +210,25 @@ namespace Transports
         .defaultValue("")
         .description("Optional custom service type (imc+udp+<Custom Service Type>), empty entry gives default service (imc+udp)");
 
+        param("Aggregation Frame Size", m_args.frame_size)
+        .defaultValue("0")
+        .maximumValue("65535")
+        .units(Units::Byte)
+        .description("Pack consecutive messages into datagrams of up to this size"
+                     " (e.g., 1472 for Ethernet). Set to 0 to send one message per"
+                     " datagram. Receivers unpack aggregated datagrams regardless"
+                     " of this setting");
+
+        param("Aggregation Deadline", m_args.frame_deadline)
+        .defaultValue("0.05")
+        .minimumValue("0.0")
+        .units(Units::Second)
+        .description("Maximum time outgoing messages are held for aggregation");
+
         // Allocate space for internal buffer.
-        m_bfr = new uint8_t[c_bfr_size];
+        m_bfr = new uint8_t[c_batch_bfr_size];
+        m_dgrams.reserve(c_batch_size);
+        m_msgids.reserve(c_batch_size);
 
         // Register listeners.
         bind<IMC::Announce>(this);
@@ -339,25 +382,86 @@ namespace Transports
         if (m_args.trace_out)
           msg->toText(std::cerr);
 
-        uint16_t rv = IMC::Packet::serialize(msg, m_bfr, c_bfr_size);
+        // Messages are queued and sent after the receiving queue is
+        // drained, in one batch per destination.
+        if (m_bfr_used + c_bfr_size > c_batch_bfr_size || m_dgrams.size() >= c_batch_size)
+          flush();
+
+        if (m_dgrams.empty())
+          m_queued_time = Clock::get();
+
+        uint16_t size = IMC::Packet::serialize(msg, m_bfr + m_bfr_used, c_bfr_size);
+
+        // Datagrams are contiguous, so the last one can grow in place.
+        // Limited comms filter messages per node and are not aggregated.
+        if (m_args.frame_size > 0 && !m_lcomms->isActive() && !m_dgrams.empty()
+            && m_dgrams.back().size + size <= m_args.frame_size)
+        {
+          m_dgrams.back().size += size;
+          m_bfr_used += size;
+          return;
+        }
+
+        UDPSocket::Datagram dgram;
+        dgram.data = m_bfr + m_bfr_used;
+        dgram.size = size;
+        dgram.port = 0;
+        m_bfr_used += size;
+        m_dgrams.push_back(dgram);
+        m_msgids.push_back(msg->getId());
+      }
+
+      //! Get the time until queued messages must be sent.
+      //! @return time in seconds.
+      double
+      getFlushTimeout(void)
+      {
+        if (m_dgrams.empty())
+          return 1.0;
+
+        if (m_args.frame_size == 0)
+          return 0.0;
+
+        double remaining = m_queued_time + m_args.frame_deadline - Clock::get();
+        return std::max(0.0, std::min(1.0, remaining));
+      }
+
+      //! Send queued messages.
+      void
+      flush(void)
+      {
+        if (m_dgrams.empty())
+          return;
 
         // Send to static nodes.
         std::set<NodeAddress>::iterator itr = m_static_dsts.begin();
         for (; itr != m_static_dsts.end(); ++itr)
         {
-          try
+          for (unsigned i = 0; i < m_dgrams.size(); ++i)
           {
-            m_sock.write(m_bfr, rv, itr->getAddress(), itr->getPort());
+            m_dgrams[i].address = itr->getAddress();
+            m_dgrams[i].port = itr->getPort();
           }
-          catch (...)
-          { }
+
+          m_send_errors += m_dgrams.size() - m_sock.write(&m_dgrams[0], m_dgrams.size());
         }
 
         if (m_args.dynamic_nodes)
         {
           // Send to dynamic nodes.
-          m_node_table.send(m_sock, m_bfr, rv, msg->getId());
+          m_send_errors += m_node_table.send(m_sock, m_dgrams, m_msgids);
+        }
+
+        if (m_send_errors > 0 && m_send_error_counter.overflow())
+        {
+          war(DTR("failed to send %u datagrams"), m_send_errors);
+          m_send_errors = 0;
+          m_send_error_counter.reset();
         }
+
+        m_dgrams.clear();
+        m_msgids.clear();
+        m_bfr_used = 0;
       }
 
       void
@@ -409,7 +513,10 @@ namespace Transports
       {
         while (!stopping())
         {
-          waitForMessages(1.0);
+          waitForMessages(getFlushTimeout());
+
+          if (getFlushTimeout() <= 0.0)
+            flush();
 
           // Check if it's time to update the contact list.
           if (m_contacts_refresh_counter.overflow())
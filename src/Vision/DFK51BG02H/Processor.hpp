@@ -0,0 +1,157 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+#ifndef VISION_DFK51BG02H_PROCESSOR_HPP_INCLUDED_
+#define VISION_DFK51BG02H_PROCESSOR_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <cstring>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Local headers.
+#include "WhiteBalance.hpp"
+#include "AutoExposure.hpp"
+
+// Import namespaces.
+using DUNE_NAMESPACES;
+
+namespace Vision
+{
+  namespace DFK51BG02H
+  {
+    //! Frame processor: white balance, Bayer decoding, JPEG
+    //! compression and exposure metering. One instance is used per
+    //! worker thread.
+    class Processor: public FramePipeline::Processor
+    {
+    public:
+      //! Constructor.
+      //! @param[in] w image width.
+      //! @param[in] h image height.
+      //! @param[in] quality JPEG quality.
+      //! @param[in] r_factor white-balance R factor.
+      //! @param[in] b_factor white-balance B factor.
+      //! @param[in] ae true to compute exposure corrections.
+      Processor(unsigned w, unsigned h, unsigned quality, float r_factor, float b_factor, bool ae):
+        m_width(w),
+        m_height(h),
+        m_debayer(BayerDecoder::TILE_GBRG, BayerDecoder::METHOD_BILINEAR),
+        m_white(w, h)
+      {
+        setParameters(quality, r_factor, b_factor, ae);
+
+        m_jpeg.setInputDimensions(w, h);
+        m_jpeg.setInputColorSpace(JPEGCompressor::CS_RGB);
+        m_jpeg.setOutputColorSpace(JPEGCompressor::CS_YUV);
+
+        m_rgb24_bfr = new uint8_t[w * h * 3];
+      }
+
+      //! Destructor.
+      ~Processor(void)
+      {
+        delete [] m_rgb24_bfr;
+      }
+
+      //! Change processing parameters. May be called while the
+      //! pipeline is running, new values apply from the next frame.
+      //! @param[in] quality JPEG quality.
+      //! @param[in] r_factor white-balance R factor.
+      //! @param[in] b_factor white-balance B factor.
+      //! @param[in] ae true to compute exposure corrections.
+      void
+      setParameters(unsigned quality, float r_factor, float b_factor, bool ae)
+      {
+        Concurrency::ScopedMutex l(m_mutex);
+        m_quality = quality;
+        m_r_factor = r_factor;
+        m_b_factor = b_factor;
+        m_ae_enabled = ae;
+      }
+
+      void
+      process(FramePipeline::Frame& frame)
+      {
+        unsigned quality = 0;
+        bool ae = false;
+
+        {
+          Concurrency::ScopedMutex l(m_mutex);
+          m_white.setRFactor(m_r_factor);
+          m_white.setBFactor(m_b_factor);
+          quality = m_quality;
+          ae = m_ae_enabled;
+        }
+
+        uint8_t* data = frame.getInput()->getBuffer();
+
+        m_white.filter(data);
+        m_debayer.decodeToRGB24(data, m_rgb24_bfr, m_width, m_height);
+        m_jpeg.compress(m_rgb24_bfr, quality);
+
+        ByteBuffer* output = frame.getOutput();
+        output->setSize(m_jpeg.imageSize());
+        std::memcpy(output->getBuffer(), m_jpeg.imageData(), m_jpeg.imageSize());
+
+        if (ae)
+          frame.setValue(m_ae.exposureCorrection(m_rgb24_bfr, m_width * m_height));
+      }
+
+    private:
+      //! Image width.
+      unsigned m_width;
+      //! Image height.
+      unsigned m_height;
+      //! Lock guarding processing parameters.
+      Concurrency::Mutex m_mutex;
+      //! JPEG quality.
+      unsigned m_quality;
+      //! White-balance R factor.
+      float m_r_factor;
+      //! White-balance B factor.
+      float m_b_factor;
+      //! True to compute exposure corrections.
+      bool m_ae_enabled;
+      //! RGB24 buffer.
+      uint8_t* m_rgb24_bfr;
+      //! Compressor.
+      JPEGCompressor m_jpeg;
+      //! Bayer decoder.
+      BayerDecoder m_debayer;
+      //! White-balance filter.
+      WhiteBalance m_white;
+      //! Automatic exposure control.
+      AutoExposure m_ae;
+    };
+  }
+}
+
+#endif
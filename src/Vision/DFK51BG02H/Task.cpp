@@ -28,7 +28,9 @@
 //***************************************************************************
 
 // ISO C++ 98 headers.
+#include <cstring>
 #include <queue>
+#include <vector>
 
 // DUNE headers.
 #include <DUNE/DUNE.hpp>
@@ -36,8 +38,8 @@
 // Local headers.
 #include "GVCP.hpp"
 #include "GVSP.hpp"
-#include "WhiteBalance.hpp"
-#include "AutoExposure.hpp"
+#include "Processor.hpp"
+#include "Writer.hpp"
 
 using DUNE_NAMESPACES;
 
@@ -102,6 +104,12 @@ namespace Vision
   //! <em>NAME</em> is the amount of seconds elapsed since the Unix
   //! Epoch (1st January, 1970) with four decimal places.
   //!
+  //! The task thread only copies each received frame to a processing
+  //! pipeline: white balance, %Bayer decoding and JPEG compression
+  //! run in a pool of worker threads and files are stored by a
+  //! separate writer thread. Frames arriving while all pipeline
+  //! buffers are in use are dropped.
+  //!
   //! @author Ricardo Martins
   namespace DFK51BG02H
   {
@@ -120,6 +128,10 @@ namespace Vision
       unsigned jpeg_quality;
       //! Number of frame buffers.
       unsigned buffer_count;
+      //! Number of processing threads.
+      unsigned proc_threads;
+      //! Number of processing buffers.
+      unsigned proc_buffers;
       //! Exposure time (or maximum value if auto).
       double exposure_time;
       //! Automatic Exposure.
@@ -161,35 +173,29 @@ namespace Vision
       GVCP* m_gvcp;
       //! %GVSP.
       GVSP* m_gvsp;
-      //! RGB24 buffer.
-      uint8_t* m_rgb24_bfr;
+      //! Processing pipeline.
+      FramePipeline* m_pipeline;
+      //! Pipeline processors, owned by the pipeline.
+      std::vector<Processor*> m_procs;
       //! Keep-alive counter.
       Counter<double> m_kalive;
       //! %Destination log folder.
       Path m_log_dir;
       //! Array of frames.
       std::queue<Frame*> m_frames;
-      //! PGM header.
-      std::string m_pgm_header;
-      //! Compressor.
-      JPEGCompressor m_jpeg;
-      //! Bayer decoder.
-      BayerDecoder m_debayer;
-      // White-balance filter.
-      WhiteBalance m_white;
       // Exposure time.
       double m_exposure;
-      //! Automatic exposure control.
-      AutoExposure m_ae;
+      //! Number of dropped frames already reported.
+      unsigned m_drops;
 
       Task(const std::string& name, Tasks::Context& ctx):
         Tasks::Task(name, ctx),
         m_gvcp(NULL),
         m_gvsp(NULL),
+        m_pipeline(NULL),
         m_kalive(0.5),
         m_log_dir(ctx.dir_log),
-        m_debayer(BayerDecoder::TILE_GBRG),
-        m_white(c_width, c_height)
+        m_drops(0)
       {
         // Retrieve configuration values.
         paramActive(Tasks::Parameter::SCOPE_MANEUVER,
@@ -264,6 +270,16 @@ namespace Vision
         .defaultValue("25")
         .description("Number of buffers");
 
+        param("Processing Threads", m_args.proc_threads)
+        .defaultValue("2")
+        .minimumValue("1")
+        .description("Number of threads used to process frames");
+
+        param("Processing Buffers", m_args.proc_buffers)
+        .defaultValue("4")
+        .minimumValue("1")
+        .description("Number of frames that can be queued for processing");
+
         param("JPEG Quality", m_args.jpeg_quality)
         .defaultValue("80")
         .units(Units::Percentage)
@@ -281,40 +297,43 @@ namespace Vision
         param("White Balance - R Factor", m_args.r_factor)
         .defaultValue("1.0");
 
-        m_rgb24_bfr = new uint8_t[c_width * c_height * 3];
-
-        // Initialize PGM header.
-        m_pgm_header = String::str("P5 %u %u 255\n", c_width, c_height);
-
         bind<IMC::LoggingControl>(this);
       }
 
-      //! Destructor.
-      ~Task(void)
-      {
-        delete [] m_rgb24_bfr;
-      }
-
       //! Update internal parameters.
       void
       onUpdateParameters(void)
       {
-        // White-balance filter.
-        m_white.setRFactor(m_args.r_factor);
-        m_white.setBFactor(m_args.b_factor);
+        if (m_pipeline == NULL)
+          return;
 
-        // Bayer decoder.
-        m_debayer.setMethod(BayerDecoder::METHOD_BILINEAR);
+        if (paramChanged(m_args.proc_threads) || paramChanged(m_args.proc_buffers)
+            || paramChanged(m_args.store_raw))
+          throw RestartNeeded(DTR("restarting to apply processing parameters"), 0);
+
+        if (paramChanged(m_args.jpeg_quality) || paramChanged(m_args.ae)
+            || paramChanged(m_args.r_factor) || paramChanged(m_args.b_factor))
+        {
+          for (unsigned i = 0; i < m_procs.size(); ++i)
+            m_procs[i]->setParameters(m_args.jpeg_quality, m_args.r_factor, m_args.b_factor, m_args.ae);
+        }
       }
 
       //! Acquire resources and buffers.
       void
       onResourceAcquisition(void)
       {
-        // Initialize JPEG compressor.
-        m_jpeg.setInputDimensions(c_width, c_height);
-        m_jpeg.setInputColorSpace(JPEGCompressor::CS_RGB);
-        m_jpeg.setOutputColorSpace(JPEGCompressor::CS_YUV);
+        m_pipeline = new FramePipeline(m_args.proc_buffers, c_width * c_height, c_width * c_height,
+                                       new Writer(c_width, c_height, m_args.store_raw));
+
+        for (unsigned i = 0; i < m_args.proc_threads; ++i)
+        {
+          m_procs.push_back(new Processor(c_width, c_height, m_args.jpeg_quality,
+                                          m_args.r_factor, m_args.b_factor, m_args.ae));
+          m_pipeline->addProcessor(m_procs.back());
+        }
+
+        m_pipeline->start();
 
         m_gvcp = new GVCP(m_args.raddr);
         m_gvsp = new GVSP(this, m_args.port);
@@ -341,6 +360,9 @@ namespace Vision
           m_gvsp = NULL;
         }
 
+        Memory::clear(m_pipeline);
+        m_procs.clear();
+
         while (!m_frames.empty())
         {
           Frame* frame = m_frames.front();
@@ -435,9 +457,51 @@ namespace Vision
       void
       onDeactivation(void)
       {
+        if (!m_pipeline->flush(5.0))
+          war(DTR("timeout while storing pending frames"));
+
         setEntityState(IMC::EntityState::ESTA_NORMAL, Status::CODE_IDLE);
       }
 
+      //! Hand frame over to the processing pipeline and apply the
+      //! latest exposure correction.
+      //! @param[in] frame received frame.
+      void
+      process(Frame* frame)
+      {
+        FramePipeline::Frame* pframe = m_pipeline->getFreeFrame();
+        if (pframe != NULL)
+        {
+          double timestamp = frame->getTimeStamp();
+          ByteBuffer* input = pframe->getInput();
+          input->setSize(c_width * c_height);
+          std::memcpy(input->getBuffer(), frame->getData(), c_width * c_height);
+          pframe->setTimeStamp(timestamp);
+          pframe->setPath((m_log_dir / String::str("%0.4f", timestamp)).str());
+          m_pipeline->put(pframe);
+        }
+
+        unsigned drops = m_pipeline->getDropCount();
+        if (drops != m_drops)
+        {
+          war(DTR("processing is too slow, dropped %u frames"), drops - m_drops);
+          m_drops = drops;
+        }
+
+        double correction = 0;
+        if (m_args.ae && m_pipeline->getValue(correction))
+        {
+          // Smooth out the exposure (make it slower varying), halve the deltaEV
+          correction = std::sqrt(correction);
+          m_exposure = Math::trimValue(m_exposure * correction, 0.0001, m_args.exposure_time);
+
+          if (m_exposure >= m_args.ae_min)
+            m_gvcp->setExposureTime(m_exposure);
+          else
+            m_gvcp->setExposureTime(m_args.ae_min);
+        }
+      }
+
       void
       onMain(void)
       {
@@ -473,39 +537,7 @@ namespace Vision
             war(DTR("lost at least %d packets"), c_pkts_per_frame - pkt_count);
 
           if (isActive())
-          {
-            m_white.filter(frame->getData());
-            double timestamp = frame->getTimeStamp();
-            Path file = m_log_dir / String::str("%0.4f.jpg", timestamp);
-
-            {
-              m_debayer.decodeToRGB24(frame->getData(), m_rgb24_bfr, c_width, c_height);
-              m_jpeg.compress(m_rgb24_bfr, m_args.jpeg_quality);
-              std::ofstream jpg(file.c_str(), std::ios::binary);
-              jpg.write((char*)m_jpeg.imageData(), m_jpeg.imageSize());
-            }
-
-            if (m_args.store_raw)
-            {
-              file = m_log_dir / String::str("%0.4f.pgm", timestamp);
-              std::ofstream pgm(file.c_str(), std::ios::binary);
-              pgm.write(m_pgm_header.c_str(), m_pgm_header.size());
-              pgm.write((char*)frame->getData(), c_width * c_height);
-            }
-
-            if (m_args.ae)
-            {
-              float correction = m_ae.exposureCorrection(m_rgb24_bfr, c_width * c_height);
-              // Smooth out the exposure (make it slower varying), halve the deltaEV
-              correction = std::sqrt(correction);
-              m_exposure = Math::trimValue(m_exposure * correction, 0.0001, m_args.exposure_time);
-
-              if (m_exposure >= m_args.ae_min)
-                m_gvcp->setExposureTime(m_exposure);
-              else
-                m_gvcp->setExposureTime(m_args.ae_min);
-            }
-          }
+            process(frame);
 
           m_gvsp->enqueueClean(frame);
         }
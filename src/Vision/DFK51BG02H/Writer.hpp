@@ -0,0 +1,94 @@
+//***************************************************************************
+// Copyright 2007-2020 Universidade do Porto - Faculdade de Engenharia      *
+// Laboratório de Sistemas e Tecnologia Subaquática (LSTS)                  *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: Ricardo Martins                                                  *
+//***************************************************************************
+
+#ifndef VISION_DFK51BG02H_WRITER_HPP_INCLUDED_
+#define VISION_DFK51BG02H_WRITER_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <fstream>
+#include <stdexcept>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+// Import namespaces.
+using DUNE_NAMESPACES;
+
+namespace Vision
+{
+  namespace DFK51BG02H
+  {
+    //! Frame writer. Frame paths are given without extension, the
+    //! JPEG image is stored as PATH.jpg and, optionally, the
+    //! white-balanced raw image as PATH.pgm.
+    class Writer: public FramePipeline::Writer
+    {
+    public:
+      //! Constructor.
+      //! @param[in] w image width.
+      //! @param[in] h image height.
+      //! @param[in] store_raw true to store raw images.
+      Writer(unsigned w, unsigned h, bool store_raw):
+        m_store_raw(store_raw)
+      {
+        m_pgm_header = String::str("P5 %u %u 255\n", w, h);
+      }
+
+      void
+      write(FramePipeline::Frame& frame)
+      {
+        ByteBuffer* jpg = frame.getOutput();
+        store(frame.getPath() + ".jpg", NULL, jpg);
+
+        if (m_store_raw)
+          store(frame.getPath() + ".pgm", &m_pgm_header, frame.getInput());
+      }
+
+    private:
+      //! True to store raw images.
+      bool m_store_raw;
+      //! PGM header.
+      std::string m_pgm_header;
+
+      void
+      store(const std::string& path, const std::string* header, ByteBuffer* data)
+      {
+        std::ofstream ofs(path.c_str(), std::ios::binary);
+        if (header != NULL)
+          ofs.write(header->c_str(), header->size());
+        ofs.write(data->getBufferSigned(), data->getSize());
+
+        if (!ofs)
+          throw std::runtime_error(String::str(DTR("failed to write %s"), path.c_str()));
+      }
+    };
+  }
+}
+
+#endif
@@ -48,70 +48,38 @@ namespace Vision
     //! Log file suffix.
     static const char* c_log_suffix = ".mjpg";
 
-    class Log: public Concurrency::Thread
+    //! Number of preallocated frames.
+    static const unsigned c_log_frames = 10;
+    //! Initial capacity of frame buffers.
+    static const unsigned c_log_frame_size = 256 * 1024;
+
+    //! MJPEG/AVI log. Frames are appended to the file by the writer
+    //! thread of a frame pipeline, so capture is never blocked by
+    //! storage.
+    class Log
     {
     public:
-      class Frame
-      {
-      public:
-        Frame():
-          m_timestamp(-1)
-        {
-          m_buffer.setSize(256 * 1024);
-        }
-
-        void
-        setTimeStamp(double timestamp)
-        {
-          m_timestamp = timestamp;
-        }
-
-        double
-        getTimeStamp(void) const
-        {
-          return m_timestamp;
-        }
-
-        ByteBuffer*
-        getBuffer(void)
-        {
-          return &m_buffer;
-        }
-
-      private:
-        ByteBuffer m_buffer;
-        double m_timestamp;
-      };
+      //! Log frame, captured JPEG data goes in the input buffer.
+      typedef FramePipeline::Frame Frame;
 
       Log(Tasks::Task* parent, const Path& folder, unsigned width, unsigned height, unsigned fps):
-        m_parent(parent),
-        m_frame_count(0)
+        m_parent(parent)
       {
         m_path = getLogPath(folder);
         folder.create();
         m_parent->debug("starting file: %s", m_path.c_str());
 
-        m_encoder = new MJPG::Encoder(m_path.c_str(), width, height, fps);
-        preAllocateFrames();
+        m_pipeline = new FramePipeline(c_log_frames, c_log_frame_size, 0,
+                                       new Encoder(m_path, width, height, fps));
+        m_pipeline->start();
       }
 
       ~Log(void)
       {
-        while (!m_queue.empty())
-        {
-          Frame* frame = m_queue.pop();
-          if (frame != NULL)
-            delete frame;
-        }
+        if (!m_pipeline->flush(1.0))
+          m_parent->war(DTR("discarding %u frames"), m_pipeline->getPendingCount());
 
-        while (!m_free_queue.empty())
-        {
-          Frame* frame = m_free_queue.pop();
-          if (frame != NULL)
-            delete frame;
-        }
-
-        delete m_encoder;
+        delete m_pipeline;
       }
 
       int64_t
@@ -123,50 +91,56 @@ namespace Vision
       size_t
       getFrameCount(void)
       {
-        return m_frame_count;
+        return m_pipeline->getWriteCount();
       }
 
       void
       put(Frame* frame)
       {
-        m_queue.push(frame);
+        m_pipeline->put(frame);
       }
 
       void
       putFree(Frame* frame)
       {
-        m_free_queue.push(frame);
+        m_pipeline->putFree(frame);
       }
 
+      //! Get an unused frame.
+      //! @return frame or NULL if all frames are waiting to be stored.
       Frame*
       getFreeFrame(void)
       {
-        Frame* frame = m_free_queue.pop();
-        if (frame == NULL)
-          frame = new Frame();
-
-        return frame;
+        return m_pipeline->getFreeFrame();
       }
 
-      ByteBuffer*
-      getBuffer(void)
+    private:
+      //! Pipeline writer that appends frames to the MJPEG/AVI file.
+      class Encoder: public FramePipeline::Writer
       {
-        return NULL;
-      }
+      public:
+        Encoder(const Path& path, unsigned width, unsigned height, unsigned fps):
+          m_encoder(path.c_str(), width, height, fps)
+        { }
+
+        void
+        write(Frame& frame)
+        {
+          ByteBuffer* buffer = frame.getInput();
+          m_encoder.encode(buffer->getBuffer(), buffer->getSize(), frame.getTimeStamp());
+        }
+
+      private:
+        //! MJPEG/AVI encoder.
+        Media::MJPG::Encoder m_encoder;
+      };
 
-    private:
       //! Parent task.
       Tasks::Task* m_parent;
       //! MJPEG/AVI file path.
       Path m_path;
-      //! Queue with dirty frames.
-      Concurrency::TSQueue<Frame*> m_queue;
-      //! Queue with free frames.
-      Concurrency::TSQueue<Frame*> m_free_queue;
-      //! MJPEG/AVI encoder.
-      Media::MJPG::Encoder* m_encoder;
-      //! Number of frames written so far.
-      size_t m_frame_count;
+      //! Frame pipeline.
+      FramePipeline* m_pipeline;
 
       static Path
       getLogPath(const Path& folder)
@@ -189,43 +163,6 @@ namespace Vision
 
         return path;
       }
-
-      void
-      preAllocateFrames(void)
-      {
-        for (size_t i = 0; i < 10; ++i)
-        {
-          Frame* frame = new Frame();
-          m_free_queue.push(frame);
-        }
-      }
-
-      void
-      processQueue(void)
-      {
-        while (!m_queue.empty())
-        {
-          Frame* frame = m_queue.pop();
-          if (frame == NULL)
-            continue;
-
-          ByteBuffer* buffer = frame->getBuffer();
-
-          m_encoder->encode(buffer->getBuffer(), buffer->getSize(), frame->getTimeStamp());
-          m_free_queue.push(frame);
-          ++m_frame_count;
-        }
-      }
-
-      void
-      run(void)
-      {
-        while (!isStopping())
-        {
-          if (m_queue.waitForItems(1.0))
-            processQueue();
-        }
-      }
     };
   }
 }
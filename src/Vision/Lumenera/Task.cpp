@@ -470,7 +470,6 @@ namespace Vision
 
         if (m_log != NULL)
         {
-          m_log->stopAndJoin();
           delete m_log;
           m_log = NULL;
         }
@@ -588,7 +587,7 @@ namespace Vision
         }
 
         // Retrieve JPEG data.
-        ByteBuffer* buffer = frame->getBuffer();
+        ByteBuffer* buffer = frame->getInput();
         buffer->setSize(jpg_size);
         m_http->getBinary(buffer->getBufferSigned(), jpg_size, timeout);
         return true;
@@ -854,13 +853,11 @@ namespace Vision
       {
         if (m_log != NULL)
         {
-          m_log->stopAndJoin();
           delete m_log;
           m_log = NULL;
         }
 
         m_log = new Log(this, m_log_dir, c_width, c_height, m_actual_frame_rate);
-        m_log->start();
       }
 
       void
@@ -876,24 +873,25 @@ namespace Vision
           changeLogFile();
 
         Log::Frame* frame = m_log->getFreeFrame();
+        if (frame == NULL)
+        {
+          // Storage is lagging behind, frame is skipped on next capture.
+          debug("log is full, dropping frame");
+          return;
+        }
+
+        bool queued = false;
 
         try
         {
           double previous_time = m_timestamp;
-          if (captureFrame(frame))
+          if (captureFrame(frame) && m_cooldown_timer.overflow())
           {
-            if (!m_cooldown_timer.overflow())
-            {
-              m_log->putFree(frame);
-            }
-            else
-            {
-              m_log->put(frame);
-              double frame_rate = 1.0 / (m_timestamp - previous_time);
-              if (std::fabs(frame_rate - m_actual_frame_rate) > 0.5)
-                inf("abnormal delta %.1f ms | %f | %u", (m_timestamp - previous_time) * 1000.0, frame_rate, m_actual_frame_rate);
-
-            }
+            m_log->put(frame);
+            queued = true;
+            double frame_rate = 1.0 / (m_timestamp - previous_time);
+            if (std::fabs(frame_rate - m_actual_frame_rate) > 0.5)
+              inf("abnormal delta %.1f ms | %f | %u", (m_timestamp - previous_time) * 1000.0, frame_rate, m_actual_frame_rate);
           }
         }
         catch (std::runtime_error& e)
@@ -902,6 +900,9 @@ namespace Vision
           stopVideo();
         }
 
+        if (!queued)
+          m_log->putFree(frame);
+
         if (m_log->getSize() >= m_args.max_file_size)
           changeLogFile();
       }
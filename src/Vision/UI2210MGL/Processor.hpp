@@ -0,0 +1,93 @@
+//***************************************************************************
+// Copyright 2013-2015 Norwegian University of Science and Technology (NTNU)*
+// Centre for Autonomous Marine Operations and Systems (AMOS)               *
+// Department of Engineering Cybernetics (ITK)                              *
+//***************************************************************************
+// This file is part of DUNE: Unified Navigation Environment.               *
+//                                                                          *
+// Commercial Licence Usage                                                 *
+// Licencees holding valid commercial DUNE licences may use this file in    *
+// accordance with the commercial licence agreement provided with the       *
+// Software or, alternatively, in accordance with the terms contained in a  *
+// written agreement between you and Faculdade de Engenharia da             *
+// Universidade do Porto. For licensing terms, conditions, and further      *
+// information contact lsts@fe.up.pt.                                       *
+//                                                                          *
+// Modified European Union Public Licence - EUPL v.1.1 Usage                *
+// Alternatively, this file may be used under the terms of the Modified     *
+// EUPL, Version 1.1 only (the "Licence"), appearing in the file LICENCE.md *
+// included in the packaging of this file. You may not use this work        *
+// except in compliance with the Licence. Unless required by applicable     *
+// law or agreed to in writing, software distributed under the Licence is   *
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF     *
+// ANY KIND, either express or implied. See the Licence for the specific    *
+// language governing permissions and limitations at                        *
+// https://github.com/LSTS/dune/blob/master/LICENCE.md and                  *
+// http://ec.europa.eu/idabc/eupl.html.                                     *
+//***************************************************************************
+// Author: João Fortuna                                                     *
+//***************************************************************************
+
+
+#ifndef VISION_UI2210MGL_PROCESSOR_HPP_INCLUDED_
+#define VISION_UI2210MGL_PROCESSOR_HPP_INCLUDED_
+
+// ISO C++ 98 headers.
+#include <cstring>
+#include <vector>
+
+// DUNE headers.
+#include <DUNE/DUNE.hpp>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#if defined(DUNE_SYS_HAS_OPENCV2_IMGCODECS_HPP)
+#  include <opencv2/imgcodecs.hpp>
+#endif
+
+// Local headers.
+#include "CaptureUeye.hpp"
+
+using DUNE_NAMESPACES;
+
+namespace Vision
+{
+  namespace UI2210MGL
+  {
+    //! Frame processor: flips the image and encodes it as BMP. One
+    //! instance is used per worker thread.
+    class Processor: public FramePipeline::Processor
+    {
+    public:
+      //! Constructor.
+      //! @param[in] aoi area of interest, must not change while frames
+      //! are being processed.
+      Processor(const AOI& aoi):
+        m_aoi(aoi)
+      { }
+
+      void
+      process(FramePipeline::Frame& frame)
+      {
+        cv::Mat image(m_aoi.height, m_aoi.width, CV_8UC1, frame.getInput()->getBuffer());
+        cv::flip(image, m_image, 0);
+        cv::imencode(".bmp", m_image, m_encoded);
+
+        ByteBuffer* output = frame.getOutput();
+        output->setSize(m_encoded.size());
+        std::memcpy(output->getBuffer(), &m_encoded[0], m_encoded.size());
+      }
+
+    private:
+      //! Area of interest.
+      const AOI& m_aoi;
+      //! Flipped image.
+      cv::Mat m_image;
+      //! Encoded image.
+      std::vector<uchar> m_encoded;
+    };
+  }
+}
+
+#endif
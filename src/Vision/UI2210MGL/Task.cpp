@@ -36,17 +36,9 @@
 // DUNE headers.
 #include <DUNE/DUNE.hpp>
 
-#include <opencv2/imgproc/imgproc.hpp>
-#include <opencv2/core/core.hpp>
-#include <opencv2/highgui/highgui.hpp>
-
-#if defined(DUNE_SYS_HAS_OPENCV2_IMGCODECS_HPP)
-#  include <opencv2/imgcodecs.hpp>
-#endif
-
-
 // Local headers.
 #include "CaptureUeye.hpp"
+#include "Processor.hpp"
 
 using DUNE_NAMESPACES;
 
@@ -83,6 +75,8 @@ namespace Vision
       bool calib_mode;
       //! Calibration delta
       float calib_delta;
+      //! Number of processing threads.
+      unsigned proc_threads;
     };
 
     //! Device driver task.
@@ -92,6 +86,8 @@ namespace Vision
       static const unsigned c_width = 640;
       //! %Frame height. 480 is total, 250 is usable.
       static const unsigned c_height = 250;
+      //! Number of images that can be queued for storage.
+      static const unsigned c_pipeline_frames = 16;
       //! Configuration parameters.
       Arguments m_args;
       //! %Destination log folder.
@@ -102,8 +98,8 @@ namespace Vision
       bool m_starting;
       //! Thread for image capture.
       CaptureUeye* m_capture;
-      //! OpenCV frame.
-      cv::Mat m_image_cv;
+      //! Image processing pipeline.
+      FramePipeline* m_pipeline;
       //! Frame
       Frame* m_frame;
       //! Current calibration gain
@@ -117,6 +113,7 @@ namespace Vision
         m_cam(1),
         m_starting(true),
         m_capture(NULL),
+        m_pipeline(NULL),
         m_frame(NULL),
         m_calib_gain(0),
         m_calib_time(0.0)
@@ -158,6 +155,11 @@ namespace Vision
         .maximumValue("100")
         .description("Image compression quality");
 
+        param("Processing Threads", m_args.proc_threads)
+        .defaultValue("1")
+        .minimumValue("1")
+        .description("Number of threads used to encode images");
+
         param("Auto Gain", m_args.auto_gain)
         .defaultValue("false")
         .description("Enable Auto Gain");
@@ -222,6 +224,10 @@ namespace Vision
 
         m_log_dir = m_args.log_dir;
 
+        // Processors read the AOI, wait for queued images.
+        if (!m_pipeline->flush(5.0))
+          war(DTR("timeout while storing pending images"));
+
         m_capture->setAOI(m_args.aoi);
         m_capture->setFPS(m_args.fps);
         m_capture->setGain(m_args.auto_gain, m_args.gain);
@@ -232,6 +238,12 @@ namespace Vision
       void
       onResourceAcquisition(void)
       {
+        m_pipeline = new FramePipeline(c_pipeline_frames, m_args.aoi.width * m_args.aoi.height,
+                                       m_args.aoi.width * m_args.aoi.height + 2048);
+        for (unsigned i = 0; i < m_args.proc_threads; ++i)
+          m_pipeline->addProcessor(new Processor(m_args.aoi));
+        m_pipeline->start();
+
         m_capture = new CaptureUeye(this, m_args.aoi, m_cam, m_args.fps);
         m_capture->setGain(m_args.auto_gain, m_args.gain);
         m_capture->setExposure(m_args.exposure);
@@ -247,6 +259,8 @@ namespace Vision
           m_capture = NULL;
         }
 
+        Memory::clear(m_pipeline);
+
         if (m_frame != NULL)
         {
           delete m_frame;
@@ -298,17 +312,25 @@ namespace Vision
         stopCapture();
       }
 
-      //! Saves the image.
+      //! Queues the image for encoding and storage.
       void
       saveImage(Frame* frame)
       {
-        Path file = m_log_dir / String::str("%0.4f_%d.bmp", frame->timestamp, frame->gain_factor);
+        FramePipeline::Frame* pframe = m_pipeline->getFreeFrame();
+        if (pframe == NULL)
+        {
+          war(DTR("image storage is too slow, dropping frame"));
+          return;
+        }
 
-        m_image_cv = cv::Mat(m_args.aoi.height, m_args.aoi.width, CV_8UC1);
-        std::memcpy(m_image_cv.ptr(), frame->data, m_args.aoi.height * m_args.aoi.width);
+        unsigned size = m_args.aoi.height * m_args.aoi.width;
+        ByteBuffer* input = pframe->getInput();
+        input->setSize(size);
+        std::memcpy(input->getBuffer(), frame->data, size);
 
-        cv::flip(m_image_cv, m_image_cv, 0);
-        cv::imwrite(file.c_str(), m_image_cv);
+        pframe->setTimeStamp(frame->timestamp);
+        pframe->setPath((m_log_dir / String::str("%0.4f_%d.bmp", frame->timestamp, frame->gain_factor)).str());
+        m_pipeline->put(pframe);
       }
 
       float
@@ -346,6 +368,9 @@ namespace Vision
 
         debug("%d images in buffer when stopping.", i);
 
+        if (!m_pipeline->flush(5.0))
+          war(DTR("timeout while storing pending images"));
+
         if (m_capture->isRunning())
           m_capture->stopAndJoin();
       }